@@ -0,0 +1,83 @@
+﻿// Benchmarks/ArgumentBuilderBenchmarks.cs
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using BenchmarkDotNet.Attributes;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Services;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// Command line construction, which runs on every launch whether or not anything was downloaded.
+    /// </summary>
+    public class ArgumentBuilderBenchmarks
+    {
+        private string _dataDir;
+        private ArgumentBuilder _builder;
+        private MinecraftVersion _version;
+        private JavaRuntimeInfo _runtime;
+        private string _clientJar;
+        private List<string> _libraryPaths;
+        private string _classpath;
+        private string _nativesDir;
+        private List<string> _templates;
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _dataDir = SyntheticData.CreateTempDirectory("args");
+            var config = new LauncherConfig(_dataDir);
+            _builder = new ArgumentBuilder(config);
+            _version = SyntheticData.CreateVersion();
+            _runtime = new JavaRuntimeInfo { HomePath = _dataDir, JavaExecutablePath = Path.Combine(_dataDir, "bin", "java"), MajorVersion = 21, ComponentName = "java-runtime-delta", Source = "mojang" };
+            _clientJar = Path.Combine(config.VersionsDir, _version.Id, _version.Id + ".jar");
+            Directory.CreateDirectory(Path.GetDirectoryName(_clientJar));
+            File.WriteAllBytes(_clientJar, new byte[0]);
+            _libraryPaths = _version.Libraries.Select(l => Path.Combine(config.LibrariesDir, l.Downloads.Artifact.Path)).ToList();
+            _classpath = _builder.BuildClasspath(_clientJar, _libraryPaths);
+            _nativesDir = Path.Combine(config.VersionsDir, _version.Id, _version.Id + "-natives");
+
+            // Every argument template of the version, conditional values included.
+            _templates = _version.Arguments.Game.Concat(_version.Arguments.Jvm)
+                .SelectMany(a => a.IsPlainString ? new[] { a.PlainStringValue } :
+                    a.ConditionalValue.IsListValue() ? a.ConditionalValue.GetListValue().ToArray() : new[] { a.ConditionalValue.GetSingleValue() })
+                .ToList();
+        }
+
+        [GlobalCleanup]
+        public void Cleanup()
+        {
+            Directory.Delete(_dataDir, true);
+        }
+
+        [Benchmark]
+        public int ReplacePlaceholders()
+        {
+            int length = 0;
+            foreach (string template in _templates)
+            {
+                length += _builder.ReplacePlaceholders(template, _version, _classpath, _nativesDir).Length;
+            }
+            return length;
+        }
+
+        [Benchmark]
+        public string BuildClasspath()
+        {
+            return _builder.BuildClasspath(_clientJar, _libraryPaths);
+        }
+
+        [Benchmark]
+        public List<string> BuildJvmArguments()
+        {
+            return _builder.BuildJvmArguments(_version, _classpath, _nativesDir, _runtime);
+        }
+
+        [Benchmark]
+        public List<string> BuildGameArguments()
+        {
+            return _builder.BuildGameArguments(_version);
+        }
+    }
+}
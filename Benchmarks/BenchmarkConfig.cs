@@ -0,0 +1,42 @@
+﻿// Benchmarks/BenchmarkConfig.cs
+using System;
+using System.IO;
+using BenchmarkDotNet.Configs;
+using BenchmarkDotNet.Diagnosers;
+using BenchmarkDotNet.Exporters;
+using BenchmarkDotNet.Exporters.Json;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// Configuration shared by every benchmark: allocations are always reported, and each run writes a GitHub
+    /// markdown table and a full JSON report under <c>Benchmarks/BenchmarkDotNet.Artifacts/results</c>.
+    /// </summary>
+    public static class BenchmarkConfig
+    {
+        public static IConfig Create()
+        {
+            return ManualConfig.Create(DefaultConfig.Instance)
+                .AddDiagnoser(MemoryDiagnoser.Default)
+                .AddExporter(MarkdownExporter.GitHub)
+                .AddExporter(JsonExporter.Full)
+                .WithArtifactsPath(Path.Combine(ProjectDirectory, "BenchmarkDotNet.Artifacts"));
+        }
+
+        /// <summary>
+        /// The directory holding <c>ObsidianLauncher.Benchmarks.csproj</c>, found by walking up from the binaries;
+        /// the current directory if the project is not found (e.g. when run from a copied build).
+        /// </summary>
+        public static string ProjectDirectory
+        {
+            get
+            {
+                for (var dir = new DirectoryInfo(AppContext.BaseDirectory); dir != null; dir = dir.Parent)
+                {
+                    if (File.Exists(Path.Combine(dir.FullName, "ObsidianLauncher.Benchmarks.csproj"))) return dir.FullName;
+                }
+                return Directory.GetCurrentDirectory();
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+﻿// Benchmarks/DeserializationBenchmarks.cs
+using System.Text.Json;
+using BenchmarkDotNet.Attributes;
+using ObsidianLauncher.Models;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// Parsing of the two metadata documents read on every launch: the version JSON and its asset index.
+    /// </summary>
+    public class DeserializationBenchmarks
+    {
+        // The options the launcher uses (see VersionCatalog).
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true };
+
+        private string _versionJson;
+        private string _assetIndexJson;
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _versionJson = SyntheticData.CreateVersionJson();
+            _assetIndexJson = SyntheticData.CreateAssetIndexJson();
+        }
+
+        [Benchmark]
+        public MinecraftVersion VersionJson()
+        {
+            return JsonSerializer.Deserialize<MinecraftVersion>(_versionJson, JsonOptions);
+        }
+
+        [Benchmark]
+        public AssetIndexDetails AssetIndex()
+        {
+            return JsonSerializer.Deserialize<AssetIndexDetails>(_assetIndexJson, JsonOptions);
+        }
+
+        /// <summary>
+        /// As <see cref="AssetIndex"/>, but with new options per call the way <c>AssetManager</c> parses indexes.
+        /// </summary>
+        [Benchmark]
+        public AssetIndexDetails AssetIndexFreshOptions()
+        {
+            return JsonSerializer.Deserialize<AssetIndexDetails>(_assetIndexJson, new JsonSerializerOptions { PropertyNameCaseInsensitive = true });
+        }
+    }
+}
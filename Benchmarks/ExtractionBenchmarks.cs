@@ -0,0 +1,65 @@
+﻿// Benchmarks/ExtractionBenchmarks.cs
+using System.Collections.Generic;
+using System.IO;
+using BenchmarkDotNet.Attributes;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Services;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// Natives jar and Java runtime extraction, under the durability modes that change how much is synced.
+    /// </summary>
+    public class ExtractionBenchmarks
+    {
+        private string _dataDir;
+        private LibraryManager _libraryManager;
+        private JavaManager _javaManager;
+        private string _nativesJar;
+        private string _nativesDir;
+        private LibraryExtractRule _extractRule;
+        private string _runtimeArchive;
+        private string _runtimeDir;
+
+        [Params(DurabilityMode.Fast, DurabilityMode.Batched)]
+        public DurabilityMode Durability { get; set; }
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _dataDir = SyntheticData.CreateTempDirectory("extract");
+            var config = new LauncherConfig(_dataDir) { Durability = Durability };
+            var httpManager = new HttpManager();
+            _libraryManager = new LibraryManager(config, httpManager);
+            _javaManager = new JavaManager(config, httpManager);
+
+            // An LWJGL-sized natives jar and a JRE-sized runtime archive.
+            _nativesJar = Path.Combine(_dataDir, "lwjgl-natives-linux.jar");
+            SyntheticData.WriteZip(_nativesJar, 24, 150_000, ".so");
+            _nativesDir = Path.Combine(_dataDir, "natives");
+            _extractRule = new LibraryExtractRule { Exclude = new List<string> { "META-INF/" } };
+            _runtimeArchive = Path.Combine(_dataDir, "runtime.zip");
+            SyntheticData.WriteZip(_runtimeArchive, 600, 40_000, ".class");
+            _runtimeDir = Path.Combine(config.JavaRuntimesDir, "bench-runtime");
+        }
+
+        [GlobalCleanup]
+        public void Cleanup()
+        {
+            Directory.Delete(_dataDir, true);
+        }
+
+        [Benchmark]
+        public bool ExtractNativeJar()
+        {
+            return _libraryManager.ExtractNativeJar(_nativesJar, _nativesDir, _extractRule);
+        }
+
+        [Benchmark]
+        public bool ExtractJavaArchive()
+        {
+            return _javaManager.ExtractJavaArchive(_runtimeArchive, _runtimeDir, "bench-runtime");
+        }
+    }
+}
@@ -0,0 +1,68 @@
+﻿// Benchmarks/HashingBenchmarks.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Threading.Tasks;
+using BenchmarkDotNet.Attributes;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// SHA-1 verification over the file size mixes a launch actually checks. The files are written once and stay in
+    /// the page cache, so this measures hashing and per-file overhead, not the disk.
+    /// </summary>
+    public class HashingBenchmarks
+    {
+        private string _dir;
+        private List<string> _paths;
+        private List<FileVerificationRequest> _requests;
+
+        [Params(FileSizeProfile.Assets, FileSizeProfile.Libraries, FileSizeProfile.ClientJar)]
+        public FileSizeProfile Profile { get; set; }
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _dir = SyntheticData.CreateTempDirectory("hash-" + Profile);
+            long[] sizes = SyntheticData.CreateFileSizes(Profile);
+            _paths = SyntheticData.WriteFiles(_dir, sizes);
+            _requests = _paths
+                .Select((path, i) => new FileVerificationRequest(path, sizes[i], Convert.ToHexString(SHA1.HashData(File.ReadAllBytes(path))).ToLowerInvariant()))
+                .ToList();
+        }
+
+        [GlobalCleanup]
+        public void Cleanup()
+        {
+            Directory.Delete(_dir, true);
+        }
+
+        /// <summary>
+        /// One <see cref="CryptoUtils.CalculateFileSHA1Async"/> per file, in sequence (a single download worker's view).
+        /// </summary>
+        [Benchmark]
+        public async Task<int> Sha1PerFile()
+        {
+            int length = 0;
+            foreach (string path in _paths)
+            {
+                length += (await CryptoUtils.CalculateFileSHA1Async(path)).Length;
+            }
+            return length;
+        }
+
+        /// <summary>
+        /// The bulk path the scheduler takes for files already on disk.
+        /// </summary>
+        [Benchmark]
+        public async Task<int> VerifyBatch()
+        {
+            FileVerificationResult[] results = await CryptoUtils.VerifyFilesAsync(_requests);
+            return results.Count(r => r.IsValid);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+﻿// Benchmarks/Program.cs
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using BenchmarkDotNet.Reports;
+using BenchmarkDotNet.Running;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// Entry point of the launcher micro-benchmarks. Arguments are passed to BenchmarkDotNet
+    /// (e.g. <c>--filter *Hashing*</c>), except <c>--save-baseline[=NAME]</c>, which copies the reports of this run
+    /// into <c>Benchmarks/baselines/NAME</c> (default: the date and machine name) so they can be committed.
+    /// </summary>
+    public static class Program
+    {
+        public static int Main(string[] args)
+        {
+            string baselineArg = args.FirstOrDefault(a => a.StartsWith("--save-baseline", StringComparison.OrdinalIgnoreCase));
+            string[] benchmarkArgs = args.Where(a => !ReferenceEquals(a, baselineArg)).ToArray();
+
+            IEnumerable<Summary> summaries = BenchmarkSwitcher.FromAssembly(typeof(Program).Assembly).Run(benchmarkArgs, BenchmarkConfig.Create());
+            List<Summary> completed = summaries.Where(s => s != null && !s.HasCriticalValidationErrors).ToList();
+            if (baselineArg == null || completed.Count == 0) return completed.Count > 0 ? 0 : 1;
+
+            int separator = baselineArg.IndexOf('=');
+            string name = separator >= 0
+                ? baselineArg.Substring(separator + 1)
+                : $"{DateTime.UtcNow.ToString("yyyy-MM-dd", CultureInfo.InvariantCulture)}-{Environment.MachineName}";
+            string baselineDir = Path.Combine(BenchmarkConfig.ProjectDirectory, "baselines", name);
+            Directory.CreateDirectory(baselineDir);
+            foreach (Summary summary in completed)
+            {
+                foreach (string suffix in new[] { "-report-github.md", "-report-full.json" })
+                {
+                    string source = Path.Combine(summary.ResultsDirectoryPath, summary.Title + suffix);
+                    if (File.Exists(source)) File.Copy(source, Path.Combine(baselineDir, summary.Title + suffix), true);
+                }
+            }
+            Console.WriteLine($"Saved baseline reports to {baselineDir}");
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+﻿// Benchmarks/RuleEvaluationBenchmarks.cs
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using BenchmarkDotNet.Attributes;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Services;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// OS and feature rule evaluation for arguments and libraries, and library resolution built on it.
+    /// </summary>
+    public class RuleEvaluationBenchmarks
+    {
+        private string _dataDir;
+        private ArgumentBuilder _argumentBuilder;
+        private LibraryManager _libraryManager;
+        private MinecraftVersion _version;
+        private JavaRuntimeInfo _runtime;
+        private List<List<ArgumentRuleCondition>> _argumentRules;
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _dataDir = SyntheticData.CreateTempDirectory("rules");
+            var config = new LauncherConfig(_dataDir);
+            _argumentBuilder = new ArgumentBuilder(config);
+            _libraryManager = new LibraryManager(config, new HttpManager());
+            _version = SyntheticData.CreateVersion();
+            _runtime = new JavaRuntimeInfo { HomePath = _dataDir, JavaExecutablePath = Path.Combine(_dataDir, "bin", "java"), MajorVersion = 21 };
+            _argumentRules = _version.Arguments.Game.Concat(_version.Arguments.Jvm)
+                .Where(a => a.IsConditional)
+                .Select(a => a.ConditionalValue.Rules)
+                .ToList();
+        }
+
+        [GlobalCleanup]
+        public void Cleanup()
+        {
+            Directory.Delete(_dataDir, true);
+        }
+
+        [Benchmark]
+        public int ArgumentRules()
+        {
+            int allowed = 0;
+            foreach (List<ArgumentRuleCondition> rules in _argumentRules)
+            {
+                if (_argumentBuilder.AreRulesSatisfied(rules, _runtime)) allowed++;
+            }
+            return allowed;
+        }
+
+        [Benchmark]
+        public int LibraryRules()
+        {
+            int applicable = 0;
+            foreach (Library library in _version.Libraries)
+            {
+                if (_libraryManager.IsLibraryApplicable(library)) applicable++;
+            }
+            return applicable;
+        }
+
+        [Benchmark]
+        public int ResolveLibraries()
+        {
+            return _libraryManager.ResolveLibraries(_version).Count;
+        }
+    }
+}
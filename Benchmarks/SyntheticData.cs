@@ -0,0 +1,279 @@
+﻿// Benchmarks/SyntheticData.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+
+namespace ObsidianLauncher.Benchmarks
+{
+    /// <summary>
+    /// Deterministic stand-ins for the metadata and files the launcher handles, shaped like a current release
+    /// (around 100 libraries with OS rules and natives, a few thousand assets, rule-guarded arguments).
+    /// Everything comes from a fixed seed so runs on different machines measure the same work.
+    /// </summary>
+    public static class SyntheticData
+    {
+        private const int Seed = 20240101;
+
+        private static readonly string[] OsNames = { "windows", "osx", "linux" };
+
+        /// <summary>
+        /// A version JSON object graph: libraries (some OS-specific, some with native classifiers),
+        /// modern <c>arguments</c> with rule-guarded entries, and a Java 21 requirement.
+        /// </summary>
+        public static MinecraftVersion CreateVersion(int libraryCount = 100)
+        {
+            var random = new Random(Seed);
+            var version = new MinecraftVersion
+            {
+                Id = "1.21.4",
+                Type = "release",
+                MainClass = "net.minecraft.client.main.Main",
+                Assets = "19",
+                ComplianceLevel = 1,
+                MinimumLauncherVersion = 21,
+                ReleaseTime = new DateTime(2024, 12, 3, 10, 12, 57, DateTimeKind.Utc),
+                Time = new DateTime(2024, 12, 3, 10, 12, 57, DateTimeKind.Utc),
+                AssetIndex = new AssetIndex { Id = "19", Sha1 = RandomSha1(random), Size = 450_000, TotalSize = 800_000_000, Url = "https://piston-meta.mojang.com/v1/packages/index/19.json" },
+                JavaVersion = new JavaVersionInfo { Component = "java-runtime-delta", MajorVersion = 21 },
+                Arguments = CreateArguments()
+            };
+            version.Downloads["client"] = new DownloadDetails { Sha1 = RandomSha1(random), Size = 27_000_000, Url = "https://piston-data.mojang.com/v1/objects/client.jar" };
+
+            for (int i = 0; i < libraryCount; i++)
+            {
+                string group = $"org.example.group{i % 12}";
+                string artifact = $"library-{i}";
+                string libVersion = $"{1 + i % 5}.{i % 10}.{i % 7}";
+                string path = $"{group.Replace('.', '/')}/{artifact}/{libVersion}/{artifact}-{libVersion}.jar";
+                var library = new Library
+                {
+                    Name = $"{group}:{artifact}:{libVersion}",
+                    Downloads = new LibraryDownloads
+                    {
+                        Artifact = new LibraryArtifact { Path = path, Sha1 = RandomSha1(random), Size = (uint)random.Next(20_000, 3_000_000), Url = "https://libraries.minecraft.net/" + path }
+                    }
+                };
+                if (i % 4 == 1)
+                {
+                    // Platform-specific library, like the per-OS LWJGL natives jars of current versions.
+                    library.Rules.Add(new Rule { Action = RuleAction.Allow, Os = new OperatingSystemInfo { Name = OsNames[i % 3] } });
+                }
+                else if (i % 9 == 2)
+                {
+                    library.Rules.Add(new Rule { Action = RuleAction.Allow });
+                    library.Rules.Add(new Rule { Action = RuleAction.Disallow, Os = new OperatingSystemInfo { Name = "osx" } });
+                }
+                if (i % 10 == 3)
+                {
+                    // Legacy native classifiers, as in versions before 1.19.
+                    foreach (string os in OsNames)
+                    {
+                        string classifier = $"natives-{os}";
+                        string nativePath = path.Replace(".jar", $"-{classifier}.jar");
+                        library.Natives[os] = classifier;
+                        library.Downloads.Classifiers[classifier] = new LibraryArtifact { Path = nativePath, Sha1 = RandomSha1(random), Size = (uint)random.Next(50_000, 900_000), Url = "https://libraries.minecraft.net/" + nativePath };
+                    }
+                    library.Extract = new LibraryExtractRule { Exclude = new List<string> { "META-INF/" } };
+                }
+                version.Libraries.Add(library);
+            }
+            return version;
+        }
+
+        /// <summary>
+        /// <see cref="CreateVersion"/> serialized the way Mojang serves it.
+        /// </summary>
+        public static string CreateVersionJson(int libraryCount = 100)
+        {
+            return JsonSerializer.Serialize(CreateVersion(libraryCount));
+        }
+
+        /// <summary>
+        /// An asset index with <paramref name="objectCount"/> objects (release indexes have around 4000).
+        /// </summary>
+        public static string CreateAssetIndexJson(int objectCount = 4000)
+        {
+            var random = new Random(Seed);
+            var index = new AssetIndexDetails();
+            for (int i = 0; i < objectCount; i++)
+            {
+                string folder = i % 3 == 0 ? "sounds" : i % 3 == 1 ? "lang" : "textures";
+                index.Objects[$"minecraft/{folder}/entry_{i}.{(folder == "sounds" ? "ogg" : folder == "lang" ? "json" : "png")}"] =
+                    new AssetObjectInfo { Hash = RandomSha1(random), Size = (ulong)AssetSize(random) };
+            }
+            return JsonSerializer.Serialize(index);
+        }
+
+        /// <summary>
+        /// The file sizes of a realistic set of files for <paramref name="profile"/>.
+        /// </summary>
+        public static long[] CreateFileSizes(FileSizeProfile profile)
+        {
+            var random = new Random(Seed);
+            switch (profile)
+            {
+                case FileSizeProfile.Assets:
+                    return Enumerable.Range(0, 2000).Select(_ => AssetSize(random)).ToArray();
+                case FileSizeProfile.Libraries:
+                    return Enumerable.Range(0, 100).Select(_ => (long)random.Next(20_000, 3_000_000)).ToArray();
+                default:
+                    return new long[] { 27_000_000 };
+            }
+        }
+
+        /// <summary>
+        /// Writes files of the given sizes with pseudo-random content into <paramref name="directory"/>.
+        /// </summary>
+        public static List<string> WriteFiles(string directory, long[] sizes)
+        {
+            Directory.CreateDirectory(directory);
+            var random = new Random(Seed);
+            var paths = new List<string>(sizes.Length);
+            byte[] buffer = new byte[1 << 20];
+            for (int i = 0; i < sizes.Length; i++)
+            {
+                string path = Path.Combine(directory, $"file_{i:D5}.bin");
+                using (var stream = new FileStream(path, FileMode.Create, FileAccess.Write))
+                {
+                    for (long remaining = sizes[i]; remaining > 0;)
+                    {
+                        int chunk = (int)Math.Min(buffer.Length, remaining);
+                        random.NextBytes(buffer.AsSpan(0, chunk));
+                        stream.Write(buffer, 0, chunk);
+                        remaining -= chunk;
+                    }
+                }
+                paths.Add(path);
+            }
+            return paths;
+        }
+
+        /// <summary>
+        /// Writes a zip shaped like a natives jar or a runtime archive: <paramref name="entryCount"/> entries of
+        /// partly compressible content spread over a few directories, plus a <c>META-INF</c> manifest.
+        /// </summary>
+        public static void WriteZip(string path, int entryCount, int averageEntryBytes, string extension)
+        {
+            var random = new Random(Seed);
+            using ZipArchive archive = ZipFile.Open(path, ZipArchiveMode.Create);
+            ZipArchiveEntry manifest = archive.CreateEntry("META-INF/MANIFEST.MF");
+            using (var writer = new StreamWriter(manifest.Open(), Encoding.ASCII))
+            {
+                writer.Write("Manifest-Version: 1.0\r\nCreated-By: benchmarks\r\n");
+            }
+            byte[] buffer = new byte[averageEntryBytes * 2];
+            for (int i = 0; i < entryCount; i++)
+            {
+                int size = random.Next(averageEntryBytes / 2, averageEntryBytes * 3 / 2);
+                // Half random, half repeated: compresses roughly like binaries do.
+                random.NextBytes(buffer.AsSpan(0, size / 2));
+                buffer.AsSpan(0, size - size / 2).CopyTo(buffer.AsSpan(size / 2));
+                ZipArchiveEntry entry = archive.CreateEntry($"dir{i % 8}/entry_{i}{extension}", CompressionLevel.Optimal);
+                using Stream stream = entry.Open();
+                stream.Write(buffer, 0, size);
+            }
+        }
+
+        /// <summary>
+        /// A fresh directory under the system temp directory.
+        /// </summary>
+        public static string CreateTempDirectory(string name)
+        {
+            string path = Path.Combine(Path.GetTempPath(), "obsidian-bench", $"{name}-{Guid.NewGuid():N}");
+            Directory.CreateDirectory(path);
+            return path;
+        }
+
+        private static VersionArguments CreateArguments()
+        {
+            var arguments = new VersionArguments();
+            foreach (string arg in new[]
+            {
+                "--username", "${auth_player_name}", "--version", "${version_name}", "--gameDir", "${game_directory}",
+                "--assetsDir", "${assets_root}", "--assetIndex", "${assets_index_name}", "--uuid", "${auth_uuid}",
+                "--accessToken", "${auth_access_token}", "--clientId", "${clientid}", "--xuid", "${auth_xuid}",
+                "--userType", "${user_type}", "--versionType", "${version_type}"
+            })
+            {
+                arguments.Game.Add(VersionArgument.Create(arg));
+            }
+            arguments.Game.Add(Conditional(new[] { "--demo" }, Feature("is_demo_user")));
+            arguments.Game.Add(Conditional(new[] { "--width", "${resolution_width}", "--height", "${resolution_height}" }, Feature("has_custom_resolution")));
+            arguments.Game.Add(Conditional(new[] { "--quickPlayPath", "${quickPlayPath}" }, Feature("has_quick_plays_support")));
+            arguments.Game.Add(Conditional(new[] { "--quickPlaySingleplayer", "${quickPlaySingleplayer}" }, Feature("is_quick_play_singleplayer")));
+            arguments.Game.Add(Conditional(new[] { "--quickPlayMultiplayer", "${quickPlayMultiplayer}" }, Feature("is_quick_play_multiplayer")));
+            arguments.Game.Add(Conditional(new[] { "--quickPlayRealms", "${quickPlayRealms}" }, Feature("is_quick_play_realms")));
+
+            arguments.Jvm.Add(Conditional(new[] { "-XstartOnFirstThread" }, Os("osx", null)));
+            arguments.Jvm.Add(Conditional(new[] { "-XX:HeapDumpPath=MojangTricksIntelDriversForPerformance_javaw.exe_minecraft.exe.heapdump" }, Os("windows", null)));
+            arguments.Jvm.Add(Conditional(new[] { "-Xss1M" }, Os(null, "x86")));
+            foreach (string arg in new[]
+            {
+                "-Djava.library.path=${natives_directory}", "-Djna.tmpdir=${natives_directory}",
+                "-Dorg.lwjgl.system.SharedLibraryExtractPath=${natives_directory}", "-Dio.netty.native.workdir=${natives_directory}",
+                "-Dminecraft.launcher.brand=${launcher_name}", "-Dminecraft.launcher.version=${launcher_version}",
+                "-cp", "${classpath}"
+            })
+            {
+                arguments.Jvm.Add(VersionArgument.Create(arg));
+            }
+            return arguments;
+        }
+
+        private static VersionArgument Conditional(string[] values, ArgumentRuleCondition rule)
+        {
+            var value = new ConditionalArgumentValue { Value = values.Length == 1 ? values[0] : values.ToList() };
+            value.Rules.Add(rule);
+            return VersionArgument.Create(value);
+        }
+
+        private static ArgumentRuleCondition Feature(string name)
+        {
+            var rule = new ArgumentRuleCondition { Action = RuleAction.Allow };
+            rule.Features[name] = true;
+            return rule;
+        }
+
+        private static ArgumentRuleCondition Os(string name, string arch)
+        {
+            return new ArgumentRuleCondition { Action = RuleAction.Allow, Os = new OperatingSystemInfo { Name = name, Arch = arch } };
+        }
+
+        // Assets are mostly small (lang files, textures) with a tail of large sounds.
+        private static long AssetSize(Random random)
+        {
+            double roll = random.NextDouble();
+            if (roll < 0.6) return random.Next(200, 8_000);
+            if (roll < 0.95) return random.Next(8_000, 120_000);
+            return random.Next(120_000, 2_500_000);
+        }
+
+        private static string RandomSha1(Random random)
+        {
+            byte[] bytes = new byte[20];
+            random.NextBytes(bytes);
+            return Convert.ToHexString(bytes).ToLowerInvariant();
+        }
+    }
+
+    /// <summary>
+    /// Size distributions of the files the launcher hashes.
+    /// </summary>
+    public enum FileSizeProfile
+    {
+        /// <summary>2000 asset objects, mostly under 8 KB with a tail of multi-megabyte sounds.</summary>
+        Assets,
+
+        /// <summary>100 library jars between 20 KB and 3 MB.</summary>
+        Libraries,
+
+        /// <summary>One 27 MB client jar.</summary>
+        ClientJar
+    }
+}
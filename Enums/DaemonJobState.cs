@@ -0,0 +1,23 @@
+﻿// Enums/DaemonJobState.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// Lifecycle of a job started through the launcher daemon.
+    /// </summary>
+    public enum DaemonJobState
+    {
+        /// <summary>
+        /// Waiting for the install running before it; the daemon installs one thing at a time.
+        /// </summary>
+        Queued,
+
+        /// <summary>
+        /// Installing, or for a launch job, installing or running the game.
+        /// </summary>
+        Running,
+
+        Succeeded,
+        Failed,
+        Cancelled
+    }
+}
@@ -0,0 +1,29 @@
+﻿// Enums/DurabilityMode.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// How hard the launcher works to make installed files survive a power loss or kernel crash.
+    /// A process crash is always safe: files are only renamed into place once complete.
+    /// </summary>
+    public enum DurabilityMode
+    {
+        /// <summary>
+        /// No fsync at all; durability is left to the OS's write-back. Intended for disposable machines
+        /// (CI images, containers) where a power loss just means starting over.
+        /// </summary>
+        Fast,
+
+        /// <summary>
+        /// Files are renamed into place immediately and fsynced in groups together with their directories.
+        /// A file is only recorded as verified in the install journal once its group has been synced, so anything
+        /// lost in a power cut is re-hashed and repaired by the next run. This is the default.
+        /// </summary>
+        Batched,
+
+        /// <summary>
+        /// Every file is fsynced before it is renamed into place and its directory is fsynced afterwards.
+        /// Slowest, but a file at its final path is always durable.
+        /// </summary>
+        Strict
+    }
+}
@@ -0,0 +1,29 @@
+﻿// Enums/FileCloneMethod.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// How <see cref="Utils.FileCloner"/> materialized a file.
+    /// </summary>
+    public enum FileCloneMethod
+    {
+        /// <summary>
+        /// Copy-on-write clone sharing the source's data blocks (btrfs/XFS <c>FICLONE</c>, APFS <c>clonefile</c>).
+        /// </summary>
+        Reflink,
+
+        /// <summary>
+        /// Second directory entry for the same file. Only used for read-only content.
+        /// </summary>
+        Hardlink,
+
+        /// <summary>
+        /// Symbolic link to the source. Only used when the caller opts in, e.g. for content-addressed files.
+        /// </summary>
+        Symlink,
+
+        /// <summary>
+        /// Plain byte copy.
+        /// </summary>
+        Copy
+    }
+}
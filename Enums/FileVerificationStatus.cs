@@ -0,0 +1,34 @@
+﻿// Enums/FileVerificationStatus.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// Outcome of checking one file in <see cref="Utils.CryptoUtils.VerifyFilesAsync"/>.
+    /// </summary>
+    public enum FileVerificationStatus
+    {
+        /// <summary>
+        /// The file exists and matches the expected size and hash.
+        /// </summary>
+        Valid,
+
+        /// <summary>
+        /// The file does not exist.
+        /// </summary>
+        Missing,
+
+        /// <summary>
+        /// The file exists but its length differs from the expected size; it was not hashed.
+        /// </summary>
+        SizeMismatch,
+
+        /// <summary>
+        /// The file was hashed and the hash differs from the expected one.
+        /// </summary>
+        HashMismatch,
+
+        /// <summary>
+        /// The file could not be read (permissions, I/O error) or the expected hash is malformed.
+        /// </summary>
+        Error
+    }
+}
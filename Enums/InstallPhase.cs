@@ -0,0 +1,24 @@
+﻿// Enums/InstallPhase.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// The steps of executing an install plan, in the order they run.
+    /// </summary>
+    public enum InstallPhase
+    {
+        /// <summary>
+        /// Selecting, and if needed downloading and extracting, the Java runtime.
+        /// </summary>
+        Runtime,
+
+        /// <summary>
+        /// Verifying and downloading the client JAR, libraries and assets.
+        /// </summary>
+        Files,
+
+        /// <summary>
+        /// Building the library classpath and extracting natives.
+        /// </summary>
+        Libraries
+    }
+}
@@ -0,0 +1,14 @@
+﻿// Enums/InstallPhaseState.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// Where an <see cref="InstallPhase"/> stands within a run.
+    /// </summary>
+    public enum InstallPhaseState
+    {
+        Pending,
+        Running,
+        Completed,
+        Failed
+    }
+}
@@ -0,0 +1,35 @@
+﻿// Enums/InstallWorkKind.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// The kind of file an install work item produces.
+    /// Used for deduplication, logging and per-kind statistics.
+    /// </summary>
+    public enum InstallWorkKind
+    {
+        /// <summary>
+        /// An asset index JSON (assets/indexes/&lt;id&gt;.json).
+        /// </summary>
+        AssetIndex,
+
+        /// <summary>
+        /// A hash-addressed asset object (assets/objects/xx/&lt;hash&gt;).
+        /// </summary>
+        Asset,
+
+        /// <summary>
+        /// A library JAR that goes on the classpath.
+        /// </summary>
+        Library,
+
+        /// <summary>
+        /// A native classifier JAR that gets extracted into the natives directory.
+        /// </summary>
+        NativeLibrary,
+
+        /// <summary>
+        /// The Minecraft client JAR for a version.
+        /// </summary>
+        ClientJar
+    }
+}
@@ -0,0 +1,21 @@
+﻿// Enums/IoBackend.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// How bulk verification and small-file writes reach the disk.
+    /// </summary>
+    public enum IoBackend
+    {
+        /// <summary>
+        /// One open, read or write and close per file through the regular .NET file APIs. This is the default.
+        /// </summary>
+        Default,
+
+        /// <summary>
+        /// Files are opened, read or written, and closed in batches through a Linux io_uring, so a batch of small files
+        /// costs a few system calls instead of several per file. Falls back to <see cref="Default"/> when io_uring is
+        /// not available (other platforms, old kernels, or io_uring disabled for the process).
+        /// </summary>
+        IoUring
+    }
+}
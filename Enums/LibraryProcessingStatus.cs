@@ -0,0 +1,26 @@
+﻿// Enums/LibraryProcessingStatus.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// What happened to a library during classpath and natives processing.
+    /// </summary>
+    public enum LibraryProcessingStatus
+    {
+        /// <summary>
+        /// The library's rules exclude it on this OS.
+        /// </summary>
+        Skipped,
+
+        /// <summary>
+        /// Its natives are being extracted; the library's final status follows.
+        /// </summary>
+        ExtractingNatives,
+
+        Processed,
+
+        /// <summary>
+        /// Its artifact or native JAR is missing, or extraction failed.
+        /// </summary>
+        Failed
+    }
+}
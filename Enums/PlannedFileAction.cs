@@ -0,0 +1,26 @@
+﻿// Enums/PlannedFileAction.cs
+namespace ObsidianLauncher.Enums
+{
+    /// <summary>
+    /// What an install plan expects to do with a file, decided from metadata, the install journal and a stat call only.
+    /// </summary>
+    public enum PlannedFileAction
+    {
+        /// <summary>
+        /// The file is missing or has the wrong size and will be downloaded.
+        /// </summary>
+        Download,
+
+        /// <summary>
+        /// The file exists with the expected size but is not vouched for by the journal; its hash will be re-verified
+        /// (and the file re-downloaded on mismatch).
+        /// </summary>
+        Verify,
+
+        /// <summary>
+        /// The file exists and either has no hash to check it against or the install journal recorded it as verified
+        /// and it has not changed since; it is used without hashing.
+        /// </summary>
+        Keep
+    }
+}
@@ -0,0 +1,414 @@
+﻿// Harness/CdnContent.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Text.Encodings.Web;
+using System.Text.Json;
+using System.Text.Json.Nodes;
+using System.Text.RegularExpressions;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// The files the stand-in CDN serves, keyed by <c>/{upstream host}/{upstream path}</c>: an upstream URL
+    /// <c>https://libraries.minecraft.net/a/b.jar</c> is served as <c>{base}/libraries.minecraft.net/a/b.jar</c>, so one
+    /// listener stands in for every Mojang and Adoptium host and the metadata only needs its URLs rewritten.
+    /// </summary>
+    public sealed class CdnContent
+    {
+        private static readonly JsonSerializerOptions RelaxedJson = new JsonSerializerOptions { Encoder = JavaScriptEncoder.UnsafeRelaxedJsonEscaping };
+        private static readonly Regex UpstreamUrl = new Regex(@"https://([A-Za-z0-9.-]+)/", RegexOptions.Compiled);
+
+        private readonly Dictionary<string, byte[]> _files = new Dictionary<string, byte[]>(StringComparer.Ordinal);
+
+        private CdnContent(string baseUrl, string versionId)
+        {
+            BaseUrl = baseUrl.TrimEnd('/');
+            VersionId = versionId;
+        }
+
+        /// <summary>
+        /// <c>http://127.0.0.1:PORT</c>, without a trailing slash.
+        /// </summary>
+        public string BaseUrl { get; }
+
+        /// <summary>
+        /// The version the launcher is asked to install.
+        /// </summary>
+        public string VersionId { get; }
+
+        public int FileCount => _files.Count;
+
+        public long TotalBytes => _files.Values.Sum(f => (long)f.Length);
+
+        public bool TryGet(string path, out byte[] body) => _files.TryGetValue(path, out body);
+
+        /// <summary>
+        /// Where the stand-in serves <paramref name="upstreamUrl"/> (the query string is dropped).
+        /// </summary>
+        public string MapUrl(string upstreamUrl)
+        {
+            var uri = new Uri(upstreamUrl);
+            return $"{BaseUrl}/{uri.Host}{uri.AbsolutePath}";
+        }
+
+        /// <summary>
+        /// The endpoint flags that point the launcher at this content.
+        /// </summary>
+        public IReadOnlyList<string> LauncherArguments => new[]
+        {
+            "--version-manifest-url=" + MapUrl(LauncherConfig.DefaultVersionManifestUrl),
+            "--assets-url=" + MapUrl(LauncherConfig.DefaultAssetResourcesUrl),
+            "--java-manifest-url=" + MapUrl(LauncherConfig.DefaultJavaRuntimeManifestUrl),
+            "--adoptium-url=" + MapUrl(LauncherConfig.DefaultAdoptiumApiUrl)
+        };
+
+        /// <summary>
+        /// A deterministic version shaped like a current release: a manifest, a version JSON with OS-specific and native
+        /// libraries, an asset index with mostly small objects and a tail of large ones, a client jar, and a Java runtime
+        /// zip announced by both the Adoptium API and Mojang's runtime manifest.
+        /// </summary>
+        public static CdnContent CreateSynthetic(string baseUrl, SyntheticContentOptions options)
+        {
+            var content = new CdnContent(baseUrl, options.VersionId);
+            var random = new Random(options.Seed);
+
+            // Asset objects and their index.
+            var index = new AssetIndexDetails();
+            long assetBytes = 0;
+            for (int i = 0; i < options.AssetCount; i++)
+            {
+                byte[] body = RandomBytes(random, AssetSize(random));
+                string hash = Sha1(body);
+                content.Add($"{LauncherConfig.DefaultAssetResourcesUrl}{hash.Substring(0, 2)}/{hash}", body);
+                string folder = i % 3 == 0 ? "sounds" : i % 3 == 1 ? "lang" : "textures";
+                index.Objects[$"minecraft/{folder}/entry_{i}"] = new AssetObjectInfo { Hash = hash, Size = (ulong)body.Length };
+                assetBytes += body.Length;
+            }
+            byte[] indexBody = JsonSerializer.SerializeToUtf8Bytes(index);
+            string indexUrl = content.Add($"https://piston-meta.mojang.com/v1/packages/{Sha1(indexBody)}/{options.AssetIndexId}.json", indexBody);
+
+            var version = new MinecraftVersion
+            {
+                Id = options.VersionId,
+                Type = "release",
+                MainClass = "net.minecraft.client.main.Main",
+                Assets = options.AssetIndexId,
+                ComplianceLevel = 1,
+                MinimumLauncherVersion = 21,
+                ReleaseTime = new DateTime(2024, 12, 3, 10, 12, 57, DateTimeKind.Utc),
+                Time = new DateTime(2024, 12, 3, 10, 12, 57, DateTimeKind.Utc),
+                AssetIndex = new AssetIndex { Id = options.AssetIndexId, Sha1 = Sha1(indexBody), Size = (ulong)indexBody.Length, TotalSize = (ulong)assetBytes, Url = indexUrl },
+                JavaVersion = new JavaVersionInfo { Component = "java-runtime-delta", MajorVersion = options.JavaMajorVersion },
+                Arguments = CreateArguments()
+            };
+
+            byte[] client = RandomBytes(random, options.ClientJarBytes);
+            version.Downloads["client"] = new DownloadDetails
+            {
+                Sha1 = Sha1(client),
+                Size = (uint)client.Length,
+                Url = content.Add($"https://piston-data.mojang.com/v1/objects/{Sha1(client)}/client.jar", client)
+            };
+
+            string[] osNames = { "windows", "osx", "linux" };
+            for (int i = 0; i < options.LibraryCount; i++)
+            {
+                string group = $"org.example.group{i % 12}";
+                string artifact = $"library-{i}";
+                string libVersion = $"{1 + i % 5}.{i % 10}.{i % 7}";
+                string path = $"{group.Replace('.', '/')}/{artifact}/{libVersion}/{artifact}-{libVersion}.jar";
+                byte[] jar = RandomBytes(random, random.Next(20_000, 1_500_000));
+                var library = new Library
+                {
+                    Name = $"{group}:{artifact}:{libVersion}",
+                    Downloads = new LibraryDownloads
+                    {
+                        Artifact = new LibraryArtifact { Path = path, Sha1 = Sha1(jar), Size = (uint)jar.Length, Url = content.Add("https://libraries.minecraft.net/" + path, jar) }
+                    }
+                };
+                if (i % 5 == 1)
+                {
+                    // Platform-specific jar, like the per-OS LWJGL natives of current versions; only one OS downloads it.
+                    library.Rules.Add(new Rule { Action = RuleAction.Allow, Os = new OperatingSystemInfo { Name = osNames[i % 3] } });
+                }
+                if (i % 10 == 3)
+                {
+                    // Legacy native classifiers, extracted into the natives directory.
+                    foreach (string os in osNames)
+                    {
+                        string classifier = $"natives-{os}";
+                        string nativePath = path.Replace(".jar", $"-{classifier}.jar");
+                        byte[] nativeJar = CreateZip(random, $"{artifact}-{os}", 6, 40_000);
+                        library.Natives[os] = classifier;
+                        library.Downloads.Classifiers[classifier] = new LibraryArtifact
+                        {
+                            Path = nativePath, Sha1 = Sha1(nativeJar), Size = (uint)nativeJar.Length,
+                            Url = content.Add("https://libraries.minecraft.net/" + nativePath, nativeJar)
+                        };
+                    }
+                    library.Extract = new LibraryExtractRule { Exclude = new List<string> { "META-INF/" } };
+                }
+                version.Libraries.Add(library);
+            }
+
+            byte[] versionBody = JsonSerializer.SerializeToUtf8Bytes(version);
+            string versionUrl = content.Add($"https://piston-meta.mojang.com/v1/packages/{Sha1(versionBody)}/{options.VersionId}.json", versionBody);
+
+            var manifest = new VersionManifest { Latest = new LatestVersionInfo { Release = options.VersionId, Snapshot = options.VersionId } };
+            manifest.Versions.Add(new VersionMetadata
+            {
+                Id = options.VersionId, Type = "release", Url = versionUrl, Sha1 = Sha1(versionBody), ComplianceLevel = 1,
+                Time = version.Time, ReleaseTime = version.ReleaseTime
+            });
+            content.Add(LauncherConfig.DefaultVersionManifestUrl, JsonSerializer.SerializeToUtf8Bytes(manifest));
+
+            content.AddJavaRuntime(random, options);
+            return content;
+        }
+
+        /// <summary>
+        /// Loads a recording made by <see cref="ContentRecorder"/> (<c>{directory}/{host}/{path}</c>). Upstream URLs in
+        /// JSON files are rewritten to the stand-in, and the SHA1s and sizes that refer to rewritten files are updated.
+        /// </summary>
+        public static CdnContent LoadRecorded(string baseUrl, string directory, string versionId)
+        {
+            var content = new CdnContent(baseUrl, versionId);
+            var jsonPaths = new List<string>();
+            foreach (string file in Directory.EnumerateFiles(directory, "*", SearchOption.AllDirectories))
+            {
+                string key = "/" + Path.GetRelativePath(directory, file).Replace(Path.DirectorySeparatorChar, '/');
+                byte[] body = File.ReadAllBytes(file);
+                if (LooksLikeJson(body))
+                {
+                    string text = UpstreamUrl.Replace(Encoding.UTF8.GetString(body), content.BaseUrl + "/$1/");
+                    body = Encoding.UTF8.GetBytes(text);
+                    jsonPaths.Add(key);
+                }
+                content._files[key] = body;
+            }
+
+            // A manifest lists the SHA1 of each version JSON, which lists that of its asset index, and so on; updating a
+            // file changes its own hash, so repeat until nothing changes (the chains are at most three deep).
+            for (int pass = 0; pass < 5; pass++)
+            {
+                bool changed = false;
+                foreach (string key in jsonPaths)
+                {
+                    JsonNode root;
+                    try
+                    {
+                        root = JsonNode.Parse(content._files[key]);
+                    }
+                    catch (JsonException)
+                    {
+                        continue;
+                    }
+                    if (root != null && content.FixDigests(root))
+                    {
+                        content._files[key] = Encoding.UTF8.GetBytes(root.ToJsonString(RelaxedJson));
+                        changed = true;
+                    }
+                }
+                if (!changed) break;
+            }
+            return content;
+        }
+
+        private string Add(string upstreamUrl, byte[] body)
+        {
+            var uri = new Uri(upstreamUrl);
+            _files[$"/{uri.Host}{uri.AbsolutePath}"] = body;
+            return MapUrl(upstreamUrl);
+        }
+
+        private void AddJavaRuntime(Random random, SyntheticContentOptions options)
+        {
+            string release = $"jdk-{options.JavaMajorVersion}.0.5_11-jre";
+            byte[] runtime;
+            using (var buffer = new MemoryStream())
+            {
+                using (var archive = new ZipArchive(buffer, ZipArchiveMode.Create, true))
+                {
+                    AddZipEntry(archive, $"{release}/release", Encoding.ASCII.GetBytes($"JAVA_VERSION=\"{options.JavaMajorVersion}.0.5\"\n"));
+                    // A launcher only needs the executable to exist for an install to complete.
+                    foreach (string exe in new[] { "java", "java.exe", "javaw.exe" })
+                    {
+                        AddZipEntry(archive, $"{release}/bin/{exe}", Encoding.ASCII.GetBytes("#!/bin/sh\nexit 0\n"));
+                    }
+                    int modules = Math.Max(1, (int)(options.JavaRuntimeBytes / 256_000));
+                    for (int i = 0; i < modules; i++)
+                    {
+                        AddZipEntry(archive, $"{release}/lib/module_{i}.bin", RandomBytes(random, 256_000));
+                    }
+                }
+                runtime = buffer.ToArray();
+            }
+
+            string packageName = $"OpenJDK{options.JavaMajorVersion}U-jre_harness_{options.JavaMajorVersion}.0.5_11.zip";
+            string runtimeUrl = Add($"https://github.com/adoptium/temurin{options.JavaMajorVersion}-binaries/releases/download/{release}/{packageName}", runtime);
+
+            var adoptium = new JsonArray(new JsonObject
+            {
+                ["binary"] = new JsonObject
+                {
+                    ["image_type"] = "jre",
+                    ["package"] = new JsonObject
+                    {
+                        ["link"] = runtimeUrl,
+                        ["name"] = packageName,
+                        ["checksum"] = Convert.ToHexString(SHA256.HashData(runtime)).ToLowerInvariant(),
+                        ["size"] = runtime.Length
+                    }
+                },
+                ["release_name"] = release
+            });
+            Add($"{LauncherConfig.DefaultAdoptiumApiUrl}/assets/latest/{options.JavaMajorVersion}/hotspot", Encoding.UTF8.GetBytes(adoptium.ToJsonString(RelaxedJson)));
+
+            // Mojang's runtime manifest is the launcher's fallback; it downloads the entry's "manifest" URL as the archive.
+            var runtimes = new JsonObject();
+            foreach (string osArch in new[] { "gamecore", "linux", "linux-i386", "mac-os", "mac-os-arm64", "windows-arm64", "windows-x64", "windows-x86" })
+            {
+                runtimes[osArch] = new JsonObject
+                {
+                    ["java-runtime-delta"] = new JsonArray(new JsonObject
+                    {
+                        ["manifest"] = new JsonObject { ["sha1"] = Sha1(runtime), ["size"] = runtime.Length, ["url"] = runtimeUrl },
+                        ["version"] = new JsonObject { ["name"] = $"{options.JavaMajorVersion}.0.5", ["released"] = "2024-10-15T00:00:00+00:00" }
+                    })
+                };
+            }
+            Add(LauncherConfig.DefaultJavaRuntimeManifestUrl, Encoding.UTF8.GetBytes(runtimes.ToJsonString(RelaxedJson)));
+        }
+
+        // Updates "sha1" (and "size") next to every "url" that points at a file of this content.
+        private bool FixDigests(JsonNode node)
+        {
+            bool changed = false;
+            if (node is JsonObject obj)
+            {
+                if (obj["url"] is JsonValue urlValue && urlValue.TryGetValue(out string url) &&
+                    url.StartsWith(BaseUrl + "/", StringComparison.Ordinal) &&
+                    obj["sha1"] is JsonValue sha1Value && sha1Value.TryGetValue(out string listedSha1) &&
+                    _files.TryGetValue(new Uri(url).AbsolutePath, out byte[] body))
+                {
+                    string sha1 = Sha1(body);
+                    if (listedSha1 != sha1)
+                    {
+                        obj["sha1"] = sha1;
+                        if (obj.ContainsKey("size")) obj["size"] = body.Length;
+                        changed = true;
+                    }
+                }
+                foreach (KeyValuePair<string, JsonNode> property in obj.ToList())
+                {
+                    if (property.Value != null) changed |= FixDigests(property.Value);
+                }
+            }
+            else if (node is JsonArray array)
+            {
+                foreach (JsonNode item in array)
+                {
+                    if (item != null) changed |= FixDigests(item);
+                }
+            }
+            return changed;
+        }
+
+        // Binaries can start with '{' too, so a cheap first-byte check is followed by a full parse.
+        private static bool LooksLikeJson(byte[] body)
+        {
+            int start = 0;
+            while (start < body.Length && (body[start] == ' ' || body[start] == '\t' || body[start] == '\r' || body[start] == '\n')) start++;
+            if (start == body.Length || (body[start] != '{' && body[start] != '[')) return false;
+            try
+            {
+                using JsonDocument document = JsonDocument.Parse(body);
+                return true;
+            }
+            catch (JsonException)
+            {
+                return false;
+            }
+        }
+
+        private static VersionArguments CreateArguments()
+        {
+            var arguments = new VersionArguments();
+            foreach (string arg in new[]
+            {
+                "--username", "${auth_player_name}", "--version", "${version_name}", "--gameDir", "${game_directory}",
+                "--assetsDir", "${assets_root}", "--assetIndex", "${assets_index_name}", "--uuid", "${auth_uuid}",
+                "--accessToken", "${auth_access_token}", "--userType", "${user_type}", "--versionType", "${version_type}"
+            })
+            {
+                arguments.Game.Add(VersionArgument.Create(arg));
+            }
+            foreach (string arg in new[] { "-Djava.library.path=${natives_directory}", "-cp", "${classpath}" })
+            {
+                arguments.Jvm.Add(VersionArgument.Create(arg));
+            }
+            return arguments;
+        }
+
+        private static byte[] CreateZip(Random random, string name, int entryCount, int averageEntryBytes)
+        {
+            using var buffer = new MemoryStream();
+            using (var archive = new ZipArchive(buffer, ZipArchiveMode.Create, true))
+            {
+                AddZipEntry(archive, "META-INF/MANIFEST.MF", Encoding.ASCII.GetBytes("Manifest-Version: 1.0\r\n"));
+                for (int i = 0; i < entryCount; i++)
+                {
+                    AddZipEntry(archive, $"{name}_{i}.so", RandomBytes(random, random.Next(averageEntryBytes / 2, averageEntryBytes * 3 / 2)));
+                }
+            }
+            return buffer.ToArray();
+        }
+
+        private static void AddZipEntry(ZipArchive archive, string name, byte[] body)
+        {
+            using Stream stream = archive.CreateEntry(name, CompressionLevel.Fastest).Open();
+            stream.Write(body, 0, body.Length);
+        }
+
+        // Mostly small objects (lang files, textures) with a tail of large sounds, as in release asset indexes.
+        private static int AssetSize(Random random)
+        {
+            double roll = random.NextDouble();
+            if (roll < 0.6) return random.Next(200, 8_000);
+            if (roll < 0.95) return random.Next(8_000, 64_000);
+            return random.Next(64_000, 1_000_000);
+        }
+
+        private static byte[] RandomBytes(Random random, long length)
+        {
+            byte[] bytes = new byte[length];
+            random.NextBytes(bytes);
+            return bytes;
+        }
+
+        private static string Sha1(byte[] body) => Convert.ToHexString(SHA1.HashData(body)).ToLowerInvariant();
+    }
+
+    /// <summary>
+    /// Size and shape of the synthetic version (<c>--version=</c>, <c>--assets=</c>, <c>--libraries=</c>,
+    /// <c>--client-mb=</c>, <c>--java-mb=</c>, <c>--seed=</c>).
+    /// </summary>
+    public sealed class SyntheticContentOptions
+    {
+        public string VersionId { get; set; } = "1.21.4";
+        public string AssetIndexId { get; set; } = "19";
+        public int AssetCount { get; set; } = 2000;
+        public int LibraryCount { get; set; } = 80;
+        public long ClientJarBytes { get; set; } = 20L * 1024 * 1024;
+        public long JavaRuntimeBytes { get; set; } = 16L * 1024 * 1024;
+        public uint JavaMajorVersion { get; set; } = 21;
+        public int Seed { get; set; } = 20240101;
+    }
+}
@@ -0,0 +1,123 @@
+﻿// Harness/ContentRecorder.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Runtime.InteropServices;
+using System.Text.Json.Nodes;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// Records what a real install of one version fetches (the version manifest, the version JSON, its libraries, client
+    /// jar, asset index and asset objects, Mojang's runtime manifest, and this machine's Adoptium runtime) into
+    /// <c>{directory}/{host}/{path}</c>, for <see cref="CdnContent.LoadRecorded"/> to replay. Files already present are
+    /// kept, so an interrupted recording can be re-run.
+    /// </summary>
+    public sealed class ContentRecorder
+    {
+        private readonly HttpClient _http;
+        private readonly string _directory;
+
+        public ContentRecorder(HttpClient http, string directory)
+        {
+            _http = http ?? throw new ArgumentNullException(nameof(http));
+            _directory = directory ?? throw new ArgumentNullException(nameof(directory));
+        }
+
+        /// <summary>
+        /// Records <paramref name="versionId"/> and returns the number of files stored, or -1 if the version was not found.
+        /// </summary>
+        public async Task<int> RecordAsync(string versionId, CancellationToken cancellationToken)
+        {
+            JsonNode manifest = JsonNode.Parse(await FetchAsync(LauncherConfig.DefaultVersionManifestUrl, true, cancellationToken));
+            string versionUrl = manifest?["versions"]?.AsArray()
+                .FirstOrDefault(v => (string)v?["id"] == versionId)?["url"]?.GetValue<string>();
+            if (versionUrl == null) return -1;
+
+            JsonNode version = JsonNode.Parse(await FetchAsync(versionUrl, false, cancellationToken));
+            var urls = new List<string>();
+            CollectUrls(version?["downloads"], urls);
+            CollectUrls(version?["libraries"], urls);
+            CollectUrls(version?["logging"], urls);
+
+            string assetIndexUrl = version?["assetIndex"]?["url"]?.GetValue<string>();
+            if (assetIndexUrl != null)
+            {
+                JsonNode assetIndex = JsonNode.Parse(await FetchAsync(assetIndexUrl, false, cancellationToken));
+                foreach (KeyValuePair<string, JsonNode> asset in assetIndex?["objects"]?.AsObject() ?? new JsonObject())
+                {
+                    string hash = asset.Value?["hash"]?.GetValue<string>();
+                    if (hash != null) urls.Add($"{LauncherConfig.DefaultAssetResourcesUrl}{hash.Substring(0, 2)}/{hash}");
+                }
+            }
+
+            await FetchAsync(LauncherConfig.DefaultJavaRuntimeManifestUrl, true, cancellationToken);
+            uint javaMajor = version?["javaVersion"]?["majorVersion"]?.GetValue<uint>() ?? 8;
+            string adoptiumUrl = $"{LauncherConfig.DefaultAdoptiumApiUrl}/assets/latest/{javaMajor}/hotspot" +
+                                 $"?architecture={AdoptiumArch()}&heap_size=normal&image_type=jre&os={AdoptiumOs()}&vendor=eclipse";
+            JsonNode adoptium = JsonNode.Parse(await FetchAsync(adoptiumUrl, true, cancellationToken));
+            string runtimeUrl = adoptium is JsonArray builds && builds.Count > 0 ? builds[0]?["binary"]?["package"]?["link"]?.GetValue<string>() : null;
+            if (runtimeUrl != null) urls.Add(runtimeUrl);
+
+            await Parallel.ForEachAsync(urls.Distinct(StringComparer.Ordinal),
+                new ParallelOptions { MaxDegreeOfParallelism = 8, CancellationToken = cancellationToken },
+                async (url, ct) => await FetchAsync(url, false, ct));
+            return Directory.EnumerateFiles(_directory, "*", SearchOption.AllDirectories).Count();
+        }
+
+        // Stores the body of an upstream URL (reusing a stored copy unless refresh is set) and returns it.
+        private async Task<byte[]> FetchAsync(string url, bool refresh, CancellationToken cancellationToken)
+        {
+            var uri = new Uri(url);
+            string path = Path.Combine(_directory, uri.Host, uri.AbsolutePath.TrimStart('/').Replace('/', Path.DirectorySeparatorChar));
+            if (!refresh && File.Exists(path)) return await File.ReadAllBytesAsync(path, cancellationToken);
+
+            byte[] body = await _http.GetByteArrayAsync(uri, cancellationToken);
+            Directory.CreateDirectory(Path.GetDirectoryName(path));
+            string temporary = path + ".part";
+            await File.WriteAllBytesAsync(temporary, body, cancellationToken);
+            File.Move(temporary, path, true);
+            Console.WriteLine($"  {body.Length,12:N0} B  {url}");
+            return body;
+        }
+
+        // Every "url" string under a node (download entries, library artifacts and classifiers, logging configs).
+        private static void CollectUrls(JsonNode node, List<string> urls)
+        {
+            if (node is JsonObject obj)
+            {
+                foreach (KeyValuePair<string, JsonNode> property in obj)
+                {
+                    if (property.Key == "url" && property.Value is JsonValue value && value.TryGetValue(out string url)) urls.Add(url);
+                    else CollectUrls(property.Value, urls);
+                }
+            }
+            else if (node is JsonArray array)
+            {
+                foreach (JsonNode item in array) CollectUrls(item, urls);
+            }
+        }
+
+        private static string AdoptiumOs()
+        {
+            if (OperatingSystem.IsWindows()) return "windows";
+            if (OperatingSystem.IsMacOS()) return "mac";
+            return "linux";
+        }
+
+        private static string AdoptiumArch()
+        {
+            switch (RuntimeInformation.OSArchitecture)
+            {
+                case Architecture.Arm64: return "aarch64";
+                case Architecture.X86: return "x32";
+                case Architecture.Arm: return "arm";
+                default: return "x64";
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+﻿// Harness/Distribution.cs
+using System;
+using System.Collections.Generic;
+using System.Linq;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// Summary statistics of a set of measurements (seconds, characters, ...).
+    /// </summary>
+    public sealed class Distribution
+    {
+        public int Count { get; set; }
+        public double Mean { get; set; }
+        public double Min { get; set; }
+        public double Median { get; set; }
+        public double P90 { get; set; }
+        public double P99 { get; set; }
+        public double Max { get; set; }
+
+        public static Distribution Of(IEnumerable<double> values)
+        {
+            double[] sorted = values.OrderBy(v => v).ToArray();
+            if (sorted.Length == 0) return new Distribution();
+            return new Distribution
+            {
+                Count = sorted.Length,
+                Mean = sorted.Average(),
+                Min = sorted[0],
+                Median = Percentile(sorted, 0.5),
+                P90 = Percentile(sorted, 0.9),
+                P99 = Percentile(sorted, 0.99),
+                Max = sorted[^1]
+            };
+        }
+
+        /// <summary>
+        /// The <paramref name="quantile"/> of ascending <paramref name="sorted"/> values, interpolating between
+        /// neighbours; 0 when there are none.
+        /// </summary>
+        public static double Percentile(double[] sorted, double quantile)
+        {
+            if (sorted.Length == 0) return 0;
+            double position = (sorted.Length - 1) * quantile;
+            int lower = (int)Math.Floor(position);
+            int upper = Math.Min(lower + 1, sorted.Length - 1);
+            return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - lower);
+        }
+    }
+}
@@ -0,0 +1,293 @@
+﻿// Harness/FakeCdn.cs
+using System;
+using System.Diagnostics;
+using System.IO;
+using System.Net;
+using System.Net.Sockets;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// Network conditions of the stand-in CDN (<c>--latency-ms=</c>, <c>--jitter-ms=</c>, <c>--bandwidth-mbps=</c>,
+    /// <c>--error-rate=</c>, <c>--drop-rate=</c>, <c>--no-ranges</c>, <c>--seed=</c>).
+    /// </summary>
+    public sealed class FakeCdnOptions
+    {
+        /// <summary>
+        /// Delay before each response's headers, like a round trip to a distant edge.
+        /// </summary>
+        public TimeSpan Latency { get; set; }
+
+        /// <summary>
+        /// Up to this much extra delay, drawn uniformly per request.
+        /// </summary>
+        public TimeSpan LatencyJitter { get; set; }
+
+        /// <summary>
+        /// Bandwidth of the simulated link, shared by all connections; 0 is unlimited.
+        /// </summary>
+        public long BytesPerSecond { get; set; }
+
+        /// <summary>
+        /// Fraction of requests for existing files answered with 503 Service Unavailable.
+        /// </summary>
+        public double ErrorRate { get; set; }
+
+        /// <summary>
+        /// Fraction of responses cut off half way through the body.
+        /// </summary>
+        public double DropRate { get; set; }
+
+        /// <summary>
+        /// Whether Range requests get 206 Partial Content; when false the whole file is sent with 200, as some mirrors do.
+        /// </summary>
+        public bool SupportRanges { get; set; } = true;
+
+        public int Seed { get; set; } = 1;
+    }
+
+    /// <summary>
+    /// Counters of what the stand-in CDN served; <see cref="Subtract"/> gives the share of one launcher run.
+    /// </summary>
+    public readonly struct CdnStats
+    {
+        public long Requests { get; init; }
+        public long BytesSent { get; init; }
+        public long NotFound { get; init; }
+        public long RangeRequests { get; init; }
+        public long InjectedErrors { get; init; }
+        public long DroppedResponses { get; init; }
+
+        public CdnStats Subtract(CdnStats earlier) => new CdnStats
+        {
+            Requests = Requests - earlier.Requests,
+            BytesSent = BytesSent - earlier.BytesSent,
+            NotFound = NotFound - earlier.NotFound,
+            RangeRequests = RangeRequests - earlier.RangeRequests,
+            InjectedErrors = InjectedErrors - earlier.InjectedErrors,
+            DroppedResponses = DroppedResponses - earlier.DroppedResponses
+        };
+    }
+
+    /// <summary>
+    /// Serves a <see cref="CdnContent"/> on <c>http://127.0.0.1:PORT/</c> with configurable latency, bandwidth,
+    /// injected errors and dropped connections, and byte ranges for resumed downloads.
+    /// </summary>
+    public sealed class FakeCdn : IDisposable
+    {
+        private const int ChunkSize = 64 * 1024;
+
+        private readonly CdnContent _content;
+        private readonly FakeCdnOptions _options;
+        private readonly HttpListener _listener = new HttpListener();
+        private readonly Random _random;
+        private readonly object _throttleLock = new object();
+        private long _throttleNext;
+
+        private long _requests;
+        private long _bytesSent;
+        private long _notFound;
+        private long _rangeRequests;
+        private long _injectedErrors;
+        private long _droppedResponses;
+
+        public FakeCdn(CdnContent content, FakeCdnOptions options, int port)
+        {
+            _content = content ?? throw new ArgumentNullException(nameof(content));
+            _options = options ?? throw new ArgumentNullException(nameof(options));
+            _random = new Random(options.Seed);
+            _listener.Prefixes.Add($"http://127.0.0.1:{port}/");
+        }
+
+        /// <summary>
+        /// A port that was free a moment ago, for <see cref="CdnContent"/> URLs that must be known before the listener starts.
+        /// </summary>
+        public static int FindFreePort()
+        {
+            var probe = new TcpListener(IPAddress.Loopback, 0);
+            probe.Start();
+            int port = ((IPEndPoint)probe.LocalEndpoint).Port;
+            probe.Stop();
+            return port;
+        }
+
+        public CdnStats Stats => new CdnStats
+        {
+            Requests = Interlocked.Read(ref _requests),
+            BytesSent = Interlocked.Read(ref _bytesSent),
+            NotFound = Interlocked.Read(ref _notFound),
+            RangeRequests = Interlocked.Read(ref _rangeRequests),
+            InjectedErrors = Interlocked.Read(ref _injectedErrors),
+            DroppedResponses = Interlocked.Read(ref _droppedResponses)
+        };
+
+        /// <summary>
+        /// Starts accepting requests; each is handled on the thread pool until <see cref="Dispose"/>.
+        /// </summary>
+        public void Start()
+        {
+            _listener.Start();
+            _ = Task.Run(AcceptLoopAsync);
+        }
+
+        public void Dispose()
+        {
+            _listener.Close();
+        }
+
+        private async Task AcceptLoopAsync()
+        {
+            while (_listener.IsListening)
+            {
+                HttpListenerContext context;
+                try
+                {
+                    context = await _listener.GetContextAsync().ConfigureAwait(false);
+                }
+                catch (Exception ex) when (ex is HttpListenerException || ex is ObjectDisposedException || ex is InvalidOperationException)
+                {
+                    return;
+                }
+                _ = Task.Run(() => RespondAsync(context));
+            }
+        }
+
+        private async Task RespondAsync(HttpListenerContext context)
+        {
+            HttpListenerRequest request = context.Request;
+            HttpListenerResponse response = context.Response;
+            Interlocked.Increment(ref _requests);
+            bool aborted = false;
+            try
+            {
+                TimeSpan delay = _options.Latency + TimeSpan.FromTicks((long)(_options.LatencyJitter.Ticks * NextDouble()));
+                if (delay > TimeSpan.Zero) await Task.Delay(delay).ConfigureAwait(false);
+
+                if (request.HttpMethod != "GET" && request.HttpMethod != "HEAD")
+                {
+                    response.StatusCode = (int)HttpStatusCode.MethodNotAllowed;
+                    return;
+                }
+                if (!_content.TryGet(request.Url.AbsolutePath, out byte[] body))
+                {
+                    Interlocked.Increment(ref _notFound);
+                    response.StatusCode = (int)HttpStatusCode.NotFound;
+                    return;
+                }
+                if (_options.ErrorRate > 0 && NextDouble() < _options.ErrorRate)
+                {
+                    Interlocked.Increment(ref _injectedErrors);
+                    response.StatusCode = (int)HttpStatusCode.ServiceUnavailable;
+                    return;
+                }
+
+                long offset = 0;
+                long length = body.Length;
+                string range = request.Headers["Range"];
+                if (_options.SupportRanges)
+                {
+                    response.AddHeader("Accept-Ranges", "bytes");
+                    if (range != null)
+                    {
+                        Interlocked.Increment(ref _rangeRequests);
+                        if (!TryParseRange(range, body.Length, out offset, out length))
+                        {
+                            response.StatusCode = (int)HttpStatusCode.RequestedRangeNotSatisfiable;
+                            response.AddHeader("Content-Range", $"bytes */{body.Length}");
+                            return;
+                        }
+                        response.StatusCode = (int)HttpStatusCode.PartialContent;
+                        response.AddHeader("Content-Range", $"bytes {offset}-{offset + length - 1}/{body.Length}");
+                    }
+                }
+                response.ContentType = request.Url.AbsolutePath.EndsWith(".json", StringComparison.Ordinal) ? "application/json" : "application/octet-stream";
+                response.ContentLength64 = length;
+                if (request.HttpMethod == "HEAD") return;
+
+                long dropAt = _options.DropRate > 0 && length > 1 && NextDouble() < _options.DropRate ? offset + length / 2 : -1;
+                Stream output = response.OutputStream;
+                for (long position = offset, end = offset + length; position < end;)
+                {
+                    int chunk = (int)Math.Min(ChunkSize, end - position);
+                    if (dropAt >= 0 && position + chunk > dropAt) chunk = (int)(dropAt - position);
+                    if (chunk > 0)
+                    {
+                        await ThrottleAsync(chunk).ConfigureAwait(false);
+                        await output.WriteAsync(body.AsMemory((int)position, chunk)).ConfigureAwait(false);
+                        Interlocked.Add(ref _bytesSent, chunk);
+                        position += chunk;
+                    }
+                    if (position == dropAt)
+                    {
+                        await output.FlushAsync().ConfigureAwait(false);
+                        Interlocked.Increment(ref _droppedResponses);
+                        response.Abort();
+                        aborted = true;
+                        return;
+                    }
+                }
+            }
+            catch (Exception ex) when (ex is HttpListenerException || ex is IOException || ex is ObjectDisposedException)
+            {
+                // The client went away (e.g. the harness killed the launcher).
+            }
+            finally
+            {
+                if (!aborted)
+                {
+                    try { response.Close(); }
+                    catch (Exception ex) when (ex is HttpListenerException || ex is IOException || ex is ObjectDisposedException) { }
+                }
+            }
+        }
+
+        // Spaces chunks so that all responses together stay under the configured bandwidth.
+        private async Task ThrottleAsync(int bytes)
+        {
+            if (_options.BytesPerSecond <= 0) return;
+            long cost = bytes * Stopwatch.Frequency / _options.BytesPerSecond;
+            long due;
+            lock (_throttleLock)
+            {
+                _throttleNext = Math.Max(_throttleNext, Stopwatch.GetTimestamp()) + cost;
+                due = _throttleNext;
+            }
+            long wait = due - Stopwatch.GetTimestamp();
+            if (wait > 0) await Task.Delay(TimeSpan.FromSeconds((double)wait / Stopwatch.Frequency)).ConfigureAwait(false);
+        }
+
+        private double NextDouble()
+        {
+            lock (_random) return _random.NextDouble();
+        }
+
+        // A single range: "bytes=FROM-", "bytes=FROM-TO" or the suffix form "bytes=-N".
+        private static bool TryParseRange(string header, long size, out long offset, out long length)
+        {
+            offset = 0;
+            length = size;
+            if (!header.StartsWith("bytes=", StringComparison.OrdinalIgnoreCase) || header.Contains(',')) return false;
+            string spec = header.Substring("bytes=".Length).Trim();
+            int dash = spec.IndexOf('-');
+            if (dash < 0) return false;
+
+            string first = spec.Substring(0, dash);
+            string last = spec.Substring(dash + 1);
+            if (first.Length == 0)
+            {
+                if (!long.TryParse(last, out long suffix) || suffix <= 0) return false;
+                length = Math.Min(suffix, size);
+                offset = size - length;
+                return true;
+            }
+            if (!long.TryParse(first, out offset) || offset >= size) return false;
+            long end = size - 1;
+            if (last.Length > 0 && (!long.TryParse(last, out end) || end < offset)) return false;
+            end = Math.Min(end, size - 1);
+            length = end - offset + 1;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,250 @@
+﻿// Harness/InstallScenarioRunner.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text.Json.Nodes;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// Install scenarios measured end to end, each in its own working directory (and so its own data directory).
+    /// </summary>
+    public enum InstallScenario
+    {
+        /// <summary>Empty data directory: everything is downloaded, verified and extracted.</summary>
+        Cold,
+
+        /// <summary>Everything already installed: the launcher only checks what is there.</summary>
+        Warm,
+
+        /// <summary>A fraction of the asset objects and libraries deleted from a complete install.</summary>
+        Partial,
+
+        /// <summary>A cold install killed part way through, then finished by the measured run.</summary>
+        Resume
+    }
+
+    /// <summary>
+    /// How the launcher is run (<c>--launcher=</c>, <c>--launcher-arg=</c>, <c>--work-dir=</c>, <c>--iterations=</c>,
+    /// <c>--partial-fraction=</c>, <c>--resume-fraction=</c>, <c>--timeout-s=</c>); the launch benchmark uses the
+    /// same options and ignores the fractions.
+    /// </summary>
+    public sealed class InstallScenarioOptions
+    {
+        /// <summary>
+        /// The launcher executable, or its <c>.dll</c> (run with <c>dotnet</c>).
+        /// </summary>
+        public string LauncherPath { get; set; }
+
+        /// <summary>
+        /// Extra launcher flags, e.g. <c>--durability=fast</c>.
+        /// </summary>
+        public List<string> LauncherArguments { get; } = new List<string>();
+
+        public string WorkDirectory { get; set; }
+        public int Iterations { get; set; } = 5;
+        public double PartialFraction { get; set; } = 0.3;
+
+        /// <summary>
+        /// Share of the CDN's content served before the first run of <see cref="InstallScenario.Resume"/> is killed.
+        /// </summary>
+        public double ResumeFraction { get; set; } = 0.4;
+
+        public TimeSpan Timeout { get; set; } = TimeSpan.FromMinutes(10);
+        public int Seed { get; set; } = 1;
+    }
+
+    /// <summary>
+    /// One measured launcher run.
+    /// </summary>
+    public sealed class InstallRunResult
+    {
+        public string Scenario { get; set; }
+        public int Iteration { get; set; }
+        public bool Succeeded { get; set; }
+        public int ExitCode { get; set; }
+        public bool TimedOut { get; set; }
+        public double WallSeconds { get; set; }
+
+        /// <summary>
+        /// What the CDN served during this run.
+        /// </summary>
+        public CdnStats Cdn { get; set; }
+
+        /// <summary>
+        /// Files deleted before a <see cref="InstallScenario.Partial"/> run.
+        /// </summary>
+        public int FilesRemoved { get; set; }
+
+        /// <summary>
+        /// Bytes served before the interrupted first run of <see cref="InstallScenario.Resume"/> was killed; 0 if it
+        /// finished before reaching the threshold.
+        /// </summary>
+        public long BytesBeforeInterrupt { get; set; }
+
+        /// <summary>
+        /// The launcher's own record of the run (phases, download and hashing totals) from <c>perf_history.jsonl</c>.
+        /// </summary>
+        public JsonNode Launcher { get; set; }
+    }
+
+    /// <summary>
+    /// Per-scenario distribution of the successful runs.
+    /// </summary>
+    public sealed class InstallScenarioSummary
+    {
+        public string Scenario { get; set; }
+        public int Runs { get; set; }
+        public int Failures { get; set; }
+        public double MedianSeconds { get; set; }
+        public double P90Seconds { get; set; }
+        public double MinSeconds { get; set; }
+        public double MaxSeconds { get; set; }
+        public double MedianInstallPhaseSeconds { get; set; }
+        public double MeanRequests { get; set; }
+        public double MeanBytesServed { get; set; }
+    }
+
+    /// <summary>
+    /// Runs the launcher with <c>--install-only</c> against the stand-in CDN, preparing the data directory for each
+    /// scenario before every measured run.
+    /// </summary>
+    public sealed class InstallScenarioRunner
+    {
+        private readonly CdnContent _content;
+        private readonly InstallScenarioOptions _options;
+        private readonly LauncherProcess _launcher;
+
+        public InstallScenarioRunner(FakeCdn cdn, CdnContent content, InstallScenarioOptions options)
+        {
+            if (cdn == null) throw new ArgumentNullException(nameof(cdn));
+            _content = content ?? throw new ArgumentNullException(nameof(content));
+            _options = options ?? throw new ArgumentNullException(nameof(options));
+            _launcher = new LauncherProcess(options.LauncherPath, cdn, options.Timeout);
+        }
+
+        public async Task<List<InstallRunResult>> RunAsync(IEnumerable<InstallScenario> scenarios, CancellationToken cancellationToken)
+        {
+            var results = new List<InstallRunResult>();
+            foreach (InstallScenario scenario in scenarios)
+            {
+                string name = scenario.ToString().ToLowerInvariant();
+                string workingDirectory = Path.Combine(_options.WorkDirectory, name);
+                Directory.CreateDirectory(workingDirectory);
+                string dataDirectory = LauncherProcess.DataDirectory(workingDirectory);
+
+                if (scenario == InstallScenario.Warm || scenario == InstallScenario.Partial)
+                {
+                    Console.WriteLine($"[{name}] priming a complete install...");
+                    LauncherExit priming = await RunLauncherAsync(workingDirectory, "prime", -1, cancellationToken);
+                    if (priming.ExitCode != 0)
+                    {
+                        Console.WriteLine($"[{name}] priming install failed with exit code {priming.ExitCode}; skipping the scenario.");
+                        results.Add(new InstallRunResult { Scenario = name, Iteration = -1, ExitCode = priming.ExitCode, TimedOut = priming.TimedOut });
+                        continue;
+                    }
+                }
+
+                for (int iteration = 0; iteration < _options.Iterations; iteration++)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    var result = new InstallRunResult { Scenario = name, Iteration = iteration };
+                    if (scenario == InstallScenario.Cold || scenario == InstallScenario.Resume)
+                    {
+                        DeleteDirectory(dataDirectory);
+                    }
+                    if (scenario == InstallScenario.Partial)
+                    {
+                        result.FilesRemoved = RemoveFiles(dataDirectory, _options.PartialFraction, _options.Seed + iteration);
+                    }
+                    if (scenario == InstallScenario.Resume)
+                    {
+                        long threshold = (long)(_content.TotalBytes * _options.ResumeFraction);
+                        LauncherExit interrupted = await RunLauncherAsync(workingDirectory, $"interrupted-{iteration}", threshold, cancellationToken);
+                        result.BytesBeforeInterrupt = interrupted.Interrupted ? interrupted.Cdn.BytesSent : 0;
+                    }
+
+                    int historyRecords = LauncherProcess.CountHistoryRecords(workingDirectory);
+                    LauncherExit exit = await RunLauncherAsync(workingDirectory, $"run-{iteration}", -1, cancellationToken);
+                    result.ExitCode = exit.ExitCode;
+                    result.TimedOut = exit.TimedOut;
+                    result.Succeeded = exit.ExitCode == 0 && !exit.TimedOut;
+                    result.WallSeconds = exit.WallSeconds;
+                    result.Cdn = exit.Cdn;
+                    result.Launcher = LauncherProcess.ReadNewHistoryRecord(workingDirectory, historyRecords);
+                    results.Add(result);
+
+                    Console.WriteLine($"[{name}] run {iteration + 1}/{_options.Iterations}: {(result.Succeeded ? "ok" : $"exit {result.ExitCode}")} " +
+                                      $"in {result.WallSeconds:F2} s, {result.Cdn.Requests} requests, {result.Cdn.BytesSent / (1024.0 * 1024.0):F1} MB served" +
+                                      (result.FilesRemoved > 0 ? $", {result.FilesRemoved} files removed before" : string.Empty) +
+                                      (result.BytesBeforeInterrupt > 0 ? $", resumed after {result.BytesBeforeInterrupt / (1024.0 * 1024.0):F1} MB" : string.Empty));
+                }
+            }
+            return results;
+        }
+
+        /// <summary>
+        /// Median, p90 and extremes of the successful runs of each scenario, in the order they ran.
+        /// </summary>
+        public static List<InstallScenarioSummary> Summarize(IEnumerable<InstallRunResult> results)
+        {
+            var summaries = new List<InstallScenarioSummary>();
+            foreach (IGrouping<string, InstallRunResult> group in results.Where(r => r.Iteration >= 0).GroupBy(r => r.Scenario))
+            {
+                List<InstallRunResult> succeeded = group.Where(r => r.Succeeded).ToList();
+                double[] wall = succeeded.Select(r => r.WallSeconds).OrderBy(s => s).ToArray();
+                double[] install = succeeded
+                    .Select(r => r.Launcher?["Phases"]?["install"]?.GetValue<double>())
+                    .Where(s => s.HasValue).Select(s => s.Value).OrderBy(s => s).ToArray();
+                summaries.Add(new InstallScenarioSummary
+                {
+                    Scenario = group.Key,
+                    Runs = group.Count(),
+                    Failures = group.Count() - succeeded.Count,
+                    MedianSeconds = Distribution.Percentile(wall, 0.5),
+                    P90Seconds = Distribution.Percentile(wall, 0.9),
+                    MinSeconds = wall.Length > 0 ? wall[0] : 0,
+                    MaxSeconds = wall.Length > 0 ? wall[^1] : 0,
+                    MedianInstallPhaseSeconds = Distribution.Percentile(install, 0.5),
+                    MeanRequests = succeeded.Count > 0 ? succeeded.Average(r => (double)r.Cdn.Requests) : 0,
+                    MeanBytesServed = succeeded.Count > 0 ? succeeded.Average(r => (double)r.Cdn.BytesSent) : 0
+                });
+            }
+            return summaries;
+        }
+
+        private Task<LauncherExit> RunLauncherAsync(string workingDirectory, string logName, long interruptAfterBytes, CancellationToken cancellationToken)
+        {
+            var arguments = new List<string> { _content.VersionId, "--install-only" };
+            arguments.AddRange(_content.LauncherArguments);
+            arguments.AddRange(_options.LauncherArguments);
+            return _launcher.RunAsync(workingDirectory, logName, arguments, interruptAfterBytes: interruptAfterBytes, cancellationToken: cancellationToken);
+        }
+
+        // Deletes a reproducible random share of the asset objects and library jars.
+        private static int RemoveFiles(string dataDirectory, double fraction, int seed)
+        {
+            var random = new Random(seed);
+            int removed = 0;
+            foreach (string directory in new[] { Path.Combine(dataDirectory, "assets", "objects"), Path.Combine(dataDirectory, "libraries") })
+            {
+                if (!Directory.Exists(directory)) continue;
+                foreach (string file in Directory.EnumerateFiles(directory, "*", SearchOption.AllDirectories).OrderBy(f => f, StringComparer.Ordinal).ToList())
+                {
+                    if (random.NextDouble() >= fraction) continue;
+                    File.Delete(file);
+                    removed++;
+                }
+            }
+            return removed;
+        }
+
+        private static void DeleteDirectory(string path)
+        {
+            if (Directory.Exists(path)) Directory.Delete(path, true);
+        }
+    }
+}
@@ -0,0 +1,244 @@
+﻿// Harness/LaunchScenarioRunner.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text.Json.Nodes;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// Relaunch scenarios of the launch benchmark. Both start from a complete install and launch the stub java.
+    /// </summary>
+    public enum LaunchScenario
+    {
+        /// <summary>Everything in place from the previous launch.</summary>
+        Warm,
+
+        /// <summary>
+        /// The cached version manifest, version JSON, asset indexes, extracted natives and install journal deleted
+        /// before each launch, so they are fetched, checked and extracted again; downloaded files are kept.
+        /// </summary>
+        Cold
+    }
+
+    /// <summary>
+    /// One measured launch up to the stub java.
+    /// </summary>
+    public sealed class LaunchRunResult
+    {
+        public string Scenario { get; set; }
+        public int Iteration { get; set; }
+        public bool Succeeded { get; set; }
+        public int ExitCode { get; set; }
+        public bool TimedOut { get; set; }
+        public double WallSeconds { get; set; }
+
+        /// <summary>
+        /// From starting the launcher process to the stub starting. Where the stub has no clock this is the end of the
+        /// launcher's "spawn" phase instead (see <see cref="SpawnFromLauncher"/>).
+        /// </summary>
+        public double? TimeToSpawnSeconds { get; set; }
+
+        public bool SpawnFromLauncher { get; set; }
+
+        /// <summary>
+        /// Time to spawn by phase: "startup" (process start to the launcher's run record), the launcher's phases up to
+        /// and including "spawn", and "unaccounted" (the rest). The launcher ends "spawn" once Process.Start returns, by
+        /// which time the stub may already be running, so "unaccounted" is often slightly negative.
+        /// </summary>
+        public Dictionary<string, double> Phases { get; } = new Dictionary<string, double>(StringComparer.Ordinal);
+
+        public int ArgumentCount { get; set; }
+
+        /// <summary>
+        /// Characters in the stub's argument string.
+        /// </summary>
+        public int ArgumentChars { get; set; }
+
+        public int EnvironmentVariables { get; set; }
+
+        /// <summary>
+        /// What the CDN served during this run.
+        /// </summary>
+        public CdnStats Cdn { get; set; }
+
+        /// <summary>
+        /// The launcher's own record of the run from <c>perf_history.jsonl</c>.
+        /// </summary>
+        public JsonNode Launcher { get; set; }
+    }
+
+    /// <summary>
+    /// Per-scenario distributions of the successful launches.
+    /// </summary>
+    public sealed class LaunchScenarioSummary
+    {
+        public string Scenario { get; set; }
+        public int Runs { get; set; }
+        public int Failures { get; set; }
+        public Distribution TimeToSpawnSeconds { get; set; }
+        public Dictionary<string, Distribution> PhaseSeconds { get; } = new Dictionary<string, Distribution>(StringComparer.Ordinal);
+        public Distribution ArgumentChars { get; set; }
+        public Distribution WallSeconds { get; set; }
+    }
+
+    /// <summary>
+    /// Launches the stub java through the launcher against the stand-in CDN, repeatedly, after one
+    /// <c>--install-only</c> priming run per scenario.
+    /// </summary>
+    public sealed class LaunchScenarioRunner
+    {
+        // The launcher phases before the game starts, in order (see PerformanceRunRecord.Phases).
+        private static readonly string[] LauncherPhases = { "manifest", "version", "plan", "install", "arguments", "spawn" };
+
+        private readonly CdnContent _content;
+        private readonly InstallScenarioOptions _options;
+        private readonly LauncherProcess _launcher;
+
+        public LaunchScenarioRunner(FakeCdn cdn, CdnContent content, InstallScenarioOptions options)
+        {
+            if (cdn == null) throw new ArgumentNullException(nameof(cdn));
+            _content = content ?? throw new ArgumentNullException(nameof(content));
+            _options = options ?? throw new ArgumentNullException(nameof(options));
+            _launcher = new LauncherProcess(options.LauncherPath, cdn, options.Timeout);
+        }
+
+        /// <summary>
+        /// The argv of the first successful launch, to show what the launcher passes to java.
+        /// </summary>
+        public List<string> SampleArguments { get; private set; }
+
+        public async Task<List<LaunchRunResult>> RunAsync(IEnumerable<LaunchScenario> scenarios, CancellationToken cancellationToken)
+        {
+            var results = new List<LaunchRunResult>();
+            string stubPath = StubJava.Write(Path.Combine(_options.WorkDirectory, "stub-java"));
+            foreach (LaunchScenario scenario in scenarios)
+            {
+                string name = "launch-" + scenario.ToString().ToLowerInvariant();
+                string workingDirectory = Path.Combine(_options.WorkDirectory, name);
+                Directory.CreateDirectory(workingDirectory);
+
+                Console.WriteLine($"[{name}] priming a complete install...");
+                var primeArguments = new List<string> { _content.VersionId, "--install-only" };
+                primeArguments.AddRange(_content.LauncherArguments);
+                primeArguments.AddRange(_options.LauncherArguments);
+                LauncherExit priming = await _launcher.RunAsync(workingDirectory, "prime", primeArguments, cancellationToken: cancellationToken);
+                if (priming.ExitCode != 0)
+                {
+                    Console.WriteLine($"[{name}] priming install failed with exit code {priming.ExitCode}; skipping the scenario.");
+                    results.Add(new LaunchRunResult { Scenario = name, Iteration = -1, ExitCode = priming.ExitCode, TimedOut = priming.TimedOut });
+                    continue;
+                }
+
+                for (int iteration = 0; iteration < _options.Iterations; iteration++)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    if (scenario == LaunchScenario.Cold) RemoveCaches(LauncherProcess.DataDirectory(workingDirectory));
+                    LaunchRunResult result = await LaunchAsync(name, iteration, workingDirectory, stubPath, cancellationToken);
+                    results.Add(result);
+
+                    Console.WriteLine($"[{name}] run {iteration + 1}/{_options.Iterations}: " +
+                                      (result.Succeeded
+                                          ? $"stub started after {result.TimeToSpawnSeconds * 1000:F0} ms, {result.ArgumentCount} arguments ({result.ArgumentChars:N0} chars)"
+                                          : $"failed (exit {result.ExitCode}{(result.TimedOut ? ", timed out" : string.Empty)})"));
+                }
+            }
+            return results;
+        }
+
+        /// <summary>
+        /// Time to spawn, its phases and argument sizes of the successful launches of each scenario, in the order they ran.
+        /// </summary>
+        public static List<LaunchScenarioSummary> Summarize(IEnumerable<LaunchRunResult> results)
+        {
+            var summaries = new List<LaunchScenarioSummary>();
+            foreach (IGrouping<string, LaunchRunResult> group in results.Where(r => r.Iteration >= 0).GroupBy(r => r.Scenario))
+            {
+                List<LaunchRunResult> succeeded = group.Where(r => r.Succeeded).ToList();
+                var summary = new LaunchScenarioSummary
+                {
+                    Scenario = group.Key,
+                    Runs = group.Count(),
+                    Failures = group.Count() - succeeded.Count,
+                    TimeToSpawnSeconds = Distribution.Of(succeeded.Select(r => r.TimeToSpawnSeconds.Value)),
+                    ArgumentChars = Distribution.Of(succeeded.Select(r => (double)r.ArgumentChars)),
+                    WallSeconds = Distribution.Of(succeeded.Select(r => r.WallSeconds))
+                };
+                foreach (string phase in succeeded.SelectMany(r => r.Phases.Keys).Distinct())
+                {
+                    summary.PhaseSeconds[phase] = Distribution.Of(succeeded.Select(r => r.Phases.TryGetValue(phase, out double seconds) ? seconds : 0));
+                }
+                summaries.Add(summary);
+            }
+            return summaries;
+        }
+
+        private async Task<LaunchRunResult> LaunchAsync(string name, int iteration, string workingDirectory, string stubPath, CancellationToken cancellationToken)
+        {
+            var result = new LaunchRunResult { Scenario = name, Iteration = iteration };
+            string stubOutput = Path.Combine(workingDirectory, "harness-logs", $"stub-{iteration}.txt");
+            Directory.CreateDirectory(Path.GetDirectoryName(stubOutput));
+            File.Delete(stubOutput);
+
+            var arguments = new List<string> { _content.VersionId, $"--java-executable={stubPath}" };
+            arguments.AddRange(_content.LauncherArguments);
+            arguments.AddRange(_options.LauncherArguments);
+            var environment = new Dictionary<string, string> { [StubJava.OutputVariable] = stubOutput };
+
+            int historyRecords = LauncherProcess.CountHistoryRecords(workingDirectory);
+            LauncherExit exit = await _launcher.RunAsync(workingDirectory, $"run-{iteration}", arguments, environment, cancellationToken: cancellationToken);
+            result.ExitCode = exit.ExitCode;
+            result.TimedOut = exit.TimedOut;
+            result.WallSeconds = exit.WallSeconds;
+            result.Cdn = exit.Cdn;
+            result.Launcher = LauncherProcess.ReadNewHistoryRecord(workingDirectory, historyRecords);
+
+            StubInvocation stub = StubJava.Read(stubOutput);
+            JsonObject phases = result.Launcher?["Phases"] as JsonObject;
+            DateTime? recordStarted = result.Launcher?["TimestampUtc"]?.GetValue<DateTime>();
+            result.Succeeded = exit.ExitCode == 0 && !exit.TimedOut && stub != null && phases != null && recordStarted.HasValue;
+            if (!result.Succeeded) return result;
+
+            result.ArgumentCount = stub.Arguments.Count;
+            result.ArgumentChars = stub.ArgumentChars;
+            result.EnvironmentVariables = stub.Environment.Count;
+            SampleArguments ??= stub.Arguments;
+
+            double accounted = (recordStarted.Value.ToUniversalTime() - exit.StartedUtc).TotalSeconds;
+            result.Phases["startup"] = accounted;
+            foreach (string phase in LauncherPhases)
+            {
+                double seconds = phases[phase]?.GetValue<double>() ?? 0;
+                result.Phases[phase] = seconds;
+                accounted += seconds;
+            }
+            if (stub.StartedUtc.HasValue)
+            {
+                result.TimeToSpawnSeconds = (stub.StartedUtc.Value - exit.StartedUtc).TotalSeconds;
+                result.Phases["unaccounted"] = result.TimeToSpawnSeconds.Value - accounted;
+            }
+            else
+            {
+                result.TimeToSpawnSeconds = accounted;
+                result.SpawnFromLauncher = true;
+            }
+            return result;
+        }
+
+        // Drops what the launcher caches about the version, keeping the downloaded libraries, assets and runtime.
+        private void RemoveCaches(string dataDirectory)
+        {
+            string versionDirectory = Path.Combine(dataDirectory, "versions", _content.VersionId);
+            File.Delete(Path.Combine(dataDirectory, "version_manifest_v2.json"));
+            File.Delete(Path.Combine(dataDirectory, "install_journal.jsonl"));
+            File.Delete(Path.Combine(versionDirectory, $"{_content.VersionId}.json"));
+            foreach (string directory in new[] { Path.Combine(versionDirectory, $"{_content.VersionId}-natives"), Path.Combine(dataDirectory, "assets", "indexes") })
+            {
+                if (Directory.Exists(directory)) Directory.Delete(directory, true);
+            }
+        }
+    }
+}
@@ -0,0 +1,169 @@
+﻿// Harness/LauncherProcess.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text.Json.Nodes;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// How one launcher process ended.
+    /// </summary>
+    public sealed class LauncherExit
+    {
+        public int ExitCode { get; set; }
+        public bool TimedOut { get; set; }
+        public bool Interrupted { get; set; }
+
+        /// <summary>
+        /// Wall clock time just before the process was started.
+        /// </summary>
+        public DateTime StartedUtc { get; set; }
+
+        public double WallSeconds { get; set; }
+
+        /// <summary>
+        /// What the CDN served while the process ran.
+        /// </summary>
+        public CdnStats Cdn { get; set; }
+    }
+
+    /// <summary>
+    /// Runs the launcher as a child process in a working directory of its own (its data directory is
+    /// <c>.ObsidianLauncher</c> under it) and writes its console output to <c>harness-logs/{name}.log</c>.
+    /// </summary>
+    public sealed class LauncherProcess
+    {
+        private readonly string _launcherPath;
+        private readonly FakeCdn _cdn;
+        private readonly TimeSpan _timeout;
+
+        /// <param name="launcherPath">The launcher executable, or its <c>.dll</c> (run with <c>dotnet</c>).</param>
+        /// <param name="cdn">The stand-in CDN, whose counters are attributed to each run.</param>
+        /// <param name="timeout">Runs taking longer are killed.</param>
+        public LauncherProcess(string launcherPath, FakeCdn cdn, TimeSpan timeout)
+        {
+            _launcherPath = launcherPath ?? throw new ArgumentNullException(nameof(launcherPath));
+            _cdn = cdn ?? throw new ArgumentNullException(nameof(cdn));
+            _timeout = timeout;
+        }
+
+        public static string DataDirectory(string workingDirectory) => Path.Combine(workingDirectory, ".ObsidianLauncher");
+
+        /// <summary>
+        /// Runs the launcher to completion, or kills it once the CDN has served <paramref name="interruptAfterBytes"/>
+        /// bytes to it (when not negative).
+        /// </summary>
+        public async Task<LauncherExit> RunAsync(
+            string workingDirectory,
+            string logName,
+            IEnumerable<string> arguments,
+            IReadOnlyDictionary<string, string> environment = null,
+            long interruptAfterBytes = -1,
+            CancellationToken cancellationToken = default)
+        {
+            var startInfo = new ProcessStartInfo
+            {
+                WorkingDirectory = workingDirectory,
+                UseShellExecute = false,
+                RedirectStandardOutput = true,
+                RedirectStandardError = true
+            };
+            if (_launcherPath.EndsWith(".dll", StringComparison.OrdinalIgnoreCase))
+            {
+                startInfo.FileName = "dotnet";
+                startInfo.ArgumentList.Add(_launcherPath);
+            }
+            else
+            {
+                startInfo.FileName = _launcherPath;
+            }
+            foreach (string arg in arguments) startInfo.ArgumentList.Add(arg);
+            if (environment != null)
+            {
+                foreach (KeyValuePair<string, string> variable in environment) startInfo.Environment[variable.Key] = variable.Value;
+            }
+
+            // The launcher's console output goes to a file per run, so a failed run can be looked at afterwards.
+            string logDirectory = Path.Combine(workingDirectory, "harness-logs");
+            Directory.CreateDirectory(logDirectory);
+            using var log = new StreamWriter(Path.Combine(logDirectory, logName + ".log"), false);
+            object logLock = new object();
+
+            using var process = new Process { StartInfo = startInfo };
+            process.OutputDataReceived += (_, e) => { if (e.Data != null) lock (logLock) log.WriteLine(e.Data); };
+            process.ErrorDataReceived += (_, e) => { if (e.Data != null) lock (logLock) log.WriteLine(e.Data); };
+
+            var exit = new LauncherExit();
+            CdnStats before = _cdn.Stats;
+            exit.StartedUtc = DateTime.UtcNow;
+            var stopwatch = Stopwatch.StartNew();
+            process.Start();
+            process.BeginOutputReadLine();
+            process.BeginErrorReadLine();
+
+            Task exited = process.WaitForExitAsync(CancellationToken.None);
+            try
+            {
+                while (!exited.IsCompleted)
+                {
+                    await Task.WhenAny(exited, Task.Delay(10, cancellationToken)).ConfigureAwait(false);
+                    if (exited.IsCompleted) break;
+                    cancellationToken.ThrowIfCancellationRequested();
+                    if (interruptAfterBytes >= 0 && _cdn.Stats.BytesSent - before.BytesSent >= interruptAfterBytes)
+                    {
+                        exit.Interrupted = true;
+                        process.Kill(true);
+                        break;
+                    }
+                    if (stopwatch.Elapsed > _timeout)
+                    {
+                        exit.TimedOut = true;
+                        process.Kill(true);
+                        break;
+                    }
+                }
+            }
+            catch (OperationCanceledException)
+            {
+                process.Kill(true);
+                await exited.ConfigureAwait(false);
+                throw;
+            }
+            await exited.ConfigureAwait(false);
+            stopwatch.Stop();
+            exit.WallSeconds = stopwatch.Elapsed.TotalSeconds;
+            exit.ExitCode = process.ExitCode;
+            exit.Cdn = _cdn.Stats.Subtract(before);
+            // The parameterless wait also drains the redirected output into the log.
+            process.WaitForExit();
+            lock (logLock) log.Flush();
+            return exit;
+        }
+
+        /// <summary>
+        /// Number of runs in the launcher's <c>perf_history.jsonl</c>.
+        /// </summary>
+        public static int CountHistoryRecords(string workingDirectory)
+        {
+            string path = Path.Combine(DataDirectory(workingDirectory), "perf_history.jsonl");
+            return File.Exists(path) ? File.ReadLines(path).Count() : 0;
+        }
+
+        /// <summary>
+        /// The launcher's record of its latest run, or null if none was added since there were
+        /// <paramref name="previousRecords"/>.
+        /// </summary>
+        public static JsonNode ReadNewHistoryRecord(string workingDirectory, int previousRecords)
+        {
+            string path = Path.Combine(DataDirectory(workingDirectory), "perf_history.jsonl");
+            if (!File.Exists(path)) return null;
+            string[] lines = File.ReadAllLines(path);
+            return lines.Length > previousRecords ? JsonNode.Parse(lines[^1]) : null;
+        }
+    }
+}
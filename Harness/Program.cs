@@ -0,0 +1,328 @@
+﻿// Harness/Program.cs
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Runtime.InteropServices;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// End-to-end install and launch benchmarks: serves a synthetic or recorded version from a local stand-in for the
+    /// Mojang and Adoptium hosts and times real launcher processes installing it, or launching a stub java with it.
+    /// <code>
+    /// run --launcher=PATH [--scenarios=cold,warm,partial,resume] [--iterations=N] [--out=FILE] [--work-dir=DIR]
+    ///     [--partial-fraction=F] [--resume-fraction=F] [--timeout-s=N] [--launcher-arg=ARG]...
+    /// launch --launcher=PATH [--scenarios=warm,cold] [--iterations=N] [--out=FILE] [--work-dir=DIR]
+    ///     [--timeout-s=N] [--launcher-arg=ARG]...
+    /// serve                                  (prints the launcher flags, serves until Ctrl+C)
+    /// record VERSION --content-dir=DIR       (records a real install for --content-dir replays)
+    /// </code>
+    /// Content: <c>--content-dir=DIR --version=ID</c> replays a recording; otherwise a synthetic version is generated
+    /// (<c>--version=</c>, <c>--assets=</c>, <c>--libraries=</c>, <c>--client-mb=</c>, <c>--java-mb=</c>, <c>--seed=</c>).
+    /// Network: <c>--latency-ms=</c>, <c>--jitter-ms=</c>, <c>--bandwidth-mbps=</c>, <c>--error-rate=</c>,
+    /// <c>--drop-rate=</c>, <c>--no-ranges</c>.
+    /// </summary>
+    public static class Program
+    {
+        private static readonly JsonSerializerOptions ResultJson = new JsonSerializerOptions { WriteIndented = true };
+
+        public static async Task<int> Main(string[] args)
+        {
+            string command = args.FirstOrDefault(a => !a.StartsWith("--", StringComparison.Ordinal))?.ToLowerInvariant();
+            using var cts = new CancellationTokenSource();
+            Console.CancelKeyPress += (_, e) =>
+            {
+                e.Cancel = true;
+                cts.Cancel();
+            };
+
+            try
+            {
+                switch (command)
+                {
+                    case "run":
+                        return await RunAsync(args, cts.Token);
+                    case "launch":
+                        return await LaunchAsync(args, cts.Token);
+                    case "serve":
+                        return await ServeAsync(args, cts.Token);
+                    case "record":
+                        return await RecordAsync(args, cts.Token);
+                    default:
+                        Console.Error.WriteLine("Usage: run --launcher=PATH [options] | launch --launcher=PATH [options] | serve [options] | record VERSION --content-dir=DIR");
+                        return 2;
+                }
+            }
+            catch (OperationCanceledException)
+            {
+                Console.Error.WriteLine("Cancelled.");
+                return 1;
+            }
+        }
+
+        private static async Task<int> RunAsync(string[] args, CancellationToken cancellationToken)
+        {
+            InstallScenarioOptions options = CreateRunOptions(args, 5);
+            if (options == null) return 2;
+
+            var scenarios = new List<InstallScenario>();
+            foreach (string name in (Option(args, "--scenarios") ?? "cold,warm,partial,resume").Split(',', StringSplitOptions.RemoveEmptyEntries))
+            {
+                if (!Enum.TryParse(name.Trim(), true, out InstallScenario scenario))
+                {
+                    Console.Error.WriteLine($"Unknown scenario '{name}'; expected cold, warm, partial or resume.");
+                    return 2;
+                }
+                scenarios.Add(scenario);
+            }
+
+            FakeCdnOptions cdnOptions = CreateCdnOptions(args);
+            (FakeCdn cdn, CdnContent content) = StartCdn(args, cdnOptions);
+            if (cdn == null) return 2;
+            using (cdn)
+            {
+                DateTime started = DateTime.UtcNow;
+                List<InstallRunResult> runs = await new InstallScenarioRunner(cdn, content, options).RunAsync(scenarios, cancellationToken);
+                List<InstallScenarioSummary> summaries = InstallScenarioRunner.Summarize(runs);
+
+                string outputPath = Path.GetFullPath(Option(args, "--out") ?? $"install-harness-{DateTime.Now:yyyyMMdd-HHmmss}.json");
+                var report = new
+                {
+                    StartedUtc = started,
+                    Setup = DescribeSetup(args, options, content, cdnOptions),
+                    Summary = summaries,
+                    Runs = runs
+                };
+                await File.WriteAllTextAsync(outputPath, JsonSerializer.Serialize(report, ResultJson), cancellationToken);
+
+                Console.WriteLine();
+                Console.WriteLine($"{"Scenario",-10} {"Runs",5} {"Failed",7} {"Median s",9} {"p90 s",8} {"Min s",8} {"Max s",8} {"Install s",10} {"Requests",9} {"MB served",10}");
+                foreach (InstallScenarioSummary summary in summaries)
+                {
+                    Console.WriteLine($"{summary.Scenario,-10} {summary.Runs,5} {summary.Failures,7} {summary.MedianSeconds,9:F2} {summary.P90Seconds,8:F2} " +
+                                      $"{summary.MinSeconds,8:F2} {summary.MaxSeconds,8:F2} {summary.MedianInstallPhaseSeconds,10:F2} " +
+                                      $"{summary.MeanRequests,9:F0} {summary.MeanBytesServed / (1024 * 1024),10:F1}");
+                }
+                Console.WriteLine($"Results written to {outputPath}; launcher logs under {options.WorkDirectory}.");
+                return runs.All(r => r.Succeeded) ? 0 : 1;
+            }
+        }
+
+        private static async Task<int> LaunchAsync(string[] args, CancellationToken cancellationToken)
+        {
+            InstallScenarioOptions options = CreateRunOptions(args, 20);
+            if (options == null) return 2;
+
+            var scenarios = new List<LaunchScenario>();
+            foreach (string name in (Option(args, "--scenarios") ?? "warm,cold").Split(',', StringSplitOptions.RemoveEmptyEntries))
+            {
+                if (!Enum.TryParse(name.Trim(), true, out LaunchScenario scenario))
+                {
+                    Console.Error.WriteLine($"Unknown scenario '{name}'; expected warm or cold.");
+                    return 2;
+                }
+                scenarios.Add(scenario);
+            }
+
+            FakeCdnOptions cdnOptions = CreateCdnOptions(args);
+            (FakeCdn cdn, CdnContent content) = StartCdn(args, cdnOptions);
+            if (cdn == null) return 2;
+            using (cdn)
+            {
+                DateTime started = DateTime.UtcNow;
+                var runner = new LaunchScenarioRunner(cdn, content, options);
+                List<LaunchRunResult> runs = await runner.RunAsync(scenarios, cancellationToken);
+                List<LaunchScenarioSummary> summaries = LaunchScenarioRunner.Summarize(runs);
+
+                string outputPath = Path.GetFullPath(Option(args, "--out") ?? $"launch-harness-{DateTime.Now:yyyyMMdd-HHmmss}.json");
+                var report = new
+                {
+                    StartedUtc = started,
+                    Setup = DescribeSetup(args, options, content, cdnOptions),
+                    Summary = summaries,
+                    SampleArguments = runner.SampleArguments,
+                    Runs = runs
+                };
+                await File.WriteAllTextAsync(outputPath, JsonSerializer.Serialize(report, ResultJson), cancellationToken);
+
+                Console.WriteLine();
+                Console.WriteLine($"{"Scenario",-14} {"Runs",5} {"Failed",7} {"Median ms",10} {"p90 ms",8} {"p99 ms",8} {"Max ms",8} {"Arg chars",10}");
+                foreach (LaunchScenarioSummary summary in summaries)
+                {
+                    Console.WriteLine($"{summary.Scenario,-14} {summary.Runs,5} {summary.Failures,7} {summary.TimeToSpawnSeconds.Median * 1000,10:F1} " +
+                                      $"{summary.TimeToSpawnSeconds.P90 * 1000,8:F1} {summary.TimeToSpawnSeconds.P99 * 1000,8:F1} " +
+                                      $"{summary.TimeToSpawnSeconds.Max * 1000,8:F1} {summary.ArgumentChars.Median,10:F0}");
+                    Console.WriteLine("    median by phase: " + string.Join(", ",
+                        summary.PhaseSeconds.Select(p => $"{p.Key} {p.Value.Median * 1000:F1} ms")));
+                }
+                Console.WriteLine($"Results written to {outputPath}; launcher logs and stub output under {options.WorkDirectory}.");
+                return runs.All(r => r.Succeeded) ? 0 : 1;
+            }
+        }
+
+        private static async Task<int> ServeAsync(string[] args, CancellationToken cancellationToken)
+        {
+            (FakeCdn cdn, CdnContent content) = StartCdn(args, CreateCdnOptions(args));
+            if (cdn == null) return 2;
+            using (cdn)
+            {
+                Console.WriteLine($"Serving version {content.VersionId} ({content.FileCount} files, {content.TotalBytes / (1024.0 * 1024.0):F1} MB) at {content.BaseUrl}/");
+                Console.WriteLine("Launcher flags:");
+                Console.WriteLine("  " + string.Join(" ", content.LauncherArguments));
+                Console.WriteLine("Press Ctrl+C to stop.");
+                try
+                {
+                    await Task.Delay(Timeout.Infinite, cancellationToken);
+                }
+                catch (OperationCanceledException)
+                {
+                }
+                CdnStats stats = cdn.Stats;
+                Console.WriteLine($"Served {stats.Requests} requests ({stats.BytesSent:N0} bytes, {stats.NotFound} not found, " +
+                                  $"{stats.RangeRequests} ranges, {stats.InjectedErrors} injected errors, {stats.DroppedResponses} dropped).");
+                return 0;
+            }
+        }
+
+        private static async Task<int> RecordAsync(string[] args, CancellationToken cancellationToken)
+        {
+            string versionId = args.Where(a => !a.StartsWith("--", StringComparison.Ordinal)).Skip(1).FirstOrDefault();
+            string directory = Option(args, "--content-dir");
+            if (versionId == null || directory == null)
+            {
+                Console.Error.WriteLine("Usage: record VERSION --content-dir=DIR");
+                return 2;
+            }
+            using var http = new HttpClient();
+            int files = await new ContentRecorder(http, Path.GetFullPath(directory)).RecordAsync(versionId, cancellationToken);
+            if (files < 0)
+            {
+                Console.Error.WriteLine($"Version {versionId} is not in the version manifest.");
+                return 1;
+            }
+            Console.WriteLine($"Recorded {files} files into {Path.GetFullPath(directory)}; replay with --content-dir={directory} --version={versionId}.");
+            return 0;
+        }
+
+        // The launcher and work directory options shared by "run" and "launch"; null after a usage error.
+        private static InstallScenarioOptions CreateRunOptions(string[] args, int defaultIterations)
+        {
+            var options = new InstallScenarioOptions
+            {
+                LauncherPath = Option(args, "--launcher"),
+                Iterations = (int)Number(args, "--iterations", defaultIterations),
+                PartialFraction = Number(args, "--partial-fraction", 0.3),
+                ResumeFraction = Number(args, "--resume-fraction", 0.4),
+                Timeout = TimeSpan.FromSeconds(Number(args, "--timeout-s", 600)),
+                Seed = (int)Number(args, "--seed", 1),
+                WorkDirectory = Path.GetFullPath(Option(args, "--work-dir") ??
+                                                 Path.Combine(Path.GetTempPath(), "obsidian-harness", DateTime.Now.ToString("yyyyMMdd-HHmmss", CultureInfo.InvariantCulture)))
+            };
+            if (options.LauncherPath == null || !File.Exists(options.LauncherPath))
+            {
+                Console.Error.WriteLine("--launcher=PATH must name the launcher executable or its .dll.");
+                return null;
+            }
+            options.LauncherPath = Path.GetFullPath(options.LauncherPath);
+            options.LauncherArguments.AddRange(args.Where(a => a.StartsWith("--launcher-arg=", StringComparison.OrdinalIgnoreCase))
+                .Select(a => a.Substring("--launcher-arg=".Length)));
+            return options;
+        }
+
+        // Machine, launcher, content and network conditions, for the report.
+        private static object DescribeSetup(string[] args, InstallScenarioOptions options, CdnContent content, FakeCdnOptions cdnOptions)
+        {
+            return new
+            {
+                Machine = new
+                {
+                    Os = RuntimeInformation.OSDescription,
+                    Architecture = RuntimeInformation.OSArchitecture.ToString(),
+                    Environment.ProcessorCount,
+                    Runtime = RuntimeInformation.FrameworkDescription
+                },
+                Launcher = new { Path = options.LauncherPath, Arguments = options.LauncherArguments },
+                Content = new { content.VersionId, Recorded = Option(args, "--content-dir") != null, Files = content.FileCount, Bytes = content.TotalBytes },
+                Network = new
+                {
+                    LatencyMs = cdnOptions.Latency.TotalMilliseconds,
+                    JitterMs = cdnOptions.LatencyJitter.TotalMilliseconds,
+                    cdnOptions.BytesPerSecond,
+                    cdnOptions.ErrorRate,
+                    cdnOptions.DropRate,
+                    cdnOptions.SupportRanges
+                }
+            };
+        }
+
+        private static (FakeCdn, CdnContent) StartCdn(string[] args, FakeCdnOptions cdnOptions)
+        {
+            int port = FakeCdn.FindFreePort();
+            string baseUrl = $"http://127.0.0.1:{port}";
+            string contentDirectory = Option(args, "--content-dir");
+            CdnContent content;
+            if (contentDirectory != null)
+            {
+                string versionId = Option(args, "--version");
+                if (versionId == null || !Directory.Exists(contentDirectory))
+                {
+                    Console.Error.WriteLine("--content-dir=DIR needs an existing recording and --version=ID.");
+                    return (null, null);
+                }
+                content = CdnContent.LoadRecorded(baseUrl, contentDirectory, versionId);
+            }
+            else
+            {
+                content = CdnContent.CreateSynthetic(baseUrl, new SyntheticContentOptions
+                {
+                    VersionId = Option(args, "--version") ?? "1.21.4",
+                    AssetCount = (int)Number(args, "--assets", 2000),
+                    LibraryCount = (int)Number(args, "--libraries", 80),
+                    ClientJarBytes = (long)(Number(args, "--client-mb", 20) * 1024 * 1024),
+                    JavaRuntimeBytes = (long)(Number(args, "--java-mb", 16) * 1024 * 1024),
+                    Seed = (int)Number(args, "--seed", 20240101)
+                });
+            }
+
+            var cdn = new FakeCdn(content, cdnOptions, port);
+            cdn.Start();
+            return (cdn, content);
+        }
+
+        private static FakeCdnOptions CreateCdnOptions(string[] args)
+        {
+            return new FakeCdnOptions
+            {
+                Latency = TimeSpan.FromMilliseconds(Number(args, "--latency-ms", 0)),
+                LatencyJitter = TimeSpan.FromMilliseconds(Number(args, "--jitter-ms", 0)),
+                BytesPerSecond = (long)(Number(args, "--bandwidth-mbps", 0) * 1_000_000 / 8),
+                ErrorRate = Number(args, "--error-rate", 0),
+                DropRate = Number(args, "--drop-rate", 0),
+                SupportRanges = !args.Contains("--no-ranges", StringComparer.OrdinalIgnoreCase),
+                Seed = (int)Number(args, "--seed", 1)
+            };
+        }
+
+        private static string Option(string[] args, string name)
+        {
+            string prefix = name + "=";
+            string arg = args.LastOrDefault(a => a.StartsWith(prefix, StringComparison.OrdinalIgnoreCase));
+            return arg?.Substring(prefix.Length);
+        }
+
+        private static double Number(string[] args, string name, double defaultValue)
+        {
+            string value = Option(args, name);
+            if (value == null) return defaultValue;
+            if (double.TryParse(value, NumberStyles.Float, CultureInfo.InvariantCulture, out double number) && number >= 0) return number;
+            Console.Error.WriteLine($"Ignoring {name}={value}: not a non-negative number.");
+            return defaultValue;
+        }
+    }
+}
@@ -0,0 +1,129 @@
+﻿// Harness/StubJava.cs
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Text;
+
+namespace ObsidianLauncher.Harness
+{
+    /// <summary>
+    /// What the stub "java" recorded about one launch.
+    /// </summary>
+    public sealed class StubInvocation
+    {
+        /// <summary>
+        /// Wall clock time the stub started running; null where the stub has no precise clock (Windows).
+        /// </summary>
+        public DateTime? StartedUtc { get; set; }
+
+        /// <summary>
+        /// The argv the stub received. On Windows this is the raw command line as a single entry.
+        /// </summary>
+        public List<string> Arguments { get; } = new List<string>();
+
+        /// <summary>
+        /// Size of the argument string: the arguments joined by single spaces.
+        /// </summary>
+        public int ArgumentChars { get; set; }
+
+        public Dictionary<string, string> Environment { get; } = new Dictionary<string, string>(StringComparer.Ordinal);
+    }
+
+    /// <summary>
+    /// A stand-in for the java executable, for <c>--java-executable=</c>: a shell script (a batch file on Windows) that
+    /// writes when it started, its arguments and its environment to the file named by <see cref="OutputVariable"/>,
+    /// then exits, so the launcher's own overhead can be measured without starting a JVM.
+    /// </summary>
+    public static class StubJava
+    {
+        public const string OutputVariable = "OBSIDIAN_STUB_JAVA_OUT";
+
+        // Line 1: start time in Unix nanoseconds (GNU date, else perl), line 2: argument count, then one argument
+        // per line and the environment.
+        private const string ShellScript =
+            "#!/bin/sh\n" +
+            "# Stand-in for java: records when it started, its arguments and its environment, then exits.\n" +
+            "started=$(date +%s%N)\n" +
+            "case \"$started\" in *N) started=$(perl -MTime::HiRes=time -e 'printf \"%.0f\", time * 1e9');; esac\n" +
+            "{\n" +
+            "  echo \"$started\"\n" +
+            "  echo \"$#\"\n" +
+            "  for arg in \"$@\"; do printf '%s\\n' \"$arg\"; done\n" +
+            "  env\n" +
+            "} > \"$" + OutputVariable + "\"\n";
+
+        // Batch files have no sub-second clock and no reliable argv, so line 1 is "-", line 2 "*" and line 3 the raw
+        // command line.
+        private const string BatchScript =
+            "@echo off\r\n" +
+            "rem Stand-in for java: records its arguments and its environment, then exits.\r\n" +
+            "> \"%" + OutputVariable + "%\" (\r\n" +
+            "  echo -\r\n" +
+            "  echo *\r\n" +
+            "  echo %*\r\n" +
+            "  set\r\n" +
+            ")\r\n";
+
+        /// <summary>
+        /// Writes the stub into <paramref name="directory"/> and returns its path.
+        /// </summary>
+        public static string Write(string directory)
+        {
+            Directory.CreateDirectory(directory);
+            if (OperatingSystem.IsWindows())
+            {
+                string batchPath = Path.Combine(directory, "java.cmd");
+                File.WriteAllText(batchPath, BatchScript, Encoding.ASCII);
+                return batchPath;
+            }
+
+            string path = Path.Combine(directory, "java");
+            File.WriteAllText(path, ShellScript, Encoding.ASCII);
+            File.SetUnixFileMode(path, UnixFileMode.UserRead | UnixFileMode.UserWrite | UnixFileMode.UserExecute |
+                                       UnixFileMode.GroupRead | UnixFileMode.GroupExecute |
+                                       UnixFileMode.OtherRead | UnixFileMode.OtherExecute);
+            return path;
+        }
+
+        /// <summary>
+        /// Reads what the stub wrote to <paramref name="path"/>, or returns null if it never ran.
+        /// </summary>
+        public static StubInvocation Read(string path)
+        {
+            if (!File.Exists(path)) return null;
+            string[] lines = File.ReadAllLines(path);
+            if (lines.Length < 2) return null;
+
+            var invocation = new StubInvocation();
+            if (long.TryParse(lines[0].Trim(), NumberStyles.Integer, CultureInfo.InvariantCulture, out long nanoseconds))
+            {
+                invocation.StartedUtc = DateTime.UnixEpoch.AddTicks(nanoseconds / 100);
+            }
+
+            int next;
+            if (lines[1].Trim() == "*")
+            {
+                string commandLine = lines.Length > 2 ? lines[2].Trim() : string.Empty;
+                invocation.Arguments.Add(commandLine);
+                invocation.ArgumentChars = commandLine.Length;
+                next = 3;
+            }
+            else
+            {
+                int count = int.TryParse(lines[1].Trim(), NumberStyles.Integer, CultureInfo.InvariantCulture, out int parsed) ? parsed : 0;
+                // An argument containing a newline would spill over; arguments the launcher builds never do.
+                for (next = 2; next < lines.Length && invocation.Arguments.Count < count; next++) invocation.Arguments.Add(lines[next]);
+                invocation.ArgumentChars = invocation.Arguments.Count == 0 ? 0 : invocation.Arguments.Count - 1;
+                foreach (string argument in invocation.Arguments) invocation.ArgumentChars += argument.Length;
+            }
+
+            for (; next < lines.Length; next++)
+            {
+                int equals = lines[next].IndexOf('=');
+                if (equals > 0) invocation.Environment[lines[next].Substring(0, equals)] = lines[next].Substring(equals + 1);
+            }
+            return invocation;
+        }
+    }
+}
@@ -2,6 +2,7 @@
 
 using System;
 using System.IO;
+using ObsidianLauncher.Enums;
 using Serilog;
 
 namespace ObsidianLauncher
@@ -18,6 +19,46 @@ namespace ObsidianLauncher
         public string MojangDownloadsDir { get; }
         public string AdoptiumDownloadsDir { get; }
         public string LogsDir { get; }
+        public string RefsDir { get; }
+        public string PacksDir { get; }
+        public string InstancesDir { get; }
+        public string SharedDir { get; }
+
+        /// <summary>
+        /// How installed files are synced to disk (<c>--durability=fast|batched|strict</c>).
+        /// </summary>
+        public DurabilityMode Durability { get; set; } = DurabilityMode.Batched;
+
+        /// <summary>
+        /// How bulk verification and small-file writes do their I/O (<c>--io=default|uring</c>).
+        /// </summary>
+        public IoBackend IoBackend { get; set; } = IoBackend.Default;
+
+        public const string DefaultVersionManifestUrl = "https://launchermeta.mojang.com/mc/game/version_manifest_v2.json";
+        public const string DefaultAssetResourcesUrl = "https://resources.download.minecraft.net/";
+        public const string DefaultJavaRuntimeManifestUrl = "https://launchermeta.mojang.com/v1/products/java-runtime/2ec0cc96c44e5a76b9c8b7c39df7210883d12871/all.json";
+        public const string DefaultAdoptiumApiUrl = "https://api.adoptium.net/v3";
+
+        /// <summary>
+        /// Mojang's version manifest (<c>--version-manifest-url=URL</c>). Version JSONs, libraries, client jars and asset
+        /// indexes are fetched from the URLs the manifest and version JSONs name, so a mirror rewrites those itself.
+        /// </summary>
+        public string VersionManifestUrl { get; set; } = DefaultVersionManifestUrl;
+
+        /// <summary>
+        /// Base URL of asset objects, which are addressed as <c>{base}/{hash[0..2]}/{hash}</c> (<c>--assets-url=URL</c>).
+        /// </summary>
+        public string AssetResourcesUrl { get; set; } = DefaultAssetResourcesUrl;
+
+        /// <summary>
+        /// Mojang's Java runtime manifest, the fallback runtime source (<c>--java-manifest-url=URL</c>).
+        /// </summary>
+        public string JavaRuntimeManifestUrl { get; set; } = DefaultJavaRuntimeManifestUrl;
+
+        /// <summary>
+        /// Base URL of the Adoptium v3 API, the preferred runtime source (<c>--adoptium-url=URL</c>).
+        /// </summary>
+        public string AdoptiumApiUrl { get; set; } = DefaultAdoptiumApiUrl;
 
         public static readonly string VERSION = "1.0"; // Version of the launcher
 
@@ -35,6 +76,10 @@ namespace ObsidianLauncher
             MojangDownloadsDir = Path.Combine(JavaRuntimesDir, "_downloads", "mojang");
             AdoptiumDownloadsDir = Path.Combine(JavaRuntimesDir, "_downloads", "adoptium");
             LogsDir = Path.Combine(BaseDataPath, "logs");
+            RefsDir = Path.Combine(BaseDataPath, "refs");
+            PacksDir = Path.Combine(BaseDataPath, "packs");
+            InstancesDir = Path.Combine(BaseDataPath, "instances");
+            SharedDir = Path.Combine(BaseDataPath, "shared");
 
             EnsureDirectoryExists(BaseDataPath, "Base Data");
             EnsureDirectoryExists(JavaRuntimesDir, "Java Runtimes");
@@ -46,6 +91,10 @@ namespace ObsidianLauncher
             EnsureDirectoryExists(LibrariesDir, "Libraries");
             EnsureDirectoryExists(VersionsDir, "Versions");
             EnsureDirectoryExists(LogsDir, "Logs");
+            EnsureDirectoryExists(RefsDir, "Store References");
+            EnsureDirectoryExists(PacksDir, "Version Packs");
+            EnsureDirectoryExists(InstancesDir, "Instances");
+            EnsureDirectoryExists(SharedDir, "Shared Content");
         }
 
         private void EnsureDirectoryExists(string path, string name)
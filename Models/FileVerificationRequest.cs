@@ -0,0 +1,36 @@
+﻿// Models/FileVerificationRequest.cs
+namespace ObsidianLauncher.Models
+{
+    /// <summary>
+    /// One file for <see cref="Utils.CryptoUtils.VerifyFilesAsync"/> to check.
+    /// </summary>
+    public class FileVerificationRequest
+    {
+        public FileVerificationRequest(string path, long? expectedSize, string expectedSha1)
+        {
+            Path = path;
+            ExpectedSize = expectedSize;
+            ExpectedSha1 = expectedSha1;
+        }
+
+        /// <summary>
+        /// Path of the file to check.
+        /// </summary>
+        public string Path { get; }
+
+        /// <summary>
+        /// Expected length in bytes, or null to skip the size check.
+        /// </summary>
+        public long? ExpectedSize { get; }
+
+        /// <summary>
+        /// Expected SHA1 (hex). Null or empty checks existence and size only, without reading the file.
+        /// </summary>
+        public string ExpectedSha1 { get; }
+
+        /// <summary>
+        /// Optional caller data carried through to the result (e.g. the originating work item).
+        /// </summary>
+        public object Tag { get; set; }
+    }
+}
@@ -0,0 +1,31 @@
+﻿// Models/FileVerificationResult.cs
+using ObsidianLauncher.Enums;
+
+namespace ObsidianLauncher.Models
+{
+    /// <summary>
+    /// Result of checking one <see cref="FileVerificationRequest"/>.
+    /// </summary>
+    public class FileVerificationResult
+    {
+        public FileVerificationRequest Request { get; set; }
+        public FileVerificationStatus Status { get; set; }
+
+        /// <summary>
+        /// Length of the file on disk, or -1 if it could not be determined.
+        /// </summary>
+        public long ActualSize { get; set; } = -1;
+
+        /// <summary>
+        /// SHA1 (lowercase hex) of the file, if it was hashed.
+        /// </summary>
+        public string ActualSha1 { get; set; }
+
+        /// <summary>
+        /// Error description for <see cref="FileVerificationStatus.Error"/>.
+        /// </summary>
+        public string Error { get; set; }
+
+        public bool IsValid => Status == FileVerificationStatus.Valid;
+    }
+}
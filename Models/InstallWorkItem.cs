@@ -0,0 +1,50 @@
+﻿// Models/InstallWorkItem.cs
+using System;
+using System.IO;
+using ObsidianLauncher.Enums;
+
+namespace ObsidianLauncher.Models
+{
+    /// <summary>
+    /// A single file the launcher needs on disk: where it comes from, where it goes and how to verify it.
+    /// Work items from several versions can be merged into one set; items with the same <see cref="Key"/>
+    /// describe the same file and are only processed once.
+    /// </summary>
+    public class InstallWorkItem
+    {
+        public InstallWorkKind Kind { get; set; }
+
+        /// <summary>
+        /// The URL to download the file from.
+        /// </summary>
+        public string Url { get; set; }
+
+        /// <summary>
+        /// The absolute local path the file is stored at.
+        /// </summary>
+        public string LocalPath { get; set; }
+
+        /// <summary>
+        /// Expected SHA1 of the file. Null or empty if the source provides none.
+        /// </summary>
+        public string Sha1 { get; set; }
+
+        /// <summary>
+        /// Expected size in bytes, if known.
+        /// </summary>
+        public ulong? Size { get; set; }
+
+        /// <summary>
+        /// Human readable description used in log messages (e.g., "Library artifact com.mojang:brigadier:1.0.18").
+        /// </summary>
+        public string Description { get; set; }
+
+        /// <summary>
+        /// Deduplication key. Assets are content addressed, so their path already encodes the hash;
+        /// libraries and JARs are keyed by their storage path.
+        /// </summary>
+        public string Key => Path.GetFullPath(LocalPath);
+
+        public override string ToString() => $"{Kind}: {Description ?? LocalPath}";
+    }
+}
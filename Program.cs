@@ -2,20 +2,23 @@
 using System;
 using System.Collections.Generic;
 using System.Diagnostics; // Required for Process related classes
+using System.Globalization;
 using System.IO;
 using System.Linq;
+using System.Net;
 using System.Net.Http;
 using System.Text.Json;
 using System.Threading;
 using System.Threading.Tasks;
 using Serilog;
+using Serilog.Events;
 
 // Specific using directives for your project's namespaces
 using ObsidianLauncher; // For LauncherConfig
 using ObsidianLauncher.Models;
 using ObsidianLauncher.Services;
+using ObsidianLauncher.Enums;
 using ObsidianLauncher.Utils;
-// using ObsidianLauncher.Enums; // If you need direct access to enums here
 
 public class Program
 {
@@ -44,187 +47,531 @@ public class Program
             return; // Exit if basic setup fails
         }
 
+        // --- Daemon client: `ctl <command> [args] [--option[=value]]...` (talks to a running `daemon`, then exits) ---
+        if (args.Length > 0 && args[0].Equals("ctl", StringComparison.OrdinalIgnoreCase))
+        {
+            var request = DaemonClient.CreateRequest(args.Skip(1).Where(a => !a.StartsWith("--socket=", StringComparison.OrdinalIgnoreCase)));
+            if (!request.ContainsKey("command"))
+            {
+                Log.Error("Usage: ctl status|list|jobs|install|launch|prefetch|progress|cancel|set-level|metrics|shutdown [args] [--socket=PATH]");
+                Environment.ExitCode = 2;
+            }
+            else
+            {
+                Environment.ExitCode = await new DaemonClient(ParseSocketPath(args, launcherConfig)).SendAsync(request, Console.Out, _cts.Token);
+            }
+            await Log.CloseAndFlushAsync();
+            return;
+        }
+
         Log.Information("==================================================");
         Log.Information("  Obsidian Launcher v{Version}",
             LauncherConfig.VERSION);
         Log.Information("==================================================");
         Log.Information("Data directory: {BaseDataPath}", launcherConfig.BaseDataPath);
         Log.Information("Log directory: {LogsDir}", launcherConfig.LogsDir);
+        ApplyLogLevels(args);
+        // `--trace[=path]` records spans for phases, downloads, hashing and extraction as a Chrome trace.
+        ChromeTraceExporter traceExporter = CreateTraceExporter(args, launcherConfig);
+        // Create the EventCounter source up front so dotnet-counters can attach to it at any time.
+        _ = LauncherEventSource.Log;
+        launcherConfig.Durability = ParseDurability(args, launcherConfig.Durability);
+        Log.Information("Durability mode: {Durability}", launcherConfig.Durability);
+        launcherConfig.IoBackend = ParseIoBackend(args, launcherConfig.IoBackend);
+        IoUringFileBatch.Backend = launcherConfig.IoBackend;
+        if (launcherConfig.IoBackend != IoBackend.Default)
+        {
+            Log.Information("I/O backend: {IoBackend}{Fallback}", launcherConfig.IoBackend,
+                IoUringFileBatch.IsAvailable ? string.Empty : " (not available, using the default path)");
+        }
+        // Endpoint overrides point the launcher at a mirror or at the install harness's local stand-in CDN.
+        ApplyEndpointOverrides(args, launcherConfig);
 
         // --- Initialize Services ---
         using var httpManager = new HttpManager();
-        var javaManager = new JavaManager(launcherConfig, httpManager);
-        var assetManager = new AssetManager(launcherConfig, httpManager);
-        var libraryManager = new LibraryManager(launcherConfig, httpManager);
+        // The journal lets an interrupted install (crash or Ctrl+C) resume instead of starting over.
+        using var installJournal = InstallJournal.Open(launcherConfig);
+        // Cross-process locks let several launchers share one data directory without duplicating downloads.
+        var fileLocks = new FileLockManager(launcherConfig);
+        // `--peer-cache` shares verified files with launchers on the LAN and asks them before downloading upstream.
+        bool peerServeMode = args.Length > 0 && args[0].Equals("peer-serve", StringComparison.OrdinalIgnoreCase);
+        using PeerCache peerCache = CreatePeerCache(args, installJournal, peerServeMode);
+        var downloadScheduler = new DownloadScheduler(httpManager, journal: installJournal, locks: fileLocks, durability: launcherConfig.Durability,
+            peerCache: peerCache);
+        var versionCatalog = new VersionCatalog(launcherConfig, httpManager);
+        var javaManager = new JavaManager(launcherConfig, httpManager, fileLocks);
+        var assetManager = new AssetManager(launcherConfig, httpManager, downloadScheduler);
+        var libraryManager = new LibraryManager(launcherConfig, httpManager, downloadScheduler);
+        var contentStore = new ContentStore(launcherConfig, fileLocks, versionCatalog, libraryManager, javaManager);
+        var versionAccess = new VersionAccessStats(launcherConfig);
+        var versionTiering = new VersionTiering(launcherConfig, contentStore, versionAccess, fileLocks);
+        var installPlanner = new InstallPlanner(launcherConfig, assetManager, libraryManager, javaManager, downloadScheduler, contentStore: contentStore, journal: installJournal);
+        var instanceManager = new InstanceManager(launcherConfig);
         var argumentBuilder = new ArgumentBuilder(launcherConfig);
         var gameLauncher = new GameLauncher(launcherConfig);
 
-        try
+        // `--watch-store` drops the journal's verified records for store files edited while this process runs.
+        using var storeWatchCts = CancellationTokenSource.CreateLinkedTokenSource(_cts.Token);
+        Task storeWatch = Task.CompletedTask;
+        if (args.Contains("--watch-store", StringComparer.OrdinalIgnoreCase))
         {
-            // --- Step 1: Fetch and Parse Version Manifest ---
-            Log.Information("Fetching Minecraft version manifest from Mojang...");
-            HttpResponseMessage manifestResponseMsg = await httpManager.GetAsync(
-                "https://launchermeta.mojang.com/mc/game/version_manifest_v2.json",
-                cancellationToken: _cts.Token);
+            storeWatch = new StoreWatcher(launcherConfig, installJournal).Start(storeWatchCts.Token);
+        }
 
-            if (_cts.IsCancellationRequested) { Log.Warning("Manifest fetch cancelled."); return; }
+        // `--metrics[=PORT]` serves Prometheus metrics on 127.0.0.1 while the launcher runs.
+        using var metricsCts = CancellationTokenSource.CreateLinkedTokenSource(_cts.Token);
+        MetricsEndpoint metricsEndpoint = CreateMetricsEndpoint(args);
+        Task metricsServer = metricsEndpoint?.Start(metricsCts.Token) ?? Task.CompletedTask;
+
+        // The peer cache keeps serving while the game runs; `peer-serve` runs it in the foreground instead.
+        using var peerCacheCts = CancellationTokenSource.CreateLinkedTokenSource(_cts.Token);
+        Task peerCacheServer = peerCache != null && !peerServeMode ? peerCache.Start(peerCacheCts.Token) : Task.CompletedTask;
+
+        Activity runActivity = LauncherTracing.Start("launcher.run");
+        runActivity?.SetTag("command", args.Length > 0 && !args[0].StartsWith("--", StringComparison.Ordinal) ? args[0] : "launch");
+        var phases = new PhaseTimer();
+        // Install and launch runs are appended to the performance history (`perf-report`) unless `--no-history` is given.
+        var performanceHistory = new PerformanceHistory(launcherConfig);
+        PerformanceRunRecorder historyRun = null;
+        string historyVersionId = null;
+        DownloadRunSummary historyDownloads = null;
+        bool historyLaunched = false;
+        bool historyInstalled = false;
+        try
+        {
+            // --- Store watch mode: `watch-store` (runs until Ctrl+C) ---
+            if (args.Length > 0 && args[0].Equals("watch-store", StringComparison.OrdinalIgnoreCase))
+            {
+                await new StoreWatcher(launcherConfig, installJournal).RunAsync(_cts.Token);
+                return;
+            }
 
-            if (!manifestResponseMsg.IsSuccessStatusCode)
+            // --- Peer cache mode: `peer-serve [--peer-port=N] [--peers=HOST:PORT,...]` (shares this data directory with LAN peers until Ctrl+C) ---
+            if (peerServeMode)
             {
-                string errorContent = await manifestResponseMsg.Content.ReadAsStringAsync(_cts.Token);
-                Log.Fatal("Failed to fetch version manifest. Status: {StatusCode}, URL: {Url}, Error: {ErrorContent}",
-                    manifestResponseMsg.StatusCode, manifestResponseMsg.RequestMessage?.RequestUri, errorContent);
+                bool served = await peerCache.RunAsync(_cts.Token, requireServing: true);
+                if (!served) Environment.ExitCode = 1;
                 return;
             }
 
-            string manifestJsonString = await manifestResponseMsg.Content.ReadAsStringAsync(_cts.Token);
-            Log.Information("Successfully fetched version manifest (status {StatusCode}). Size: {Length} bytes",
-                manifestResponseMsg.StatusCode, manifestJsonString.Length);
+            // --- Daemon mode: `daemon [--socket=PATH] [--background-scrub]` (serves `ctl` clients until Ctrl+C or `ctl shutdown`) ---
+            if (args.Length > 0 && args[0].Equals("daemon", StringComparison.OrdinalIgnoreCase))
+            {
+                // The journal's verified records stay trusted across jobs only while edits to the stores are noticed.
+                if (!args.Contains("--watch-store", StringComparer.OrdinalIgnoreCase))
+                {
+                    storeWatch = new StoreWatcher(launcherConfig, installJournal).Start(storeWatchCts.Token);
+                }
+                using var daemonScrubCts = CancellationTokenSource.CreateLinkedTokenSource(_cts.Token);
+                Task daemonScrub = Task.CompletedTask;
+                if (args.Contains("--background-scrub", StringComparer.OrdinalIgnoreCase))
+                {
+                    var scrubber = new IntegrityScrubber(launcherConfig, httpManager, versionCatalog, assetManager, libraryManager,
+                        installJournal, CreateScrubOptions(args), fileLocks);
+                    daemonScrub = scrubber.Start(daemonScrubCts.Token);
+                }
 
-            VersionManifest versionManifestAll = JsonSerializer.Deserialize<VersionManifest>(manifestJsonString,
-                new JsonSerializerOptions { PropertyNameCaseInsensitive = true });
+                var prefetchService = new PrefetchService(launcherConfig, versionCatalog, assetManager, libraryManager, javaManager, downloadScheduler);
+                var daemon = new LauncherDaemon(launcherConfig, ParseSocketPath(args, launcherConfig), versionCatalog, installPlanner, assetManager,
+                    javaManager, prefetchService, installJournal, instanceManager, versionAccess, versionTiering);
+                bool served = await daemon.RunAsync(_cts.Token);
+                daemonScrubCts.Cancel();
+                await daemonScrub;
+                if (!served) Environment.ExitCode = 1;
+                return;
+            }
 
-            if (versionManifestAll?.Versions == null)
+            // --- Headless prefetch mode: `prefetch <selector>... [--no-java]` ---
+            if (args.Length > 0 && args[0].Equals("prefetch", StringComparison.OrdinalIgnoreCase))
             {
-                Log.Fatal("Failed to parse version manifest or no versions found.");
+                var selectors = args.Skip(1).Where(a => !a.StartsWith("--")).ToList();
+                bool includeRuntimes = !args.Contains("--no-java", StringComparer.OrdinalIgnoreCase);
+                if (selectors.Count == 0)
+                {
+                    Log.Error("Usage: prefetch <version|glob|latest-release|latest-snapshot|type:TYPE>... [--no-java]");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+
+                var prefetchService = new PrefetchService(launcherConfig, versionCatalog, assetManager, libraryManager, javaManager, downloadScheduler);
+                bool prefetchOk = await prefetchService.PrefetchAsync(selectors, includeRuntimes, _cts.Token);
+                if (!prefetchOk) Environment.ExitCode = 1;
                 return;
             }
-            Log.Verbose("Version manifest JSON parsed successfully. Found {Count} versions.", versionManifestAll.Versions.Count);
 
-            // --- Step 2: Select a Version and Get its Details ---
-            string versionIdToLaunch = "1.20.4"; // Default
-            if (args.Length > 0 && !string.IsNullOrWhiteSpace(args[0]))
+            // --- Background prefetch watch mode: `prefetch-watch [--no-snapshots]` (runs until Ctrl+C) ---
+            if (args.Length > 0 && args[0].Equals("prefetch-watch", StringComparison.OrdinalIgnoreCase))
             {
-                versionIdToLaunch = args[0];
-                Log.Information("Overriding target version with command line argument: {VersionId}", versionIdToLaunch);
+                var watcher = new BackgroundPrefetcher(launcherConfig, httpManager, versionCatalog, assetManager, libraryManager,
+                    CreateBackgroundPrefetchOptions(args), fileLocks);
+                await watcher.RunAsync(_cts.Token);
+                return;
             }
-            Log.Information("Target Minecraft version for setup: {VersionId}", versionIdToLaunch);
 
-            var selectedVersionMeta = versionManifestAll.Versions.FirstOrDefault(v => v.Id == versionIdToLaunch);
-            if (selectedVersionMeta == null || string.IsNullOrEmpty(selectedVersionMeta.Url))
+            // --- Integrity scrub: `scrub [--scrub-rate-kb=N] [--no-repair]` (finishes the current pass; Ctrl+C pauses it) ---
+            if (args.Length > 0 && args[0].Equals("scrub", StringComparison.OrdinalIgnoreCase))
             {
-                Log.Error("Target version '{VersionId}' not found in manifest or URL is missing.", versionIdToLaunch);
+                var scrubber = new IntegrityScrubber(launcherConfig, httpManager, versionCatalog, assetManager, libraryManager,
+                    installJournal, CreateScrubOptions(args), fileLocks);
+                try
+                {
+                    ScrubReport scrubReport = await scrubber.RunPassAsync(_cts.Token);
+                    if (scrubReport != null && (scrubReport.Unrepaired > 0 || scrubReport.CorruptRuntimeFiles > 0)) Environment.ExitCode = 1;
+                }
+                catch (OperationCanceledException)
+                {
+                    // The position was saved; the next run continues from there.
+                }
                 return;
             }
-            Log.Information("Found URL for version '{VersionId}': {Url}", versionIdToLaunch, selectedVersionMeta.Url);
 
-            Log.Information("Fetching details for version '{VersionId}'...", versionIdToLaunch);
-            HttpResponseMessage versionDetailsResponseMsg = await httpManager.GetAsync(selectedVersionMeta.Url, cancellationToken: _cts.Token);
+            // --- Store maintenance: `gc [--execute] [--min-age-hours=N]` and `uninstall <version>` ---
+            if (args.Length > 0 && args[0].Equals("gc", StringComparison.OrdinalIgnoreCase))
+            {
+                bool execute = args.Contains("--execute", StringComparer.OrdinalIgnoreCase);
+                TimeSpan? minimumAge = null;
+                string ageArg = args.FirstOrDefault(a => a.StartsWith("--min-age-hours=", StringComparison.OrdinalIgnoreCase));
+                if (ageArg != null && double.TryParse(ageArg.Substring("--min-age-hours=".Length), NumberStyles.Float, CultureInfo.InvariantCulture, out double ageHours) && ageHours >= 0)
+                {
+                    minimumAge = TimeSpan.FromHours(ageHours);
+                }
+                GcReport gcReport = await contentStore.CollectGarbageAsync(execute, minimumAge, _cts.Token);
+                if (!execute && gcReport.CandidateCount > 0) Log.Information("Dry run; re-run with --execute to delete.");
+                return;
+            }
+            if (args.Length > 0 && args[0].Equals("uninstall", StringComparison.OrdinalIgnoreCase))
+            {
+                string uninstallId = args.Skip(1).FirstOrDefault(a => !a.StartsWith("--"));
+                if (uninstallId == null)
+                {
+                    Log.Error("Usage: uninstall <version>");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+                if (!await contentStore.RemoveVersionAsync(uninstallId, _cts.Token)) Environment.ExitCode = 1;
+                return;
+            }
 
-            if (_cts.IsCancellationRequested) { Log.Warning("Version details fetch cancelled."); return; }
+            // --- Storage tiering: `tier --budget-mb=N [--execute]` ---
+            if (args.Length > 0 && args[0].Equals("tier", StringComparison.OrdinalIgnoreCase))
+            {
+                long? tierBudget = ParseTierBudget(args, "--budget-mb=");
+                if (tierBudget == null)
+                {
+                    Log.Error("Usage: tier --budget-mb=N [--execute]");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+                bool execute = args.Contains("--execute", StringComparer.OrdinalIgnoreCase);
+                TieringReport tieringReport = await versionTiering.ApplyBudgetAsync(tierBudget.Value, execute, _cts.Token);
+                if (!execute && tieringReport.Cold.Count > 0) Log.Information("Dry run; re-run with --execute to pack the cold versions.");
+                return;
+            }
 
-            if (!versionDetailsResponseMsg.IsSuccessStatusCode)
+            // --- Instances: `instance create <name> <version> [--share=a,b]`, `instance clone <src> <name>`, `instance list`, `instance delete <name>` ---
+            if (args.Length > 0 && args[0].Equals("instance", StringComparison.OrdinalIgnoreCase))
             {
-                string errorContent = await versionDetailsResponseMsg.Content.ReadAsStringAsync(_cts.Token);
-                Log.Error("Failed to fetch version details for '{VersionId}'. Status: {StatusCode}, URL: {Url}, Error: {ErrorContent}",
-                    versionIdToLaunch, versionDetailsResponseMsg.StatusCode, versionDetailsResponseMsg.RequestMessage?.RequestUri, errorContent);
+                var instanceArgs = args.Skip(1).Where(a => !a.StartsWith("--")).ToList();
+                string subcommand = instanceArgs.FirstOrDefault()?.ToLowerInvariant();
+                if (subcommand == "list")
+                {
+                    foreach (var profile in instanceManager.List())
+                    {
+                        Log.Information("{Name,-24} {VersionId,-16} created {Created:u}, last launched {LastLaunch}",
+                            profile.Name, profile.VersionId, profile.CreatedUtc, profile.LastLaunchUtc?.ToString("u") ?? "never");
+                    }
+                    return;
+                }
+                if (subcommand == "create" && instanceArgs.Count == 3)
+                {
+                    string shareArg = args.FirstOrDefault(a => a.StartsWith("--share=", StringComparison.OrdinalIgnoreCase));
+                    var categories = shareArg?.Substring("--share=".Length).Split(',', StringSplitOptions.RemoveEmptyEntries);
+                    if (instanceManager.Create(instanceArgs[1], instanceArgs[2], categories) == null) Environment.ExitCode = 1;
+                    return;
+                }
+                if (subcommand == "clone" && instanceArgs.Count == 3)
+                {
+                    if (instanceManager.Clone(instanceArgs[1], instanceArgs[2]) == null) Environment.ExitCode = 1;
+                    return;
+                }
+                if (subcommand == "delete" && instanceArgs.Count == 2)
+                {
+                    if (!instanceManager.Delete(instanceArgs[1])) Environment.ExitCode = 1;
+                    return;
+                }
+                Log.Error("Usage: instance create <name> <version> [--share={Categories}] | instance clone <source> <name> | instance list | instance delete <name>",
+                    string.Join(",", InstanceManager.SharedCategoryNames));
+                Environment.ExitCode = 2;
                 return;
             }
-            string versionDetailsJsonString = await versionDetailsResponseMsg.Content.ReadAsStringAsync(_cts.Token);
-            Log.Information("Successfully fetched version details for '{VersionId}'. Size: {Length} bytes",
-                versionIdToLaunch, versionDetailsJsonString.Length);
 
-            MinecraftVersion minecraftVersion = JsonSerializer.Deserialize<MinecraftVersion>(versionDetailsJsonString,
-                new JsonSerializerOptions { PropertyNameCaseInsensitive = true });
+            // --- Durability measurement mode: `bench-durability <version> [--files=N]` ---
+            if (args.Length > 0 && args[0].Equals("bench-durability", StringComparison.OrdinalIgnoreCase))
+            {
+                string benchVersionId = args.Skip(1).FirstOrDefault(a => !a.StartsWith("--"));
+                if (benchVersionId == null)
+                {
+                    Log.Error("Usage: bench-durability <version> [--files=N]");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+                VersionManifest benchManifest = await versionCatalog.GetManifestAsync(cancellationToken: _cts.Token);
+                var benchMeta = benchManifest?.Versions.FirstOrDefault(v => v.Id == benchVersionId);
+                MinecraftVersion benchVersion = benchMeta != null ? await versionCatalog.GetVersionAsync(benchMeta, _cts.Token) : null;
+                List<InstallWorkItem> benchAssets = benchVersion != null ? await assetManager.CollectAssetWorkItemsAsync(benchVersion, _cts.Token) : null;
+                if (benchAssets == null)
+                {
+                    Log.Error("Could not resolve the asset index of version {VersionId}.", benchVersionId);
+                    Environment.ExitCode = 1;
+                    return;
+                }
+                int maxFiles = 0;
+                string filesArg = args.FirstOrDefault(a => a.StartsWith("--files=", StringComparison.OrdinalIgnoreCase));
+                if (filesArg != null) int.TryParse(filesArg.Substring("--files=".Length), out maxFiles);
+                new DurabilityBenchmark(launcherConfig).Run(benchAssets, maxFiles, _cts.Token);
+                return;
+            }
 
-            if (minecraftVersion == null)
+            // --- Verification measurement mode: `bench-verify <version> [--parallelism=N]` ---
+            if (args.Length > 0 && args[0].Equals("bench-verify", StringComparison.OrdinalIgnoreCase))
             {
-                Log.Fatal("Failed to parse details for version '{VersionId}'.", versionIdToLaunch);
+                string benchVersionId = args.Skip(1).FirstOrDefault(a => !a.StartsWith("--"));
+                if (benchVersionId == null)
+                {
+                    Log.Error("Usage: bench-verify <version> [--parallelism=N]");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+                VersionManifest benchManifest = await versionCatalog.GetManifestAsync(cancellationToken: _cts.Token);
+                var benchMeta = benchManifest?.Versions.FirstOrDefault(v => v.Id == benchVersionId);
+                MinecraftVersion benchVersion = benchMeta != null ? await versionCatalog.GetVersionAsync(benchMeta, _cts.Token) : null;
+                InstallPlan benchPlan = benchVersion != null ? await installPlanner.CreatePlanAsync(benchVersion, _cts.Token) : null;
+                if (benchPlan == null)
+                {
+                    Log.Error("Could not resolve the files of version {VersionId}.", benchVersionId);
+                    Environment.ExitCode = 1;
+                    return;
+                }
+                int parallelism = 0;
+                string parallelismArg = args.FirstOrDefault(a => a.StartsWith("--parallelism=", StringComparison.OrdinalIgnoreCase));
+                if (parallelismArg != null) int.TryParse(parallelismArg.Substring("--parallelism=".Length), out parallelism);
+                await new VerifyBenchmark().RunAsync(benchPlan.Files.Select(f => f.Item).ToList(), parallelism, _cts.Token);
                 return;
             }
-            Log.Information("Successfully parsed Minecraft version object: {Id} (Type: {Type})", minecraftVersion.Id, minecraftVersion.Type);
 
-            // --- Step 3: Ensure Java Runtime ---
-            Log.Information("--- Ensuring Java Runtime for Minecraft {VersionId} ---", minecraftVersion.Id);
-            JavaRuntimeInfo javaRuntime = await javaManager.EnsureJavaForMinecraftVersionAsync(minecraftVersion, _cts.Token);
+            // --- I/O backend measurement mode: `bench-io <version>` ---
+            if (args.Length > 0 && args[0].Equals("bench-io", StringComparison.OrdinalIgnoreCase))
+            {
+                string benchVersionId = args.Skip(1).FirstOrDefault(a => !a.StartsWith("--"));
+                if (benchVersionId == null)
+                {
+                    Log.Error("Usage: bench-io <version>");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+                VersionManifest benchManifest = await versionCatalog.GetManifestAsync(cancellationToken: _cts.Token);
+                var benchMeta = benchManifest?.Versions.FirstOrDefault(v => v.Id == benchVersionId);
+                MinecraftVersion benchVersion = benchMeta != null ? await versionCatalog.GetVersionAsync(benchMeta, _cts.Token) : null;
+                InstallPlan benchPlan = benchVersion != null ? await installPlanner.CreatePlanAsync(benchVersion, _cts.Token) : null;
+                if (benchPlan == null)
+                {
+                    Log.Error("Could not resolve the files of version {VersionId}.", benchVersionId);
+                    Environment.ExitCode = 1;
+                    return;
+                }
+                await new IoBackendBenchmark(launcherConfig).RunAsync(benchPlan.Files.Select(f => f.Item).ToList(), _cts.Token);
+                return;
+            }
 
-            if (_cts.IsCancellationRequested) { Log.Warning("Java setup cancelled."); return; }
+            // --- Logging cost measurement mode: `bench-logging <version> [--runs=N]` ---
+            if (args.Length > 0 && args[0].Equals("bench-logging", StringComparison.OrdinalIgnoreCase))
+            {
+                string benchVersionId = args.Skip(1).FirstOrDefault(a => !a.StartsWith("--"));
+                if (benchVersionId == null)
+                {
+                    Log.Error("Usage: bench-logging <version> [--runs=N]");
+                    Environment.ExitCode = 2;
+                    return;
+                }
+                VersionManifest benchManifest = await versionCatalog.GetManifestAsync(cancellationToken: _cts.Token);
+                var benchMeta = benchManifest?.Versions.FirstOrDefault(v => v.Id == benchVersionId);
+                MinecraftVersion benchVersion = benchMeta != null ? await versionCatalog.GetVersionAsync(benchMeta, _cts.Token) : null;
+                InstallPlan benchPlan = benchVersion != null ? await installPlanner.CreatePlanAsync(benchVersion, _cts.Token) : null;
+                if (benchPlan == null)
+                {
+                    Log.Error("Could not resolve the files of version {VersionId}.", benchVersionId);
+                    Environment.ExitCode = 1;
+                    return;
+                }
+                int runs = 5;
+                string runsArg = args.FirstOrDefault(a => a.StartsWith("--runs=", StringComparison.OrdinalIgnoreCase));
+                if (runsArg != null && int.TryParse(runsArg.Substring("--runs=".Length), out int parsedRuns) && parsedRuns > 0) runs = parsedRuns;
+                await new LoggingBenchmark(downloadScheduler).RunAsync(benchPlan.Files.Select(f => f.Item).ToList(), runs, _cts.Token);
+                return;
+            }
 
-            if (javaRuntime == null)
+            // --- Performance history: `perf-report [version] [--baseline=N] [--threshold=PCT]` (exit code 1 on a regression) ---
+            if (args.Length > 0 && args[0].Equals("perf-report", StringComparison.OrdinalIgnoreCase))
             {
-                Log.Error("Failed to obtain a suitable Java runtime for Minecraft version '{VersionId}'. Cannot proceed.", minecraftVersion.Id);
+                string reportVersionId = args.Skip(1).FirstOrDefault(a => !a.StartsWith("--"));
+                int baselineRuns = 10;
+                double threshold = 20;
+                string baselineArg = args.FirstOrDefault(a => a.StartsWith("--baseline=", StringComparison.OrdinalIgnoreCase));
+                if (baselineArg != null && int.TryParse(baselineArg.Substring("--baseline=".Length), out int parsedBaseline) && parsedBaseline > 0) baselineRuns = parsedBaseline;
+                string thresholdArg = args.FirstOrDefault(a => a.StartsWith("--threshold=", StringComparison.OrdinalIgnoreCase));
+                if (thresholdArg != null && double.TryParse(thresholdArg.Substring("--threshold=".Length), NumberStyles.Float, CultureInfo.InvariantCulture, out double parsedThreshold) && parsedThreshold > 0) threshold = parsedThreshold;
+                PerformanceReport report = performanceHistory.CreateReport(reportVersionId, baselineRuns, threshold);
+                performanceHistory.LogReport(report, threshold);
+                if (report != null && report.Regressions.Count > 0) Environment.ExitCode = 1;
                 return;
             }
-            Log.Information("Java Runtime Ensured: {JavaExecutablePath}", javaRuntime.JavaExecutablePath);
 
+            // --- Step 1: Fetch and Parse Version Manifest ---
+            phases.Next("manifest");
+            if (!args.Contains("--no-history", StringComparer.OrdinalIgnoreCase)) historyRun = performanceHistory.BeginRun("launch");
+            VersionManifest versionManifestAll = await versionCatalog.GetManifestAsync(cancellationToken: _cts.Token);
+            if (versionManifestAll == null)
+            {
+                Log.Fatal("Failed to fetch or parse the version manifest.");
+                Environment.ExitCode = 1;
+                return;
+            }
 
-            // --- Step 4: Download/Verify Assets ---
-            Log.Information("--- Ensuring Assets for Minecraft {VersionId} ---", minecraftVersion.Id);
-            var assetProgress = new Progress<AssetDownloadProgress>(report =>
+            // --- Step 2: Select a Version and Get its Details ---
+            phases.Next("version");
+            // `plan <version>` (or `--dry-run`) stops after printing the install plan.
+            bool planCommand = args.Length > 0 && args[0].Equals("plan", StringComparison.OrdinalIgnoreCase);
+            bool dryRun = planCommand || args.Contains("--dry-run", StringComparer.OrdinalIgnoreCase);
+
+            // `--instance=<name>` runs the game in that instance's directory and defaults to its version.
+            InstanceProfile instance = null;
+            string instanceArg = args.FirstOrDefault(a => a.StartsWith("--instance=", StringComparison.OrdinalIgnoreCase));
+            if (instanceArg != null)
             {
-                if (report.ProcessedFiles % Math.Max(1, report.TotalFiles / 20) == 0 || report.ProcessedFiles == report.TotalFiles)
+                instance = instanceManager.Get(instanceArg.Substring("--instance=".Length));
+                if (instance == null)
                 {
-                    Log.Information(
-                        "[Assets] Progress: {Processed}/{Total} files ({OverallPercent:F1}%) - Current: {CurrentFile}",
-                        report.ProcessedFiles, report.TotalFiles,
-                        (report.TotalFiles > 0 ? (double)report.ProcessedFiles / report.TotalFiles * 100 : 0),
-                        report.CurrentFile ?? "...");
+                    Log.Error("Instance '{Name}' does not exist; create it with `instance create`.", instanceArg.Substring("--instance=".Length));
+                    Environment.ExitCode = 2;
+                    return;
                 }
-            });
-            bool assetsOk = await assetManager.EnsureAssetsAsync(minecraftVersion, assetProgress, _cts.Token);
+            }
 
-            if (_cts.IsCancellationRequested) { Log.Warning("Asset processing cancelled."); return; }
-            if (!assetsOk)
+            string versionIdToLaunch = instance?.VersionId ?? "1.20.4"; // Default
+            string versionArgument = args.Skip(planCommand ? 1 : 0).FirstOrDefault(a => !a.StartsWith("--"));
+            if (!string.IsNullOrWhiteSpace(versionArgument))
             {
-                Log.Error("Asset download or verification failed for version {VersionId}. Cannot proceed.", minecraftVersion.Id);
+                versionIdToLaunch = versionArgument;
+                Log.Information("Overriding target version with command line argument: {VersionId}", versionIdToLaunch);
+            }
+            Log.Information("Target Minecraft version for setup: {VersionId}", versionIdToLaunch);
+
+            var selectedVersionMeta = versionManifestAll.Versions.FirstOrDefault(v => v.Id == versionIdToLaunch);
+            if (selectedVersionMeta == null || string.IsNullOrEmpty(selectedVersionMeta.Url))
+            {
+                Log.Error("Target version '{VersionId}' not found in manifest or URL is missing.", versionIdToLaunch);
+                Environment.ExitCode = 1;
                 return;
             }
-            Log.Information("Assets Ensured for version {VersionId}", minecraftVersion.Id);
+            Log.Information("Found URL for version '{VersionId}': {Url}", versionIdToLaunch, selectedVersionMeta.Url);
 
-            // --- Step 5: Download Libraries & Extract Natives ---
-            Log.Information("--- Ensuring Libraries for Minecraft {VersionId} ---", minecraftVersion.Id);
-            string versionSpecificDir = Path.Combine(launcherConfig.VersionsDir, minecraftVersion.Id);
-            Directory.CreateDirectory(versionSpecificDir);
-            string nativesDirectory = Path.Combine(versionSpecificDir, $"{minecraftVersion.Id}-natives");
-            Log.Information("Natives will be extracted to: {NativesDirectory}", nativesDirectory);
+            MinecraftVersion minecraftVersion = await versionCatalog.GetVersionAsync(selectedVersionMeta, _cts.Token);
+            if (_cts.IsCancellationRequested) { Log.Warning("Version details fetch cancelled."); return; }
 
-            var libraryProgress = new Progress<LibraryProcessingProgress>(report =>
+            if (minecraftVersion == null)
             {
-                if (report.Status.Contains("failed", StringComparison.OrdinalIgnoreCase) || report.Status.Contains("Skipped") || report.ProcessedLibraries % Math.Max(1, report.TotalLibraries / 10) == 0 || report.ProcessedLibraries == report.TotalLibraries)
-                {
-                    Log.Information("[Libs] {Processed}/{Total} - Status: {Status} - Lib: {LibraryName}",
-                        report.ProcessedLibraries, report.TotalLibraries, report.Status, report.CurrentLibraryName);
-                } else { Log.Verbose("[Libs] {Processed}/{Total} - Status: {Status} - Lib: {LibraryName}", report.ProcessedLibraries, report.TotalLibraries, report.Status, report.CurrentLibraryName); }
-            });
-            List<string> libraryClasspathEntries = await libraryManager.EnsureLibrariesAsync(minecraftVersion, nativesDirectory, libraryProgress, _cts.Token);
+                Log.Fatal("Failed to parse details for version '{VersionId}'.", versionIdToLaunch);
+                Environment.ExitCode = 1;
+                return;
+            }
+            Log.Information("Successfully parsed Minecraft version object: {Id} (Type: {Type})", minecraftVersion.Id, minecraftVersion.Type);
 
-            if (_cts.IsCancellationRequested) { Log.Warning("Library processing cancelled."); return; }
-            if (libraryClasspathEntries == null)
+            // --- Step 3: Plan the Install (metadata and stat calls only) ---
+            phases.Next("plan");
+            // Held until the game exits, so tiering in another launcher leaves this version's files alone.
+            using FileLease versionInUse = dryRun ? null : await versionTiering.AcquireInUseAsync(minecraftVersion.Id, _cts.Token);
+            if (versionTiering.IsPacked(minecraftVersion.Id))
+            {
+                if (dryRun)
+                {
+                    Log.Information("Version {VersionId} is packed; a real launch rehydrates it from local disk first, so files listed below for download would mostly be restored from the pack.", minecraftVersion.Id);
+                }
+                else
+                {
+                    await versionTiering.RehydrateAsync(minecraftVersion.Id, _cts.Token);
+                }
+            }
+            InstallPlan installPlan = await installPlanner.CreatePlanAsync(minecraftVersion, _cts.Token);
+            if (_cts.IsCancellationRequested) { Log.Warning("Install planning cancelled."); return; }
+            if (installPlan == null)
+            {
+                Log.Error("Failed to build an install plan for version {VersionId}. Cannot proceed.", minecraftVersion.Id);
+                Environment.ExitCode = 1;
+                return;
+            }
+            installPlanner.LogPlan(installPlan);
+            if (dryRun)
             {
-                Log.Error("Failed to process one or more libraries for version {VersionId}. Cannot proceed.", minecraftVersion.Id);
+                Log.Information("Dry run: nothing was downloaded, extracted or launched.");
                 return;
             }
-            Log.Information("All applicable libraries processed. Library classpath entries: {Count}", libraryClasspathEntries.Count);
 
-            // --- Step 5.5: Download Client JAR ---
-            Log.Information("--- Ensuring Client JAR for Minecraft {VersionId} ---", minecraftVersion.Id);
-            string clientJarPath = Path.Combine(versionSpecificDir, $"{minecraftVersion.Id}.jar");
-            bool clientJarOk = false;
-            if (minecraftVersion.Downloads.TryGetValue("client", out DownloadDetails clientDownloadDetails))
+            // --- Step 4: Execute the Plan (Java, client JAR, libraries, assets, natives) ---
+            phases.Next("install");
+            var installProgress = new InstallProgress();
+            Task installProgressLog = LogInstallProgressAsync(installProgress);
+            historyVersionId = minecraftVersion.Id;
+            InstallResult installResult = await installPlanner.ExecuteAsync(installPlan, installProgress, _cts.Token);
+            await installProgressLog;
+            historyDownloads = installResult.Summary;
+
+            if (_cts.IsCancellationRequested) { Log.Warning("Install cancelled."); return; }
+            if (!installResult.Success)
             {
-                clientJarOk = await assetManager.DownloadAndVerifyFileAsync(
-                    clientDownloadDetails.Url, clientJarPath, clientDownloadDetails.Sha1,
-                    $"Client JAR for {minecraftVersion.Id}", _cts.Token, clientDownloadDetails.Size);
+                Log.Error("Install failed for version {VersionId}. Cannot proceed.", minecraftVersion.Id);
+                Environment.ExitCode = 1;
+                return;
             }
-            else { Log.Error("No client JAR download information found for version {VersionId}.", minecraftVersion.Id); }
+            // `--install-only` stops once every file is in place (used by the install harness).
+            if (args.Contains("--install-only", StringComparer.OrdinalIgnoreCase))
+            {
+                Log.Information("Install of version {VersionId} complete; not launching (--install-only).", minecraftVersion.Id);
+                historyInstalled = true;
+                return;
+            }
+            JavaRuntimeInfo javaRuntime = installResult.Runtime;
+            List<string> libraryClasspathEntries = installResult.LibraryClasspath;
+            string clientJarPath = installPlan.ClientJarPath;
+            string nativesDirectory = installPlan.NativesDirectory;
+            Log.Information("Java Runtime Ensured: {JavaExecutablePath}", javaRuntime.JavaExecutablePath);
+            Log.Information("All files in place for version {VersionId}. Library classpath entries: {Count}", minecraftVersion.Id, libraryClasspathEntries.Count);
+            versionAccess.RecordLaunch(minecraftVersion.Id);
+
+            string gameWorkingDirectory = instance != null
+                ? instanceManager.GetGameDirectory(instance.Name)
+                : Path.GetFullPath(launcherConfig.BaseDataPath);
 
-            if (_cts.IsCancellationRequested) { Log.Warning("Client JAR download cancelled."); return; }
-            if (!clientJarOk)
+            // Versions before 1.7.3 read assets by path rather than from the hash store; link their tree into place.
+            string gameAssetsDirectory = assetManager.MaterializeLegacyAssets(minecraftVersion, gameWorkingDirectory);
+            if (gameAssetsDirectory == null)
             {
-                Log.Error("Failed to download or verify client JAR for version {VersionId}. Cannot proceed.", minecraftVersion.Id);
+                Log.Error("Failed to lay out legacy assets for version {VersionId}. Cannot proceed.", minecraftVersion.Id);
+                Environment.ExitCode = 1;
                 return;
             }
-            Log.Information("Client JAR for version {VersionId} is ready at {ClientJarPath}", minecraftVersion.Id, clientJarPath);
 
-            // --- Step 6: Construct Classpath ---
+            // --- Step 5: Construct Classpath ---
+            phases.Next("arguments");
             Log.Information("--- Constructing Classpath ---");
             string classpathString = argumentBuilder.BuildClasspath(clientJarPath, libraryClasspathEntries);
             // BuildClasspath already logs details.
 
-            // --- Step 7: Construct JVM Arguments ---
+            // --- Step 6: Construct JVM Arguments ---
             Log.Information("--- Constructing JVM Arguments ---");
             // TODO: Populate these from a real auth flow / settings
             argumentBuilder.SetOfflinePlayerName("Player123");
+            if (instance != null) argumentBuilder.SetGameDirectory(gameWorkingDirectory);
+            argumentBuilder.SetGameAssetsDirectory(gameAssetsDirectory);
             // Example of setting a feature flag if needed by arguments:
             // argumentBuilder.SetFeatureFlag("is_demo_user", true);
             // argumentBuilder.SetFeatureFlag("has_custom_resolution", true);
@@ -233,25 +580,64 @@ public class Program
 
             List<string> jvmArgs = argumentBuilder.BuildJvmArguments(minecraftVersion, classpathString, Path.GetFullPath(nativesDirectory), javaRuntime);
 
-            // --- Step 8: Construct Game Arguments ---
+            // --- Step 7: Construct Game Arguments ---
             Log.Information("--- Constructing Game Arguments ---");
             List<string> gameArgs = argumentBuilder.BuildGameArguments(minecraftVersion);
 
-            // --- Step 9: Launch Minecraft ---
+            // --- Step 8: Launch Minecraft ---
+            // "spawn" runs until the process has started, "game" from then until it exits.
+            phases.Next("spawn");
             Log.Information("--- Launching Minecraft {VersionId} ---", minecraftVersion.Id);
-            string gameWorkingDirectory = Path.GetFullPath(launcherConfig.BaseDataPath); // Or a version-specific instance directory like `versionSpecificDir`
-            // For isolated instances: string gameWorkingDirectory = versionSpecificDir;
             Log.Information("Game working directory set to: {GameDir}", gameWorkingDirectory);
+            if (instance != null) instanceManager.RecordLaunch(instance.Name);
+
+
+            // Optionally use the play session to pre-download the next release/snapshot at low priority.
+            using var backgroundPrefetchCts = CancellationTokenSource.CreateLinkedTokenSource(_cts.Token);
+            Task backgroundPrefetch = Task.CompletedTask;
+            if (args.Contains("--background-prefetch", StringComparer.OrdinalIgnoreCase))
+            {
+                var prefetcher = new BackgroundPrefetcher(launcherConfig, httpManager, versionCatalog, assetManager, libraryManager,
+                    CreateBackgroundPrefetchOptions(args), fileLocks);
+                backgroundPrefetch = prefetcher.Start(backgroundPrefetchCts.Token);
+                Log.Information("Background prefetch of new versions enabled for this session.");
+            }
 
+            // Optionally use the play session to continue the integrity scrub under idle I/O priority.
+            Task backgroundScrub = Task.CompletedTask;
+            if (args.Contains("--background-scrub", StringComparer.OrdinalIgnoreCase))
+            {
+                var scrubber = new IntegrityScrubber(launcherConfig, httpManager, versionCatalog, assetManager, libraryManager,
+                    installJournal, CreateScrubOptions(args), fileLocks);
+                backgroundScrub = scrubber.Start(backgroundPrefetchCts.Token);
+                Log.Information("Background integrity scrub enabled for this session.");
+            }
 
+            // `--java-executable=PATH` runs another executable with the same arguments (e.g. the launch benchmark's stub).
+            string javaExecutable = ParseJavaExecutable(args) ?? javaRuntime.JavaExecutablePath;
             int exitCode = await gameLauncher.LaunchAsync(
-                javaRuntime.JavaExecutablePath,
+                javaExecutable,
                 jvmArgs,
                 minecraftVersion.MainClass,
                 gameArgs,
                 gameWorkingDirectory,
-                _cts.Token
+                onStarted: () => phases.Next("game"),
+                cancellationToken: _cts.Token
             );
+            historyLaunched = true;
+            versionInUse?.Dispose();
+
+            backgroundPrefetchCts.Cancel();
+            await backgroundPrefetch;
+            await backgroundScrub;
+            phases.Next("post_session");
+
+            // Optionally pack versions that no longer fit the disk budget, now that this one counts as recently used.
+            long? tierBudgetAfterLaunch = ParseTierBudget(args, "--tier-budget-mb=");
+            if (tierBudgetAfterLaunch != null && !_cts.IsCancellationRequested)
+            {
+                await versionTiering.ApplyBudgetAsync(tierBudgetAfterLaunch.Value, true, _cts.Token);
+            }
 
             if (_cts.IsCancellationRequested)
             {
@@ -279,6 +665,22 @@ public class Program
         }
         finally
         {
+            storeWatchCts.Cancel();
+            await storeWatch;
+            metricsCts.Cancel();
+            await metricsServer;
+            peerCacheCts.Cancel();
+            await peerCacheServer;
+            // Persist whatever the journal has buffered, so the next run resumes from here (also on the Ctrl+C path).
+            installJournal.Flush();
+            phases.Stop();
+            runActivity?.Stop();
+            if (historyRun != null && historyVersionId != null)
+            {
+                string outcome = _cts.IsCancellationRequested ? "cancelled" : historyLaunched ? "ok" : historyInstalled ? "installed" : "failed";
+                performanceHistory.Append(historyRun.Complete(historyVersionId, outcome, historyDownloads, launcherConfig.BaseDataPath));
+            }
+            traceExporter?.Dispose();
             Log.Information("Shutting down logger...");
             await Log.CloseAndFlushAsync();
             if (Environment.ExitCode != 0 || _cts.IsCancellationRequested)
@@ -287,4 +689,284 @@ public class Program
             }
         }
     }
+
+    /// <summary>
+    /// Reads a budget in MiB from a <c>prefix=N</c> flag, returned in bytes; null if absent or invalid.
+    /// </summary>
+    private static long? ParseTierBudget(string[] args, string prefix)
+    {
+        string arg = args.FirstOrDefault(a => a.StartsWith(prefix, StringComparison.OrdinalIgnoreCase));
+        if (arg != null && long.TryParse(arg.Substring(prefix.Length), out long megabytes) && megabytes >= 0)
+        {
+            return megabytes * 1024 * 1024;
+        }
+        return null;
+    }
+
+    /// <summary>
+    /// Reads <c>--socket=PATH</c>, the daemon's Unix domain socket; defaults to <c>launcher.sock</c> in the data directory.
+    /// </summary>
+    private static string ParseSocketPath(string[] args, LauncherConfig config)
+    {
+        string arg = args.FirstOrDefault(a => a.StartsWith("--socket=", StringComparison.OrdinalIgnoreCase));
+        return arg != null ? Path.GetFullPath(arg.Substring("--socket=".Length)) : LauncherDaemon.GetDefaultSocketPath(config);
+    }
+
+    /// <summary>
+    /// Reads <c>--java-executable=PATH</c>; null if absent or if the file does not exist.
+    /// </summary>
+    private static string ParseJavaExecutable(string[] args)
+    {
+        string arg = args.FirstOrDefault(a => a.StartsWith("--java-executable=", StringComparison.OrdinalIgnoreCase));
+        if (arg == null) return null;
+        string path = Path.GetFullPath(arg.Substring("--java-executable=".Length));
+        if (File.Exists(path))
+        {
+            Log.Information("Launching with {JavaExecutable} instead of the runtime's java.", path);
+            return path;
+        }
+        Log.Warning("Ignoring {Argument}: the file does not exist.", arg);
+        return null;
+    }
+
+    /// <summary>
+    /// Reads <c>--durability=fast|batched|strict</c>; anything else keeps <paramref name="defaultMode"/>.
+    /// </summary>
+    private static DurabilityMode ParseDurability(string[] args, DurabilityMode defaultMode)
+    {
+        string arg = args.FirstOrDefault(a => a.StartsWith("--durability=", StringComparison.OrdinalIgnoreCase));
+        if (arg == null) return defaultMode;
+        if (Enum.TryParse(arg.Substring("--durability=".Length), true, out DurabilityMode mode) && Enum.IsDefined(typeof(DurabilityMode), mode))
+        {
+            return mode;
+        }
+        Log.Warning("Unknown durability mode in {Argument}; expected fast, batched or strict. Using {Default}.", arg, defaultMode);
+        return defaultMode;
+    }
+
+    /// <summary>
+    /// Reads <c>--io=default|uring</c>; anything else keeps <paramref name="defaultBackend"/>.
+    /// </summary>
+    private static IoBackend ParseIoBackend(string[] args, IoBackend defaultBackend)
+    {
+        string arg = args.FirstOrDefault(a => a.StartsWith("--io=", StringComparison.OrdinalIgnoreCase));
+        if (arg == null) return defaultBackend;
+        switch (arg.Substring("--io=".Length).ToLowerInvariant())
+        {
+            case "default":
+                return IoBackend.Default;
+            case "uring":
+            case "io_uring":
+                return IoBackend.IoUring;
+            default:
+                Log.Warning("Unknown I/O backend in {Argument}; expected default or uring. Using {Default}.", arg, defaultBackend);
+                return defaultBackend;
+        }
+    }
+
+    /// <summary>
+    /// Applies <c>--version-manifest-url=</c>, <c>--assets-url=</c>, <c>--java-manifest-url=</c> and
+    /// <c>--adoptium-url=</c>; values that are not absolute http(s) URLs are ignored with a warning.
+    /// </summary>
+    private static void ApplyEndpointOverrides(string[] args, LauncherConfig config)
+    {
+        foreach (string arg in args)
+        {
+            int separator = arg.IndexOf('=');
+            if (!arg.StartsWith("--", StringComparison.Ordinal) || separator < 0) continue;
+            string name = arg.Substring(0, separator).ToLowerInvariant();
+            if (name != "--version-manifest-url" && name != "--assets-url" && name != "--java-manifest-url" && name != "--adoptium-url") continue;
+
+            string url = arg.Substring(separator + 1);
+            if (!Uri.TryCreate(url, UriKind.Absolute, out Uri uri) || (uri.Scheme != Uri.UriSchemeHttp && uri.Scheme != Uri.UriSchemeHttps))
+            {
+                Log.Warning("Ignoring {Argument}: not an absolute http(s) URL.", arg);
+                continue;
+            }
+            switch (name)
+            {
+                case "--version-manifest-url": config.VersionManifestUrl = url; break;
+                case "--assets-url": config.AssetResourcesUrl = url; break;
+                case "--java-manifest-url": config.JavaRuntimeManifestUrl = url; break;
+                default: config.AdoptiumApiUrl = url; break;
+            }
+            Log.Information("Endpoint override: {Argument}", arg);
+        }
+    }
+
+    /// <summary>
+    /// Applies <c>--log-level=LEVEL</c> (every context) and <c>--log-level=CONTEXT:LEVEL</c> flags, in order, where
+    /// CONTEXT is a launcher type or namespace (e.g. <c>AssetManager</c> or <c>ObsidianLauncher.Services</c>).
+    /// </summary>
+    private static void ApplyLogLevels(string[] args)
+    {
+        foreach (string arg in args)
+        {
+            if (!arg.StartsWith("--log-level=", StringComparison.OrdinalIgnoreCase)) continue;
+            string value = arg.Substring("--log-level=".Length);
+            int separator = value.LastIndexOf(':');
+            string context = separator > 0 ? value.Substring(0, separator) : "*";
+            if (Enum.TryParse(value.Substring(separator + 1), true, out LogEventLevel level) && Enum.IsDefined(level))
+            {
+                LoggerSetup.SetLevel(context, level);
+            }
+            else
+            {
+                Log.Warning("Unknown log level in {Argument}; expected Verbose, Debug, Information, Warning, Error or Fatal.", arg);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Starts recording spans if <c>--trace</c> (into the logs directory) or <c>--trace=PATH</c> is given.
+    /// </summary>
+    private static ChromeTraceExporter CreateTraceExporter(string[] args, LauncherConfig config)
+    {
+        string arg = args.FirstOrDefault(a => a.Equals("--trace", StringComparison.OrdinalIgnoreCase) ||
+                                              a.StartsWith("--trace=", StringComparison.OrdinalIgnoreCase));
+        if (arg == null) return null;
+        string path = arg.Length > "--trace=".Length
+            ? arg.Substring("--trace=".Length)
+            : Path.Combine(config.LogsDir, $"trace-{DateTime.Now:yyyyMMdd-HHmmss}.json");
+        Log.Information("Tracing enabled; the trace is written to {TracePath} on exit.", path);
+        return new ChromeTraceExporter(path);
+    }
+
+    /// <summary>
+    /// Creates the Prometheus endpoint if <c>--metrics</c> (default port) or <c>--metrics=PORT</c> is given.
+    /// </summary>
+    private static MetricsEndpoint CreateMetricsEndpoint(string[] args)
+    {
+        string arg = args.FirstOrDefault(a => a.Equals("--metrics", StringComparison.OrdinalIgnoreCase) ||
+                                              a.StartsWith("--metrics=", StringComparison.OrdinalIgnoreCase));
+        if (arg == null) return null;
+        int port = MetricsEndpoint.DefaultPort;
+        if (arg.Length > "--metrics=".Length &&
+            (!int.TryParse(arg.Substring("--metrics=".Length), out port) || port <= 0 || port > 65535))
+        {
+            Log.Warning("Invalid port in {Argument}; using {DefaultPort}.", arg, MetricsEndpoint.DefaultPort);
+            port = MetricsEndpoint.DefaultPort;
+        }
+        return new MetricsEndpoint(port);
+    }
+
+    /// <summary>
+    /// Creates the LAN peer cache if <c>--peer-cache</c> is given (or for <c>peer-serve</c>), configured by
+    /// <c>--peer-port=N</c>, <c>--peer-discovery-port=N</c>, <c>--peers=HOST[:PORT],...</c> and <c>--no-peer-discovery</c>.
+    /// </summary>
+    private static PeerCache CreatePeerCache(string[] args, InstallJournal journal, bool force)
+    {
+        if (!force && !args.Contains("--peer-cache", StringComparer.OrdinalIgnoreCase)) return null;
+        var options = new PeerCacheOptions
+        {
+            Discovery = !args.Contains("--no-peer-discovery", StringComparer.OrdinalIgnoreCase)
+        };
+        foreach (string arg in args)
+        {
+            if (arg.StartsWith("--peer-port=", StringComparison.OrdinalIgnoreCase) &&
+                int.TryParse(arg.Substring("--peer-port=".Length), out int port) && port > 0 && port <= 65535)
+            {
+                options.Port = port;
+            }
+            else if (arg.StartsWith("--peer-discovery-port=", StringComparison.OrdinalIgnoreCase) &&
+                     int.TryParse(arg.Substring("--peer-discovery-port=".Length), out int discoveryPort) && discoveryPort > 0 && discoveryPort <= 65535)
+            {
+                options.DiscoveryPort = discoveryPort;
+            }
+            else if (arg.StartsWith("--peers=", StringComparison.OrdinalIgnoreCase))
+            {
+                foreach (string peer in arg.Substring("--peers=".Length).Split(',', StringSplitOptions.RemoveEmptyEntries | StringSplitOptions.TrimEntries))
+                {
+                    string endpoint = ParsePeerEndpoint(peer);
+                    if (endpoint != null) options.StaticPeers.Add(endpoint);
+                    else Log.Warning("Ignoring peer {Peer}: expected HOST[:PORT], IPv4[:PORT] or [IPv6]:PORT.", peer);
+                }
+            }
+        }
+        return new PeerCache(journal, options);
+    }
+
+    /// <summary>
+    /// Normalizes one <c>--peers=</c> entry to <c>host:port</c>, adding <see cref="PeerCacheOptions.DefaultPort"/> when
+    /// no port is given. IPv6 addresses may be bare (<c>fe80::1</c>, default port) or bracketed with a port
+    /// (<c>[fe80::1]:47761</c>); they come back bracketed. Returns null for an entry that cannot be parsed.
+    /// </summary>
+    private static string ParsePeerEndpoint(string peer)
+    {
+        if (IPEndPoint.TryParse(peer, out IPEndPoint address))
+        {
+            if (address.Port == 0) address.Port = PeerCacheOptions.DefaultPort;
+            return address.ToString();
+        }
+
+        // A host name, optionally with a port; names never contain a colon.
+        int colon = peer.IndexOf(':');
+        if (colon < 0) return Uri.CheckHostName(peer) == UriHostNameType.Dns ? $"{peer}:{PeerCacheOptions.DefaultPort}" : null;
+        string host = peer.Substring(0, colon);
+        return Uri.CheckHostName(host) == UriHostNameType.Dns &&
+               int.TryParse(peer.Substring(colon + 1), NumberStyles.None, CultureInfo.InvariantCulture, out int port) && port > 0 && port <= 65535
+            ? $"{host}:{port}"
+            : null;
+    }
+
+    /// <summary>
+    /// Builds background prefetch options from command line flags:
+    /// <c>--no-snapshots</c>, <c>--prefetch-rate-kb=N</c> (KiB/s) and <c>--prefetch-budget-mb=N</c> (MiB per cycle).
+    /// </summary>
+    private static BackgroundPrefetchOptions CreateBackgroundPrefetchOptions(string[] args)
+    {
+        var options = new BackgroundPrefetchOptions
+        {
+            IncludeSnapshots = !args.Contains("--no-snapshots", StringComparer.OrdinalIgnoreCase)
+        };
+        foreach (string arg in args)
+        {
+            if (arg.StartsWith("--prefetch-rate-kb=", StringComparison.OrdinalIgnoreCase) &&
+                long.TryParse(arg.Substring("--prefetch-rate-kb=".Length), out long rateKb) && rateKb > 0)
+            {
+                options.MaxBytesPerSecond = rateKb * 1024;
+            }
+            else if (arg.StartsWith("--prefetch-budget-mb=", StringComparison.OrdinalIgnoreCase) &&
+                     long.TryParse(arg.Substring("--prefetch-budget-mb=".Length), out long budgetMb) && budgetMb >= 0)
+            {
+                options.DiskBudgetBytes = budgetMb * 1024 * 1024;
+            }
+        }
+        return options;
+    }
+
+    /// <summary>
+    /// Logs install progress at most once a second until the install finishes. The planner and scheduler log the
+    /// outcome themselves, so the final snapshot is not repeated.
+    /// </summary>
+    private static async Task LogInstallProgressAsync(InstallProgress progress)
+    {
+        await foreach (InstallProgressSnapshot snapshot in progress.WatchAsync(TimeSpan.FromSeconds(1)))
+        {
+            if (snapshot.IsFinished || !snapshot.CurrentPhase.HasValue) continue;
+            InstallPhaseProgress phase = snapshot[snapshot.CurrentPhase.Value];
+            Log.Information("[Install] {Phase}: {ItemsDone}/{ItemsTotal} done ({Failed} failed), {DoneMB:F1}/{TotalMB:F1} MB overall ({OverallPercent:F1}%) at {RateMBps:F2} MB/s, ETA {Eta}",
+                phase.Phase, phase.ItemsDone, phase.ItemsTotal, phase.ItemsFailed,
+                snapshot.BytesDone / (1024.0 * 1024.0), snapshot.BytesTotal / (1024.0 * 1024.0), snapshot.Fraction * 100,
+                snapshot.BytesPerSecond / (1024.0 * 1024.0), snapshot.Eta?.ToString(@"hh\:mm\:ss") ?? "unknown");
+        }
+    }
+
+    /// <summary>
+    /// Builds integrity scrub options from command line flags:
+    /// <c>--scrub-rate-kb=N</c> (KiB/s read ceiling) and <c>--no-repair</c>.
+    /// </summary>
+    private static ScrubOptions CreateScrubOptions(string[] args)
+    {
+        var options = new ScrubOptions
+        {
+            Repair = !args.Contains("--no-repair", StringComparer.OrdinalIgnoreCase)
+        };
+        string rateArg = args.FirstOrDefault(a => a.StartsWith("--scrub-rate-kb=", StringComparison.OrdinalIgnoreCase));
+        if (rateArg != null && long.TryParse(rateArg.Substring("--scrub-rate-kb=".Length), out long rateKb) && rateKb > 0)
+        {
+            options.MaxBytesPerSecond = rateKb * 1024;
+        }
+        return options;
+    }
 }
\ No newline at end of file
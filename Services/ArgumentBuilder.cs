@@ -31,6 +31,8 @@ namespace ObsidianLauncher.Services
         private string _resolutionHeight = "480";
         private bool _hasCustomResolution = false;
         private bool _isDemoUser = false;
+        private string _gameDirectory; // Null means the shared data directory
+        private string _gameAssetsDirectory; // Null means the assets root
 
         // Quick Play (example placeholders)
         private bool _hasQuickPlaysSupport = false;
@@ -87,6 +89,26 @@ namespace ObsidianLauncher.Services
             _logger.Information("Custom resolution set: {Width}x{Height}", width, height);
         }
 
+        /// <summary>
+        /// Sets the directory substituted for <c>${game_directory}</c> (saves, options, resource packs, mods).
+        /// Defaults to the launcher data directory.
+        /// </summary>
+        public void SetGameDirectory(string gameDirectory)
+        {
+            _gameDirectory = string.IsNullOrWhiteSpace(gameDirectory) ? null : Path.GetFullPath(gameDirectory);
+            _logger.Information("Game directory set to: {GameDirectory}", _gameDirectory ?? _config.BaseDataPath);
+        }
+
+        /// <summary>
+        /// Sets the directory substituted for <c>${game_assets}</c>, the path-based asset tree of legacy versions
+        /// (see <see cref="AssetManager.MaterializeLegacyAssets"/>). Defaults to the assets root.
+        /// </summary>
+        public void SetGameAssetsDirectory(string gameAssetsDirectory)
+        {
+            _gameAssetsDirectory = string.IsNullOrWhiteSpace(gameAssetsDirectory) ? null : Path.GetFullPath(gameAssetsDirectory);
+            _logger.Verbose("Game assets directory set to: {GameAssetsDirectory}", _gameAssetsDirectory ?? _config.AssetsDir);
+        }
+
         /// <summary>
         /// Sets a specific feature flag for rule evaluation.
         /// </summary>
@@ -248,7 +270,7 @@ namespace ObsidianLauncher.Services
             return gameArgs;
         }
 
-        private string ReplacePlaceholders(string argument, MinecraftVersion mcVersion, string classpath, string nativesDir)
+        internal string ReplacePlaceholders(string argument, MinecraftVersion mcVersion, string classpath, string nativesDir)
         {
             if (argument == null) return null;
 
@@ -256,8 +278,9 @@ namespace ObsidianLauncher.Services
             string assetsIndexName = mcVersion.AssetIndex?.Id ?? mcVersion.Assets ?? "unknown_assets_index";
 
             // Ensure paths are full and use quotes for robustness if they might contain spaces
-            string gameDirectoryPath = $"\"{Path.GetFullPath(_config.BaseDataPath)}\"";
+            string gameDirectoryPath = $"\"{_gameDirectory ?? Path.GetFullPath(_config.BaseDataPath)}\"";
             string assetsRootPath = $"\"{Path.GetFullPath(_config.AssetsDir)}\"";
+            string gameAssetsPath = $"\"{_gameAssetsDirectory ?? Path.GetFullPath(_config.AssetsDir)}\"";
             string nativesDirectoryPath = nativesDir != null ? $"\"{Path.GetFullPath(nativesDir)}\"" : "\"${natives_directory}\""; // Keep placeholder if null
             string effectiveClasspath = classpath != null ? $"\"{classpath}\"" : "\"${classpath}\""; // Quote classpath
 
@@ -275,6 +298,7 @@ namespace ObsidianLauncher.Services
             argument = argument.Replace("${game_dir}", gameDirectoryPath); // Some older versions might use this
             argument = argument.Replace("${assets_root}", assetsRootPath);
             argument = argument.Replace("${assets_index_name}", assetsIndexName);
+            argument = argument.Replace("${game_assets}", gameAssetsPath); // Pre-1.7.3 versions
 
             if (classpath != null) // Only replace if classpath is available
                 argument = argument.Replace("${classpath}", effectiveClasspath);
@@ -295,7 +319,7 @@ namespace ObsidianLauncher.Services
             return argument;
         }
 
-        private bool AreRulesSatisfied(List<ArgumentRuleCondition> rules, JavaRuntimeInfo javaRuntimeForJvmRules)
+        internal bool AreRulesSatisfied(List<ArgumentRuleCondition> rules, JavaRuntimeInfo javaRuntimeForJvmRules)
         {
             if (rules == null || !rules.Any())
             {
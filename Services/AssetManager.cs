@@ -1,12 +1,14 @@
 ﻿// Services/AssetManager.cs
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
 using System.Linq;
 using System.Net.Http;
 using System.Text.Json;
 using System.Threading;
 using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
 using ObsidianLauncher.Models;
 using ObsidianLauncher.Utils;
 using Serilog;
@@ -17,14 +19,17 @@ namespace ObsidianLauncher.Services
     {
         private readonly LauncherConfig _config;
         private readonly HttpManager _httpManager;
+        private readonly DownloadScheduler _scheduler;
         private readonly ILogger _logger;
 
-        private const string MinecraftResourcesUrlBase = "https://resources.download.minecraft.net/";
+        // Path-to-hash record kept in the root of each materialized legacy asset tree.
+        private const string LegacyTreeRecordFileName = ".obsidian-assets.json";
 
-        public AssetManager(LauncherConfig config, HttpManager httpManager)
+        public AssetManager(LauncherConfig config, HttpManager httpManager, DownloadScheduler scheduler = null)
         {
             _config = config ?? throw new ArgumentNullException(nameof(config));
             _httpManager = httpManager ?? throw new ArgumentNullException(nameof(httpManager));
+            _scheduler = scheduler ?? new DownloadScheduler(httpManager);
             _logger = Log.ForContext<AssetManager>();
             _logger.Verbose("AssetManager initialized.");
         }
@@ -41,10 +46,66 @@ namespace ObsidianLauncher.Services
             IProgress<AssetDownloadProgress> progress = null,
             CancellationToken cancellationToken = default)
         {
+            List<InstallWorkItem> assetItems = await CollectAssetWorkItemsAsync(mcVersion, cancellationToken);
+            if (assetItems == null)
+            {
+                return false;
+            }
+            if (assetItems.Count == 0)
+            {
+                return true; // Nothing to download (no index to read assets from).
+            }
+
+            string assetIndexId = mcVersion.AssetIndex?.Id ?? mcVersion.Assets;
+            assetItems = _scheduler.Deduplicate(assetItems); // Dedupe up front so progress totals match completions
+            int totalAssets = assetItems.Count;
+            int processedAssets = 0;
+
+            DownloadRunSummary summary = await _scheduler.RunAsync(assetItems, (item, success) =>
+            {
+                int processed = Interlocked.Increment(ref processedAssets);
+                progress?.Report(new AssetDownloadProgress
+                {
+                    CurrentFile = Path.GetFileName(item.LocalPath),
+                    TotalFiles = totalAssets,
+                    ProcessedFiles = processed,
+                    CurrentFileBytesDownloaded = success ? (long)(item.Size ?? 0) : 0,
+                    CurrentFileTotalBytes = (long)(item.Size ?? 0)
+                });
+            }, cancellationToken: cancellationToken).ConfigureAwait(false);
+
+            bool allSucceeded = summary.Failed == 0;
+            if (allSucceeded)
+            {
+                _logger.Information("All {TotalAssets} assets for index {AssetIndexId} are present and verified.",
+                    summary.TotalItems, assetIndexId);
+            }
+            else
+            {
+                _logger.Error("{FailedCount} out of {TotalAssets} assets failed to download or verify for index {AssetIndexId}.",
+                    summary.Failed, summary.TotalItems, assetIndexId);
+            }
+
+            return allSucceeded;
+        }
+
+        /// <summary>
+        /// Resolves the asset objects required by a version without downloading them.
+        /// The asset index JSON itself is downloaded and verified, since it is the metadata the list comes from.
+        /// </summary>
+        /// <param name="mcVersion">The Minecraft version details.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>One work item per asset object (an empty list if there is nothing to do), or null on failure.</returns>
+        public async Task<List<InstallWorkItem>> CollectAssetWorkItemsAsync(
+            MinecraftVersion mcVersion,
+            CancellationToken cancellationToken = default)
+        {
+            using Activity activity = LauncherTracing.Start("assets.resolve");
+            activity?.SetTag("asset_index", mcVersion.AssetIndex?.Id ?? mcVersion.Assets);
             if (mcVersion.AssetIndex == null && string.IsNullOrEmpty(mcVersion.Assets))
             {
                 _logger.Warning("Version {VersionId} has no AssetIndex and no fallback 'assets' string. Cannot process assets.", mcVersion.Id);
-                return true; // No assets to process, so technically successful.
+                return new List<InstallWorkItem>(); // No assets to process, so technically successful.
             }
 
             AssetIndex currentAssetIndexMetadata = mcVersion.AssetIndex;
@@ -58,16 +119,16 @@ namespace ObsidianLauncher.Services
                 // If supporting very old versions, this part would need to fetch the manifest
                 // to find the URL for the "assets" string id.
                 _logger.Warning("Minecraft version {VersionId} does not have a direct AssetIndex object. The 'assets' field is '{AssetsString}'. Advanced handling for this might be needed.", mcVersion.Id, mcVersion.Assets);
-                 // If assetIndexId is "legacy" or "pre-1.6", specific handling is needed which is complex.
+                // Legacy layouts are built from an asset index (see MaterializeLegacyAssets); without one there is nothing to do.
                 if (assetIndexId.Equals("legacy", StringComparison.OrdinalIgnoreCase) ||
                     assetIndexId.Equals("pre-1.6", StringComparison.OrdinalIgnoreCase))
                 {
-                    _logger.Information("Legacy assets ('{AssetIndexId}') require special handling (copying from client JAR or specific download logic not implemented in this basic manager). Skipping asset download.", assetIndexId);
-                    return true; // Consider this "successful" as there's no standard index to process.
+                    _logger.Information("Version {VersionId} names the '{AssetIndexId}' assets but links no asset index; there are no assets to download or lay out.", mcVersion.Id, assetIndexId);
+                    return new List<InstallWorkItem>(); // Consider this "successful" as there's no standard index to process.
                 }
                 // If it's a modern ID but the AssetIndex object was missing, that's an error in the version JSON or our parsing.
                 _logger.Error("AssetIndex object is missing for version {VersionId}, but 'assets' field ('{AssetsString}') is not a known legacy type. Cannot proceed.", mcVersion.Id, mcVersion.Assets);
-                return false;
+                return null;
             }
 
             _logger.Information("Processing assets for index ID: {AssetIndexId}, URL: {AssetIndexUrl}",
@@ -76,17 +137,19 @@ namespace ObsidianLauncher.Services
             string assetIndexFilePath = Path.Combine(_config.AssetIndexesDir, $"{currentAssetIndexMetadata.Id}.json");
 
             // 1. Download or verify the Asset Index JSON file
-            bool assetIndexValid = await DownloadAndVerifyFileAsync(
-                currentAssetIndexMetadata.Url,
-                assetIndexFilePath,
-                currentAssetIndexMetadata.Sha1,
-                "Asset Index JSON",
-                cancellationToken);
+            bool assetIndexValid = await _scheduler.EnsureFileAsync(new InstallWorkItem
+            {
+                Kind = InstallWorkKind.AssetIndex,
+                Url = currentAssetIndexMetadata.Url,
+                LocalPath = assetIndexFilePath,
+                Sha1 = currentAssetIndexMetadata.Sha1,
+                Description = "Asset Index JSON"
+            }, cancellationToken);
 
             if (!assetIndexValid)
             {
                 _logger.Error("Failed to obtain a valid asset index JSON for {AssetIndexId}.", currentAssetIndexMetadata.Id);
-                return false;
+                return null;
             }
 
             // 2. Parse the Asset Index JSON
@@ -100,7 +163,7 @@ namespace ObsidianLauncher.Services
                 {
                     _logger.Error("Failed to parse asset index JSON for {AssetIndexId} or 'objects' map is missing. File: {FilePath}",
                         currentAssetIndexMetadata.Id, assetIndexFilePath);
-                    return false;
+                    return null;
                 }
                 _logger.Information("Successfully parsed asset index for {AssetIndexId}. Found {Count} asset objects.",
                     currentAssetIndexMetadata.Id, assetIndexDetails.Objects.Count);
@@ -109,32 +172,64 @@ namespace ObsidianLauncher.Services
             {
                 _logger.Error(ex, "Exception while reading or parsing asset index JSON {FilePath} for {AssetIndexId}.",
                     assetIndexFilePath, currentAssetIndexMetadata.Id);
-                return false;
+                return null;
             }
 
-            // 3. Iterate and download/verify individual assets
-            int totalAssets = assetIndexDetails.Objects.Count;
-            int processedAssets = 0;
-            int successfullyProcessedAssets = 0;
-
-            // Determine base asset objects directory
-            string assetObjectsDir = _config.AssetObjectsDir;
+            // Objects are always downloaded into the hash store. Legacy indexes (virtual / map_to_resources) additionally
+            // need their path-based tree, which MaterializeLegacyAssets links from the store after the download.
             if (assetIndexDetails.IsVirtual || assetIndexDetails.MapToResources)
             {
-                // Legacy versions might store assets in a "virtual/legacy" or "resources" subdirectory.
-                // For "virtual": assets are typically in assets/virtual/<asset_index_id>/<virtual_path>
-                // For "map_to_resources": assets are in assets/resources/<virtual_path> (very old pre-1.6)
-                // This basic manager will use the modern HASH-based storage for simplicity,
-                // but a full launcher would need to respect these flags for path construction if copying/symlinking.
-                // For now, we just log it.
-                 _logger.Information("Asset index {AssetIndexId} is marked as virtual ({IsVirtual}) or map_to_resources ({MapToResources}). Using modern hash-based storage.",
+                _logger.Information("Asset index {AssetIndexId} is marked as virtual ({IsVirtual}) or map_to_resources ({MapToResources}); its path tree is linked from the hash store after download.",
                     currentAssetIndexMetadata.Id, assetIndexDetails.IsVirtual, assetIndexDetails.MapToResources);
             }
 
+            // 3. One work item per asset object.
+            activity?.SetTag("objects", assetIndexDetails.Objects.Count);
+            return CreateAssetWorkItems(assetIndexDetails);
+        }
 
-            List<Task<bool>> downloadTasks = new List<Task<bool>>();
-            int maxConcurrentDownloads = Environment.ProcessorCount; // Or a configurable value
+        /// <summary>
+        /// Resolves the asset objects of a version from its cached asset index only: no download, no verification of the index.
+        /// </summary>
+        /// <returns>One work item per asset object plus the index itself, or null if the index is not cached or cannot be parsed.</returns>
+        public List<InstallWorkItem> CollectCachedAssetWorkItems(MinecraftVersion mcVersion)
+        {
+            if (mcVersion.AssetIndex == null) return new List<InstallWorkItem>();
+            string assetIndexFilePath = Path.Combine(_config.AssetIndexesDir, $"{mcVersion.AssetIndex.Id}.json");
+            if (!File.Exists(assetIndexFilePath)) return null;
+            AssetIndexDetails assetIndexDetails;
+            try
+            {
+                assetIndexDetails = JsonSerializer.Deserialize<AssetIndexDetails>(File.ReadAllText(assetIndexFilePath),
+                    new JsonSerializerOptions { PropertyNameCaseInsensitive = true });
+            }
+            catch (Exception ex) when (ex is IOException || ex is JsonException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not read cached asset index {FilePath}.", assetIndexFilePath);
+                return null;
+            }
+            if (assetIndexDetails?.Objects == null) return null;
 
+            List<InstallWorkItem> items = CreateAssetWorkItems(assetIndexDetails);
+            items.Add(new InstallWorkItem
+            {
+                Kind = InstallWorkKind.AssetIndex,
+                Url = mcVersion.AssetIndex.Url,
+                LocalPath = assetIndexFilePath,
+                Sha1 = mcVersion.AssetIndex.Sha1,
+                Description = "Asset Index JSON"
+            });
+            return items;
+        }
+
+        /// <summary>
+        /// One work item per asset object of an index. Several virtual paths can share a hash; the scheduler deduplicates them.
+        /// </summary>
+        private List<InstallWorkItem> CreateAssetWorkItems(AssetIndexDetails assetIndexDetails)
+        {
+            string assetObjectsDir = _config.AssetObjectsDir;
+            string resourcesUrl = _config.AssetResourcesUrl.EndsWith('/') ? _config.AssetResourcesUrl : _config.AssetResourcesUrl + "/";
+            var items = new List<InstallWorkItem>(assetIndexDetails.Objects.Count);
             foreach (var assetEntry in assetIndexDetails.Objects)
             {
                 //string virtualPath = assetEntry.Key; // e.g., "minecraft/textures/block/stone.png"
@@ -142,183 +237,178 @@ namespace ObsidianLauncher.Services
 
                 string assetHash = assetInfo.Hash;
                 string subDir = assetHash.Substring(0, 2);
-                string assetFilename = assetHash;
-                string assetObjectPath = Path.Combine(assetObjectsDir, subDir, assetFilename);
-                string assetDownloadUrl = $"{MinecraftResourcesUrlBase}{subDir}/{assetHash}";
-
-                // Simple concurrency limiting
-                while (downloadTasks.Count(t => !t.IsCompleted) >= maxConcurrentDownloads)
+                items.Add(new InstallWorkItem
                 {
-                    await Task.WhenAny(downloadTasks.Where(t => !t.IsCompleted));
-                    cancellationToken.ThrowIfCancellationRequested();
-                }
-
-                var downloadTask = Task.Run(async () =>
-                {
-                    bool success = await DownloadAndVerifyFileAsync(
-                        assetDownloadUrl,
-                        assetObjectPath,
-                        assetHash,
-                        $"Asset {assetHash}", // virtualPath could be used for more descriptive logging
-                        cancellationToken,
-                        assetInfo.Size);
-
-                    Interlocked.Increment(ref processedAssets);
-                    if (success)
-                    {
-                        Interlocked.Increment(ref successfullyProcessedAssets);
-                    }
-                    progress?.Report(new AssetDownloadProgress
-                    {
-                        CurrentFile = Path.GetFileName(assetObjectPath), // or virtualPath
-                        TotalFiles = totalAssets,
-                        ProcessedFiles = Interlocked.CompareExchange(ref processedAssets, 0, 0), // Read current value
-                        CurrentFileBytesDownloaded = success ? (long)assetInfo.Size : 0,
-                        CurrentFileTotalBytes = (long)assetInfo.Size
-                    });
-                    return success;
-                }, cancellationToken);
-                downloadTasks.Add(downloadTask);
+                    Kind = InstallWorkKind.Asset,
+                    Url = $"{resourcesUrl}{subDir}/{assetHash}",
+                    LocalPath = Path.Combine(assetObjectsDir, subDir, assetHash),
+                    Sha1 = assetHash,
+                    Size = assetInfo.Size,
+                    Description = $"Asset {assetHash}" // virtualPath could be used for more descriptive logging
+                });
             }
+            return items;
+        }
 
-            await Task.WhenAll(downloadTasks).ConfigureAwait(false);
+        /// <summary>
+        /// Lays out the path-based asset tree that legacy versions read instead of the hash store:
+        /// <c>assets/virtual/&lt;index&gt;/&lt;path&gt;</c> for <c>virtual</c> indexes (1.6 to 1.7.2) and
+        /// <c>&lt;game directory&gt;/resources/&lt;path&gt;</c> for <c>map_to_resources</c> indexes (pre-1.6).
+        /// Every file is linked from <c>assets/objects</c> (reflink, hard link or symlink; a copy only as a last resort),
+        /// so a legacy version costs no extra disk space.
+        /// <para>
+        /// The work is incremental: the tree root holds a record of the hash each path was materialized from, and only
+        /// paths whose hash changed, that are missing or that have the wrong size are redone. Paths that left the index are removed.
+        /// Each file is linked under a temporary name and renamed into place, so concurrent launchers never see a partial tree.
+        /// </para>
+        /// Must run after the version's assets are installed; the cached asset index is read, nothing is downloaded.
+        /// </summary>
+        /// <param name="mcVersion">The Minecraft version details.</param>
+        /// <param name="gameDirectory">Game directory the version runs in (holds <c>resources</c> for pre-1.6 versions).</param>
+        /// <returns>The directory to pass as <c>${game_assets}</c> (the assets root for modern versions), or null on failure.</returns>
+        public string MaterializeLegacyAssets(MinecraftVersion mcVersion, string gameDirectory)
+        {
+            if (mcVersion.AssetIndex == null) return _config.AssetsDir;
 
-            bool allSucceeded = successfullyProcessedAssets == totalAssets;
-            if (allSucceeded)
+            string assetIndexFilePath = Path.Combine(_config.AssetIndexesDir, $"{mcVersion.AssetIndex.Id}.json");
+            AssetIndexDetails assetIndexDetails;
+            try
             {
-                _logger.Information("All {TotalAssets} assets for index {AssetIndexId} are present and verified.",
-                    totalAssets, currentAssetIndexMetadata.Id);
+                assetIndexDetails = JsonSerializer.Deserialize<AssetIndexDetails>(File.ReadAllText(assetIndexFilePath),
+                    new JsonSerializerOptions { PropertyNameCaseInsensitive = true });
             }
-            else
+            catch (Exception ex)
             {
-                _logger.Error("{FailedCount} out of {TotalAssets} assets failed to download or verify for index {AssetIndexId}.",
-                    totalAssets - successfullyProcessedAssets, totalAssets, currentAssetIndexMetadata.Id);
+                _logger.Error(ex, "Failed to read asset index {FilePath} for legacy asset layout.", assetIndexFilePath);
+                return null;
             }
+            if (assetIndexDetails?.Objects == null) return null;
+            if (!assetIndexDetails.IsVirtual && !assetIndexDetails.MapToResources) return _config.AssetsDir;
 
-            return allSucceeded;
-        }
+            string treeRoot = assetIndexDetails.MapToResources
+                ? Path.Combine(Path.GetFullPath(gameDirectory), "resources")
+                : Path.Combine(_config.AssetsDir, "virtual", mcVersion.AssetIndex.Id);
+            string recordPath = Path.Combine(treeRoot, LegacyTreeRecordFileName);
+            using Activity activity = LauncherTracing.Start("assets.materialize_legacy");
 
-        /// <summary>
-        /// Downloads a file if it doesn't exist or if its SHA1 hash doesn't match.
-        /// </summary>
-        /// <returns>True if the file is valid (exists and matches hash, or successfully downloaded and verified).</returns>
-        internal async Task<bool> DownloadAndVerifyFileAsync(
-            string url,
-            string localPath,
-            string expectedSha1,
-            string fileDescription, // For logging
-            CancellationToken cancellationToken,
-            ulong? expectedSize = null) // Optional expected size for more robust check before download
-        {
-            _logger.Verbose("Ensuring file: {Description} -> {LocalPath} from {Url}", fileDescription, localPath, url);
-
-            FileInfo fileInfo = new FileInfo(localPath);
+            Dictionary<string, string> previous = LoadLegacyTreeRecord(recordPath);
+            var current = new Dictionary<string, string>(assetIndexDetails.Objects.Count, StringComparer.Ordinal);
+            int linked = 0, symlinked = 0, copied = 0, unchanged = 0, failed = 0;
+            var stopwatch = Stopwatch.StartNew();
 
-            if (fileInfo.Exists)
+            foreach (var assetEntry in assetIndexDetails.Objects)
             {
-                if (expectedSize.HasValue && fileInfo.Length != (long)expectedSize.Value)
+                string virtualPath = assetEntry.Key;
+                AssetObjectInfo assetInfo = assetEntry.Value;
+                string targetPath = Path.GetFullPath(Path.Combine(treeRoot, virtualPath.Replace('/', Path.DirectorySeparatorChar)));
+                if (!targetPath.StartsWith(treeRoot + Path.DirectorySeparatorChar, StringComparison.Ordinal))
                 {
-                    _logger.Warning("File {Description} exists at {LocalPath} but size mismatch. Expected: {ExpectedSize}, Actual: {ActualSize}. Re-downloading.",
-                        fileDescription, localPath, expectedSize.Value, fileInfo.Length);
+                    _logger.Warning("Skipping asset path {VirtualPath} that escapes {TreeRoot}.", virtualPath, treeRoot);
+                    continue;
                 }
-                else if (!string.IsNullOrEmpty(expectedSha1))
+
+                if (previous.TryGetValue(virtualPath, out string previousHash) &&
+                    string.Equals(previousHash, assetInfo.Hash, StringComparison.OrdinalIgnoreCase) &&
+                    IsIntact(targetPath, assetInfo.Size))
                 {
-                    _logger.Verbose("Verifying SHA1 for existing file: {LocalPath}", localPath);
-                    string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(localPath, cancellationToken);
-                    if (cancellationToken.IsCancellationRequested) return false;
+                    current[virtualPath] = assetInfo.Hash;
+                    unchanged++;
+                    continue;
+                }
 
-                    if (actualSha1 != null && actualSha1.Equals(expectedSha1, StringComparison.OrdinalIgnoreCase))
-                    {
-                        _logger.Verbose("SHA1 match for existing file: {LocalPath}. No download needed.", localPath);
-                        return true;
-                    }
-                    _logger.Warning("SHA1 mismatch for existing file {Description} at {LocalPath}. Expected: {ExpectedSha1}, Actual: {ActualSha1}. Re-downloading.",
-                        fileDescription, localPath, expectedSha1, actualSha1 ?? "N/A");
+                string objectPath = Path.Combine(_config.AssetObjectsDir, assetInfo.Hash.Substring(0, 2), assetInfo.Hash);
+                string tempPath = null;
+                try
+                {
+                    Directory.CreateDirectory(Path.GetDirectoryName(targetPath));
+                    tempPath = AtomicFile.CreateTempPath(targetPath);
+                    // The store is content-addressed and re-verified by the scheduler, so it is not marked read-only.
+                    FileCloneMethod method = FileCloner.Clone(objectPath, tempPath, allowHardlink: true, allowSymlink: true, protectSource: false);
+                    AtomicFile.Commit(tempPath, targetPath);
+                    current[virtualPath] = assetInfo.Hash;
+                    if (method == FileCloneMethod.Copy) copied++;
+                    else if (method == FileCloneMethod.Symlink) symlinked++;
+                    else linked++;
                 }
-                else
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
                 {
-                    // No SHA1 to verify, and size matches or not provided, assume it's fine.
-                    _logger.Verbose("File {Description} exists and no SHA1 provided for verification, or size matches. Assuming valid: {LocalPath}", fileDescription, localPath);
-                    return true;
+                    AtomicFile.TryDeleteTemp(tempPath);
+                    _logger.Error(ex, "Failed to materialize legacy asset {VirtualPath} from {ObjectPath}", virtualPath, objectPath);
+                    failed++;
                 }
-                // If we reach here, it's because of size mismatch or SHA1 mismatch, so delete and re-download
-                try { fileInfo.Delete(); } catch(Exception ex) { _logger.Error(ex, "Failed to delete mismatched file {LocalPath} before re-download.", localPath); return false; }
             }
 
-            _logger.Verbose("Downloading {Description}: {Url} -> {LocalPath}", fileDescription, url, localPath);
-
-            // Ensure directory exists
-            string directory = Path.GetDirectoryName(localPath);
-            if (!string.IsNullOrEmpty(directory) && !Directory.Exists(directory))
+            // Paths that were materialized before but are no longer in the index.
+            int removed = 0;
+            foreach (string stalePath in previous.Keys.Where(p => !assetIndexDetails.Objects.ContainsKey(p)))
             {
-                Directory.CreateDirectory(directory);
+                try
+                {
+                    string fullPath = Path.Combine(treeRoot, stalePath.Replace('/', Path.DirectorySeparatorChar));
+                    if (File.Exists(fullPath))
+                    {
+                        File.Delete(fullPath);
+                        removed++;
+                    }
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    _logger.Verbose(ex, "Could not remove stale legacy asset {VirtualPath}", stalePath);
+                }
             }
 
-            var (response, downloadedFilePath) = await _httpManager.DownloadAsync(url, localPath, null /* IProgress can be added */, cancellationToken);
-            if (cancellationToken.IsCancellationRequested)
+            try
             {
-                DeletePartialFile(downloadedFilePath, "Download Canceled");
-                return false;
+                AtomicFile.WriteAllText(recordPath, JsonSerializer.Serialize(current));
             }
-
-            if (!response.IsSuccessStatusCode)
+            catch (Exception ex)
             {
-                _logger.Error("Failed to download {Description} from {Url}. Status: {StatusCode}. File: {LocalPath}",
-                    fileDescription, url, response.StatusCode, localPath);
-                DeletePartialFile(downloadedFilePath, $"HTTP Error {response.StatusCode}");
-                return false;
+                _logger.Warning(ex, "Failed to record the legacy asset layout at {RecordPath}; it will be re-checked next time.", recordPath);
             }
 
-            _logger.Verbose("Download complete for {Description}: {LocalPath}", fileDescription, localPath);
-
-            if (!string.IsNullOrEmpty(expectedSha1))
-            {
-                _logger.Verbose("Verifying SHA1 for downloaded file: {LocalPath}", localPath);
-                string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(localPath, cancellationToken);
-                if (cancellationToken.IsCancellationRequested)
-                {
-                    DeletePartialFile(localPath, "Verification Canceled");
-                    return false;
-                }
+            _logger.Information("Legacy assets for {AssetIndexId} at {TreeRoot}: {Unchanged} unchanged, {Linked} linked, {Symlinked} symlinked, {Copied} copied, {Removed} removed, {Failed} failed in {ElapsedMs:F0} ms.",
+                mcVersion.AssetIndex.Id, treeRoot, unchanged, linked, symlinked, copied, removed, failed, stopwatch.Elapsed.TotalMilliseconds);
+            activity?.SetTag("unchanged", unchanged);
+            activity?.SetTag("materialized", linked + symlinked + copied);
+            activity?.SetTag("failed", failed);
+            return failed == 0 ? treeRoot : null;
+        }
 
-                if (actualSha1 == null || !actualSha1.Equals(expectedSha1, StringComparison.OrdinalIgnoreCase))
-                {
-                    _logger.Error("SHA1 mismatch after downloading {Description} to {LocalPath}. Expected: {ExpectedSha1}, Actual: {ActualSha1}",
-                        fileDescription, localPath, expectedSha1, actualSha1 ?? "N/A");
-                    DeletePartialFile(localPath, "SHA1 Mismatch");
-                    return false;
-                }
-                _logger.Verbose("SHA1 verified for downloaded file: {LocalPath}", localPath);
-            }
-            return true;
+        private static bool IsIntact(string path, ulong expectedSize)
+        {
+            // A symlinked entry is judged by what it points to; a dangling link is not intact.
+            var info = new FileInfo(path);
+            if (info.Exists && info.LinkTarget != null) info = info.ResolveLinkTarget(true) as FileInfo;
+            return info != null && info.Exists && (ulong)info.Length == expectedSize;
         }
 
-        private void DeletePartialFile(string filePath, string reason)
+        private Dictionary<string, string> LoadLegacyTreeRecord(string recordPath)
         {
-            if (File.Exists(filePath))
+            try
             {
-                try
-                {
-                    File.Delete(filePath);
-                    _logger.Warning("Deleted file {FilePath} due to: {Reason}", filePath, reason);
-                }
-                catch (Exception ex)
+                if (File.Exists(recordPath))
                 {
-                    _logger.Error(ex, "Failed to delete file {FilePath} after error ({Reason})", filePath, reason);
+                    var record = JsonSerializer.Deserialize<Dictionary<string, string>>(File.ReadAllText(recordPath));
+                    if (record != null) return new Dictionary<string, string>(record, StringComparer.Ordinal);
                 }
             }
+            catch (Exception ex)
+            {
+                _logger.Verbose(ex, "Ignoring unreadable legacy asset record {RecordPath}", recordPath);
+            }
+            return new Dictionary<string, string>(StringComparer.Ordinal);
         }
     }
 
     /// <summary>
-    /// Progress report structure for asset downloads.
+    /// Progress report structure for asset downloads. A value type, so reporting allocates nothing.
     /// </summary>
-    public class AssetDownloadProgress
+    public readonly struct AssetDownloadProgress
     {
-        public string CurrentFile { get; set; }
-        public int ProcessedFiles { get; set; }
-        public int TotalFiles { get; set; }
-        public long CurrentFileBytesDownloaded { get; set; } // For the currently downloading file
-        public long CurrentFileTotalBytes { get; set; }      // For the currently downloading file
+        public string CurrentFile { get; init; }
+        public int ProcessedFiles { get; init; }
+        public int TotalFiles { get; init; }
+        public long CurrentFileBytesDownloaded { get; init; } // For the currently downloading file
+        public long CurrentFileTotalBytes { get; init; }      // For the currently downloading file
     }
 }
\ No newline at end of file
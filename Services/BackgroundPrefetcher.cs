@@ -0,0 +1,253 @@
+﻿// Services/BackgroundPrefetcher.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Settings for <see cref="BackgroundPrefetcher"/>. The defaults are deliberately conservative so that
+    /// the job can run while the game is being played.
+    /// </summary>
+    public class BackgroundPrefetchOptions
+    {
+        /// <summary>
+        /// Whether the latest snapshot is prefetched in addition to the latest release.
+        /// </summary>
+        public bool IncludeSnapshots { get; set; } = true;
+
+        /// <summary>
+        /// How often the manifest is re-checked for new versions.
+        /// </summary>
+        public TimeSpan PollInterval { get; set; } = TimeSpan.FromHours(1);
+
+        /// <summary>
+        /// Combined download rate ceiling for all background transfers.
+        /// </summary>
+        public long MaxBytesPerSecond { get; set; } = 2 * 1024 * 1024;
+
+        /// <summary>
+        /// Number of files downloaded concurrently.
+        /// </summary>
+        public int MaxConcurrency { get; set; } = 2;
+
+        /// <summary>
+        /// Maximum number of bytes a single prefetch cycle may add to disk.
+        /// Anything beyond it is left for the next cycle.
+        /// </summary>
+        public long DiskBudgetBytes { get; set; } = 1024L * 1024 * 1024;
+
+        /// <summary>
+        /// Free space that must remain on the data drive after prefetching.
+        /// </summary>
+        public long MinFreeDiskBytes { get; set; } = 5L * 1024 * 1024 * 1024;
+    }
+
+    /// <summary>
+    /// Optional background job that watches <see cref="VersionManifest.Latest"/> through the cached manifest and
+    /// pre-downloads the client JAR, libraries and assets of new releases (and snapshots) before the user asks for them.
+    /// Only the delta against what is already on disk is fetched, through a separate low-concurrency,
+    /// rate-limited <see cref="DownloadScheduler"/> and within a per-cycle disk budget.
+    /// </summary>
+    public class BackgroundPrefetcher
+    {
+        private readonly LauncherConfig _config;
+        private readonly VersionCatalog _catalog;
+        private readonly AssetManager _assetManager;
+        private readonly LibraryManager _libraryManager;
+        private readonly DownloadScheduler _scheduler;
+        private readonly BackgroundPrefetchOptions _options;
+        private readonly ILogger _logger;
+        private LatestVersionInfo _lastSeenLatest;
+
+        public BackgroundPrefetcher(
+            LauncherConfig config,
+            HttpManager httpManager,
+            VersionCatalog catalog,
+            AssetManager assetManager,
+            LibraryManager libraryManager,
+            BackgroundPrefetchOptions options = null,
+            FileLockManager locks = null)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            if (httpManager == null) throw new ArgumentNullException(nameof(httpManager));
+            _catalog = catalog ?? throw new ArgumentNullException(nameof(catalog));
+            _assetManager = assetManager ?? throw new ArgumentNullException(nameof(assetManager));
+            _libraryManager = libraryManager ?? throw new ArgumentNullException(nameof(libraryManager));
+            _options = options ?? new BackgroundPrefetchOptions();
+            _scheduler = new DownloadScheduler(httpManager, _options.MaxConcurrency, new BandwidthLimiter(_options.MaxBytesPerSecond), locks: locks, durability: config.Durability);
+            _logger = Log.ForContext<BackgroundPrefetcher>();
+            _logger.Verbose("BackgroundPrefetcher initialized (rate {Rate} B/s, budget {Budget} bytes, snapshots {Snapshots}).",
+                _options.MaxBytesPerSecond, _options.DiskBudgetBytes, _options.IncludeSnapshots);
+        }
+
+        /// <summary>
+        /// Starts the watch loop on the thread pool. The returned task completes when <paramref name="cancellationToken"/>
+        /// is cancelled; it never faults, background failures are only logged.
+        /// </summary>
+        public Task Start(CancellationToken cancellationToken)
+        {
+            return Task.Run(async () =>
+            {
+                try
+                {
+                    await RunAsync(cancellationToken).ConfigureAwait(false);
+                }
+                catch (OperationCanceledException)
+                {
+                    _logger.Verbose("Background prefetch stopped.");
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Background prefetch stopped after an unexpected error.");
+                }
+            }, CancellationToken.None);
+        }
+
+        /// <summary>
+        /// Runs prefetch cycles every <see cref="BackgroundPrefetchOptions.PollInterval"/> until cancelled.
+        /// </summary>
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            bool refresh = false;
+            while (true)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                await RunOnceAsync(refresh, cancellationToken).ConfigureAwait(false);
+                // The first cycle reuses whatever manifest the launcher already has; later cycles poll Mojang.
+                refresh = true;
+                await Task.Delay(_options.PollInterval, cancellationToken).ConfigureAwait(false);
+            }
+        }
+
+        /// <summary>
+        /// Performs a single prefetch cycle: resolves the latest release/snapshot, computes which of their files are
+        /// missing locally and downloads as many of them as the disk budget allows.
+        /// </summary>
+        /// <param name="refreshManifest">Whether to re-fetch the manifest instead of using the cached copy.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>True if the cycle completed without failures (including "nothing to do").</returns>
+        public async Task<bool> RunOnceAsync(bool refreshManifest = false, CancellationToken cancellationToken = default)
+        {
+            VersionManifest manifest = await _catalog.GetManifestAsync(refreshManifest, cancellationToken).ConfigureAwait(false);
+            if (manifest?.Latest == null)
+            {
+                _logger.Warning("Background prefetch: no manifest available, skipping this cycle.");
+                return false;
+            }
+
+            if (_lastSeenLatest == null ||
+                _lastSeenLatest.Release != manifest.Latest.Release ||
+                _lastSeenLatest.Snapshot != manifest.Latest.Snapshot)
+            {
+                _logger.Information("Background prefetch: latest release {Release}, latest snapshot {Snapshot}.",
+                    manifest.Latest.Release, manifest.Latest.Snapshot);
+                _lastSeenLatest = manifest.Latest;
+            }
+
+            var selectors = new List<string> { "latest-release" };
+            if (_options.IncludeSnapshots) selectors.Add("latest-snapshot");
+            List<VersionMetadata> targets = _catalog.ResolveSelectors(manifest, selectors);
+
+            // 1. Resolve the targets' requirements.
+            var workItems = new List<InstallWorkItem>();
+            foreach (var versionMeta in targets)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                MinecraftVersion version = await _catalog.GetVersionAsync(versionMeta, cancellationToken).ConfigureAwait(false);
+                if (version == null) continue;
+
+                if (version.Downloads.TryGetValue("client", out DownloadDetails client))
+                {
+                    workItems.Add(new InstallWorkItem
+                    {
+                        Kind = InstallWorkKind.ClientJar,
+                        Url = client.Url,
+                        LocalPath = Path.Combine(_config.VersionsDir, version.Id, $"{version.Id}.jar"),
+                        Sha1 = client.Sha1,
+                        Size = client.Size,
+                        Description = $"Client JAR for {version.Id}"
+                    });
+                }
+                workItems.AddRange(_libraryManager.CollectLibraryWorkItems(version));
+
+                List<InstallWorkItem> assetItems = await _assetManager.CollectAssetWorkItemsAsync(version, cancellationToken).ConfigureAwait(false);
+                if (assetItems != null) workItems.AddRange(assetItems);
+            }
+
+            // 2. Delta against disk. Only a stat is done here; anything present with the right size is left
+            //    for the foreground install to verify, which keeps the background job cheap.
+            List<InstallWorkItem> missing = _scheduler.Deduplicate(workItems).Where(IsMissingOrWrongSize).ToList();
+            if (missing.Count == 0)
+            {
+                _logger.Verbose("Background prefetch: {Versions} already present on disk.", string.Join(", ", targets.Select(t => t.Id)));
+                return true;
+            }
+
+            // 3. Apply the disk budget. Items are kept in resolution order (client JAR, libraries, assets),
+            //    so a partially funded cycle still completes whole versions' code before their assets.
+            long allowance = GetDiskAllowance();
+            var funded = new List<InstallWorkItem>();
+            long fundedBytes = 0;
+            foreach (var item in missing)
+            {
+                long size = (long)(item.Size ?? 0);
+                if (fundedBytes + size > allowance) break;
+                fundedBytes += size;
+                funded.Add(item);
+            }
+
+            long missingBytes = missing.Sum(i => (long)(i.Size ?? 0));
+            _logger.Information("Background prefetch: {Missing} file(s) ({MissingMb:F1} MB) missing for {Versions}; fetching {Funded} ({FundedMb:F1} MB) within budget.",
+                missing.Count, missingBytes / (1024.0 * 1024.0), string.Join(", ", targets.Select(t => t.Id)),
+                funded.Count, fundedBytes / (1024.0 * 1024.0));
+            if (funded.Count == 0)
+            {
+                _logger.Warning("Background prefetch: disk budget exhausted ({Allowance} bytes available), skipping this cycle.", allowance);
+                return true;
+            }
+
+            DownloadRunSummary summary = await _scheduler.RunAsync(funded, cancellationToken: cancellationToken).ConfigureAwait(false);
+            _logger.Information("Background prefetch cycle done: {Downloaded} downloaded, {Failed} failed, {MBps:F2} MB/s over {Elapsed:F0}s.",
+                summary.Downloaded, summary.Failed, summary.DownloadMegabytesPerSecond, summary.Elapsed.TotalSeconds);
+            return summary.Failed == 0;
+        }
+
+        private static bool IsMissingOrWrongSize(InstallWorkItem item)
+        {
+            var info = new FileInfo(item.LocalPath);
+            if (!info.Exists) return true;
+            return item.Size.HasValue && info.Length != (long)item.Size.Value;
+        }
+
+        /// <summary>
+        /// Bytes this cycle may write: the configured budget, reduced so that
+        /// <see cref="BackgroundPrefetchOptions.MinFreeDiskBytes"/> stays free on the data drive.
+        /// </summary>
+        private long GetDiskAllowance()
+        {
+            long allowance = _options.DiskBudgetBytes;
+            try
+            {
+                string root = Path.GetPathRoot(Path.GetFullPath(_config.BaseDataPath));
+                if (!string.IsNullOrEmpty(root))
+                {
+                    long free = new DriveInfo(root).AvailableFreeSpace;
+                    allowance = Math.Min(allowance, free - _options.MinFreeDiskBytes);
+                }
+            }
+            catch (Exception ex)
+            {
+                _logger.Verbose(ex, "Could not query free disk space for {Path}; using the configured budget only.", _config.BaseDataPath);
+            }
+            return Math.Max(0, allowance);
+        }
+    }
+}
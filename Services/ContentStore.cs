@@ -0,0 +1,499 @@
+﻿// Services/ContentStore.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// The files one installed version depends on, stored as <c>&lt;data&gt;/refs/&lt;version&gt;.json</c>.
+    /// Paths are relative to the data directory and use <c>/</c> as separator.
+    /// </summary>
+    public class VersionRefs
+    {
+        public string VersionId { get; set; }
+        public DateTime RecordedUtc { get; set; }
+
+        /// <summary>
+        /// Directory name of the Java runtime under <c>java_runtimes</c>, or null if unknown.
+        /// </summary>
+        public string Runtime { get; set; }
+
+        public List<string> Files { get; set; } = new List<string>();
+    }
+
+    /// <summary>
+    /// What a garbage collection found (dry run) or removed (execute) in one store area.
+    /// </summary>
+    public class GcAreaStats
+    {
+        public int Objects { get; set; }
+        public long Bytes { get; set; }
+        public int Deleted { get; set; }
+        public long DeletedBytes { get; set; }
+        public int Failed { get; set; }
+    }
+
+    /// <summary>
+    /// Result of <see cref="ContentStore.CollectGarbageAsync"/>.
+    /// </summary>
+    public class GcReport
+    {
+        public bool Executed { get; set; }
+        public int Roots { get; set; }
+
+        /// <summary>
+        /// Versions whose references could not be determined; the areas they could use were not swept.
+        /// </summary>
+        public List<string> UnresolvedVersions { get; } = new List<string>();
+
+        /// <summary>
+        /// Unreferenced objects left alone because they are newer than the minimum age.
+        /// </summary>
+        public int SkippedRecent { get; set; }
+
+        public Dictionary<string, GcAreaStats> Areas { get; } = new Dictionary<string, GcAreaStats>(StringComparer.Ordinal);
+
+        /// <summary>
+        /// Unreferenced paths, in sweep order (for dry-run reporting).
+        /// </summary>
+        public List<string> Candidates { get; } = new List<string>();
+
+        public int CandidateCount => Areas.Values.Sum(a => a.Objects);
+        public long CandidateBytes => Areas.Values.Sum(a => a.Bytes);
+        public long DeletedBytes => Areas.Values.Sum(a => a.DeletedBytes);
+    }
+
+    /// <summary>
+    /// Ownership tracking and garbage collection for everything the launcher installs under the data directory.
+    /// <para>
+    /// The data directory is treated as one store made of areas: asset objects (keyed by SHA1), asset indexes,
+    /// libraries (keyed by Maven path), Java runtimes, runtime download archives and version directories. Each installed
+    /// version is a root. Its <see cref="VersionRefs"/> list the store objects it uses and are written by the install path.
+    /// Versions installed before refs existed, or only prefetched, are resolved from their cached version JSON.
+    /// </para>
+    /// <para>
+    /// Collection is mark-and-sweep under the cross-process <c>store-gc</c> lock. Planning an install holds the same lock
+    /// while it fetches the asset index and classifies files, and executing it publishes the version's refs before the
+    /// scheduler checks any file. A collection that runs between the two can still remove files the plan counted as
+    /// present; the plan's figures are then stale, but the scheduler re-checks every file and downloads them again.
+    /// Objects younger than a minimum age are never removed, which protects files written by prefetches that publish no
+    /// refs.
+    /// </para>
+    /// </summary>
+    public class ContentStore
+    {
+        public const string GcLockKey = "store-gc";
+
+        /// <summary>
+        /// Unreferenced objects modified more recently than this are kept.
+        /// </summary>
+        public static readonly TimeSpan DefaultMinimumAge = TimeSpan.FromHours(1);
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true, WriteIndented = true };
+        private static readonly StringComparer PathComparer = OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+
+        private readonly LauncherConfig _config;
+        private readonly FileLockManager _locks;
+        private readonly VersionCatalog _catalog;
+        private readonly LibraryManager _libraryManager;
+        private readonly JavaManager _javaManager;
+        private readonly ILogger _logger;
+
+        public ContentStore(
+            LauncherConfig config,
+            FileLockManager locks,
+            VersionCatalog catalog,
+            LibraryManager libraryManager,
+            JavaManager javaManager)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _locks = locks ?? throw new ArgumentNullException(nameof(locks));
+            _catalog = catalog ?? throw new ArgumentNullException(nameof(catalog));
+            _libraryManager = libraryManager ?? throw new ArgumentNullException(nameof(libraryManager));
+            _javaManager = javaManager ?? throw new ArgumentNullException(nameof(javaManager));
+            _logger = Log.ForContext<ContentStore>();
+            _logger.Verbose("ContentStore initialized with refs at {RefsDir}.", _config.RefsDir);
+        }
+
+        /// <summary>
+        /// Takes the <c>store-gc</c> lock without changing anything, so no collection runs while the caller inspects the
+        /// store (e.g., while an install plan classifies its files).
+        /// </summary>
+        /// <param name="purpose">Short description written into the lock file for diagnostics.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>The lease; dispose it to let collections run again.</returns>
+        public Task<FileLease> AcquireCollectionLockAsync(string purpose, CancellationToken cancellationToken = default)
+        {
+            return _locks.AcquireAsync(GcLockKey, purpose, cancellationToken);
+        }
+
+        /// <summary>
+        /// Publishes the refs of the version an install plan is about to install. Call before the scheduler checks the
+        /// plan's files; a collection that ran after planning may already have removed some, which the scheduler then
+        /// downloads again.
+        /// </summary>
+        /// <param name="plan">The install plan.</param>
+        /// <param name="runtime">The runtime the version will use, if already known.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public async Task RecordInstallAsync(InstallPlan plan, JavaRuntimeInfo runtime, CancellationToken cancellationToken = default)
+        {
+            if (plan == null) throw new ArgumentNullException(nameof(plan));
+            var refs = new VersionRefs
+            {
+                VersionId = plan.Version.Id,
+                RecordedUtc = DateTime.UtcNow,
+                Runtime = GetRuntimeDirectoryName(runtime?.HomePath)
+            };
+            refs.Files.AddRange(plan.Files.Select(f => ToStorePath(f.Item.LocalPath)));
+            if (plan.Version.AssetIndex != null)
+            {
+                refs.Files.Add(ToStorePath(GetAssetIndexPath(plan.Version.AssetIndex.Id)));
+            }
+
+            using FileLease lease = await _locks.AcquireAsync(GcLockKey, $"recording refs of {plan.Version.Id}", cancellationToken).ConfigureAwait(false);
+            try
+            {
+                AtomicFile.WriteAllText(GetRefsPath(refs.VersionId), JsonSerializer.Serialize(refs, JsonOptions));
+                _logger.Verbose("Recorded {Count} store reference(s) for {VersionId} (runtime {Runtime}).", refs.Files.Count, refs.VersionId, refs.Runtime ?? "none");
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                // Not fatal: without refs the version is resolved from its version JSON during collection.
+                _logger.Warning(ex, "Failed to record store references for {VersionId}.", refs.VersionId);
+            }
+        }
+
+        /// <summary>
+        /// Uninstalls a version: removes its refs and its version directory (client JAR, natives, version JSON).
+        /// Shared content it used is reclaimed by the next collection if nothing else references it.
+        /// </summary>
+        /// <returns>True if the version was installed and has been removed.</returns>
+        public async Task<bool> RemoveVersionAsync(string versionId, CancellationToken cancellationToken = default)
+        {
+            string versionDir = Path.Combine(_config.VersionsDir, versionId);
+            string refsPath = GetRefsPath(versionId);
+            string packPath = VersionTiering.GetPackPath(_config, versionId);
+            if (!Directory.Exists(versionDir) && !File.Exists(refsPath) && !File.Exists(packPath))
+            {
+                _logger.Warning("Version {VersionId} is not installed.", versionId);
+                return false;
+            }
+
+            using FileLease lease = await _locks.AcquireAsync(GcLockKey, $"removing {versionId}", cancellationToken).ConfigureAwait(false);
+            try
+            {
+                if (File.Exists(refsPath)) File.Delete(refsPath);
+                if (Directory.Exists(versionDir)) Directory.Delete(versionDir, true);
+                if (File.Exists(packPath)) File.Delete(packPath);
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Error(ex, "Failed to remove version {VersionId}.", versionId);
+                return false;
+            }
+            _logger.Information("Removed version {VersionId}. Run 'gc --execute' to reclaim content no other version uses.", versionId);
+            return true;
+        }
+
+        /// <summary>
+        /// Finds (and with <paramref name="execute"/>, deletes) store objects no installed version references.
+        /// </summary>
+        /// <param name="execute">False for a dry run that only reports what would be removed.</param>
+        /// <param name="minimumAge">Unreferenced objects modified more recently are kept; defaults to <see cref="DefaultMinimumAge"/>.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public async Task<GcReport> CollectGarbageAsync(bool execute, TimeSpan? minimumAge = null, CancellationToken cancellationToken = default)
+        {
+            var report = new GcReport { Executed = execute };
+            using FileLease lease = await _locks.AcquireAsync(GcLockKey, execute ? "garbage collection" : "garbage collection (dry run)", cancellationToken).ConfigureAwait(false);
+            DateTime cutoffUtc = DateTime.UtcNow - (minimumAge ?? DefaultMinimumAge);
+
+            // --- Mark ---
+            var markedFiles = new HashSet<string>(PathComparer);
+            var markedRuntimes = new HashSet<string>(PathComparer);
+            var versionDirectories = new List<string>();
+            bool allResolved = true;
+
+            foreach (string versionDir in Directory.Exists(_config.VersionsDir) ? Directory.EnumerateDirectories(_config.VersionsDir) : Enumerable.Empty<string>())
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                string versionId = Path.GetFileName(versionDir);
+                VersionRefs refs = ResolveRefs(versionId);
+                if (refs == null)
+                {
+                    if (File.Exists(_catalog.GetVersionJsonPath(versionId)))
+                    {
+                        // Installed, but we can't tell what it uses: keep everything it might need.
+                        report.UnresolvedVersions.Add(versionId);
+                        allResolved = false;
+                    }
+                    else
+                    {
+                        versionDirectories.Add(versionDir); // Neither refs nor version JSON: debris of a failed install.
+                    }
+                    continue;
+                }
+
+                report.Roots++;
+                foreach (string file in refs.Files) markedFiles.Add(FromStorePath(file));
+                if (refs.Runtime != null) markedRuntimes.Add(refs.Runtime);
+            }
+
+            _logger.Information("Store mark phase: {Roots} installed version(s), {Files} referenced file(s), {Runtimes} referenced runtime(s){Unresolved}.",
+                report.Roots, markedFiles.Count, markedRuntimes.Count,
+                allResolved ? string.Empty : $"; unresolved: {string.Join(", ", report.UnresolvedVersions)}");
+
+            // --- Sweep ---
+            foreach (string versionDir in versionDirectories)
+            {
+                SweepDirectory(report, "versions", versionDir, cutoffUtc, execute);
+            }
+
+            if (allResolved)
+            {
+                SweepFiles(report, "assets", _config.AssetObjectsDir, markedFiles, cutoffUtc, execute, cancellationToken);
+                SweepFiles(report, "asset-indexes", _config.AssetIndexesDir, markedFiles, cutoffUtc, execute, cancellationToken);
+                SweepFiles(report, "libraries", _config.LibrariesDir, markedFiles, cutoffUtc, execute, cancellationToken);
+                if (execute) AtomicFile.PruneEmptyDirectories(_config.LibrariesDir);
+
+                foreach (string runtimeDir in Directory.Exists(_config.JavaRuntimesDir) ? Directory.EnumerateDirectories(_config.JavaRuntimesDir) : Enumerable.Empty<string>())
+                {
+                    string name = Path.GetFileName(runtimeDir);
+                    if (name.StartsWith("_") || markedRuntimes.Contains(name)) continue;
+                    SweepDirectory(report, "runtimes", runtimeDir, cutoffUtc, execute);
+                }
+            }
+            else
+            {
+                _logger.Warning("Skipping assets, libraries and runtimes: {Count} installed version(s) could not be resolved offline. Launch them once to record their references.",
+                    report.UnresolvedVersions.Count);
+            }
+
+            // Refs of versions whose directory is gone (removed by hand) no longer protect anything.
+            foreach (string refsPath in Directory.Exists(_config.RefsDir) ? Directory.GetFiles(_config.RefsDir, "*.json") : Array.Empty<string>())
+            {
+                VersionRefs refs = LoadRefs(Path.GetFileNameWithoutExtension(refsPath));
+                if (refs?.VersionId == null || Directory.Exists(Path.Combine(_config.VersionsDir, refs.VersionId))) continue;
+                _logger.Verbose("Dropping stale references of {VersionId}.", refs.VersionId);
+                if (!execute) continue;
+                try
+                {
+                    File.Delete(refsPath);
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    _logger.Verbose(ex, "Could not delete stale references {Path}", refsPath);
+                }
+            }
+
+            // Runtime archives are only needed until they are extracted.
+            SweepFiles(report, "runtime-downloads", Path.Combine(_config.JavaRuntimesDir, "_downloads"), markedFiles, cutoffUtc, execute, cancellationToken);
+
+            LogReport(report);
+            return report;
+        }
+
+        /// <summary>
+        /// Reads the recorded refs of a version, or null if none were recorded.
+        /// </summary>
+        public VersionRefs LoadRefs(string versionId)
+        {
+            string refsPath = GetRefsPath(versionId);
+            if (!File.Exists(refsPath)) return null;
+            try
+            {
+                return JsonSerializer.Deserialize<VersionRefs>(File.ReadAllText(refsPath), JsonOptions);
+            }
+            catch (Exception ex) when (ex is IOException || ex is JsonException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not read store references {Path}; resolving {VersionId} from its version JSON.", refsPath, versionId);
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Returns the recorded refs of a version, falling back to resolving them from its cached metadata.
+        /// </summary>
+        /// <returns>The refs, or null if the version cannot be resolved offline.</returns>
+        internal VersionRefs ResolveRefs(string versionId) => LoadRefs(versionId) ?? DeriveRefs(versionId);
+
+        /// <summary>
+        /// Computes a version's refs from its cached version JSON and asset index, without network access.
+        /// </summary>
+        private VersionRefs DeriveRefs(string versionId)
+        {
+            MinecraftVersion version = _catalog.TryLoadCachedVersion(versionId);
+            if (version == null) return null;
+
+            var refs = new VersionRefs { VersionId = versionId, RecordedUtc = DateTime.UtcNow };
+            refs.Files.AddRange(_libraryManager.CollectLibraryWorkItems(version).Select(i => ToStorePath(i.LocalPath)));
+
+            if (version.AssetIndex != null)
+            {
+                string indexPath = GetAssetIndexPath(version.AssetIndex.Id);
+                AssetIndexDetails index = null;
+                try
+                {
+                    if (File.Exists(indexPath))
+                    {
+                        index = JsonSerializer.Deserialize<AssetIndexDetails>(File.ReadAllText(indexPath), JsonOptions);
+                    }
+                }
+                catch (Exception ex) when (ex is IOException || ex is JsonException)
+                {
+                    _logger.Verbose(ex, "Could not read asset index {Path}", indexPath);
+                }
+                if (index?.Objects == null)
+                {
+                    _logger.Verbose("Asset index {IndexId} of {VersionId} is not cached; cannot resolve its assets.", version.AssetIndex.Id, versionId);
+                    return null;
+                }
+
+                refs.Files.Add(ToStorePath(indexPath));
+                foreach (var entry in index.Objects.Values)
+                {
+                    refs.Files.Add(ToStorePath(Path.Combine(_config.AssetObjectsDir, entry.Hash.Substring(0, 2), entry.Hash)));
+                }
+            }
+
+            if (version.JavaVersion != null)
+            {
+                refs.Runtime = GetRuntimeDirectoryName(_javaManager.FindInstalledRuntime(version.JavaVersion)?.HomePath);
+            }
+            return refs;
+        }
+
+        private void SweepFiles(GcReport report, string area, string rootDir, HashSet<string> markedFiles, DateTime cutoffUtc, bool execute, CancellationToken cancellationToken)
+        {
+            if (!Directory.Exists(rootDir)) return;
+            foreach (string file in Directory.EnumerateFiles(rootDir, "*", SearchOption.AllDirectories))
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                if (markedFiles.Contains(Path.GetFullPath(file))) continue;
+
+                var info = new FileInfo(file);
+                if (!info.Exists) continue;
+                if (info.LastWriteTimeUtc > cutoffUtc)
+                {
+                    report.SkippedRecent++;
+                    continue;
+                }
+
+                var stats = GetArea(report, area);
+                stats.Objects++;
+                stats.Bytes += info.Length;
+                report.Candidates.Add(file);
+                if (!execute) continue;
+
+                try
+                {
+                    info.Delete();
+                    stats.Deleted++;
+                    stats.DeletedBytes += info.Length;
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    stats.Failed++;
+                    _logger.Warning(ex, "Failed to delete unreferenced {Path}", file);
+                }
+            }
+        }
+
+        private void SweepDirectory(GcReport report, string area, string directory, DateTime cutoffUtc, bool execute)
+        {
+            long bytes = 0;
+            DateTime newestUtc = Directory.GetLastWriteTimeUtc(directory);
+            foreach (var file in new DirectoryInfo(directory).EnumerateFiles("*", SearchOption.AllDirectories))
+            {
+                bytes += file.Length;
+                if (file.LastWriteTimeUtc > newestUtc) newestUtc = file.LastWriteTimeUtc;
+            }
+            if (newestUtc > cutoffUtc)
+            {
+                report.SkippedRecent++;
+                return;
+            }
+
+            var stats = GetArea(report, area);
+            stats.Objects++;
+            stats.Bytes += bytes;
+            report.Candidates.Add(directory);
+            if (!execute) return;
+
+            try
+            {
+                Directory.Delete(directory, true);
+                stats.Deleted++;
+                stats.DeletedBytes += bytes;
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                stats.Failed++;
+                _logger.Warning(ex, "Failed to delete unreferenced directory {Path}", directory);
+            }
+        }
+
+        private void LogReport(GcReport report)
+        {
+            string verb = report.Executed ? "Reclaimed" : "Would reclaim";
+            foreach (var pair in report.Areas.OrderBy(p => p.Key, StringComparer.Ordinal))
+            {
+                _logger.Information("  {Area,-18} {Objects,7} object(s) {Mb,10:F1} MB{Result}",
+                    pair.Key, pair.Value.Objects, pair.Value.Bytes / (1024.0 * 1024.0),
+                    report.Executed ? $"  ({pair.Value.Deleted} deleted, {pair.Value.Failed} failed)" : string.Empty);
+            }
+            if (!report.Executed)
+            {
+                foreach (string path in report.Candidates.Take(20)) _logger.Information("  unreferenced: {Path}", path);
+                foreach (string path in report.Candidates.Skip(20)) _logger.Verbose("  unreferenced: {Path}", path);
+                if (report.Candidates.Count > 20) _logger.Information("  ... and {More} more (see the verbose log).", report.Candidates.Count - 20);
+            }
+            _logger.Information("{Verb} {Mb:F1} MB in {Count} object(s); {Recent} recent unreferenced object(s) kept.",
+                verb, (report.Executed ? report.DeletedBytes : report.CandidateBytes) / (1024.0 * 1024.0), report.CandidateCount, report.SkippedRecent);
+        }
+
+        private static GcAreaStats GetArea(GcReport report, string area)
+        {
+            if (!report.Areas.TryGetValue(area, out var stats))
+            {
+                stats = new GcAreaStats();
+                report.Areas[area] = stats;
+            }
+            return stats;
+        }
+
+        private string GetRuntimeDirectoryName(string homePath)
+        {
+            if (string.IsNullOrEmpty(homePath)) return null;
+            string relative = Path.GetRelativePath(_config.JavaRuntimesDir, Path.GetFullPath(homePath));
+            if (relative.StartsWith("..") || Path.IsPathRooted(relative)) return null; // User-provided runtime outside the store.
+            return relative.Split(Path.DirectorySeparatorChar, Path.AltDirectorySeparatorChar)[0];
+        }
+
+        private string GetAssetIndexPath(string indexId) => Path.Combine(_config.AssetIndexesDir, $"{indexId}.json");
+
+        private string GetRefsPath(string versionId)
+        {
+            var sanitized = new StringBuilder(versionId.Length);
+            foreach (char c in versionId)
+            {
+                sanitized.Append(Array.IndexOf(Path.GetInvalidFileNameChars(), c) >= 0 ? '_' : c);
+            }
+            return Path.Combine(_config.RefsDir, sanitized + ".json");
+        }
+
+        internal string ToStorePath(string fullPath) =>
+            Path.GetRelativePath(_config.BaseDataPath, Path.GetFullPath(fullPath)).Replace(Path.DirectorySeparatorChar, '/');
+
+        internal string FromStorePath(string storePath) =>
+            Path.GetFullPath(Path.Combine(_config.BaseDataPath, storePath.Replace('/', Path.DirectorySeparatorChar)));
+    }
+}
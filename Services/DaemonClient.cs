@@ -0,0 +1,110 @@
+﻿// Services/DaemonClient.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Net.Sockets;
+using System.Text;
+using System.Text.Json;
+using System.Text.Json.Nodes;
+using System.Threading;
+using System.Threading.Tasks;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Thin client of <see cref="LauncherDaemon"/> (<c>ctl</c>): sends one request and writes the answer lines to the
+    /// output as they arrive, so scripts can read them as JSON lines. Nothing is initialized beyond the socket.
+    /// </summary>
+    public class DaemonClient
+    {
+        private readonly string _socketPath;
+        private readonly ILogger _logger;
+
+        public DaemonClient(string socketPath)
+        {
+            _socketPath = socketPath ?? throw new ArgumentNullException(nameof(socketPath));
+            _logger = Log.ForContext<DaemonClient>();
+        }
+
+        /// <summary>
+        /// Builds a request from command line words: the first is the command, later words go to <c>args</c>,
+        /// <c>--name=value</c> becomes an option and a bare <c>--name</c> a flag set to true.
+        /// </summary>
+        public static JsonObject CreateRequest(IEnumerable<string> words)
+        {
+            var request = new JsonObject();
+            var arguments = new JsonArray();
+            foreach (string word in words)
+            {
+                if (word.StartsWith("--", StringComparison.Ordinal))
+                {
+                    int separator = word.IndexOf('=');
+                    if (separator < 0) request[word.Substring(2)] = true;
+                    else request[word.Substring(2, separator - 2)] = word.Substring(separator + 1);
+                }
+                else if (!request.ContainsKey("command"))
+                {
+                    request["command"] = word;
+                }
+                else
+                {
+                    arguments.Add(word);
+                }
+            }
+            request["args"] = arguments;
+            return request;
+        }
+
+        /// <summary>
+        /// Sends <paramref name="request"/> and copies the answer to <paramref name="output"/> until the daemon is done
+        /// with it. A <c>result</c> carrying text (e.g. <c>metrics</c>) is written as that text.
+        /// </summary>
+        /// <returns>0 on success, 1 if the daemon reported an error or a failed job, or could not be reached.</returns>
+        public async Task<int> SendAsync(JsonObject request, TextWriter output, CancellationToken cancellationToken = default)
+        {
+            if (request == null) throw new ArgumentNullException(nameof(request));
+            if (output == null) throw new ArgumentNullException(nameof(output));
+
+            using var socket = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+            try
+            {
+                await socket.ConnectAsync(new UnixDomainSocketEndPoint(_socketPath), cancellationToken).ConfigureAwait(false);
+            }
+            catch (SocketException ex)
+            {
+                _logger.Error("No daemon is listening on {SocketPath} ({Reason}); start one with `daemon`.", _socketPath, ex.SocketErrorCode);
+                return 1;
+            }
+
+            using var stream = new NetworkStream(socket, ownsSocket: false);
+            byte[] line = Encoding.UTF8.GetBytes(request.ToJsonString() + "\n");
+            await stream.WriteAsync(line, cancellationToken).ConfigureAwait(false);
+            // Closing our side tells the daemon this was the only request, so it closes the connection once it has answered.
+            socket.Shutdown(SocketShutdown.Send);
+
+            int exitCode = 0;
+            using var reader = new StreamReader(stream, new UTF8Encoding(false));
+            string answer;
+            while ((answer = await reader.ReadLineAsync(cancellationToken).ConfigureAwait(false)) != null)
+            {
+                JsonObject message;
+                try
+                {
+                    message = JsonNode.Parse(answer) as JsonObject;
+                }
+                catch (JsonException)
+                {
+                    message = null;
+                }
+                string kind = message?["event"]?.GetValue<string>();
+                if (kind == "error" || (kind == "done" && message["state"]?.GetValue<string>() != "succeeded")) exitCode = 1;
+
+                if (kind == "result" && message["text"] is JsonValue text) await output.WriteAsync(text.GetValue<string>()).ConfigureAwait(false);
+                else await output.WriteLineAsync(answer).ConfigureAwait(false);
+                await output.FlushAsync().ConfigureAwait(false);
+            }
+            return exitCode;
+        }
+    }
+}
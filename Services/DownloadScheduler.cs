@@ -0,0 +1,499 @@
+﻿// Services/DownloadScheduler.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+using Serilog.Events;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Downloads and verifies sets of <see cref="InstallWorkItem"/>s with bounded concurrency.
+    /// This is the single place where "make sure this file exists and matches its hash" is implemented;
+    /// AssetManager and LibraryManager both delegate to it.
+    /// </summary>
+    public class DownloadScheduler
+    {
+        private readonly HttpManager _httpManager;
+        private readonly ILogger _logger;
+        private readonly int _maxConcurrency;
+        private readonly BandwidthLimiter _bandwidthLimiter;
+        private readonly InstallJournal _journal;
+        private readonly FileLockManager _locks;
+        private readonly DurableCommitter _committer;
+        private readonly PeerCache _peerCache;
+
+        // Below this many existing files the per-item path is just as fast, so no bulk pass is made.
+        private const int BulkVerifyThreshold = 32;
+
+        /// <param name="httpManager">HTTP manager used for downloads.</param>
+        /// <param name="maxConcurrency">Maximum concurrent items; 0 uses the processor count.</param>
+        /// <param name="bandwidthLimiter">Optional limiter capping the combined download rate of this scheduler.</param>
+        /// <param name="journal">
+        /// Optional install journal. When set, files verified in an earlier run are not re-hashed, and partial downloads
+        /// survive crashes and cancellation and are resumed by the next run.
+        /// </param>
+        /// <param name="locks">
+        /// Optional cross-process lock manager. When set, downloads of the same file by several launcher processes
+        /// sharing the data directory are serialized, and the waiting process reuses the finished file.
+        /// </param>
+        /// <param name="durability">How completed downloads are synced to disk; see <see cref="DurabilityMode"/>.</param>
+        /// <param name="peerCache">
+        /// Optional LAN peer cache. When set, files with a known SHA1 are first requested from launchers on the local
+        /// network and only downloaded upstream if no peer has a good copy.
+        /// </param>
+        public DownloadScheduler(
+            HttpManager httpManager,
+            int maxConcurrency = 0,
+            BandwidthLimiter bandwidthLimiter = null,
+            InstallJournal journal = null,
+            FileLockManager locks = null,
+            DurabilityMode durability = DurabilityMode.Fast,
+            PeerCache peerCache = null)
+        {
+            _httpManager = httpManager ?? throw new ArgumentNullException(nameof(httpManager));
+            _maxConcurrency = maxConcurrency > 0 ? maxConcurrency : Environment.ProcessorCount;
+            _bandwidthLimiter = bandwidthLimiter;
+            _journal = journal;
+            _locks = locks;
+            _committer = new DurableCommitter(durability);
+            _peerCache = peerCache;
+            _logger = Log.ForContext<DownloadScheduler>();
+            _logger.Verbose("DownloadScheduler initialized with max concurrency {MaxConcurrency}, bandwidth limit {BytesPerSecond} B/s, durability {Durability}.",
+                _maxConcurrency, bandwidthLimiter?.BytesPerSecond.ToString() ?? "none", durability);
+        }
+
+        /// <summary>
+        /// Ensures every item in the set is present and verified. Items sharing a <see cref="InstallWorkItem.Key"/>
+        /// are processed once.
+        /// </summary>
+        /// <param name="items">The work items to process.</param>
+        /// <param name="onItemCompleted">Optional callback invoked after each item (item, success).</param>
+        /// <param name="installProgress">Optional install progress that downloaded bytes are counted into as they arrive.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>A summary of the run. Check <see cref="DownloadRunSummary.Failed"/> for failures.</returns>
+        public async Task<DownloadRunSummary> RunAsync(
+            IEnumerable<InstallWorkItem> items,
+            Action<InstallWorkItem, bool> onItemCompleted = null,
+            InstallProgress installProgress = null,
+            CancellationToken cancellationToken = default)
+        {
+            using Activity activity = LauncherTracing.Start("download.run");
+            var uniqueItems = Deduplicate(items);
+            var summary = new DownloadRunSummary { TotalItems = uniqueItems.Count };
+            var stopwatch = Stopwatch.StartNew();
+
+            _logger.Information("Scheduling {Count} unique work items with concurrency {MaxConcurrency}.", uniqueItems.Count, _maxConcurrency);
+
+            List<InstallWorkItem> pendingItems = await VerifyExistingInBulkAsync(uniqueItems, summary, onItemCompleted, cancellationToken).ConfigureAwait(false);
+
+            using var throttler = new SemaphoreSlim(_maxConcurrency);
+            var tasks = new List<Task>(pendingItems.Count);
+            foreach (var item in pendingItems)
+            {
+                await throttler.WaitAsync(cancellationToken).ConfigureAwait(false);
+                tasks.Add(Task.Run(async () =>
+                {
+                    var outcome = EnsureFileOutcome.Failed;
+                    try
+                    {
+                        outcome = await EnsureFileCoreAsync(item, installProgress, cancellationToken).ConfigureAwait(false);
+                    }
+                    catch (Exception ex) when (ex is not OperationCanceledException)
+                    {
+                        _logger.Error(ex, "Unexpected error while processing {Item}.", item);
+                    }
+                    finally
+                    {
+                        throttler.Release();
+                    }
+                    summary.Record(item, outcome);
+                    onItemCompleted?.Invoke(item, outcome != EnsureFileOutcome.Failed);
+                }, cancellationToken));
+            }
+
+            await Task.WhenAll(tasks).ConfigureAwait(false);
+            FlushCommitted();
+            stopwatch.Stop();
+            summary.Elapsed = stopwatch.Elapsed;
+            activity?.SetTag("items", summary.TotalItems);
+            activity?.SetTag("downloaded", summary.Downloaded);
+            activity?.SetTag("already_valid", summary.AlreadyValid);
+            activity?.SetTag("failed", summary.Failed);
+            activity?.SetTag("bytes", summary.BytesDownloaded);
+
+            _logger.Information("Scheduler run finished: {Succeeded}/{Total} ok ({Downloaded} downloaded, {AlreadyValid} already valid, {Failed} failed) in {Elapsed:F1}s.",
+                summary.Succeeded, summary.TotalItems, summary.Downloaded, summary.AlreadyValid, summary.Failed, summary.Elapsed.TotalSeconds);
+            return summary;
+        }
+
+        /// <summary>
+        /// Hashes the items that are already on disk with the right size (and not vouched for by the journal) in one
+        /// <see cref="CryptoUtils.VerifyFilesAsync"/> pass, which is much cheaper per file than one async hash per item.
+        /// Valid files are recorded as done; everything else is returned for the regular per-item path.
+        /// </summary>
+        private async Task<List<InstallWorkItem>> VerifyExistingInBulkAsync(
+            List<InstallWorkItem> items,
+            DownloadRunSummary summary,
+            Action<InstallWorkItem, bool> onItemCompleted,
+            CancellationToken cancellationToken)
+        {
+            var requests = new List<FileVerificationRequest>();
+            foreach (var item in items)
+            {
+                if (string.IsNullOrEmpty(item.Sha1)) continue;
+                var fileInfo = new FileInfo(item.LocalPath);
+                if (!fileInfo.Exists || (item.Size.HasValue && fileInfo.Length != (long)item.Size.Value)) continue;
+                if (_journal != null && _journal.IsVerified(item, fileInfo)) continue;
+                if (_journal != null) RecordJournalLookup(false);
+                requests.Add(new FileVerificationRequest(item.LocalPath, (long?)item.Size, item.Sha1) { Tag = item });
+            }
+            if (requests.Count < BulkVerifyThreshold) return items;
+
+            var stopwatch = Stopwatch.StartNew();
+            FileVerificationResult[] results = await CryptoUtils.VerifyFilesAsync(requests, cancellationToken: cancellationToken).ConfigureAwait(false);
+            var done = new HashSet<InstallWorkItem>();
+            long bytes = 0;
+            foreach (var result in results)
+            {
+                if (!result.IsValid) continue;
+                var item = (InstallWorkItem)result.Request.Tag;
+                _journal?.RecordVerified(item);
+                RecordCacheLookup(item, true);
+                summary.Record(item, EnsureFileOutcome.AlreadyValid);
+                onItemCompleted?.Invoke(item, true);
+                done.Add(item);
+                bytes += result.ActualSize;
+            }
+            _logger.Information("Bulk-verified {Valid}/{Checked} existing files ({Megabytes:F1} MB) in {Elapsed:F2}s; {Remaining} item(s) left to process.",
+                done.Count, requests.Count, bytes / (1024.0 * 1024.0), stopwatch.Elapsed.TotalSeconds, items.Count - done.Count);
+            return done.Count == 0 ? items : items.Where(i => !done.Contains(i)).ToList();
+        }
+
+        /// <summary>
+        /// Removes duplicate work items (same target path), keeping the first occurrence.
+        /// If two items target the same path with different hashes the first one wins and a warning is logged.
+        /// </summary>
+        public List<InstallWorkItem> Deduplicate(IEnumerable<InstallWorkItem> items)
+        {
+            var byKey = new Dictionary<string, InstallWorkItem>(OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal);
+            var ordered = new List<InstallWorkItem>();
+            foreach (var item in items)
+            {
+                if (byKey.TryGetValue(item.Key, out var existing))
+                {
+                    if (!string.Equals(existing.Sha1, item.Sha1, StringComparison.OrdinalIgnoreCase))
+                    {
+                        _logger.Warning("Conflicting work items for {Path}: {ExistingSha1} vs {NewSha1}. Keeping the first.",
+                            item.LocalPath, existing.Sha1 ?? "N/A", item.Sha1 ?? "N/A");
+                    }
+                    continue;
+                }
+                byKey[item.Key] = item;
+                ordered.Add(item);
+            }
+            return ordered;
+        }
+
+        /// <summary>
+        /// Downloads a file if it doesn't exist or if its size or SHA1 hash doesn't match.
+        /// </summary>
+        /// <returns>True if the file is valid (exists and matches hash, or successfully downloaded and verified).</returns>
+        public async Task<bool> EnsureFileAsync(InstallWorkItem item, CancellationToken cancellationToken = default)
+        {
+            EnsureFileOutcome outcome = await EnsureFileCoreAsync(item, null, cancellationToken).ConfigureAwait(false);
+            FlushCommitted();
+            return outcome != EnsureFileOutcome.Failed;
+        }
+
+        private void FlushCommitted()
+        {
+            try
+            {
+                _committer.Flush();
+            }
+            catch (Exception ex)
+            {
+                // The files are in place; they just aren't journaled, so the next run re-verifies them.
+                _logger.Warning(ex, "Failed to sync downloaded files to disk.");
+            }
+        }
+
+        private async Task<EnsureFileOutcome> EnsureFileCoreAsync(InstallWorkItem item, InstallProgress installProgress, CancellationToken cancellationToken)
+        {
+            using Activity activity = LauncherTracing.Start("file.ensure");
+            activity?.SetTag("kind", item.Kind.ToString());
+            string fileDescription = item.Description ?? Path.GetFileName(item.LocalPath);
+            // Per-file events on this path are guarded so they cost nothing unless Verbose is enabled for this context.
+            if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Ensuring file: {Description} -> {LocalPath} from {Url}", fileDescription, item.LocalPath, item.Url);
+
+            EnsureFileOutcome? existing = await CheckExistingFileAsync(item, fileDescription, cancellationToken).ConfigureAwait(false);
+            activity?.SetTag("cache", existing == EnsureFileOutcome.AlreadyValid ? "hit" : "miss");
+            if (existing.HasValue)
+            {
+                RecordCacheLookup(item, existing == EnsureFileOutcome.AlreadyValid);
+                return existing.Value;
+            }
+
+            if (_locks == null)
+            {
+                RecordCacheLookup(item, false);
+                return await DownloadFileAsync(item, fileDescription, installProgress, cancellationToken).ConfigureAwait(false);
+            }
+
+            // Another launcher on the same data directory may be downloading this file right now. Wait for it and
+            // re-check afterwards: if it succeeded, its file is used instead of downloading the same bytes again.
+            using FileLease lease = await _locks.AcquireForFileAsync(item.LocalPath, cancellationToken).ConfigureAwait(false);
+            existing = await CheckExistingFileAsync(item, fileDescription, cancellationToken).ConfigureAwait(false);
+            if (existing == EnsureFileOutcome.AlreadyValid) activity?.SetTag("cache", "peer"); // Another launcher finished it meanwhile.
+            RecordCacheLookup(item, existing == EnsureFileOutcome.AlreadyValid);
+            if (existing.HasValue) return existing.Value;
+            return await DownloadFileAsync(item, fileDescription, installProgress, cancellationToken).ConfigureAwait(false);
+        }
+
+        private static void RecordCacheLookup(InstallWorkItem item, bool hit)
+        {
+            if (!LauncherMetrics.CacheLookups.Enabled) return;
+            LauncherMetrics.CacheLookups.Add(1, LauncherMetrics.Tag("kind", item.Kind.ToString()), LauncherMetrics.Tag("result", hit ? "hit" : "miss"));
+        }
+
+        private static void RecordJournalLookup(bool hit)
+        {
+            if (!LauncherMetrics.JournalLookups.Enabled) return;
+            LauncherMetrics.JournalLookups.Add(1, LauncherMetrics.Tag("result", hit ? "hit" : "miss"));
+        }
+
+        /// <summary>
+        /// Checks the file already at the item's path. Mismatched files are deleted.
+        /// </summary>
+        /// <returns>The outcome if no download is needed (or the check failed), null if the file must be downloaded.</returns>
+        private async Task<EnsureFileOutcome?> CheckExistingFileAsync(InstallWorkItem item, string fileDescription, CancellationToken cancellationToken)
+        {
+            string localPath = item.LocalPath;
+            FileInfo fileInfo = new FileInfo(localPath);
+            if (!fileInfo.Exists)
+            {
+                return null;
+            }
+
+            if (item.Size.HasValue && fileInfo.Length != (long)item.Size.Value)
+            {
+                _logger.Warning("File {Description} exists at {LocalPath} but size mismatch. Expected: {ExpectedSize}, Actual: {ActualSize}. Re-downloading.",
+                    fileDescription, localPath, item.Size.Value, fileInfo.Length);
+            }
+            else if (_journal != null && _journal.IsVerified(item, fileInfo))
+            {
+                RecordJournalLookup(true);
+                if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("File {LocalPath} unchanged since it was last verified (journal). No download needed.", localPath);
+                return EnsureFileOutcome.AlreadyValid;
+            }
+            else if (!string.IsNullOrEmpty(item.Sha1))
+            {
+                if (_journal != null) RecordJournalLookup(false);
+                if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Verifying SHA1 for existing file: {LocalPath}", localPath);
+                string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(localPath, cancellationToken);
+                if (cancellationToken.IsCancellationRequested) return EnsureFileOutcome.Failed;
+
+                if (actualSha1 != null && actualSha1.Equals(item.Sha1, StringComparison.OrdinalIgnoreCase))
+                {
+                    if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("SHA1 match for existing file: {LocalPath}. No download needed.", localPath);
+                    _journal?.RecordVerified(item);
+                    return EnsureFileOutcome.AlreadyValid;
+                }
+                _logger.Warning("SHA1 mismatch for existing file {Description} at {LocalPath}. Expected: {ExpectedSha1}, Actual: {ActualSha1}. Re-downloading.",
+                    fileDescription, localPath, item.Sha1, actualSha1 ?? "N/A");
+            }
+            else
+            {
+                // No SHA1 to verify, and size matches or not provided, assume it's fine.
+                _logger.Verbose("File {Description} exists and no SHA1 provided for verification, or size matches. Assuming valid: {LocalPath}", fileDescription, localPath);
+                return EnsureFileOutcome.AlreadyValid;
+            }
+
+            // If we reach here, it's because of size mismatch or SHA1 mismatch, so delete and re-download
+            try { fileInfo.Delete(); } catch (Exception ex) { _logger.Error(ex, "Failed to delete mismatched file {LocalPath} before re-download.", localPath); return EnsureFileOutcome.Failed; }
+            _journal?.RecordRemoved(item);
+            return null;
+        }
+
+        /// <summary>
+        /// Downloads into <c>&lt;path&gt;.part</c>, verifies it, then renames it into place, so the final path only ever
+        /// holds verified content. With a journal, a partial left by an interrupted run is resumed when the journal vouches
+        /// for it, and the partial is kept on cancellation or network failure so the next run can continue the transfer.
+        /// Without one, partials are of unknown origin and are discarded. With a peer cache, a file not already partly
+        /// downloaded is fetched from a LAN peer first; the bandwidth limit only applies to the upstream download.
+        /// </summary>
+        private async Task<EnsureFileOutcome> DownloadFileAsync(InstallWorkItem item, string fileDescription, InstallProgress installProgress, CancellationToken cancellationToken)
+        {
+            string localPath = item.LocalPath;
+            string partialPath = localPath + InstallJournal.PartialSuffix;
+            _logger.Verbose("Downloading {Description}: {Url} -> {LocalPath}", fileDescription, item.Url, localPath);
+
+            if (File.Exists(partialPath) && !(_journal?.CanResume(item) ?? false))
+            {
+                DeletePartialFile(partialPath, "Partial file not recorded in journal", fileDescription);
+            }
+
+            _journal?.RecordTransferStarted(item);
+            if (_peerCache != null && !string.IsNullOrEmpty(item.Sha1) && !File.Exists(partialPath) &&
+                await _peerCache.TryFetchAsync(item, partialPath, installProgress, cancellationToken).ConfigureAwait(false))
+            {
+                // The peer cache has already checked the size and SHA1.
+                return CommitDownload(item, fileDescription, partialPath);
+            }
+            if (cancellationToken.IsCancellationRequested) return EnsureFileOutcome.Failed;
+
+            var (response, _, resumedFrom) = await _httpManager.DownloadResumableAsync(item.Url, partialPath, _bandwidthLimiter, installProgress, cancellationToken).ConfigureAwait(false);
+            if (cancellationToken.IsCancellationRequested)
+            {
+                if (_journal == null) DeletePartialFile(partialPath, "Download Canceled", fileDescription);
+                else _logger.Verbose("Download of {Description} cancelled; partial file {PartialPath} kept for resume.", fileDescription, partialPath);
+                return EnsureFileOutcome.Failed;
+            }
+
+            if (!response.IsSuccessStatusCode)
+            {
+                _logger.Error("Failed to download {Description} from {Url}. Status: {StatusCode}. File: {LocalPath}",
+                    fileDescription, item.Url, response.StatusCode, localPath);
+                if (_journal == null) DeletePartialFile(partialPath, $"HTTP Error {response.StatusCode}", fileDescription);
+                return EnsureFileOutcome.Failed;
+            }
+
+            if (resumedFrom > 0)
+            {
+                _logger.Information("Resumed {Description} from byte {Offset}.", fileDescription, resumedFrom);
+            }
+
+            if (!string.IsNullOrEmpty(item.Sha1))
+            {
+                _logger.Verbose("Verifying SHA1 for downloaded file: {PartialPath}", partialPath);
+                string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(partialPath, cancellationToken);
+                if (cancellationToken.IsCancellationRequested) return EnsureFileOutcome.Failed;
+
+                if (actualSha1 == null || !actualSha1.Equals(item.Sha1, StringComparison.OrdinalIgnoreCase))
+                {
+                    _logger.Error("SHA1 mismatch after downloading {Description} to {LocalPath}. Expected: {ExpectedSha1}, Actual: {ActualSha1}",
+                        fileDescription, localPath, item.Sha1, actualSha1 ?? "N/A");
+                    DeletePartialFile(partialPath, "SHA1 Mismatch", fileDescription);
+                    _journal?.RecordRemoved(item);
+                    return EnsureFileOutcome.Failed;
+                }
+                _logger.Verbose("SHA1 verified for downloaded file: {PartialPath}", partialPath);
+            }
+
+            return CommitDownload(item, fileDescription, partialPath);
+        }
+
+        /// <summary>
+        /// Moves a verified partial file into place and records it in the journal once it is durable.
+        /// </summary>
+        private EnsureFileOutcome CommitDownload(InstallWorkItem item, string fileDescription, string partialPath)
+        {
+            string localPath = item.LocalPath;
+            // The journal may only vouch for the file once it is durable, so in batched mode the record is deferred
+            // until its fsync group has been flushed.
+            Action onDurable = null;
+            if (_journal != null)
+            {
+                if (string.IsNullOrEmpty(item.Sha1)) onDurable = () => _journal.RecordRemoved(item); // Nothing to vouch for; just close the in-flight record.
+                else onDurable = () => _journal.RecordVerified(item);
+            }
+
+            try
+            {
+                _committer.Commit(partialPath, localPath, onDurable);
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Failed to move downloaded {Description} from {PartialPath} into place at {LocalPath}.", fileDescription, partialPath, localPath);
+                return EnsureFileOutcome.Failed;
+            }
+            _logger.Verbose("Download complete for {Description}: {LocalPath}", fileDescription, localPath);
+            return EnsureFileOutcome.Downloaded;
+        }
+
+        private void DeletePartialFile(string filePath, string reason, string fileDescription)
+        {
+            if (File.Exists(filePath))
+            {
+                try
+                {
+                    File.Delete(filePath);
+                    _logger.Warning("Deleted file {Description} ({FilePath}) due to: {Reason}", fileDescription, filePath, reason);
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Failed to delete file {Description} ({FilePath}) after error ({Reason})", fileDescription, filePath, reason);
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// How a single work item was satisfied.
+    /// </summary>
+    public enum EnsureFileOutcome
+    {
+        AlreadyValid,
+        Downloaded,
+        Failed
+    }
+
+    /// <summary>
+    /// Aggregate statistics for one <see cref="DownloadScheduler.RunAsync"/> call.
+    /// </summary>
+    public class DownloadRunSummary
+    {
+        private int _alreadyValid;
+        private int _downloaded;
+        private int _failed;
+        private long _bytesDownloaded;
+        private long _bytesVerified;
+
+        public int TotalItems { get; set; }
+        public int AlreadyValid => _alreadyValid;
+        public int Downloaded => _downloaded;
+        public int Failed => _failed;
+        public int Succeeded => _alreadyValid + _downloaded;
+        public long BytesDownloaded => Interlocked.Read(ref _bytesDownloaded);
+        public long BytesVerified => Interlocked.Read(ref _bytesVerified);
+        public TimeSpan Elapsed { get; set; }
+
+        public double DownloadMegabytesPerSecond =>
+            Elapsed.TotalSeconds > 0 ? BytesDownloaded / (1024.0 * 1024.0) / Elapsed.TotalSeconds : 0;
+
+        public double ItemsPerSecond =>
+            Elapsed.TotalSeconds > 0 ? TotalItems / Elapsed.TotalSeconds : 0;
+
+        internal void Record(InstallWorkItem item, EnsureFileOutcome outcome)
+        {
+            long size = (long)(item.Size ?? 0);
+            switch (outcome)
+            {
+                case EnsureFileOutcome.AlreadyValid:
+                    Interlocked.Increment(ref _alreadyValid);
+                    Interlocked.Add(ref _bytesVerified, size);
+                    break;
+                case EnsureFileOutcome.Downloaded:
+                    Interlocked.Increment(ref _downloaded);
+                    Interlocked.Add(ref _bytesDownloaded, size > 0 ? size : SafeLength(item.LocalPath));
+                    break;
+                default:
+                    Interlocked.Increment(ref _failed);
+                    break;
+            }
+        }
+
+        private static long SafeLength(string path)
+        {
+            try { return new FileInfo(path).Length; } catch { return 0; }
+        }
+    }
+}
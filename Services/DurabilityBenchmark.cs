@@ -0,0 +1,164 @@
+﻿// Services/DurabilityBenchmark.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Result of writing one asset set under one <see cref="DurabilityMode"/>.
+    /// </summary>
+    public class DurabilityBenchmarkResult
+    {
+        public DurabilityMode Mode { get; set; }
+        public int Files { get; set; }
+        public long Bytes { get; set; }
+
+        /// <summary>
+        /// Time until every file was committed (and, for batched mode, the last group flushed).
+        /// </summary>
+        public TimeSpan Elapsed { get; set; }
+
+        /// <summary>
+        /// Time a system-wide <c>sync</c> took afterwards, i.e. the write-back the mode left for the OS.
+        /// </summary>
+        public TimeSpan Writeback { get; set; }
+
+        public long FileSyncs { get; set; }
+        public long DirectorySyncs { get; set; }
+
+        /// <summary>
+        /// Time spent inside fsync calls, summed over all writer threads (can exceed <see cref="Elapsed"/>).
+        /// </summary>
+        public TimeSpan SyncTime { get; set; }
+
+        public double FilesPerSecond => Elapsed.TotalSeconds > 0 ? Files / Elapsed.TotalSeconds : 0;
+        public double MegabytesPerSecond => Elapsed.TotalSeconds > 0 ? Bytes / (1024.0 * 1024.0) / Elapsed.TotalSeconds : 0;
+    }
+
+    /// <summary>
+    /// Measures the I/O cost of each <see cref="DurabilityMode"/> on a real asset index: every object of the index is
+    /// written (with its real size, random content) through the same temp-file and <see cref="DurableCommitter"/> path
+    /// the installer uses, at the scheduler's concurrency. Files go to a scratch directory inside the data directory,
+    /// so they land on the same file system as a real install, and are deleted afterwards.
+    /// </summary>
+    public class DurabilityBenchmark
+    {
+        private readonly LauncherConfig _config;
+        private readonly ILogger _logger;
+
+        public DurabilityBenchmark(LauncherConfig config)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _logger = Log.ForContext<DurabilityBenchmark>();
+            _logger.Verbose("DurabilityBenchmark initialized.");
+        }
+
+        /// <summary>
+        /// Writes the asset set once per mode (fast, batched, strict) and logs a comparison.
+        /// </summary>
+        /// <param name="assetItems">Asset work items from <see cref="AssetManager.CollectAssetWorkItemsAsync"/>.</param>
+        /// <param name="maxFiles">Limits the run to the first N objects; 0 writes all of them.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public List<DurabilityBenchmarkResult> Run(IReadOnlyList<InstallWorkItem> assetItems, int maxFiles = 0, CancellationToken cancellationToken = default)
+        {
+            if (assetItems == null) throw new ArgumentNullException(nameof(assetItems));
+            List<InstallWorkItem> objects = assetItems
+                .Where(i => !string.IsNullOrEmpty(i.Sha1) && i.Size.HasValue)
+                .GroupBy(i => i.Sha1, StringComparer.OrdinalIgnoreCase)
+                .Select(g => g.First())
+                .Take(maxFiles > 0 ? maxFiles : int.MaxValue)
+                .ToList();
+            if (objects.Count == 0)
+            {
+                _logger.Warning("Durability benchmark: the asset index has no objects to write.");
+                return new List<DurabilityBenchmarkResult>();
+            }
+
+            // One random buffer sized for the largest object; every file writes a prefix of it.
+            var content = new byte[objects.Max(o => (long)o.Size.Value)];
+            new Random(1234).NextBytes(content);
+
+            _logger.Information("Durability benchmark: {Count} asset objects, {Mb:F1} MB, concurrency {Concurrency}.",
+                objects.Count, objects.Sum(o => (long)o.Size.Value) / (1024.0 * 1024.0), Environment.ProcessorCount);
+
+            var results = new List<DurabilityBenchmarkResult>();
+            foreach (DurabilityMode mode in new[] { DurabilityMode.Fast, DurabilityMode.Batched, DurabilityMode.Strict })
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                results.Add(RunMode(mode, objects, content, cancellationToken));
+            }
+
+            _logger.Information("{Mode,-8} {Files,8} {Seconds,10} {FilesPerSec,10} {MBps,8} {FileSyncs,9} {DirSyncs,8} {SyncSec,9} {WritebackSec,11}",
+                "mode", "files", "elapsed s", "files/s", "MB/s", "fsyncs", "dirsyncs", "fsync s", "writeback s");
+            foreach (var r in results)
+            {
+                _logger.Information("{Mode,-8} {Files,8} {Seconds,10:F2} {FilesPerSec,10:F0} {MBps,8:F1} {FileSyncs,9} {DirSyncs,8} {SyncSec,9:F2} {WritebackSec,11:F2}",
+                    r.Mode.ToString().ToLowerInvariant(), r.Files, r.Elapsed.TotalSeconds, r.FilesPerSecond, r.MegabytesPerSecond,
+                    r.FileSyncs, r.DirectorySyncs, r.SyncTime.TotalSeconds, r.Writeback.TotalSeconds);
+            }
+            return results;
+        }
+
+        private DurabilityBenchmarkResult RunMode(DurabilityMode mode, List<InstallWorkItem> objects, byte[] content, CancellationToken cancellationToken)
+        {
+            string root = Path.Combine(_config.BaseDataPath, "_bench", $"durability-{mode.ToString().ToLowerInvariant()}");
+            if (Directory.Exists(root)) Directory.Delete(root, true);
+            Directory.CreateDirectory(root);
+
+            // Start each mode with no dirty pages left over from the previous one.
+            FileSync.SyncAll();
+
+            var committer = new DurableCommitter(mode);
+            var stopwatch = Stopwatch.StartNew();
+            Parallel.ForEach(objects, new ParallelOptions { MaxDegreeOfParallelism = Environment.ProcessorCount, CancellationToken = cancellationToken }, item =>
+            {
+                string finalPath = Path.Combine(root, item.Sha1.Substring(0, 2), item.Sha1);
+                Directory.CreateDirectory(Path.GetDirectoryName(finalPath));
+                string tempPath = AtomicFile.CreateTempPath(finalPath);
+                using (var stream = new FileStream(tempPath, FileMode.CreateNew, FileAccess.Write, FileShare.None))
+                {
+                    stream.Write(content, 0, (int)item.Size.Value);
+                }
+                committer.Commit(tempPath, finalPath);
+            });
+            committer.Flush();
+            stopwatch.Stop();
+
+            var writeback = Stopwatch.StartNew();
+            FileSync.SyncAll();
+            writeback.Stop();
+
+            var result = new DurabilityBenchmarkResult
+            {
+                Mode = mode,
+                Files = objects.Count,
+                Bytes = objects.Sum(o => (long)o.Size.Value),
+                Elapsed = stopwatch.Elapsed,
+                Writeback = writeback.Elapsed,
+                FileSyncs = committer.FileSyncs,
+                DirectorySyncs = committer.DirectorySyncs,
+                SyncTime = committer.SyncTime
+            };
+            _logger.Information("Durability benchmark: {Mode} wrote {Files} files in {Elapsed:F2}s.", mode, result.Files, result.Elapsed.TotalSeconds);
+
+            try
+            {
+                Directory.Delete(root, true);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Could not delete benchmark directory {Root}.", root);
+            }
+            return result;
+        }
+    }
+}
@@ -0,0 +1,244 @@
+﻿// Services/FileLockManager.cs
+using System;
+using System.Collections.Concurrent;
+using System.IO;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Cross-process locks for a shared data directory. Each lock is a file under <c>&lt;data&gt;/locks</c> held open
+    /// with <see cref="FileShare.None"/>, which the OS turns into an exclusive lock (a <c>flock</c> on Unix, a sharing
+    /// violation on Windows). The OS drops the lock when the holder exits or crashes, so a lease can never outlive its
+    /// process. Holders of named locks record their pid and purpose next to the lock so that waiters can report who they
+    /// wait for; the per-file download locks skip that, since they are taken once per file.
+    /// <para>
+    /// Inside one process, waiters for the same key queue on a semaphore rather than polling the file. Shared leases
+    /// (<see cref="AcquireSharedAsync"/>) skip the semaphore; the OS lock alone keeps them apart from exclusive holders.
+    /// </para>
+    /// </summary>
+    public class FileLockManager
+    {
+        // Per-file locks are hashed into a fixed number of lock files, so the locks directory stays small.
+        private const int FileLockBuckets = 1024;
+
+        private static readonly TimeSpan MinPollDelay = TimeSpan.FromMilliseconds(25);
+        private static readonly TimeSpan MaxPollDelay = TimeSpan.FromMilliseconds(500);
+
+        private readonly string _locksDir;
+        private readonly ILogger _logger;
+        private readonly ConcurrentDictionary<string, SemaphoreSlim> _localGates = new ConcurrentDictionary<string, SemaphoreSlim>(StringComparer.Ordinal);
+
+        public FileLockManager(LauncherConfig config)
+        {
+            if (config == null) throw new ArgumentNullException(nameof(config));
+            _locksDir = Path.Combine(config.BaseDataPath, "locks");
+            Directory.CreateDirectory(_locksDir);
+            _logger = Log.ForContext<FileLockManager>();
+            _logger.Verbose("FileLockManager initialized at {LocksDir}.", _locksDir);
+        }
+
+        /// <summary>
+        /// Tries to take the lock once without waiting.
+        /// </summary>
+        /// <returns>The lease, or null if another process (or another caller in this process) holds the lock.</returns>
+        public FileLease TryAcquire(string key, string purpose = null)
+        {
+            var gate = _localGates.GetOrAdd(key, _ => new SemaphoreSlim(1, 1));
+            if (!gate.Wait(0)) return null;
+
+            FileStream stream = TryOpenLockFile(key, purpose, recordHolder: true);
+            if (stream == null)
+            {
+                gate.Release();
+                return null;
+            }
+            return new FileLease(key, stream, gate);
+        }
+
+        /// <summary>
+        /// Takes the lock, waiting for other holders to release it.
+        /// </summary>
+        /// <param name="key">Lock name, e.g. <c>runtime-java-runtime-gamma_17</c>.</param>
+        /// <param name="purpose">Short description written into the lock file for diagnostics.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>The lease; dispose it to release the lock.</returns>
+        public Task<FileLease> AcquireAsync(string key, string purpose = null, CancellationToken cancellationToken = default)
+        {
+            return AcquireCoreAsync(key, purpose, recordHolder: true, cancellationToken);
+        }
+
+        /// <summary>
+        /// Takes the lock guarding writes to a single data file (e.g., a download target).
+        /// Keys are bucketed, so unrelated files occasionally share a lock; that only serializes them.
+        /// No holder information is written, so taking one costs a single file open.
+        /// </summary>
+        public Task<FileLease> AcquireForFileAsync(string filePath, CancellationToken cancellationToken = default)
+        {
+            return AcquireCoreAsync(GetFileLockKey(filePath), null, recordHolder: false, cancellationToken);
+        }
+
+        /// <summary>
+        /// Takes the lock in shared mode, waiting while someone holds it exclusively. Any number of shared holders, in
+        /// this process or others, can hold it together; exclusive takers (<see cref="TryAcquire"/>,
+        /// <see cref="AcquireAsync"/>) fail or wait until all of them are gone. Shared holders record no holder information.
+        /// </summary>
+        /// <returns>The lease; dispose it to release the lock.</returns>
+        public async Task<FileLease> AcquireSharedAsync(string key, CancellationToken cancellationToken = default)
+        {
+            FileStream stream = await WaitForLockFileAsync(key, () => TryOpenSharedLockFile(key), cancellationToken).ConfigureAwait(false);
+            return new FileLease(key, stream, null);
+        }
+
+        private async Task<FileLease> AcquireCoreAsync(string key, string purpose, bool recordHolder, CancellationToken cancellationToken)
+        {
+            var gate = _localGates.GetOrAdd(key, _ => new SemaphoreSlim(1, 1));
+            await gate.WaitAsync(cancellationToken).ConfigureAwait(false);
+
+            try
+            {
+                FileStream stream = await WaitForLockFileAsync(key, () => TryOpenLockFile(key, purpose, recordHolder), cancellationToken).ConfigureAwait(false);
+                return new FileLease(key, stream, gate);
+            }
+            catch
+            {
+                gate.Release();
+                throw;
+            }
+        }
+
+        private async Task<FileStream> WaitForLockFileAsync(string key, Func<FileStream> tryOpen, CancellationToken cancellationToken)
+        {
+            TimeSpan delay = MinPollDelay;
+            bool reported = false;
+            while (true)
+            {
+                FileStream stream = tryOpen();
+                if (stream != null)
+                {
+                    if (reported) _logger.Information("Acquired lock {Key} after waiting.", key);
+                    return stream;
+                }
+
+                if (!reported)
+                {
+                    _logger.Information("Waiting for lock {Key} held by another launcher ({Holder}).", key, ReadHolder(key) ?? "unknown holder");
+                    reported = true;
+                }
+                await Task.Delay(delay, cancellationToken).ConfigureAwait(false);
+                delay = TimeSpan.FromMilliseconds(Math.Min(delay.TotalMilliseconds * 2, MaxPollDelay.TotalMilliseconds));
+            }
+        }
+
+        /// <summary>
+        /// Returns the description the current holder wrote when it took the lock, or null if unknown.
+        /// It is kept in a sidecar <c>.owner</c> file because the lock file itself cannot be opened while locked.
+        /// </summary>
+        public string ReadHolder(string key)
+        {
+            try
+            {
+                string ownerPath = GetLockPath(key) + ".owner";
+                return File.Exists(ownerPath) ? File.ReadAllText(ownerPath).Trim() : null;
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                return null;
+            }
+        }
+
+        private FileStream TryOpenLockFile(string key, string purpose, bool recordHolder)
+        {
+            string lockPath = GetLockPath(key);
+            FileStream stream;
+            try
+            {
+                stream = new FileStream(lockPath, FileMode.OpenOrCreate, FileAccess.ReadWrite, FileShare.None);
+            }
+            catch (IOException)
+            {
+                return null; // Held by another process.
+            }
+            if (!recordHolder) return stream;
+
+            try
+            {
+                AtomicFile.WriteAllText(lockPath + ".owner",
+                    $"pid {Environment.ProcessId} on {Environment.MachineName} since {DateTime.UtcNow:O}{(purpose != null ? $" ({purpose})" : string.Empty)}");
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Verbose(ex, "Could not write holder information for {LockPath}", lockPath);
+            }
+            return stream;
+        }
+
+        // A read-only open that shares reading is a shared lock: flock(LOCK_SH) on Unix, and on Windows it conflicts
+        // only with the FileShare.None opens of exclusive holders.
+        private FileStream TryOpenSharedLockFile(string key)
+        {
+            try
+            {
+                return new FileStream(GetLockPath(key), FileMode.OpenOrCreate, FileAccess.Read, FileShare.Read);
+            }
+            catch (IOException)
+            {
+                return null; // Held exclusively.
+            }
+        }
+
+        private string GetLockPath(string key)
+        {
+            var sanitized = new StringBuilder(key.Length);
+            foreach (char c in key)
+            {
+                sanitized.Append(char.IsLetterOrDigit(c) || c == '-' || c == '_' || c == '.' ? c : '_');
+            }
+            return Path.Combine(_locksDir, sanitized + ".lock");
+        }
+
+        private static string GetFileLockKey(string filePath)
+        {
+            string fullPath = Path.GetFullPath(filePath);
+            if (OperatingSystem.IsWindows()) fullPath = fullPath.ToUpperInvariant();
+
+            // FNV-1a; string.GetHashCode is randomized per process and would not agree across launchers.
+            uint hash = 2166136261;
+            foreach (char c in fullPath)
+            {
+                hash = (hash ^ c) * 16777619;
+            }
+            return $"file-{hash % FileLockBuckets:x3}";
+        }
+    }
+
+    /// <summary>
+    /// A held <see cref="FileLockManager"/> lock. Disposing it releases the lock.
+    /// </summary>
+    public sealed class FileLease : IDisposable
+    {
+        private FileStream _stream;
+        private SemaphoreSlim _gate;
+
+        internal FileLease(string key, FileStream stream, SemaphoreSlim gate)
+        {
+            Key = key;
+            _stream = stream;
+            _gate = gate;
+        }
+
+        public string Key { get; }
+
+        public void Dispose()
+        {
+            var stream = Interlocked.Exchange(ref _stream, null);
+            if (stream == null) return;
+            stream.Dispose();
+            Interlocked.Exchange(ref _gate, null)?.Release();
+        }
+    }
+}
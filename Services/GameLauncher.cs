@@ -19,6 +19,7 @@ using System.Threading.Tasks;
 using Serilog;
 // Assuming LauncherConfig is in ObsidianLauncher namespace
 using ObsidianLauncher;
+using ObsidianLauncher.Utils;
 
 namespace ObsidianLauncher.Services
 {
@@ -42,6 +43,7 @@ namespace ObsidianLauncher.Services
         /// <param name="mainClass">The main class to execute (e.g., net.minecraft.client.main.Main).</param>
         /// <param name="gameArguments">List of arguments for the Minecraft game itself.</param>
         /// <param name="workingDirectory">The working directory for the Minecraft process.</param>
+        /// <param name="onStarted">Called as soon as the process has been started, before its output is read.</param>
         /// <param name="cancellationToken">Optional token to allow for early termination signal.</param>
         /// <returns>A Task representing the asynchronous operation. The task completes when the Minecraft process exits. Returns the exit code of the process.</returns>
         public async Task<int> LaunchAsync(
@@ -50,6 +52,7 @@ namespace ObsidianLauncher.Services
             string mainClass,
             List<string> gameArguments,
             string workingDirectory,
+            Action onStarted = null,
             CancellationToken cancellationToken = default)
         {
             if (string.IsNullOrWhiteSpace(javaExecutablePath) || !File.Exists(javaExecutablePath))
@@ -185,16 +188,20 @@ namespace ObsidianLauncher.Services
                 }
             };
 
+            long sessionStarted = 0;
             try
             {
                 _logger.Information("Starting Minecraft process (ID will be assigned by OS)...");
                 if (!process.Start())
                 {
                     _logger.Error("Failed to start Minecraft process. Process.Start() returned false.");
+                    RecordSession("failed", 0);
                     return -1; // Indicate failure to start
                 }
+                onStarted?.Invoke();
 
                 _logger.Information("Minecraft process successfully started with ID: {ProcessId}. Attaching output readers.", process.Id);
+                sessionStarted = Stopwatch.GetTimestamp();
 
                 process.BeginOutputReadLine();
                 process.BeginErrorReadLine();
@@ -208,6 +215,7 @@ namespace ObsidianLauncher.Services
                 // The most reliable way is that the events themselves handle all data.
 
                 _logger.Information("Minecraft process (ID: {ProcessId}) has exited with code: {ExitCode}", process.Id, process.ExitCode);
+                RecordSession(process.ExitCode == 0 ? "exited" : "crashed", sessionStarted);
                 return process.ExitCode;
             }
             catch (OperationCanceledException)
@@ -230,6 +238,7 @@ namespace ObsidianLauncher.Services
                         _logger.Error(killEx, "Exception while trying to kill Minecraft process (ID: {ProcessId}) after cancellation.", process.Id);
                     }
                 }
+                RecordSession("cancelled", sessionStarted);
                 return -100; // Specific exit code for cancellation
             }
             catch (Exception ex)
@@ -239,6 +248,7 @@ namespace ObsidianLauncher.Services
                 {
                     try { process.Kill(true); } catch { /* Best effort to kill */ }
                 }
+                RecordSession("failed", sessionStarted);
                 return -1; // General error code
             }
             finally
@@ -248,6 +258,13 @@ namespace ObsidianLauncher.Services
                 // If not using `using`, then `process.Dispose()` would be here.
             }
         }
+
+        // Counts the session by outcome; its length is only known once the process has started.
+        private static void RecordSession(string result, long startTimestamp)
+        {
+            LauncherMetrics.GameSessions.Add(1, LauncherMetrics.Tag("result", result));
+            if (startTimestamp != 0) LauncherMetrics.GameSessionDuration.Record(LauncherMetrics.SecondsSince(startTimestamp));
+        }
     }
 
     /// <summary>
@@ -1,16 +1,24 @@
 ﻿// Services/HttpManager.cs
 using System;
+using System.Diagnostics;
 using System.IO;
 using System.Net.Http;
 using System.Net.Http.Headers; // For User-Agent
 using System.Threading;
 using System.Threading.Tasks;
+using ObsidianLauncher.Utils;
 using Serilog;
 
 namespace ObsidianLauncher.Services
 {
     public class HttpManager : IDisposable
     {
+        /// <summary>
+        /// Downloads of at least this many bytes (with a known length) get their disk space preallocated.
+        /// Smaller files gain nothing from it and would only pay for the extra system call.
+        /// </summary>
+        public const long PreallocationThreshold = 1024 * 1024;
+
         // HttpClient is designed to be instantiated once and reused throughout the life of an application.
         // Instantiating an HttpClient class for every request will exhaust the number of sockets available under heavy loads.
         private static readonly HttpClient httpClient;
@@ -57,6 +65,11 @@ namespace ObsidianLauncher.Services
             CancellationToken cancellationToken = default)
         {
             _logger.Verbose("HTTP GET: {Url}", url);
+            using Activity activity = LauncherTracing.Start("http.get");
+            activity?.SetTag("url.host", LauncherTracing.GetHost(url));
+            long started = Stopwatch.GetTimestamp();
+            int statusCode = 0;
+            long bytesReceived = 0;
 
             // If CPR Parameters were used for GET, they'd typically be query strings.
             // The C++ version didn't show how it used cpr::Parameters in Get,
@@ -80,6 +93,10 @@ namespace ObsidianLauncher.Services
                 // However, the C++ version's Get(url, parameters) likely meant URL query parameters.
 
                 HttpResponseMessage response = await httpClient.GetAsync(url, cancellationToken).ConfigureAwait(false);
+                statusCode = (int)response.StatusCode;
+                bytesReceived = response.Content.Headers.ContentLength ?? 0;
+                activity?.SetTag("http.status_code", statusCode);
+                activity?.SetTag("bytes", bytesReceived);
 
                 _logger.Verbose("GET Response: {Url}, Status: {StatusCode}, IsSuccess: {IsSuccessStatusCode}",
                     url, response.StatusCode, response.IsSuccessStatusCode);
@@ -114,24 +131,35 @@ namespace ObsidianLauncher.Services
                     RequestMessage = new HttpRequestMessage(HttpMethod.Get, url)
                 };
             }
+            finally
+            {
+                RecordRequest(url, statusCode, started, bytesReceived);
+            }
         }
 
         /// <summary>
         /// Downloads a file from the specified URL to the given file path.
-        /// This method streams the content directly to the file.
+        /// The content is streamed into a temporary sibling file that is renamed over <paramref name="filePath"/> only once
+        /// complete, so readers never see a half-written file and a failed download leaves any existing file untouched.
         /// </summary>
         /// <param name="url">The URL to download from.</param>
         /// <param name="filePath">The local path where the file will be saved.</param>
         /// <param name="progress">Optional progress reporter (0.0 to 1.0).</param>
+        /// <param name="bandwidthLimiter">Optional rate limiter shared between downloads (used by background work).</param>
         /// <param name="cancellationToken">A token to cancel the operation.</param>
         /// <returns>A tuple containing the HttpResponseMessage and the final file path. The response might indicate failure.</returns>
         public async Task<(HttpResponseMessage Response, string FilePath)> DownloadAsync(
             string url,
             string filePath,
             IProgress<float> progress = null,
+            BandwidthLimiter bandwidthLimiter = null,
             CancellationToken cancellationToken = default)
         {
             _logger.Verbose("HTTP DOWNLOAD: {Url} -> {FilePath}", url, filePath);
+            string tempPath = AtomicFile.CreateTempPath(filePath);
+            long started = Stopwatch.GetTimestamp();
+            int statusCode = 0;
+            long bytesReceived = 0;
 
             try
             {
@@ -143,6 +171,8 @@ namespace ObsidianLauncher.Services
 
                 // Use GetAsync with HttpCompletionOption.ResponseHeadersRead to avoid loading the whole content into memory first.
                 using HttpResponseMessage response = await httpClient.GetAsync(url, HttpCompletionOption.ResponseHeadersRead, cancellationToken).ConfigureAwait(false);
+                statusCode = (int)response.StatusCode;
+                RecordTimeToFirstByte(url, started);
 
                 if (!response.IsSuccessStatusCode)
                 {
@@ -155,46 +185,256 @@ namespace ObsidianLauncher.Services
                 long? totalBytes = response.Content.Headers.ContentLength;
                 _logger.Verbose("Download started. Total size: {TotalBytes} bytes for {Url}", totalBytes?.ToString() ?? "Unknown", url);
 
-                using Stream contentStream = await response.Content.ReadAsStreamAsync(cancellationToken).ConfigureAwait(false);
-                using FileStream fileStream = new FileStream(filePath, FileMode.Create, FileAccess.Write, FileShare.None, 8192, true); // true for async
-
-                byte[] buffer = new byte[8192]; // Standard buffer size
-                long totalBytesRead = 0;
-                int bytesRead;
-
-                while ((bytesRead = await contentStream.ReadAsync(buffer, 0, buffer.Length, cancellationToken).ConfigureAwait(false)) > 0)
+                long totalBytesRead;
+                using (Stream contentStream = await response.Content.ReadAsStreamAsync(cancellationToken).ConfigureAwait(false))
+                using (FileStream fileStream = OpenDownloadFile(tempPath, FileMode.CreateNew, totalBytes))
                 {
-                    await fileStream.WriteAsync(buffer, 0, bytesRead, cancellationToken).ConfigureAwait(false);
-                    totalBytesRead += bytesRead;
-
-                    if (progress != null && totalBytes.HasValue && totalBytes.Value > 0)
-                    {
-                        progress.Report((float)totalBytesRead / totalBytes.Value);
-                    }
+                    totalBytesRead = await CopyToFileAsync(contentStream, fileStream, totalBytes, 0, progress, null, bandwidthLimiter, cancellationToken).ConfigureAwait(false);
                 }
-
-                await fileStream.FlushAsync(cancellationToken).ConfigureAwait(false); // Ensure all data is written
+                bytesReceived = totalBytesRead;
+                AtomicFile.Commit(tempPath, filePath);
                 _logger.Verbose("Download complete: {FilePath}, Bytes read: {TotalBytesRead}", filePath, totalBytesRead);
                 return (response, filePath);
             }
             catch (HttpRequestException ex)
             {
                 _logger.Error(ex, "HttpRequestException during download for {Url} to {FilePath}", url, filePath);
-                DeletePartialFile(filePath, "HttpRequestException");
+                DeletePartialFile(tempPath, "HttpRequestException");
                 return (new HttpResponseMessage(System.Net.HttpStatusCode.ServiceUnavailable) { ReasonPhrase = ex.Message }, filePath);
             }
             catch (TaskCanceledException ex) // Handles both timeout and explicit cancellation
             {
                 _logger.Warning(ex, "Download cancelled or timed out for {Url} to {FilePath}", url, filePath);
-                DeletePartialFile(filePath, "TaskCanceledException");
+                DeletePartialFile(tempPath, "TaskCanceledException");
                 return (new HttpResponseMessage(System.Net.HttpStatusCode.RequestTimeout) { ReasonPhrase = ex.Message }, filePath);
             }
             catch (Exception ex)
             {
                 _logger.Error(ex, "Unexpected error during download for {Url} to {FilePath}", url, filePath);
-                DeletePartialFile(filePath, "Unexpected Exception");
+                DeletePartialFile(tempPath, "Unexpected Exception");
                 return (new HttpResponseMessage(System.Net.HttpStatusCode.InternalServerError) { ReasonPhrase = ex.Message }, filePath);
             }
+            finally
+            {
+                RecordRequest(url, statusCode, started, bytesReceived);
+            }
+        }
+
+        /// <summary>
+        /// Downloads into a partial file, resuming it with an HTTP Range request if it already has content.
+        /// Unlike <see cref="DownloadAsync"/>, the partial file is kept when the transfer fails or is cancelled,
+        /// so a later call can continue where this one stopped. If the server ignores the range, the file is rewritten;
+        /// if it answers with a range that does not continue the file, the partial is discarded and the download restarted.
+        /// </summary>
+        /// <param name="url">The URL to download from.</param>
+        /// <param name="partialPath">The partial file to write (and resume).</param>
+        /// <param name="bandwidthLimiter">Optional rate limiter.</param>
+        /// <param name="installProgress">Optional install progress the received bytes are counted into.</param>
+        /// <param name="cancellationToken">A token to cancel the operation.</param>
+        /// <returns>The response, the partial file path and the offset the transfer resumed from (0 for a fresh download).</returns>
+        public async Task<(HttpResponseMessage Response, string FilePath, long ResumedFrom)> DownloadResumableAsync(
+            string url,
+            string partialPath,
+            BandwidthLimiter bandwidthLimiter = null,
+            InstallProgress installProgress = null,
+            CancellationToken cancellationToken = default)
+        {
+            long existingBytes = File.Exists(partialPath) ? new FileInfo(partialPath).Length : 0;
+            _logger.Verbose("HTTP DOWNLOAD (resumable): {Url} -> {FilePath} from offset {Offset}", url, partialPath, existingBytes);
+            using Activity activity = LauncherTracing.Start("http.download");
+            activity?.SetTag("url.host", LauncherTracing.GetHost(url));
+            long started = Stopwatch.GetTimestamp();
+            int statusCode = 0;
+            long bytesReceived = 0;
+
+            try
+            {
+                string directoryPath = Path.GetDirectoryName(partialPath);
+                if (!string.IsNullOrEmpty(directoryPath))
+                {
+                    Directory.CreateDirectory(directoryPath);
+                }
+
+                using var request = new HttpRequestMessage(HttpMethod.Get, url);
+                if (existingBytes > 0)
+                {
+                    request.Headers.Range = new RangeHeaderValue(existingBytes, null);
+                }
+
+                using HttpResponseMessage response = await httpClient.SendAsync(request, HttpCompletionOption.ResponseHeadersRead, cancellationToken).ConfigureAwait(false);
+                statusCode = (int)response.StatusCode;
+                RecordTimeToFirstByte(url, started);
+                activity?.SetTag("http.status_code", statusCode);
+                activity?.SetTag("ttfb_ms", Stopwatch.GetElapsedTime(started).TotalMilliseconds);
+
+                if (response.StatusCode == System.Net.HttpStatusCode.RequestedRangeNotSatisfiable && existingBytes > 0)
+                {
+                    // The partial is as long as (or longer than) the resource; we can't tell which, so start over.
+                    _logger.Warning("Server rejected resume range for {Url} at offset {Offset}; restarting download.", url, existingBytes);
+                    File.Delete(partialPath);
+                    activity?.SetTag("retries", 1);
+                    if (LauncherMetrics.HttpRetries.Enabled)
+                    {
+                        LauncherMetrics.HttpRetries.Add(1, LauncherMetrics.Tag("host", LauncherTracing.GetHost(url)), LauncherMetrics.Tag("reason", "range_restart"));
+                    }
+                    return await DownloadResumableAsync(url, partialPath, bandwidthLimiter, installProgress, cancellationToken).ConfigureAwait(false);
+                }
+
+                if (!response.IsSuccessStatusCode)
+                {
+                    _logger.Error("Download HTTP request failed for {Url}. Status: {StatusCode}. Reason: {ReasonPhrase}",
+                        url, response.StatusCode, response.ReasonPhrase);
+                    return (response, partialPath, 0);
+                }
+
+                bool partialContent = response.StatusCode == System.Net.HttpStatusCode.PartialContent;
+                ContentRangeHeaderValue range = response.Content.Headers.ContentRange;
+                bool resumed = existingBytes > 0 && partialContent && range?.From == existingBytes;
+                bool wholeResource = range?.From == 0 && range.Length.HasValue && range.To == range.Length - 1;
+                if (partialContent && !resumed && !(existingBytes == 0 && wholeResource))
+                {
+                    // A fragment that does not continue the partial file must never be written as the whole file.
+                    if (existingBytes == 0)
+                    {
+                        _logger.Error("Server answered a full download of {Url} with a fragment ({Range}).", url, range?.ToString());
+                        return (new HttpResponseMessage(System.Net.HttpStatusCode.BadGateway) { ReasonPhrase = "Unexpected partial content" }, partialPath, 0);
+                    }
+                    _logger.Warning("Server answered the resume of {Url} at offset {Offset} with range {Range}; restarting download.",
+                        url, existingBytes, range?.ToString());
+                    File.Delete(partialPath);
+                    activity?.SetTag("retries", 1);
+                    if (LauncherMetrics.HttpRetries.Enabled)
+                    {
+                        LauncherMetrics.HttpRetries.Add(1, LauncherMetrics.Tag("host", LauncherTracing.GetHost(url)), LauncherMetrics.Tag("reason", "range_mismatch"));
+                    }
+                    return await DownloadResumableAsync(url, partialPath, bandwidthLimiter, installProgress, cancellationToken).ConfigureAwait(false);
+                }
+
+                long offset = resumed ? existingBytes : 0;
+                if (existingBytes > 0 && !resumed)
+                {
+                    _logger.Verbose("Server did not honour the range for {Url}; rewriting {FilePath} from the start.", url, partialPath);
+                }
+
+                long? contentLength = response.Content.Headers.ContentLength;
+                long? totalBytes = contentLength.HasValue ? contentLength + offset : null;
+
+                using Stream contentStream = await response.Content.ReadAsStreamAsync(cancellationToken).ConfigureAwait(false);
+                using FileStream fileStream = OpenDownloadFile(partialPath, resumed ? FileMode.Append : FileMode.Create, resumed ? null : totalBytes);
+
+                long bytesWritten = await CopyToFileAsync(contentStream, fileStream, totalBytes, offset, null, installProgress, bandwidthLimiter, cancellationToken).ConfigureAwait(false);
+                bytesReceived = bytesWritten - offset;
+                activity?.SetTag("bytes", bytesReceived);
+                activity?.SetTag("resumed_from", offset);
+                _logger.Verbose("Download complete: {FilePath}, Bytes read: {BytesRead} (resumed from {Offset})", partialPath, bytesWritten - offset, offset);
+                return (response, partialPath, offset);
+            }
+            catch (HttpRequestException ex)
+            {
+                _logger.Error(ex, "HttpRequestException during download for {Url} to {FilePath}; partial file kept for resume.", url, partialPath);
+                return (new HttpResponseMessage(System.Net.HttpStatusCode.ServiceUnavailable) { ReasonPhrase = ex.Message }, partialPath, 0);
+            }
+            catch (TaskCanceledException ex) // Handles both timeout and explicit cancellation
+            {
+                _logger.Warning(ex, "Download cancelled or timed out for {Url} to {FilePath}; partial file kept for resume.", url, partialPath);
+                return (new HttpResponseMessage(System.Net.HttpStatusCode.RequestTimeout) { ReasonPhrase = ex.Message }, partialPath, 0);
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Unexpected error during download for {Url} to {FilePath}", url, partialPath);
+                return (new HttpResponseMessage(System.Net.HttpStatusCode.InternalServerError) { ReasonPhrase = ex.Message }, partialPath, 0);
+            }
+            finally
+            {
+                RecordRequest(url, statusCode, started, bytesReceived);
+            }
+        }
+
+        // Per-host request metrics; a status of 0 means no response arrived.
+        private static void RecordRequest(string url, int statusCode, long startTimestamp, long bytes)
+        {
+            if (!LauncherMetrics.HttpRequests.Enabled) return;
+            var host = LauncherMetrics.Tag("host", LauncherTracing.GetHost(url));
+            LauncherMetrics.HttpRequests.Add(1, host, LauncherMetrics.Tag("status", statusCode));
+            LauncherMetrics.HttpDuration.Record(LauncherMetrics.SecondsSince(startTimestamp), host);
+            if (bytes > 0) LauncherMetrics.HttpBytes.Add(bytes, host);
+        }
+
+        private static void RecordTimeToFirstByte(string url, long startTimestamp)
+        {
+            if (!LauncherMetrics.HttpTimeToFirstByte.Enabled) return;
+            LauncherMetrics.HttpTimeToFirstByte.Record(LauncherMetrics.SecondsSince(startTimestamp), LauncherMetrics.Tag("host", LauncherTracing.GetHost(url)));
+        }
+
+        /// <summary>
+        /// Opens a download target for asynchronous writing. When the final size is known and at least
+        /// <see cref="PreallocationThreshold"/>, the space is reserved up front (fallocate on Linux, an allocation-size hint
+        /// on Windows), which keeps large JARs and runtime archives contiguous and fails early when the disk is full.
+        /// The file length is not changed, so a partial file still reflects exactly what was written.
+        /// </summary>
+        internal static FileStream OpenDownloadFile(string path, FileMode mode, long? expectedBytes)
+        {
+            var options = new FileStreamOptions
+            {
+                Mode = mode,
+                Access = FileAccess.Write,
+                Share = FileShare.None,
+                BufferSize = 8192,
+                Options = FileOptions.Asynchronous
+            };
+            // Preallocation only applies when the file is created; appends to an existing partial keep its allocation.
+            if (mode != FileMode.Append && expectedBytes >= PreallocationThreshold)
+            {
+                options.PreallocationSize = expectedBytes.Value;
+            }
+            return new FileStream(path, options);
+        }
+
+        /// <summary>
+        /// Copies a response stream into a file, applying the optional rate limit and reporting progress.
+        /// With <paramref name="maxBytes"/>, the copy stops before the file would grow past it.
+        /// </summary>
+        /// <returns>
+        /// The total number of bytes in the file, counting <paramref name="initialBytes"/> already present; if the stream
+        /// had more than <paramref name="maxBytes"/>, a count above it (the rest of the stream is not read).
+        /// </returns>
+        internal static async Task<long> CopyToFileAsync(
+            Stream contentStream,
+            FileStream fileStream,
+            long? totalBytes,
+            long initialBytes,
+            IProgress<float> progress,
+            InstallProgress installProgress,
+            BandwidthLimiter bandwidthLimiter,
+            CancellationToken cancellationToken,
+            long? maxBytes = null)
+        {
+            byte[] buffer = new byte[8192]; // Standard buffer size
+            long totalBytesRead = initialBytes;
+            int bytesRead;
+
+            while ((bytesRead = await contentStream.ReadAsync(buffer, 0, buffer.Length, cancellationToken).ConfigureAwait(false)) > 0)
+            {
+                if (maxBytes.HasValue && totalBytesRead + bytesRead > maxBytes.Value)
+                {
+                    return totalBytesRead + bytesRead;
+                }
+                if (bandwidthLimiter != null)
+                {
+                    await bandwidthLimiter.WaitAsync(bytesRead, cancellationToken).ConfigureAwait(false);
+                }
+                await fileStream.WriteAsync(buffer, 0, bytesRead, cancellationToken).ConfigureAwait(false);
+                totalBytesRead += bytesRead;
+                installProgress?.AddBytes(bytesRead);
+
+                if (progress != null && totalBytes.HasValue && totalBytes.Value > 0)
+                {
+                    progress.Report((float)totalBytesRead / totalBytes.Value);
+                }
+            }
+
+            await fileStream.FlushAsync(cancellationToken).ConfigureAwait(false); // Ensure all data is written
+            return totalBytesRead;
         }
 
         private void DeletePartialFile(string filePath, string reasonForDeletion)
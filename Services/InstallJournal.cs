@@ -0,0 +1,490 @@
+﻿// Services/InstallJournal.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+using System.Text.Json;
+using System.Text.Json.Serialization;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Append-only journal of install work, kept at <c>&lt;data&gt;/install_journal.jsonl</c>.
+    /// It records files that were verified (path, SHA1, size and modification time) and transfers that are in flight,
+    /// so that a run interrupted by a crash or Ctrl+C can skip re-hashing finished files and resume partial downloads.
+    /// <para>
+    /// Each line is one JSON record. A torn last line (the process died mid-write) is ignored on load.
+    /// The file is compacted to its live state whenever it grows well beyond it, which bounds its size.
+    /// </para>
+    /// </summary>
+    public sealed class InstallJournal : IDisposable
+    {
+        public const string PartialSuffix = ".part";
+
+        // Sidecar file whose exclusive handle marks the process that owns the journal.
+        private const string LockSuffix = ".lock";
+
+        private const string OpVerified = "verified";
+        private const string OpBegin = "begin";
+        private const string OpRemoved = "removed";
+
+        // Compact once the journal holds this many more records than live entries (and at least this many overall).
+        private const int CompactionSlack = 4096;
+
+        // Buffered records are flushed to the OS after this many appends; losing them only costs some re-hashing.
+        private const int FlushEvery = 64;
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions
+        {
+            PropertyNameCaseInsensitive = true,
+            DefaultIgnoreCondition = JsonIgnoreCondition.WhenWritingDefault
+        };
+
+        private readonly object _lock = new object();
+        private readonly string _path;
+        private readonly ILogger _logger;
+        private readonly Dictionary<string, JournalRecord> _verified;
+        private readonly Dictionary<string, JournalRecord> _inFlight;
+        private StreamWriter _writer;
+        private FileStream _ownership;
+        private int _recordCount;
+        private int _unflushed;
+        private bool _disposed;
+
+        private InstallJournal(string path)
+        {
+            _path = path;
+            _logger = Log.ForContext<InstallJournal>();
+            var comparer = OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+            _verified = new Dictionary<string, JournalRecord>(comparer);
+            _inFlight = new Dictionary<string, JournalRecord>(comparer);
+        }
+
+        /// <summary>
+        /// Path of the journal file.
+        /// </summary>
+        public string FilePath => _path;
+
+        /// <summary>
+        /// Opens (or creates) the journal under the launcher's data directory and replays it.
+        /// </summary>
+        public static InstallJournal Open(LauncherConfig config)
+        {
+            if (config == null) throw new ArgumentNullException(nameof(config));
+            var journal = new InstallJournal(Path.Combine(config.BaseDataPath, "install_journal.jsonl"));
+            journal.Load();
+            return journal;
+        }
+
+        /// <summary>
+        /// Number of files currently recorded as verified.
+        /// </summary>
+        public int VerifiedCount { get { lock (_lock) return _verified.Count; } }
+
+        /// <summary>
+        /// Number of transfers that were started but never finished (e.g., interrupted by a crash).
+        /// </summary>
+        public int InFlightCount { get { lock (_lock) return _inFlight.Count; } }
+
+        /// <summary>
+        /// Returns true if the file was verified against <paramref name="item"/>'s SHA1 and has not changed since
+        /// (same size and modification time), so hashing it again can be skipped.
+        /// </summary>
+        public bool IsVerified(InstallWorkItem item, FileInfo fileInfo)
+        {
+            if (string.IsNullOrEmpty(item.Sha1) || !fileInfo.Exists) return false;
+            lock (_lock)
+            {
+                return _verified.TryGetValue(item.Key, out var record) &&
+                       string.Equals(record.Sha1, item.Sha1, StringComparison.OrdinalIgnoreCase) &&
+                       record.Size == fileInfo.Length &&
+                       record.MtimeTicks == fileInfo.LastWriteTimeUtc.Ticks;
+            }
+        }
+
+        /// <summary>
+        /// Records that the file at the item's path was verified against its SHA1.
+        /// </summary>
+        public void RecordVerified(InstallWorkItem item)
+        {
+            if (string.IsNullOrEmpty(item.Sha1)) return;
+            var info = new FileInfo(item.LocalPath);
+            if (!info.Exists) return;
+
+            var record = new JournalRecord
+            {
+                Op = OpVerified,
+                Path = item.Key,
+                Sha1 = item.Sha1,
+                Size = info.Length,
+                MtimeTicks = info.LastWriteTimeUtc.Ticks
+            };
+            lock (_lock)
+            {
+                _inFlight.Remove(record.Path);
+                _verified[record.Path] = record;
+                Append(record);
+            }
+        }
+
+        /// <summary>
+        /// Records that a transfer of <paramref name="item"/> into its partial file has started.
+        /// </summary>
+        public void RecordTransferStarted(InstallWorkItem item)
+        {
+            var record = new JournalRecord { Op = OpBegin, Path = item.Key, Url = item.Url, Sha1 = item.Sha1 };
+            lock (_lock)
+            {
+                _verified.Remove(record.Path);
+                _inFlight[record.Path] = record;
+                Append(record);
+                Flush(); // In-flight records gate resumption, so don't leave them in the buffer.
+            }
+        }
+
+        /// <summary>
+        /// Forgets everything about a path (the file or its partial was deleted or failed verification).
+        /// </summary>
+        public void RecordRemoved(InstallWorkItem item)
+        {
+            lock (_lock)
+            {
+                bool known = _verified.Remove(item.Key) | _inFlight.Remove(item.Key);
+                if (known) Append(new JournalRecord { Op = OpRemoved, Path = item.Key });
+            }
+        }
+
+        /// <summary>
+        /// Drops the verified records of files changed outside the launcher, so the next check hashes them again even if
+        /// their size and modification time look unchanged.
+        /// </summary>
+        /// <param name="files">Full paths of changed files.</param>
+        /// <param name="trees">Full paths of renamed or deleted entries that may be directories; every record under them is dropped as well.</param>
+        /// <returns>Number of records dropped.</returns>
+        public int MarkDirty(IReadOnlyCollection<string> files, IReadOnlyCollection<string> trees)
+        {
+            lock (_lock)
+            {
+                var dirty = new List<string>();
+                foreach (string path in files)
+                {
+                    if (_verified.ContainsKey(path)) dirty.Add(path);
+                }
+                if (trees.Count > 0)
+                {
+                    var roots = new HashSet<string>(trees, _verified.Comparer);
+                    foreach (string path in _verified.Keys)
+                    {
+                        for (string current = path; !string.IsNullOrEmpty(current); current = Path.GetDirectoryName(current))
+                        {
+                            if (!roots.Contains(current)) continue;
+                            dirty.Add(path);
+                            break;
+                        }
+                    }
+                }
+
+                int dropped = 0;
+                foreach (string path in dirty)
+                {
+                    if (!_verified.Remove(path)) continue;
+                    Append(new JournalRecord { Op = OpRemoved, Path = path });
+                    dropped++;
+                }
+                if (dropped > 0) Flush();
+                return dropped;
+            }
+        }
+
+        /// <summary>
+        /// Drops the verified record of <paramref name="path"/> if the file is gone or its size or modification time no
+        /// longer match. Used to re-check records after file change notifications were lost.
+        /// </summary>
+        /// <returns>True if a record was dropped.</returns>
+        public bool MarkDirtyIfChanged(string path)
+        {
+            var info = new FileInfo(path);
+            lock (_lock)
+            {
+                if (!_verified.TryGetValue(path, out var record)) return false;
+                if (info.Exists && record.Size == info.Length && record.MtimeTicks == info.LastWriteTimeUtc.Ticks) return false;
+                _verified.Remove(path);
+                Append(new JournalRecord { Op = OpRemoved, Path = path });
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Paths of every file currently recorded as verified.
+        /// </summary>
+        public List<string> GetVerifiedPaths()
+        {
+            lock (_lock)
+            {
+                return new List<string>(_verified.Keys);
+            }
+        }
+
+        /// <summary>
+        /// SHA1 and path of every file currently recorded as verified.
+        /// </summary>
+        public List<(string Sha1, string Path)> GetVerifiedObjects()
+        {
+            lock (_lock)
+            {
+                var objects = new List<(string Sha1, string Path)>(_verified.Count);
+                foreach (var record in _verified.Values) objects.Add((record.Sha1, record.Path));
+                return objects;
+            }
+        }
+
+        /// <summary>
+        /// Returns true if a partial file for <paramref name="item"/> may be resumed: an interrupted transfer of the
+        /// same URL and SHA1 was recorded. Partial files without a matching record are of unknown origin.
+        /// </summary>
+        public bool CanResume(InstallWorkItem item)
+        {
+            lock (_lock)
+            {
+                return _inFlight.TryGetValue(item.Key, out var record) &&
+                       string.Equals(record.Url, item.Url, StringComparison.Ordinal) &&
+                       string.Equals(record.Sha1 ?? string.Empty, item.Sha1 ?? string.Empty, StringComparison.OrdinalIgnoreCase);
+            }
+        }
+
+        /// <summary>
+        /// Flushes buffered records to the operating system.
+        /// </summary>
+        public void Flush()
+        {
+            lock (_lock)
+            {
+                if (_writer == null) return;
+                try
+                {
+                    _writer.Flush();
+                    _unflushed = 0;
+                }
+                catch (Exception ex)
+                {
+                    _logger.Warning(ex, "Failed to flush install journal {Path}", _path);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Rewrites the journal with only its live records. Entries for files that no longer exist are dropped.
+        /// </summary>
+        public void Compact()
+        {
+            lock (_lock)
+            {
+                CompactCore();
+            }
+        }
+
+        public void Dispose()
+        {
+            lock (_lock)
+            {
+                if (_disposed) return;
+                _disposed = true;
+                try
+                {
+                    _writer?.Flush();
+                    _writer?.Dispose();
+                }
+                catch (Exception ex)
+                {
+                    _logger.Warning(ex, "Failed to close install journal {Path}", _path);
+                }
+                _writer = null;
+                _ownership?.Dispose();
+                _ownership = null;
+            }
+        }
+
+        private void Load()
+        {
+            // Ownership of the journal is a sidecar lock file held exclusively for the life of the process, so it is not
+            // given up while compaction replaces the journal file itself. A second launcher on the same data directory
+            // runs without a journal rather than interleaving records with ours.
+            FileStream stream;
+            try
+            {
+                Directory.CreateDirectory(Path.GetDirectoryName(_path));
+                _ownership = new FileStream(_path + LockSuffix, FileMode.OpenOrCreate, FileAccess.ReadWrite, FileShare.None);
+                stream = new FileStream(_path, FileMode.OpenOrCreate, FileAccess.ReadWrite, FileShare.None);
+            }
+            catch (IOException ex)
+            {
+                _ownership?.Dispose();
+                _ownership = null;
+                _logger.Warning(ex, "Install journal {Path} is in use by another launcher process; this run will not be journaled.", _path);
+                return;
+            }
+
+            int malformed = 0;
+            try
+            {
+                using var reader = new StreamReader(stream, Encoding.UTF8, false, 4096, leaveOpen: true);
+                string line;
+                while ((line = reader.ReadLine()) != null)
+                {
+                    if (string.IsNullOrWhiteSpace(line)) continue;
+                    JournalRecord record;
+                    try
+                    {
+                        record = JsonSerializer.Deserialize<JournalRecord>(line, JsonOptions);
+                    }
+                    catch (JsonException)
+                    {
+                        malformed++; // Torn write from a crash; everything before it is intact.
+                        continue;
+                    }
+                    if (record?.Path == null) continue;
+                    _recordCount++;
+                    Apply(record);
+                }
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to read install journal {Path}; starting with an empty journal.", _path);
+                _verified.Clear();
+                _inFlight.Clear();
+                malformed++;
+            }
+
+            _logger.Information("Install journal loaded: {Verified} verified file(s), {InFlight} interrupted transfer(s){Malformed}.",
+                _verified.Count, _inFlight.Count, malformed > 0 ? $", {malformed} torn record(s) ignored" : string.Empty);
+
+            if (malformed > 0 || NeedsCompaction())
+            {
+                stream.Dispose();
+                CompactCore();
+            }
+            else
+            {
+                stream.Seek(0, SeekOrigin.End);
+                _writer = new StreamWriter(stream, new UTF8Encoding(false));
+            }
+        }
+
+        private void Apply(JournalRecord record)
+        {
+            switch (record.Op)
+            {
+                case OpVerified:
+                    _inFlight.Remove(record.Path);
+                    _verified[record.Path] = record;
+                    break;
+                case OpBegin:
+                    _verified.Remove(record.Path);
+                    _inFlight[record.Path] = record;
+                    break;
+                case OpRemoved:
+                    _verified.Remove(record.Path);
+                    _inFlight.Remove(record.Path);
+                    break;
+            }
+        }
+
+        private void Append(JournalRecord record)
+        {
+            if (_writer == null) return;
+            try
+            {
+                _writer.WriteLine(JsonSerializer.Serialize(record, JsonOptions));
+                _recordCount++;
+                if (++_unflushed >= FlushEvery)
+                {
+                    _writer.Flush();
+                    _unflushed = 0;
+                }
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to append to install journal {Path}", _path);
+                return;
+            }
+
+            if (NeedsCompaction())
+            {
+                CompactCore();
+            }
+        }
+
+        private bool NeedsCompaction() => _recordCount > _verified.Count + _inFlight.Count + CompactionSlack;
+
+        // The journal file is closed and replaced here; ownership stays with the sidecar lock throughout.
+        private void CompactCore()
+        {
+            _writer?.Dispose();
+            _writer = null;
+
+            // Drop entries whose files are gone; an in-flight entry stays while its partial file exists.
+            var deadVerified = new List<string>();
+            foreach (var pair in _verified)
+            {
+                if (!File.Exists(pair.Key)) deadVerified.Add(pair.Key);
+            }
+            foreach (string key in deadVerified) _verified.Remove(key);
+
+            var deadInFlight = new List<string>();
+            foreach (var pair in _inFlight)
+            {
+                if (!File.Exists(pair.Key + PartialSuffix)) deadInFlight.Add(pair.Key);
+            }
+            foreach (string key in deadInFlight) _inFlight.Remove(key);
+
+            string tempPath = AtomicFile.CreateTempPath(_path);
+            try
+            {
+                using (var writer = new StreamWriter(tempPath, false, new UTF8Encoding(false)))
+                {
+                    foreach (var record in _verified.Values) writer.WriteLine(JsonSerializer.Serialize(record, JsonOptions));
+                    foreach (var record in _inFlight.Values) writer.WriteLine(JsonSerializer.Serialize(record, JsonOptions));
+                }
+                AtomicFile.Commit(tempPath, _path);
+                _recordCount = _verified.Count + _inFlight.Count;
+                _logger.Verbose("Install journal compacted to {Count} record(s).", _recordCount);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to compact install journal {Path}; continuing to append to the old file.", _path);
+                AtomicFile.TryDeleteTemp(tempPath);
+            }
+
+            OpenWriter(FileMode.Append);
+        }
+
+        private void OpenWriter(FileMode mode)
+        {
+            try
+            {
+                Directory.CreateDirectory(Path.GetDirectoryName(_path));
+                var stream = new FileStream(_path, mode, FileAccess.Write, FileShare.None);
+                _writer = new StreamWriter(stream, new UTF8Encoding(false));
+                _unflushed = 0;
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Could not reopen install journal {Path} for writing; progress will not be journaled.", _path);
+                _writer = null;
+            }
+        }
+
+        private class JournalRecord
+        {
+            public string Op { get; set; }
+            public string Path { get; set; }
+            public string Url { get; set; }
+            public string Sha1 { get; set; }
+            public long Size { get; set; }
+            public long MtimeTicks { get; set; }
+        }
+    }
+}
@@ -0,0 +1,444 @@
+﻿// Services/InstallPlanner.cs
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Resolves a version end to end into an <see cref="InstallPlan"/> using only metadata and stat calls,
+    /// and executes such plans. The launch path always goes through a plan, so a dry run reports exactly
+    /// the work a real install would do.
+    /// </summary>
+    public class InstallPlanner
+    {
+        private readonly LauncherConfig _config;
+        private readonly AssetManager _assetManager;
+        private readonly LibraryManager _libraryManager;
+        private readonly JavaManager _javaManager;
+        private readonly DownloadScheduler _scheduler;
+        private readonly ThroughputHistory _throughputHistory;
+        private readonly ContentStore _contentStore;
+        private readonly InstallJournal _journal;
+        private readonly ILogger _logger;
+
+        public InstallPlanner(
+            LauncherConfig config,
+            AssetManager assetManager,
+            LibraryManager libraryManager,
+            JavaManager javaManager,
+            DownloadScheduler scheduler,
+            ThroughputHistory throughputHistory = null,
+            ContentStore contentStore = null,
+            InstallJournal journal = null)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _assetManager = assetManager ?? throw new ArgumentNullException(nameof(assetManager));
+            _libraryManager = libraryManager ?? throw new ArgumentNullException(nameof(libraryManager));
+            _javaManager = javaManager ?? throw new ArgumentNullException(nameof(javaManager));
+            _scheduler = scheduler ?? throw new ArgumentNullException(nameof(scheduler));
+            _throughputHistory = throughputHistory ?? new ThroughputHistory(config);
+            _contentStore = contentStore;
+            _journal = journal;
+            _logger = Log.ForContext<InstallPlanner>();
+            _logger.Verbose("InstallPlanner initialized.");
+        }
+
+        /// <summary>
+        /// Builds the install plan for a version. Nothing is downloaded except the asset index JSON,
+        /// which is metadata the plan cannot be computed without (it is cached after the first time).
+        /// </summary>
+        /// <returns>The plan, or null if the version's requirements could not be resolved.</returns>
+        public async Task<InstallPlan> CreatePlanAsync(MinecraftVersion mcVersion, CancellationToken cancellationToken = default)
+        {
+            if (mcVersion == null) throw new ArgumentNullException(nameof(mcVersion));
+            using Activity activity = LauncherTracing.Start("install.plan");
+            activity?.SetTag("version.id", mcVersion.Id);
+
+            string versionDir = Path.Combine(_config.VersionsDir, mcVersion.Id);
+            var plan = new InstallPlan
+            {
+                Version = mcVersion,
+                ClientJarPath = Path.Combine(versionDir, $"{mcVersion.Id}.jar"),
+                NativesDirectory = Path.Combine(versionDir, $"{mcVersion.Id}-natives"),
+                RequiredRuntime = mcVersion.JavaVersion,
+                InstalledRuntime = _javaManager.FindInstalledRuntime(mcVersion.JavaVersion)
+            };
+
+            var items = new List<InstallWorkItem>();
+
+            // Client JAR
+            if (mcVersion.Downloads != null && mcVersion.Downloads.TryGetValue("client", out DownloadDetails client))
+            {
+                plan.ClientJar = new InstallWorkItem
+                {
+                    Kind = InstallWorkKind.ClientJar,
+                    Url = client.Url,
+                    LocalPath = plan.ClientJarPath,
+                    Sha1 = client.Sha1,
+                    Size = client.Size,
+                    Description = $"Client JAR for {mcVersion.Id}"
+                };
+                items.Add(plan.ClientJar);
+            }
+            else
+            {
+                _logger.Error("No client JAR download information found for version {VersionId}.", mcVersion.Id);
+                return null;
+            }
+
+            // Libraries and natives
+            plan.Libraries = _libraryManager.ResolveLibraries(mcVersion);
+            items.AddRange(plan.Libraries.SelectMany(r => r.WorkItems));
+            plan.NativesToExtract.AddRange(plan.Libraries.Where(r => r.Native != null).Select(r => r.Native));
+
+            // Hold off store collection while the asset index is fetched and files are classified, so the plan does not
+            // count files a concurrent sweep is deleting. Refs are only published when the plan is executed.
+            using FileLease gcLease = _contentStore == null
+                ? null
+                : await _contentStore.AcquireCollectionLockAsync($"planning {mcVersion.Id}", cancellationToken).ConfigureAwait(false);
+
+            // Assets
+            List<InstallWorkItem> assetItems = await _assetManager.CollectAssetWorkItemsAsync(mcVersion, cancellationToken).ConfigureAwait(false);
+            if (assetItems == null)
+            {
+                _logger.Error("Could not resolve assets for version {VersionId}; cannot build an install plan.", mcVersion.Id);
+                return null;
+            }
+            items.AddRange(assetItems);
+
+            // Classify every unique file with a single stat.
+            foreach (var item in _scheduler.Deduplicate(items))
+            {
+                plan.Files.Add(Classify(item));
+            }
+
+            plan.EstimatedBytesPerSecond = _throughputHistory.GetRecentBytesPerSecond();
+            plan.AvailableDiskBytes = GetAvailableDiskBytes();
+            if (activity != null)
+            {
+                activity.SetTag("files", plan.Files.Count);
+                activity.SetTag("download_files", plan.DownloadCount);
+                activity.SetTag("download_bytes", plan.DownloadBytes);
+            }
+            return plan;
+        }
+
+        /// <summary>
+        /// Executes a plan: ensures the Java runtime, runs every planned file through the scheduler, then builds
+        /// the library classpath and extracts natives.
+        /// </summary>
+        /// <param name="plan">A plan created by <see cref="CreatePlanAsync"/>.</param>
+        /// <param name="progress">Optional progress tracker; it is given the plan's totals and finished when this returns.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>The outcome. Check <see cref="InstallResult.Success"/>.</returns>
+        public async Task<InstallResult> ExecuteAsync(
+            InstallPlan plan,
+            InstallProgress progress = null,
+            CancellationToken cancellationToken = default)
+        {
+            if (plan == null) throw new ArgumentNullException(nameof(plan));
+            if (progress != null)
+            {
+                progress.EstimatedBytesPerSecond ??= plan.EstimatedBytesPerSecond;
+                progress.SetTotals(InstallPhase.Runtime, 0, 1); // Runtime archive sizes are only known once its download starts
+                progress.SetTotals(InstallPhase.Files, plan.DownloadBytes, plan.Files.Count);
+                progress.SetTotals(InstallPhase.Libraries, 0, plan.Version.Libraries?.Count ?? 0);
+            }
+            try
+            {
+                return await ExecuteCoreAsync(plan, progress, cancellationToken).ConfigureAwait(false);
+            }
+            finally
+            {
+                progress?.Finish();
+            }
+        }
+
+        private async Task<InstallResult> ExecuteCoreAsync(InstallPlan plan, InstallProgress progress, CancellationToken cancellationToken)
+        {
+            using Activity activity = LauncherTracing.Start("install.execute");
+            activity?.SetTag("version.id", plan.Version.Id);
+            var result = new InstallResult { Plan = plan };
+
+            // 0. Claim the plan's files before the scheduler checks them, so a store collection from now on keeps them.
+            //    One that ran since planning may have removed some; the scheduler re-checks every file and fetches those again.
+            if (_contentStore != null)
+            {
+                await _contentStore.RecordInstallAsync(plan, plan.InstalledRuntime, cancellationToken).ConfigureAwait(false);
+            }
+
+            // 1. Runtime
+            if (plan.RequiredRuntime == null)
+            {
+                _logger.Error("Version {VersionId} does not specify a Java runtime; cannot select one.", plan.Version.Id);
+                return result;
+            }
+            _logger.Information("--- Ensuring Java Runtime for Minecraft {VersionId} ---", plan.Version.Id);
+            progress?.BeginPhase(InstallPhase.Runtime);
+            result.Runtime = await _javaManager.EnsureJavaForMinecraftVersionAsync(plan.Version, cancellationToken).ConfigureAwait(false);
+            progress?.CompleteItem(InstallPhase.Runtime, result.Runtime != null);
+            progress?.CompletePhase(InstallPhase.Runtime, result.Runtime != null);
+            if (result.Runtime == null)
+            {
+                _logger.Error("Failed to obtain a suitable Java runtime for Minecraft version '{VersionId}'.", plan.Version.Id);
+                return result;
+            }
+            if (_contentStore != null && result.Runtime.HomePath != plan.InstalledRuntime?.HomePath)
+            {
+                await _contentStore.RecordInstallAsync(plan, result.Runtime, cancellationToken).ConfigureAwait(false);
+            }
+            cancellationToken.ThrowIfCancellationRequested();
+
+            // 2. Files
+            _logger.Information("--- Ensuring {Count} files for Minecraft {VersionId} ---", plan.Files.Count, plan.Version.Id);
+            progress?.BeginPhase(InstallPhase.Files);
+            var fileResults = new ConcurrentDictionary<string, bool>();
+            result.Summary = await _scheduler.RunAsync(
+                plan.Files.Select(f => f.Item),
+                (item, success) =>
+                {
+                    fileResults[item.Key] = success;
+                    progress?.CompleteItem(InstallPhase.Files, success);
+                },
+                progress,
+                cancellationToken).ConfigureAwait(false);
+            _throughputHistory.Record(result.Summary);
+            progress?.CompletePhase(InstallPhase.Files, result.Summary.Failed == 0);
+            cancellationToken.ThrowIfCancellationRequested();
+
+            if (!(fileResults.TryGetValue(plan.ClientJar.Key, out bool clientOk) && clientOk))
+            {
+                _logger.Error("Failed to download or verify client JAR for version {VersionId}.", plan.Version.Id);
+                return result;
+            }
+
+            // 3. Classpath and natives
+            _logger.Information("--- Processing Libraries for Minecraft {VersionId} ---", plan.Version.Id);
+            progress?.BeginPhase(InstallPhase.Libraries);
+            result.LibraryClasspath = _libraryManager.CompleteLibraries(
+                plan.Version, plan.Libraries, fileResults, plan.NativesDirectory, progress, cancellationToken);
+            progress?.CompletePhase(InstallPhase.Libraries, result.LibraryClasspath != null);
+            if (result.LibraryClasspath == null)
+            {
+                return result;
+            }
+
+            if (result.Summary.Failed > 0)
+            {
+                _logger.Error("{Failed} file(s) failed to download or verify for version {VersionId}.", result.Summary.Failed, plan.Version.Id);
+                return result;
+            }
+
+            result.Success = true;
+            return result;
+        }
+
+        /// <summary>
+        /// Writes a human readable report of the plan to the log.
+        /// </summary>
+        public void LogPlan(InstallPlan plan)
+        {
+            const double MB = 1024.0 * 1024.0;
+            _logger.Information("==================== Install plan: {VersionId} ====================", plan.Version.Id);
+            _logger.Information("Files:        {Total} unique; {Download} to download, {Verify} to re-verify, {Keep} kept as-is",
+                plan.Files.Count, plan.DownloadCount, plan.VerifyCount, plan.Files.Count - plan.DownloadCount - plan.VerifyCount);
+            foreach (var group in plan.Files.Where(f => f.Action == PlannedFileAction.Download).GroupBy(f => f.Item.Kind))
+            {
+                _logger.Information("  download {Kind}: {Count} file(s), {Megabytes:F1} MB", group.Key, group.Count(), group.Sum(f => f.ExpectedBytes) / MB);
+            }
+            _logger.Information("Download:     {Megabytes:F1} MB", plan.DownloadBytes / MB);
+            foreach (var origin in plan.DownloadBytesByOrigin.OrderByDescending(o => o.Value))
+            {
+                _logger.Information("  from {Origin}: {Megabytes:F1} MB", origin.Key, origin.Value / MB);
+            }
+            _logger.Information("Re-verify:    {Megabytes:F1} MB of existing files will be hashed", plan.VerifyBytes / MB);
+            _logger.Information("Natives:      {Count} JAR(s) to extract into {NativesDir}", plan.NativesToExtract.Count, plan.NativesDirectory);
+            foreach (var native in plan.NativesToExtract)
+            {
+                _logger.Information("  {Native}", native.Description);
+            }
+
+            if (plan.RequiredRuntime == null)
+            {
+                _logger.Information("Runtime:      none specified by the version");
+            }
+            else if (plan.RuntimeDownloadRequired)
+            {
+                _logger.Information("Runtime:      {Component} (Java {Major}) must be downloaded (size known only once the source is chosen)",
+                    plan.RequiredRuntime.Component, plan.RequiredRuntime.MajorVersion);
+            }
+            else
+            {
+                _logger.Information("Runtime:      {Component} (Java {Major}) already installed at {Home}",
+                    plan.RequiredRuntime.Component, plan.RequiredRuntime.MajorVersion, plan.InstalledRuntime.HomePath);
+            }
+
+            _logger.Information("Disk needed:  {Megabytes:F1} MB (excluding runtime){Available}",
+                plan.DiskBytesNeeded / MB,
+                plan.AvailableDiskBytes.HasValue ? $", {plan.AvailableDiskBytes.Value / MB:F0} MB available" : string.Empty);
+            if (plan.DownloadBytes == 0)
+            {
+                _logger.Information("Estimate:     nothing to download");
+            }
+            else if (plan.EstimatedDownloadTime.HasValue)
+            {
+                _logger.Information("Estimate:     ~{Seconds:F0}s of downloading at the recent {MBps:F2} MB/s",
+                    plan.EstimatedDownloadTime.Value.TotalSeconds, plan.EstimatedBytesPerSecond.Value / MB);
+            }
+            else
+            {
+                _logger.Information("Estimate:     unknown (no recent download throughput recorded yet)");
+            }
+            _logger.Information("==================================================================");
+        }
+
+        private PlannedFile Classify(InstallWorkItem item)
+        {
+            var planned = new PlannedFile { Item = item, ExpectedBytes = (long)(item.Size ?? 0) };
+            var info = new FileInfo(item.LocalPath);
+            if (!info.Exists)
+            {
+                planned.Action = PlannedFileAction.Download;
+                return planned;
+            }
+
+            planned.ExistingBytes = info.Length;
+            if (item.Size.HasValue && info.Length != (long)item.Size.Value)
+            {
+                planned.Action = PlannedFileAction.Download;
+            }
+            else if (string.IsNullOrEmpty(item.Sha1) || (_journal != null && _journal.IsVerified(item, info)))
+            {
+                // The scheduler skips files the journal vouches for, so the plan must not count them as hashing work.
+                planned.Action = PlannedFileAction.Keep;
+            }
+            else
+            {
+                planned.Action = PlannedFileAction.Verify;
+            }
+            return planned;
+        }
+
+        private long? GetAvailableDiskBytes()
+        {
+            try
+            {
+                string root = Path.GetPathRoot(Path.GetFullPath(_config.BaseDataPath));
+                return string.IsNullOrEmpty(root) ? null : new DriveInfo(root).AvailableFreeSpace;
+            }
+            catch (Exception ex)
+            {
+                _logger.Verbose(ex, "Could not query free disk space for {Path}.", _config.BaseDataPath);
+                return null;
+            }
+        }
+    }
+
+    /// <summary>
+    /// One file in an <see cref="InstallPlan"/> and what will be done with it.
+    /// </summary>
+    public class PlannedFile
+    {
+        public InstallWorkItem Item { get; set; }
+        public PlannedFileAction Action { get; set; }
+
+        /// <summary>
+        /// Size the file will have once installed (0 if the metadata gives none).
+        /// </summary>
+        public long ExpectedBytes { get; set; }
+
+        /// <summary>
+        /// Size of the file currently on disk (0 if absent).
+        /// </summary>
+        public long ExistingBytes { get; set; }
+    }
+
+    /// <summary>
+    /// The full, stat-based description of what installing a version will do. Created by
+    /// <see cref="InstallPlanner.CreatePlanAsync"/> and executed by <see cref="InstallPlanner.ExecuteAsync"/>.
+    /// </summary>
+    public class InstallPlan
+    {
+        public MinecraftVersion Version { get; set; }
+        public string ClientJarPath { get; set; }
+        public string NativesDirectory { get; set; }
+        public InstallWorkItem ClientJar { get; set; }
+
+        /// <summary>
+        /// Every unique file the version needs, classified.
+        /// </summary>
+        public List<PlannedFile> Files { get; } = new List<PlannedFile>();
+
+        /// <summary>
+        /// Native classifier JARs that will be extracted into <see cref="NativesDirectory"/>.
+        /// </summary>
+        public List<InstallWorkItem> NativesToExtract { get; } = new List<InstallWorkItem>();
+
+        public JavaVersionInfo RequiredRuntime { get; set; }
+
+        /// <summary>
+        /// The matching runtime already on disk, or null.
+        /// </summary>
+        public JavaRuntimeInfo InstalledRuntime { get; set; }
+
+        public bool RuntimeDownloadRequired => RequiredRuntime != null && InstalledRuntime == null;
+
+        /// <summary>
+        /// Recent download rate from <see cref="ThroughputHistory"/>, if any.
+        /// </summary>
+        public double? EstimatedBytesPerSecond { get; set; }
+
+        /// <summary>
+        /// Free space on the data drive at planning time, if it could be determined.
+        /// </summary>
+        public long? AvailableDiskBytes { get; set; }
+
+        internal List<ResolvedLibrary> Libraries { get; set; } = new List<ResolvedLibrary>();
+
+        public int DownloadCount => Files.Count(f => f.Action == PlannedFileAction.Download);
+        public int VerifyCount => Files.Count(f => f.Action == PlannedFileAction.Verify);
+        public long DownloadBytes => Files.Where(f => f.Action == PlannedFileAction.Download).Sum(f => f.ExpectedBytes);
+        public long VerifyBytes => Files.Where(f => f.Action == PlannedFileAction.Verify).Sum(f => f.ExpectedBytes);
+
+        /// <summary>
+        /// Net growth of the data directory: downloaded bytes minus the wrong-sized files they replace.
+        /// Files that fail re-verification are not included, since that cannot be known without hashing.
+        /// </summary>
+        public long DiskBytesNeeded => Math.Max(0, Files.Where(f => f.Action == PlannedFileAction.Download).Sum(f => f.ExpectedBytes - f.ExistingBytes));
+
+        /// <summary>
+        /// Download bytes grouped by URL host.
+        /// </summary>
+        public IReadOnlyDictionary<string, long> DownloadBytesByOrigin =>
+            Files.Where(f => f.Action == PlannedFileAction.Download)
+                 .GroupBy(f => Uri.TryCreate(f.Item.Url, UriKind.Absolute, out Uri uri) ? uri.Host : "(unknown)")
+                 .ToDictionary(g => g.Key, g => g.Sum(f => f.ExpectedBytes));
+
+        public TimeSpan? EstimatedDownloadTime =>
+            EstimatedBytesPerSecond.HasValue && EstimatedBytesPerSecond.Value > 0
+                ? TimeSpan.FromSeconds(DownloadBytes / EstimatedBytesPerSecond.Value)
+                : (DownloadBytes == 0 ? TimeSpan.Zero : null);
+    }
+
+    /// <summary>
+    /// The outcome of <see cref="InstallPlanner.ExecuteAsync"/>.
+    /// </summary>
+    public class InstallResult
+    {
+        public InstallPlan Plan { get; set; }
+        public bool Success { get; set; }
+        public JavaRuntimeInfo Runtime { get; set; }
+        public List<string> LibraryClasspath { get; set; }
+        public DownloadRunSummary Summary { get; set; }
+    }
+}
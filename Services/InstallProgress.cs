@@ -0,0 +1,376 @@
+﻿// Services/InstallProgress.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Runtime.CompilerServices;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Live progress of one install plan execution, across all of its <see cref="InstallPhase"/>s.
+    /// <para>
+    /// Workers update it with one or two interlocked operations per event: no allocation, no lock and no post to a
+    /// synchronization context, so it can be fed from every buffer of every concurrent download. Observers read it as
+    /// <see cref="InstallProgressSnapshot"/> values, on demand with <see cref="Sample"/> or at a fixed maximum rate
+    /// with <see cref="WatchAsync"/>. Rates and the ETA are only computed when sampling, so an unwatched run pays for
+    /// the counters alone.
+    /// </para>
+    /// </summary>
+    public sealed class InstallProgress : IProgress<LibraryProcessingProgress>
+    {
+        private const int PhaseCount = 3;
+        private const double RateSmoothing = 0.3; // Weight of the newest interval in the moving rate averages
+        private const double MinRateIntervalSeconds = 0.05;
+
+        private readonly long[] _bytesDone = new long[PhaseCount];
+        private readonly long[] _bytesTotal = new long[PhaseCount];
+        private readonly int[] _itemsDone = new int[PhaseCount];
+        private readonly int[] _itemsFailed = new int[PhaseCount];
+        private readonly int[] _itemsTotal = new int[PhaseCount];
+        private readonly int[] _states = new int[PhaseCount];
+        private readonly long[] _startedAt = new long[PhaseCount];
+        private readonly long[] _endedAt = new long[PhaseCount];
+        private readonly long _createdAt = Stopwatch.GetTimestamp();
+        private readonly CancellationTokenSource _finished = new CancellationTokenSource();
+        private int _currentPhase = -1;
+
+        private readonly object _sampleLock = new object();
+        private long _lastSampleAt;
+        private long _lastSampleBytes;
+        private int _lastSampleItems;
+        private double _bytesPerSecond;
+        private double _itemsPerSecond;
+        private bool _hasByteRate;
+        private bool _hasItemRate;
+
+        /// <summary>
+        /// Download rate assumed until one has been measured, typically <see cref="InstallPlan.EstimatedBytesPerSecond"/>.
+        /// Gives the first snapshots an ETA instead of none.
+        /// </summary>
+        public double? EstimatedBytesPerSecond { get; set; }
+
+        /// <summary>
+        /// True once <see cref="Finish"/> has been called.
+        /// </summary>
+        public bool IsFinished => _finished.IsCancellationRequested;
+
+        /// <summary>
+        /// Sets the work a phase is expected to do. Called for every phase before the first one starts, so that totals
+        /// (and the ETA) cover the whole run from the beginning.
+        /// </summary>
+        public void SetTotals(InstallPhase phase, long totalBytes, int totalItems)
+        {
+            int index = (int)phase;
+            Volatile.Write(ref _bytesTotal[index], Math.Max(0, totalBytes));
+            Volatile.Write(ref _itemsTotal[index], Math.Max(0, totalItems));
+        }
+
+        /// <summary>
+        /// Marks <paramref name="phase"/> as running; bytes added from now on are counted against it.
+        /// </summary>
+        public void BeginPhase(InstallPhase phase)
+        {
+            int index = (int)phase;
+            Volatile.Write(ref _startedAt[index], Stopwatch.GetTimestamp());
+            Volatile.Write(ref _states[index], (int)InstallPhaseState.Running);
+            Volatile.Write(ref _currentPhase, index);
+        }
+
+        public void CompletePhase(InstallPhase phase, bool success)
+        {
+            int index = (int)phase;
+            Volatile.Write(ref _endedAt[index], Stopwatch.GetTimestamp());
+            Volatile.Write(ref _states[index], (int)(success ? InstallPhaseState.Completed : InstallPhaseState.Failed));
+        }
+
+        /// <summary>
+        /// Counts bytes transferred by the running phase. Called by the download loops for every buffer written.
+        /// </summary>
+        public void AddBytes(long bytes)
+        {
+            int index = Volatile.Read(ref _currentPhase);
+            if (index >= 0 && bytes > 0) Interlocked.Add(ref _bytesDone[index], bytes);
+        }
+
+        /// <summary>
+        /// Counts one finished item (file, library) of <paramref name="phase"/>.
+        /// </summary>
+        public void CompleteItem(InstallPhase phase, bool success)
+        {
+            int index = (int)phase;
+            if (!success) Interlocked.Increment(ref _itemsFailed[index]);
+            Interlocked.Increment(ref _itemsDone[index]);
+        }
+
+        /// <summary>
+        /// Counts a processed library, so <see cref="LibraryManager.CompleteLibraries"/> can report straight into the
+        /// <see cref="InstallPhase.Libraries"/> phase.
+        /// </summary>
+        public void Report(LibraryProcessingProgress value)
+        {
+            if (value.Status == LibraryProcessingStatus.ExtractingNatives) return; // The library's final report follows
+            CompleteItem(InstallPhase.Libraries, value.Status != LibraryProcessingStatus.Failed);
+        }
+
+        /// <summary>
+        /// Ends the run. Phases still running are marked failed (the run was cancelled or bailed out), and watchers
+        /// deliver a final snapshot and complete.
+        /// </summary>
+        public void Finish()
+        {
+            for (int i = 0; i < PhaseCount; i++)
+            {
+                if (Volatile.Read(ref _states[i]) == (int)InstallPhaseState.Running) CompletePhase((InstallPhase)i, false);
+            }
+            _finished.Cancel();
+        }
+
+        /// <summary>
+        /// Reads the current progress and updates the moving rates.
+        /// </summary>
+        public InstallProgressSnapshot Sample()
+        {
+            bool finished = IsFinished; // Read first: everything recorded before Finish is then in this sample
+            long now = Stopwatch.GetTimestamp();
+            InstallPhaseProgress runtime = ReadPhase(0, now);
+            InstallPhaseProgress files = ReadPhase(1, now);
+            InstallPhaseProgress libraries = ReadPhase(2, now);
+            int current = Volatile.Read(ref _currentPhase);
+
+            long bytesDone = runtime.BytesDone + files.BytesDone + libraries.BytesDone;
+            long bytesRemaining = runtime.BytesRemaining + files.BytesRemaining + libraries.BytesRemaining;
+            int itemsDone = runtime.ItemsDone + files.ItemsDone + libraries.ItemsDone;
+
+            double bytesPerSecond;
+            double itemsPerSecond;
+            lock (_sampleLock)
+            {
+                if (_lastSampleAt == 0)
+                {
+                    _hasByteRate = EstimatedBytesPerSecond > 0;
+                    _bytesPerSecond = EstimatedBytesPerSecond ?? 0;
+                    _lastSampleAt = now;
+                    _lastSampleBytes = bytesDone;
+                    _lastSampleItems = itemsDone;
+                }
+                else
+                {
+                    double seconds = (now - _lastSampleAt) / (double)Stopwatch.Frequency;
+                    if (seconds >= MinRateIntervalSeconds)
+                    {
+                        // Phases that move no bytes (runtime selection, natives) would drag the download rate to zero,
+                        // so a rate only changes while there is still work of its kind left or some was just done.
+                        long newBytes = bytesDone - _lastSampleBytes;
+                        if (newBytes > 0 || (bytesRemaining > 0 && current == (int)InstallPhase.Files))
+                        {
+                            UpdateRate(ref _bytesPerSecond, ref _hasByteRate, newBytes / seconds);
+                        }
+                        int newItems = itemsDone - _lastSampleItems;
+                        if (newItems > 0 || current >= 0)
+                        {
+                            UpdateRate(ref _itemsPerSecond, ref _hasItemRate, newItems / seconds);
+                        }
+                        _lastSampleAt = now;
+                        _lastSampleBytes = bytesDone;
+                        _lastSampleItems = itemsDone;
+                    }
+                }
+                bytesPerSecond = _bytesPerSecond;
+                itemsPerSecond = _itemsPerSecond;
+            }
+
+            TimeSpan? eta;
+            if (finished || bytesRemaining == 0) eta = TimeSpan.Zero;
+            else if (bytesPerSecond > 0) eta = TimeSpan.FromSeconds(bytesRemaining / bytesPerSecond);
+            else eta = null;
+
+            return new InstallProgressSnapshot(
+                current >= 0 ? (InstallPhase?)current : null, runtime, files, libraries,
+                bytesPerSecond, itemsPerSecond, eta, ElapsedSince(_createdAt, now), finished);
+        }
+
+        /// <summary>
+        /// Publishes snapshots at most once per <paramref name="interval"/>, skipping ticks where nothing moved.
+        /// Completes after delivering the final snapshot once <see cref="Finish"/> is called, or when
+        /// <paramref name="cancellationToken"/> is cancelled.
+        /// </summary>
+        public async IAsyncEnumerable<InstallProgressSnapshot> WatchAsync(
+            TimeSpan interval,
+            [EnumeratorCancellation] CancellationToken cancellationToken = default)
+        {
+            if (interval <= TimeSpan.Zero) throw new ArgumentOutOfRangeException(nameof(interval));
+            using var wake = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken, _finished.Token);
+            using var timer = new PeriodicTimer(interval);
+            InstallProgressSnapshot previous = default;
+            bool first = true;
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                InstallProgressSnapshot snapshot = Sample();
+                if (first || snapshot.IsFinished || !SameProgress(snapshot, previous))
+                {
+                    first = false;
+                    previous = snapshot;
+                    yield return snapshot;
+                }
+                if (snapshot.IsFinished) yield break;
+                await WaitForTickAsync(timer, wake.Token).ConfigureAwait(false);
+            }
+        }
+
+        private static async Task WaitForTickAsync(PeriodicTimer timer, CancellationToken cancellationToken)
+        {
+            try
+            {
+                await timer.WaitForNextTickAsync(cancellationToken).ConfigureAwait(false);
+            }
+            catch (OperationCanceledException)
+            {
+                // Finished or cancelled; the caller's loop condition sorts out which.
+            }
+        }
+
+        private static bool SameProgress(in InstallProgressSnapshot a, in InstallProgressSnapshot b)
+        {
+            return a.CurrentPhase == b.CurrentPhase &&
+                   a.BytesDone == b.BytesDone &&
+                   a.ItemsDone == b.ItemsDone &&
+                   a.Runtime.State == b.Runtime.State &&
+                   a.Files.State == b.Files.State &&
+                   a.Libraries.State == b.Libraries.State;
+        }
+
+        private static void UpdateRate(ref double rate, ref bool hasRate, double measured)
+        {
+            rate = hasRate ? RateSmoothing * measured + (1 - RateSmoothing) * rate : measured;
+            hasRate = true;
+        }
+
+        private InstallPhaseProgress ReadPhase(int index, long now)
+        {
+            long started = Volatile.Read(ref _startedAt[index]);
+            long ended = Volatile.Read(ref _endedAt[index]);
+            TimeSpan elapsed = started == 0 ? TimeSpan.Zero : ElapsedSince(started, ended != 0 ? ended : now);
+            return new InstallPhaseProgress(
+                (InstallPhase)index,
+                (InstallPhaseState)Volatile.Read(ref _states[index]),
+                Interlocked.Read(ref _bytesDone[index]),
+                Volatile.Read(ref _bytesTotal[index]),
+                Volatile.Read(ref _itemsDone[index]),
+                Volatile.Read(ref _itemsFailed[index]),
+                Volatile.Read(ref _itemsTotal[index]),
+                elapsed);
+        }
+
+        private static TimeSpan ElapsedSince(long start, long end)
+        {
+            return TimeSpan.FromSeconds((end - start) / (double)Stopwatch.Frequency);
+        }
+    }
+
+    /// <summary>
+    /// Progress of one <see cref="InstallPhase"/> at the time of a snapshot.
+    /// </summary>
+    public readonly struct InstallPhaseProgress
+    {
+        public InstallPhaseProgress(InstallPhase phase, InstallPhaseState state, long bytesDone, long bytesTotal,
+            int itemsDone, int itemsFailed, int itemsTotal, TimeSpan elapsed)
+        {
+            Phase = phase;
+            State = state;
+            BytesDone = bytesDone;
+            BytesTotal = Math.Max(bytesTotal, bytesDone); // Re-downloads of files planned as "verify" add to the total
+            ItemsDone = itemsDone;
+            ItemsFailed = itemsFailed;
+            ItemsTotal = Math.Max(itemsTotal, itemsDone);
+            Elapsed = elapsed;
+        }
+
+        public InstallPhase Phase { get; }
+        public InstallPhaseState State { get; }
+        public long BytesDone { get; }
+        public long BytesTotal { get; }
+
+        /// <summary>
+        /// Finished items, failed ones included.
+        /// </summary>
+        public int ItemsDone { get; }
+        public int ItemsFailed { get; }
+        public int ItemsTotal { get; }
+        public TimeSpan Elapsed { get; }
+
+        /// <summary>
+        /// Bytes still expected; 0 once the phase has ended, whatever the plan expected.
+        /// </summary>
+        public long BytesRemaining => State == InstallPhaseState.Completed || State == InstallPhaseState.Failed ? 0 : BytesTotal - BytesDone;
+    }
+
+    /// <summary>
+    /// A point-in-time view of an <see cref="InstallProgress"/>. A value type, so sampling allocates nothing.
+    /// </summary>
+    public readonly struct InstallProgressSnapshot
+    {
+        public InstallProgressSnapshot(InstallPhase? currentPhase, InstallPhaseProgress runtime, InstallPhaseProgress files,
+            InstallPhaseProgress libraries, double bytesPerSecond, double itemsPerSecond, TimeSpan? eta, TimeSpan elapsed, bool isFinished)
+        {
+            CurrentPhase = currentPhase;
+            Runtime = runtime;
+            Files = files;
+            Libraries = libraries;
+            BytesPerSecond = bytesPerSecond;
+            ItemsPerSecond = itemsPerSecond;
+            Eta = eta;
+            Elapsed = elapsed;
+            IsFinished = isFinished;
+        }
+
+        /// <summary>
+        /// The phase started last, or null before the first one.
+        /// </summary>
+        public InstallPhase? CurrentPhase { get; }
+        public InstallPhaseProgress Runtime { get; }
+        public InstallPhaseProgress Files { get; }
+        public InstallPhaseProgress Libraries { get; }
+
+        /// <summary>
+        /// Moving average of the download rate (the plan's estimate until a rate has been measured).
+        /// </summary>
+        public double BytesPerSecond { get; }
+
+        /// <summary>
+        /// Moving average of finished items per second, all phases together.
+        /// </summary>
+        public double ItemsPerSecond { get; }
+
+        /// <summary>
+        /// Time left for the remaining bytes at <see cref="BytesPerSecond"/>; null while no rate is known.
+        /// Runtime selection and natives extraction move no planned bytes and are not part of the estimate.
+        /// </summary>
+        public TimeSpan? Eta { get; }
+        public TimeSpan Elapsed { get; }
+        public bool IsFinished { get; }
+
+        public long BytesDone => Runtime.BytesDone + Files.BytesDone + Libraries.BytesDone;
+        public long BytesTotal => Runtime.BytesTotal + Files.BytesTotal + Libraries.BytesTotal;
+        public int ItemsDone => Runtime.ItemsDone + Files.ItemsDone + Libraries.ItemsDone;
+        public int ItemsFailed => Runtime.ItemsFailed + Files.ItemsFailed + Libraries.ItemsFailed;
+        public int ItemsTotal => Runtime.ItemsTotal + Files.ItemsTotal + Libraries.ItemsTotal;
+
+        /// <summary>
+        /// Overall completion from 0 to 1: by bytes when there are any to move, otherwise by items.
+        /// </summary>
+        public double Fraction =>
+            BytesTotal > 0 ? (double)BytesDone / BytesTotal :
+            ItemsTotal > 0 ? (double)ItemsDone / ItemsTotal :
+            IsFinished ? 1 : 0;
+
+        public InstallPhaseProgress this[InstallPhase phase] => phase switch
+        {
+            InstallPhase.Runtime => Runtime,
+            InstallPhase.Files => Files,
+            _ => Libraries
+        };
+    }
+}
@@ -0,0 +1,392 @@
+﻿// Services/InstanceManager.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text.Json;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Metadata of one instance, stored as <c>instance.json</c> in the instance directory.
+    /// </summary>
+    public class InstanceProfile
+    {
+        public string Name { get; set; }
+        public string VersionId { get; set; }
+        public DateTime CreatedUtc { get; set; }
+        public DateTime? LastLaunchUtc { get; set; }
+
+        /// <summary>
+        /// Shared-content categories (e.g. <c>resourcepacks</c>) materialized into the instance.
+        /// </summary>
+        public List<string> SharedCategories { get; set; } = new List<string>();
+    }
+
+    /// <summary>
+    /// Counts of how the files of an instance were materialized.
+    /// </summary>
+    public class MaterializeStats
+    {
+        public int Reflinked { get; set; }
+        public int Hardlinked { get; set; }
+        public int Copied { get; set; }
+        public long CopiedBytes { get; set; }
+        public TimeSpan Elapsed { get; set; }
+
+        internal void Add(FileCloneMethod method, long length)
+        {
+            switch (method)
+            {
+                case FileCloneMethod.Reflink: Reflinked++; break;
+                case FileCloneMethod.Hardlink: Hardlinked++; break;
+                default: Copied++; CopiedBytes += length; break;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Manages isolated game directories under <c>&lt;data&gt;/instances/&lt;name&gt;</c>, one per profile, so that
+    /// saves, options and mods of different profiles never mix. Content shared between instances lives once under
+    /// <c>&lt;data&gt;/shared/&lt;category&gt;</c> and is materialized into each instance with
+    /// <see cref="FileCloner"/>: a reflink where the file system supports it, a hard link for read-only categories,
+    /// and a copy otherwise. Creating or cloning an instance therefore costs metadata operations, not data copies,
+    /// on btrfs/XFS/APFS, and at most one copy of the mutable files elsewhere.
+    /// <para>
+    /// Hard-linked shared files are marked read-only. The game only reads resource packs, shader packs and mods;
+    /// <c>config</c> templates are edited in place by mods and are never hard linked.
+    /// </para>
+    /// </summary>
+    public class InstanceManager
+    {
+        /// <summary>
+        /// Name of the metadata file in each instance directory.
+        /// </summary>
+        public const string ProfileFileName = "instance.json";
+
+        /// <summary>
+        /// Shared-content categories, each a sub-directory of <see cref="LauncherConfig.SharedDir"/> and of every instance.
+        /// </summary>
+        public static readonly IReadOnlyList<string> SharedCategoryNames = new[] { "resourcepacks", "shaderpacks", "mods", "config" };
+
+        /// <summary>
+        /// Categories materialized when the caller does not name any.
+        /// </summary>
+        public static readonly IReadOnlyList<string> DefaultSharedCategories = new[] { "resourcepacks", "config" };
+
+        // Categories the game writes to; these may be reflinked (copy-on-write) but never hard linked.
+        private static readonly HashSet<string> MutableCategories = new HashSet<string>(StringComparer.OrdinalIgnoreCase) { "config" };
+
+        // Per-run output that is not worth carrying into a clone.
+        private static readonly HashSet<string> CloneExcludedDirectories = new HashSet<string>(StringComparer.OrdinalIgnoreCase) { "logs", "crash-reports" };
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true, WriteIndented = true };
+
+        private readonly LauncherConfig _config;
+        private readonly ILogger _logger;
+
+        public InstanceManager(LauncherConfig config)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _logger = Log.ForContext<InstanceManager>();
+
+            foreach (string category in SharedCategoryNames)
+            {
+                Directory.CreateDirectory(Path.Combine(_config.SharedDir, category));
+            }
+            _logger.Verbose("InstanceManager initialized at {InstancesDir} (shared content in {SharedDir}).", _config.InstancesDir, _config.SharedDir);
+        }
+
+        /// <summary>
+        /// Returns the game directory of the named instance.
+        /// </summary>
+        public string GetGameDirectory(string name)
+        {
+            return Path.Combine(_config.InstancesDir, name);
+        }
+
+        /// <summary>
+        /// Loads the profile of the named instance.
+        /// </summary>
+        /// <returns>The profile, or null if the instance does not exist or its metadata is unreadable.</returns>
+        public InstanceProfile Get(string name)
+        {
+            if (!IsValidName(name)) return null;
+            string profilePath = Path.Combine(GetGameDirectory(name), ProfileFileName);
+            if (!File.Exists(profilePath)) return null;
+
+            try
+            {
+                return JsonSerializer.Deserialize<InstanceProfile>(File.ReadAllText(profilePath), JsonOptions);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to read instance metadata {Path}", profilePath);
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Returns every instance, ordered by name.
+        /// </summary>
+        public List<InstanceProfile> List()
+        {
+            return Directory.EnumerateDirectories(_config.InstancesDir)
+                .Select(Path.GetFileName)
+                .Where(IsValidName)
+                .Select(Get)
+                .Where(p => p != null)
+                .OrderBy(p => p.Name, StringComparer.OrdinalIgnoreCase)
+                .ToList();
+        }
+
+        /// <summary>
+        /// Creates a new instance for <paramref name="versionId"/> and materializes the given shared categories into it.
+        /// The instance is assembled in a staging directory and renamed into place, so a half-created instance is never visible.
+        /// </summary>
+        /// <param name="name">Instance name; also its directory name.</param>
+        /// <param name="versionId">Minecraft version the instance launches by default.</param>
+        /// <param name="sharedCategories">Categories from <see cref="SharedCategoryNames"/>, or null for <see cref="DefaultSharedCategories"/>.</param>
+        /// <returns>The new profile, or null on failure (already exists, invalid name or category, I/O error).</returns>
+        public InstanceProfile Create(string name, string versionId, IEnumerable<string> sharedCategories = null)
+        {
+            if (!IsValidName(name))
+            {
+                _logger.Error("Invalid instance name '{Name}'.", name);
+                return null;
+            }
+            if (string.IsNullOrWhiteSpace(versionId)) throw new ArgumentNullException(nameof(versionId));
+
+            var categories = (sharedCategories ?? DefaultSharedCategories).Select(c => c.Trim().ToLowerInvariant()).Where(c => c.Length > 0).Distinct().ToList();
+            var unknown = categories.Where(c => !SharedCategoryNames.Contains(c)).ToList();
+            if (unknown.Count > 0)
+            {
+                _logger.Error("Unknown shared content categories: {Categories}. Known: {Known}.", string.Join(", ", unknown), string.Join(", ", SharedCategoryNames));
+                return null;
+            }
+
+            var profile = new InstanceProfile { Name = name, VersionId = versionId, CreatedUtc = DateTime.UtcNow, SharedCategories = categories };
+            var stats = new MaterializeStats();
+            var stopwatch = Stopwatch.StartNew();
+
+            bool created = Publish(name, stagingDir =>
+            {
+                foreach (string category in categories)
+                {
+                    string source = Path.Combine(_config.SharedDir, category);
+                    string destination = Path.Combine(stagingDir, category);
+                    Directory.CreateDirectory(destination);
+                    CloneTree(source, destination, allowHardlink: !MutableCategories.Contains(category), excludedDirectories: null, stats);
+                }
+                Directory.CreateDirectory(Path.Combine(stagingDir, "saves"));
+                WriteProfile(stagingDir, profile);
+            });
+            if (!created) return null;
+
+            stats.Elapsed = stopwatch.Elapsed;
+            LogMaterialized("Created", name, stats);
+            return profile;
+        }
+
+        /// <summary>
+        /// Creates <paramref name="newName"/> as a copy of <paramref name="sourceName"/>, including saves and options.
+        /// Files are reflinked where possible; files of read-only shared categories may be hard linked.
+        /// </summary>
+        /// <returns>The new profile, or null on failure.</returns>
+        public InstanceProfile Clone(string sourceName, string newName)
+        {
+            InstanceProfile source = Get(sourceName);
+            if (source == null)
+            {
+                _logger.Error("Instance '{Name}' does not exist.", sourceName);
+                return null;
+            }
+            if (!IsValidName(newName))
+            {
+                _logger.Error("Invalid instance name '{Name}'.", newName);
+                return null;
+            }
+
+            var profile = new InstanceProfile
+            {
+                Name = newName,
+                VersionId = source.VersionId,
+                CreatedUtc = DateTime.UtcNow,
+                SharedCategories = new List<string>(source.SharedCategories ?? new List<string>())
+            };
+            string sourceDir = GetGameDirectory(sourceName);
+            var stats = new MaterializeStats();
+            var stopwatch = Stopwatch.StartNew();
+
+            bool created = Publish(newName, stagingDir =>
+            {
+                foreach (string entry in Directory.EnumerateFileSystemEntries(sourceDir))
+                {
+                    string entryName = Path.GetFileName(entry);
+                    string destination = Path.Combine(stagingDir, entryName);
+                    if (Directory.Exists(entry))
+                    {
+                        if (CloneExcludedDirectories.Contains(entryName)) continue;
+                        bool readOnlyShared = profile.SharedCategories.Contains(entryName, StringComparer.OrdinalIgnoreCase) && !MutableCategories.Contains(entryName);
+                        Directory.CreateDirectory(destination);
+                        CloneTree(entry, destination, readOnlyShared, CloneExcludedDirectories, stats);
+                    }
+                    else if (!entryName.Equals(ProfileFileName, StringComparison.OrdinalIgnoreCase))
+                    {
+                        stats.Add(FileCloner.Clone(entry, destination, allowHardlink: false), new FileInfo(entry).Length);
+                    }
+                }
+                WriteProfile(stagingDir, profile);
+            });
+            if (!created) return null;
+
+            stats.Elapsed = stopwatch.Elapsed;
+            LogMaterialized($"Cloned '{sourceName}' to", newName, stats);
+            return profile;
+        }
+
+        /// <summary>
+        /// Records a launch of the named instance in its profile.
+        /// </summary>
+        public void RecordLaunch(string name)
+        {
+            InstanceProfile profile = Get(name);
+            if (profile == null) return;
+            profile.LastLaunchUtc = DateTime.UtcNow;
+            try
+            {
+                WriteProfile(GetGameDirectory(name), profile);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to update instance metadata for {Name}", name);
+            }
+        }
+
+        /// <summary>
+        /// Deletes the named instance, including its saves. Hard-linked shared files only lose a link;
+        /// the shared copies are untouched.
+        /// </summary>
+        /// <returns>True if the instance was deleted.</returns>
+        public bool Delete(string name)
+        {
+            if (Get(name) == null)
+            {
+                _logger.Error("Instance '{Name}' does not exist.", name);
+                return false;
+            }
+
+            string instanceDir = GetGameDirectory(name);
+            // Move it out of the way first, so a failed delete never leaves a half-deleted instance behind its name.
+            string retiredDir = Path.Combine(_config.InstancesDir, $".retired.{name}.{Environment.ProcessId}.{Guid.NewGuid():N}");
+            try
+            {
+                Directory.Move(instanceDir, retiredDir);
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Failed to delete instance {Name}; is the game still running?", name);
+                return false;
+            }
+
+            try
+            {
+                DeleteTree(retiredDir);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Instance {Name} was removed but {RetiredDir} could not be deleted; it can be removed manually.", name, retiredDir);
+            }
+            _logger.Information("Deleted instance {Name}.", name);
+            return true;
+        }
+
+        /// <summary>
+        /// Instance names become directory names and command-line arguments: letters, digits, '-', '_' and '.',
+        /// not starting with '.'.
+        /// </summary>
+        public static bool IsValidName(string name)
+        {
+            if (string.IsNullOrWhiteSpace(name) || name.Length > 64 || name[0] == '.') return false;
+            return name.All(c => char.IsLetterOrDigit(c) || c == '-' || c == '_' || c == '.');
+        }
+
+        private bool Publish(string name, Action<string> populate)
+        {
+            string finalDir = GetGameDirectory(name);
+            if (Directory.Exists(finalDir))
+            {
+                _logger.Error("Instance '{Name}' already exists.", name);
+                return false;
+            }
+
+            string stagingDir = Path.Combine(_config.InstancesDir, $".staging.{name}.{Environment.ProcessId}.{Guid.NewGuid():N}");
+            try
+            {
+                Directory.CreateDirectory(stagingDir);
+                populate(stagingDir);
+                Directory.Move(stagingDir, finalDir);
+                return true;
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Failed to create instance {Name}", name);
+                try
+                {
+                    if (Directory.Exists(stagingDir)) DeleteTree(stagingDir);
+                }
+                catch (Exception cleanupEx)
+                {
+                    _logger.Verbose(cleanupEx, "Failed to delete staging directory {StagingDir}", stagingDir);
+                }
+                return false;
+            }
+        }
+
+        private static void CloneTree(string sourceDir, string destinationDir, bool allowHardlink, HashSet<string> excludedDirectories, MaterializeStats stats)
+        {
+            foreach (string directory in Directory.EnumerateDirectories(sourceDir))
+            {
+                string directoryName = Path.GetFileName(directory);
+                if (excludedDirectories != null && excludedDirectories.Contains(directoryName)) continue;
+                string target = Path.Combine(destinationDir, directoryName);
+                Directory.CreateDirectory(target);
+                CloneTree(directory, target, allowHardlink, excludedDirectories, stats);
+            }
+            foreach (string file in Directory.EnumerateFiles(sourceDir))
+            {
+                FileCloneMethod method = FileCloner.Clone(file, Path.Combine(destinationDir, Path.GetFileName(file)), allowHardlink);
+                stats.Add(method, method == FileCloneMethod.Copy ? new FileInfo(file).Length : 0);
+            }
+        }
+
+        private static void WriteProfile(string instanceDir, InstanceProfile profile)
+        {
+            AtomicFile.WriteAllText(Path.Combine(instanceDir, ProfileFileName), JsonSerializer.Serialize(profile, JsonOptions));
+        }
+
+        private static void DeleteTree(string directory)
+        {
+            if (OperatingSystem.IsWindows())
+            {
+                // Windows refuses to delete read-only files, and hard-linked shared files are read-only.
+                foreach (string file in Directory.EnumerateFiles(directory, "*", SearchOption.AllDirectories))
+                {
+                    var attributes = File.GetAttributes(file);
+                    if ((attributes & FileAttributes.ReadOnly) != 0) File.SetAttributes(file, attributes & ~FileAttributes.ReadOnly);
+                }
+            }
+            Directory.Delete(directory, true);
+        }
+
+        private void LogMaterialized(string action, string name, MaterializeStats stats)
+        {
+            _logger.Information("{Action} instance {Name} in {ElapsedMs:F0} ms: {Reflinked} reflinked, {Hardlinked} hard linked, {Copied} copied ({CopiedMb:F1} MB).",
+                action, name, stats.Elapsed.TotalMilliseconds, stats.Reflinked, stats.Hardlinked, stats.Copied, stats.CopiedBytes / (1024.0 * 1024.0));
+        }
+    }
+}
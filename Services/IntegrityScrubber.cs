@@ -0,0 +1,628 @@
+﻿// Services/IntegrityScrubber.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Settings for <see cref="IntegrityScrubber"/>. The defaults let a scrub run during a play session unnoticed.
+    /// </summary>
+    public class ScrubOptions
+    {
+        /// <summary>
+        /// Read rate ceiling while re-hashing the store.
+        /// </summary>
+        public long MaxBytesPerSecond { get; set; } = 4 * 1024 * 1024;
+
+        /// <summary>
+        /// Time between the end of one complete pass over the store and the start of the next.
+        /// </summary>
+        public TimeSpan PassInterval { get; set; } = TimeSpan.FromDays(7);
+
+        /// <summary>
+        /// Whether corrupted files are downloaded again right away. Otherwise they are only dropped from the install
+        /// journal, so the next launch that needs them replaces them.
+        /// </summary>
+        public bool Repair { get; set; } = true;
+
+        /// <summary>
+        /// Download rate ceiling for repairs.
+        /// </summary>
+        public long RepairBytesPerSecond { get; set; } = 2 * 1024 * 1024;
+
+        /// <summary>
+        /// How often the pass position is saved, so an interrupted pass loses at most this much work.
+        /// </summary>
+        public TimeSpan CheckpointInterval { get; set; } = TimeSpan.FromSeconds(30);
+    }
+
+    /// <summary>
+    /// Progress of the scrubber, kept in <c>&lt;data&gt;/scrub/state.json</c> across runs.
+    /// </summary>
+    public class ScrubState
+    {
+        /// <summary>
+        /// Path of the last file checked in the current pass, or null at the start of a pass. Files are visited in
+        /// ordinal path order, so a resumed pass continues with the first path after this one.
+        /// </summary>
+        public string Cursor { get; set; }
+
+        /// <summary>
+        /// Start of the current pass, or null if no pass is in progress.
+        /// </summary>
+        public DateTime? PassStartedUtc { get; set; }
+
+        public DateTime? LastPassCompletedUtc { get; set; }
+        public int PassesCompleted { get; set; }
+
+        /// <summary>
+        /// Counters of the current pass.
+        /// </summary>
+        public long FilesChecked { get; set; }
+        public long BytesChecked { get; set; }
+        public int Corrupt { get; set; }
+        public int Repaired { get; set; }
+
+        /// <summary>
+        /// Java runtime files whose content changed while their size and modification time did not.
+        /// Runtimes are installed from archives, so there is no per-file source to repair them from.
+        /// </summary>
+        public List<string> CorruptRuntimeFiles { get; set; } = new List<string>();
+    }
+
+    /// <summary>
+    /// Result of <see cref="IntegrityScrubber.RunPassAsync"/>.
+    /// </summary>
+    public class ScrubReport
+    {
+        public bool PassCompleted { get; set; }
+        public long FilesChecked { get; set; }
+        public long BytesChecked { get; set; }
+        public int Corrupt { get; set; }
+        public int Repaired { get; set; }
+        public int CorruptRuntimeFiles { get; set; }
+        public TimeSpan Elapsed { get; set; }
+
+        /// <summary>
+        /// Corrupted files that are still in place (repair disabled or failed).
+        /// </summary>
+        public int Unrepaired => Corrupt - Repaired;
+    }
+
+    /// <summary>
+    /// Slowly re-verifies everything in the store against its recorded hash, to catch silent corruption (bit rot,
+    /// bad sectors, tools that rewrite files in place) before a launch trips over it:
+    /// <list type="bullet">
+    /// <item>Client JARs, libraries, asset objects and asset indexes of every installed version, against the hashes
+    /// in the cached version JSON and asset index. Versions that cannot be resolved offline are skipped.</item>
+    /// <item>Java runtime files, which have no published per-file hashes, against a baseline taken the first time
+    /// each file is scrubbed (<c>&lt;data&gt;/scrub/runtimes</c>). A file whose size or modification time changed
+    /// since was replaced on purpose and gets a new baseline; only a content change behind unchanged metadata counts
+    /// as corruption.</item>
+    /// </list>
+    /// The walk runs on a dedicated thread in the idle I/O class (<see cref="IoPriority"/>), so the disk only serves
+    /// it when nothing else wants it, and reads at most <see cref="ScrubOptions.MaxBytesPerSecond"/>. Verified files
+    /// are recorded in the <see cref="InstallJournal"/>; corrupted ones are dropped from it and downloaded again through
+    /// a rate-limited <see cref="DownloadScheduler"/>.
+    /// <para>
+    /// The position in the pass is saved every <see cref="ScrubOptions.CheckpointInterval"/> and when stopped, so
+    /// short sessions add up to full passes. A new pass starts <see cref="ScrubOptions.PassInterval"/> after the last
+    /// one completed. Only one process scrubs a data directory at a time.
+    /// </para>
+    /// </summary>
+    public class IntegrityScrubber
+    {
+        /// <summary>
+        /// Lock held for the duration of a pass.
+        /// </summary>
+        public const string ScrubLockKey = "store-scrub";
+
+        private const int ReadChunkSize = 64 * 1024;
+
+        private static readonly StringComparer PathComparer = OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions
+        {
+            PropertyNameCaseInsensitive = true,
+            WriteIndented = true
+        };
+
+        private readonly LauncherConfig _config;
+        private readonly VersionCatalog _catalog;
+        private readonly AssetManager _assetManager;
+        private readonly LibraryManager _libraryManager;
+        private readonly InstallJournal _journal;
+        private readonly FileLockManager _locks;
+        private readonly ScrubOptions _options;
+        private readonly DownloadScheduler _scheduler;
+        private readonly BandwidthLimiter _readLimiter;
+        private readonly string _stateDir;
+        private readonly ILogger _logger;
+        private readonly Dictionary<string, Dictionary<string, RuntimeFileRecord>> _baselines = new Dictionary<string, Dictionary<string, RuntimeFileRecord>>(PathComparer);
+        private readonly HashSet<string> _dirtyBaselines = new HashSet<string>(PathComparer);
+
+        public IntegrityScrubber(
+            LauncherConfig config,
+            HttpManager httpManager,
+            VersionCatalog catalog,
+            AssetManager assetManager,
+            LibraryManager libraryManager,
+            InstallJournal journal,
+            ScrubOptions options = null,
+            FileLockManager locks = null)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            if (httpManager == null) throw new ArgumentNullException(nameof(httpManager));
+            _catalog = catalog ?? throw new ArgumentNullException(nameof(catalog));
+            _assetManager = assetManager ?? throw new ArgumentNullException(nameof(assetManager));
+            _libraryManager = libraryManager ?? throw new ArgumentNullException(nameof(libraryManager));
+            _journal = journal ?? throw new ArgumentNullException(nameof(journal));
+            _locks = locks;
+            _options = options ?? new ScrubOptions();
+            _readLimiter = new BandwidthLimiter(_options.MaxBytesPerSecond);
+            _scheduler = new DownloadScheduler(httpManager, 1, new BandwidthLimiter(_options.RepairBytesPerSecond), journal, locks, config.Durability);
+            _stateDir = Path.Combine(config.BaseDataPath, "scrub");
+            _logger = Log.ForContext<IntegrityScrubber>();
+            _logger.Verbose("IntegrityScrubber initialized (rate {Rate} B/s, interval {Interval}, repair {Repair}).",
+                _options.MaxBytesPerSecond, _options.PassInterval, _options.Repair);
+        }
+
+        private string StatePath => Path.Combine(_stateDir, "state.json");
+
+        /// <summary>
+        /// Scrubs whenever a pass is due until <paramref name="cancellationToken"/> is cancelled. The returned task
+        /// never faults, failures are only logged.
+        /// </summary>
+        public Task Start(CancellationToken cancellationToken)
+        {
+            return RunOnIdleThread(() =>
+            {
+                try
+                {
+                    RunLoop(cancellationToken);
+                }
+                catch (OperationCanceledException)
+                {
+                    _logger.Verbose("Integrity scrubber stopped.");
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Integrity scrubber stopped after an unexpected error.");
+                }
+                return true;
+            }, CancellationToken.None);
+        }
+
+        /// <summary>
+        /// Continues the current pass, or starts a new one if the last pass completed, and runs it to the end.
+        /// When cancelled, the position reached is saved before the task is cancelled.
+        /// </summary>
+        /// <returns>The report, or null if another process is scrubbing this data directory.</returns>
+        public Task<ScrubReport> RunPassAsync(CancellationToken cancellationToken)
+        {
+            return RunOnIdleThread(() => RunPass(cancellationToken), cancellationToken);
+        }
+
+        private void RunLoop(CancellationToken cancellationToken)
+        {
+            while (true)
+            {
+                ScrubState state = LoadState();
+                TimeSpan wait = TimeSpan.Zero;
+                if (state.PassStartedUtc == null && state.LastPassCompletedUtc.HasValue)
+                {
+                    wait = state.LastPassCompletedUtc.Value + _options.PassInterval - DateTime.UtcNow;
+                }
+                if (wait > TimeSpan.Zero)
+                {
+                    _logger.Verbose("Next scrub pass due in {Wait}.", wait);
+                    // Re-check at least hourly, in case another process completed a pass meanwhile.
+                    cancellationToken.WaitHandle.WaitOne(wait < TimeSpan.FromHours(1) ? wait : TimeSpan.FromHours(1));
+                    cancellationToken.ThrowIfCancellationRequested();
+                    continue;
+                }
+                if (RunPass(cancellationToken) == null)
+                {
+                    cancellationToken.WaitHandle.WaitOne(TimeSpan.FromHours(1));
+                    cancellationToken.ThrowIfCancellationRequested();
+                }
+            }
+        }
+
+        private ScrubReport RunPass(CancellationToken cancellationToken)
+        {
+            using FileLease lease = _locks?.TryAcquire(ScrubLockKey, "integrity scrub");
+            if (_locks != null && lease == null)
+            {
+                _logger.Information("Another launcher is scrubbing this data directory; skipping.");
+                return null;
+            }
+
+            ScrubState state = LoadState();
+            if (state.PassStartedUtc == null)
+            {
+                state = new ScrubState
+                {
+                    PassStartedUtc = DateTime.UtcNow,
+                    LastPassCompletedUtc = state.LastPassCompletedUtc,
+                    PassesCompleted = state.PassesCompleted
+                };
+            }
+
+            var stopwatch = Stopwatch.StartNew();
+            List<ScrubTarget> targets = CollectTargets(cancellationToken);
+            int position = 0;
+            if (state.Cursor != null)
+            {
+                // Binary search for the first target after the cursor; the cursor itself may have disappeared since.
+                int lo = 0, hi = targets.Count;
+                while (lo < hi)
+                {
+                    int mid = (lo + hi) / 2;
+                    if (PathComparer.Compare(targets[mid].Path, state.Cursor) <= 0) lo = mid + 1;
+                    else hi = mid;
+                }
+                position = lo;
+            }
+            _logger.Information("Integrity scrub: {Remaining} of {Total} file(s) left in this pass (started {Started:u}), reading at most {Rate} KiB/s.",
+                targets.Count - position, targets.Count, state.PassStartedUtc, _options.MaxBytesPerSecond / 1024);
+
+            var buffer = new byte[ReadChunkSize];
+            var checkpoint = Stopwatch.StartNew();
+            bool completed = false;
+            try
+            {
+                for (; position < targets.Count; position++)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    ScrubTarget target = targets[position];
+                    if (target.Item != null) ScrubItem(target.Item, state, buffer, cancellationToken);
+                    else ScrubRuntimeFile(target, state, buffer, cancellationToken);
+                    state.Cursor = target.Path;
+
+                    if (checkpoint.Elapsed >= _options.CheckpointInterval)
+                    {
+                        SaveProgress(state);
+                        checkpoint.Restart();
+                    }
+                }
+
+                state.LastPassCompletedUtc = DateTime.UtcNow;
+                state.PassesCompleted++;
+                completed = true;
+                _logger.Information("Integrity scrub pass complete: {Files} file(s), {Mb:F1} MB checked, {Corrupt} corrupted, {Repaired} repaired, {Runtime} corrupted runtime file(s).",
+                    state.FilesChecked, state.BytesChecked / (1024.0 * 1024.0), state.Corrupt, state.Repaired, state.CorruptRuntimeFiles.Count);
+                return CreateReport(state, true, stopwatch.Elapsed);
+            }
+            finally
+            {
+                ScrubReport report = CreateReport(state, completed, stopwatch.Elapsed);
+                if (completed)
+                {
+                    state.PassStartedUtc = null;
+                    state.Cursor = null;
+                }
+                SaveProgress(state);
+                if (!completed)
+                {
+                    _logger.Information("Integrity scrub paused after {Files} file(s) of this pass; it continues from {Cursor} next time.",
+                        report.FilesChecked, state.Cursor ?? "the start");
+                }
+            }
+        }
+
+        private static ScrubReport CreateReport(ScrubState state, bool completed, TimeSpan elapsed)
+        {
+            return new ScrubReport
+            {
+                PassCompleted = completed,
+                FilesChecked = state.FilesChecked,
+                BytesChecked = state.BytesChecked,
+                Corrupt = state.Corrupt,
+                Repaired = state.Repaired,
+                CorruptRuntimeFiles = state.CorruptRuntimeFiles.Count,
+                Elapsed = elapsed
+            };
+        }
+
+        /// <summary>
+        /// Re-hashes one store file against its published hash, repairing it if it does not match.
+        /// </summary>
+        private void ScrubItem(InstallWorkItem item, ScrubState state, byte[] buffer, CancellationToken cancellationToken)
+        {
+            var before = new FileInfo(item.LocalPath);
+            if (!before.Exists) return; // Not installed (or packed away by tiering); installing it is not the scrubber's job.
+
+            bool corrupt;
+            if (item.Size.HasValue && before.Length != (long)item.Size.Value)
+            {
+                corrupt = true;
+            }
+            else
+            {
+                string actual = HashFile(item.LocalPath, buffer, state, cancellationToken);
+                if (actual == null) return;
+                corrupt = !string.Equals(actual, item.Sha1, StringComparison.OrdinalIgnoreCase);
+            }
+            state.FilesChecked++;
+
+            var after = new FileInfo(item.LocalPath);
+            if (!after.Exists || after.Length != before.Length || after.LastWriteTimeUtc != before.LastWriteTimeUtc)
+            {
+                // Replaced while it was being read, most likely by an install; what was read proves nothing.
+                return;
+            }
+            if (!corrupt)
+            {
+                _journal.RecordVerified(item);
+                return;
+            }
+
+            state.Corrupt++;
+            _journal.RecordRemoved(item);
+            _journal.Flush();
+            if (!_options.Repair)
+            {
+                _logger.Warning("Integrity scrub: {Path} is corrupted; it will be downloaded again when a launch needs it.", item.LocalPath);
+                return;
+            }
+
+            _logger.Warning("Integrity scrub: {Path} is corrupted; downloading it again.", item.LocalPath);
+            // Repairs are rare and network-bound, so this thread just waits for the download.
+            if (_scheduler.EnsureFileAsync(item, cancellationToken).GetAwaiter().GetResult())
+            {
+                state.Repaired++;
+                _logger.Information("Integrity scrub: repaired {Path}.", item.LocalPath);
+            }
+            else
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                _logger.Warning("Integrity scrub: could not repair {Path}; the next launch that needs it will try again.", item.LocalPath);
+            }
+        }
+
+        /// <summary>
+        /// Re-hashes one Java runtime file against its baseline, or takes the baseline.
+        /// </summary>
+        private void ScrubRuntimeFile(ScrubTarget target, ScrubState state, byte[] buffer, CancellationToken cancellationToken)
+        {
+            var info = new FileInfo(target.Path);
+            if (!info.Exists) return;
+            string actual = HashFile(target.Path, buffer, state, cancellationToken);
+            if (actual == null) return;
+            state.FilesChecked++;
+
+            var after = new FileInfo(target.Path);
+            if (!after.Exists || after.Length != info.Length || after.LastWriteTimeUtc != info.LastWriteTimeUtc) return;
+
+            Dictionary<string, RuntimeFileRecord> baseline = GetBaseline(target.Runtime);
+            var current = new RuntimeFileRecord { Sha1 = actual, Size = info.Length, MtimeTicks = info.LastWriteTimeUtc.Ticks };
+            if (baseline.TryGetValue(target.RelativePath, out RuntimeFileRecord recorded) &&
+                recorded.Size == current.Size && recorded.MtimeTicks == current.MtimeTicks)
+            {
+                if (string.Equals(recorded.Sha1, actual, StringComparison.OrdinalIgnoreCase)) return;
+
+                state.Corrupt++;
+                if (!state.CorruptRuntimeFiles.Contains(target.Path, PathComparer)) state.CorruptRuntimeFiles.Add(target.Path);
+                _logger.Error("Integrity scrub: Java runtime file {Path} changed on disk without its size or date changing. Delete {Runtime} in {RuntimesDir} to have it reinstalled.",
+                    target.Path, target.Runtime, _config.JavaRuntimesDir);
+                return; // The baseline is kept, so the file is reported again until the runtime is replaced.
+            }
+
+            baseline[target.RelativePath] = current;
+            _dirtyBaselines.Add(target.Runtime);
+        }
+
+        /// <summary>
+        /// SHA1 of a file, read in chunks no faster than the configured rate.
+        /// </summary>
+        /// <returns>The lowercase hex hash, or null if the file could not be read.</returns>
+        private string HashFile(string path, byte[] buffer, ScrubState state, CancellationToken cancellationToken)
+        {
+            try
+            {
+                using var stream = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite | FileShare.Delete, 1, FileOptions.SequentialScan);
+                using var hash = IncrementalHash.CreateHash(HashAlgorithmName.SHA1);
+                long remaining = stream.Length;
+                while (true)
+                {
+                    // Reserve only what is left of the file, so small files are not charged a whole chunk.
+                    ValueTask wait = _readLimiter.WaitAsync((int)Math.Min(buffer.Length, Math.Max(remaining, 0)), cancellationToken);
+                    if (!wait.IsCompletedSuccessfully) wait.AsTask().GetAwaiter().GetResult();
+                    int read = stream.Read(buffer, 0, buffer.Length);
+                    if (read == 0) break;
+                    hash.AppendData(buffer, 0, read);
+                    state.BytesChecked += read;
+                    remaining -= read;
+                }
+                return Convert.ToHexString(hash.GetHashAndReset()).ToLowerInvariant();
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Verbose(ex, "Integrity scrub: could not read {Path}; skipping it this pass.", path);
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Everything to scrub, in ordinal path order so a saved cursor stays meaningful when the store changes.
+        /// </summary>
+        private List<ScrubTarget> CollectTargets(CancellationToken cancellationToken)
+        {
+            var targets = new Dictionary<string, ScrubTarget>(PathComparer);
+            if (Directory.Exists(_config.VersionsDir))
+            {
+                foreach (string versionDir in Directory.EnumerateDirectories(_config.VersionsDir))
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    MinecraftVersion version = _catalog.TryLoadCachedVersion(Path.GetFileName(versionDir));
+                    if (version == null) continue;
+
+                    var items = new List<InstallWorkItem>();
+                    if (version.Downloads != null && version.Downloads.TryGetValue("client", out DownloadDetails client))
+                    {
+                        items.Add(new InstallWorkItem
+                        {
+                            Kind = InstallWorkKind.ClientJar,
+                            Url = client.Url,
+                            LocalPath = Path.Combine(_config.VersionsDir, version.Id, $"{version.Id}.jar"),
+                            Sha1 = client.Sha1,
+                            Size = client.Size,
+                            Description = $"Client JAR for {version.Id}"
+                        });
+                    }
+                    items.AddRange(_libraryManager.CollectLibraryWorkItems(version));
+                    List<InstallWorkItem> assetItems = _assetManager.CollectCachedAssetWorkItems(version);
+                    if (assetItems != null) items.AddRange(assetItems);
+
+                    foreach (var item in items)
+                    {
+                        if (string.IsNullOrEmpty(item.Sha1) || string.IsNullOrEmpty(item.Url)) continue;
+                        string path = Path.GetFullPath(item.LocalPath);
+                        targets.TryAdd(path, new ScrubTarget { Path = path, Item = item });
+                    }
+                }
+            }
+
+            if (Directory.Exists(_config.JavaRuntimesDir))
+            {
+                var enumeration = new EnumerationOptions { RecurseSubdirectories = true, AttributesToSkip = FileAttributes.ReparsePoint };
+                foreach (string runtimeDir in Directory.EnumerateDirectories(_config.JavaRuntimesDir))
+                {
+                    string runtime = Path.GetFileName(runtimeDir);
+                    if (runtime.StartsWith("_", StringComparison.Ordinal)) continue; // _downloads and other launcher scratch space.
+                    foreach (string file in Directory.EnumerateFiles(runtimeDir, "*", enumeration))
+                    {
+                        string path = Path.GetFullPath(file);
+                        targets.TryAdd(path, new ScrubTarget
+                        {
+                            Path = path,
+                            Runtime = runtime,
+                            RelativePath = Path.GetRelativePath(runtimeDir, path).Replace('\\', '/')
+                        });
+                    }
+                }
+            }
+
+            var sorted = targets.Values.ToList();
+            sorted.Sort((a, b) => PathComparer.Compare(a.Path, b.Path));
+            return sorted;
+        }
+
+        private Dictionary<string, RuntimeFileRecord> GetBaseline(string runtime)
+        {
+            if (_baselines.TryGetValue(runtime, out var baseline)) return baseline;
+            string path = Path.Combine(_stateDir, "runtimes", runtime + ".json");
+            try
+            {
+                if (File.Exists(path)) baseline = JsonSerializer.Deserialize<Dictionary<string, RuntimeFileRecord>>(File.ReadAllText(path), JsonOptions);
+            }
+            catch (Exception ex) when (ex is IOException || ex is JsonException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not read the scrub baseline {Path}; taking a new one.", path);
+            }
+            baseline ??= new Dictionary<string, RuntimeFileRecord>();
+            _baselines[runtime] = baseline;
+            return baseline;
+        }
+
+        private ScrubState LoadState()
+        {
+            try
+            {
+                if (File.Exists(StatePath)) return JsonSerializer.Deserialize<ScrubState>(File.ReadAllText(StatePath), JsonOptions) ?? new ScrubState();
+            }
+            catch (Exception ex) when (ex is IOException || ex is JsonException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not read scrub state {Path}; starting a new pass.", StatePath);
+            }
+            return new ScrubState();
+        }
+
+        /// <summary>
+        /// Saves the pass position and any new runtime baselines, and flushes the journal records written so far.
+        /// </summary>
+        private void SaveProgress(ScrubState state)
+        {
+            try
+            {
+                Directory.CreateDirectory(Path.Combine(_stateDir, "runtimes"));
+                foreach (string runtime in _dirtyBaselines)
+                {
+                    AtomicFile.WriteAllText(Path.Combine(_stateDir, "runtimes", runtime + ".json"), JsonSerializer.Serialize(_baselines[runtime], JsonOptions));
+                }
+                _dirtyBaselines.Clear();
+                AtomicFile.WriteAllText(StatePath, JsonSerializer.Serialize(state, JsonOptions));
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not save scrub progress to {Path}.", StatePath);
+            }
+            _journal.Flush();
+        }
+
+        /// <summary>
+        /// Runs <paramref name="work"/> on a new background thread in the idle I/O class.
+        /// </summary>
+        private Task<T> RunOnIdleThread<T>(Func<T> work, CancellationToken cancellationToken)
+        {
+            var completion = new TaskCompletionSource<T>(TaskCreationOptions.RunContinuationsAsynchronously);
+            var thread = new Thread(() =>
+            {
+                if (!IoPriority.SetCurrentThreadIdle())
+                {
+                    _logger.Verbose("Could not lower the scrubber's I/O priority on this platform; relying on the rate limit alone.");
+                }
+                try
+                {
+                    completion.TrySetResult(work());
+                }
+                catch (OperationCanceledException) when (cancellationToken.IsCancellationRequested)
+                {
+                    completion.TrySetCanceled(cancellationToken);
+                }
+                catch (Exception ex)
+                {
+                    completion.TrySetException(ex);
+                }
+            })
+            {
+                IsBackground = true,
+                Name = "Integrity scrubber"
+            };
+            thread.Start();
+            return completion.Task;
+        }
+
+        private sealed class ScrubTarget
+        {
+            public string Path { get; set; }
+
+            /// <summary>
+            /// Store file with a published hash, or null for a runtime file.
+            /// </summary>
+            public InstallWorkItem Item { get; set; }
+
+            public string Runtime { get; set; }
+            public string RelativePath { get; set; }
+        }
+
+        private sealed class RuntimeFileRecord
+        {
+            public string Sha1 { get; set; }
+            public long Size { get; set; }
+            public long MtimeTicks { get; set; }
+        }
+    }
+}
@@ -0,0 +1,277 @@
+﻿// Services/IoBackendBenchmark.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Result of one workload under one <see cref="IoBackend"/>.
+    /// </summary>
+    public class IoBackendBenchmarkResult
+    {
+        public string Workload { get; set; }
+        public IoBackend Backend { get; set; }
+        public int Files { get; set; }
+        public long Bytes { get; set; }
+        public int Failed { get; set; }
+        public TimeSpan Elapsed { get; set; }
+
+        /// <summary>
+        /// Read-type system calls during the run (<c>syscr</c> in <c>/proc/self/io</c>, the whole process).
+        /// </summary>
+        public long ReadCalls { get; set; }
+
+        /// <summary>
+        /// Write-type system calls during the run (<c>syscw</c> in <c>/proc/self/io</c>, the whole process).
+        /// </summary>
+        public long WriteCalls { get; set; }
+
+        /// <summary>
+        /// <c>io_uring_enter</c> calls during the run. The kernel counts these in neither of the above.
+        /// </summary>
+        public long SubmitCalls { get; set; }
+
+        public double FilesPerSecond => Elapsed.TotalSeconds > 0 ? Files / Elapsed.TotalSeconds : 0;
+    }
+
+    /// <summary>
+    /// Compares the default file I/O path with the io_uring backend (<see cref="IoUringFileBatch"/>) on a real version:
+    /// <list type="bullet">
+    /// <item><b>verify</b>: <see cref="CryptoUtils.VerifyFilesAsync"/> over every installed file of the version, against a
+    /// warm page cache (a discarded pass reads everything first).</item>
+    /// <item><b>install</b>: every asset object written (real size, random content) through temp file plus rename into a
+    /// scratch directory in the data directory, which is deleted afterwards. No fsync on either side, as in
+    /// <see cref="DurabilityMode.Fast"/>, so only the cost of issuing the I/O is compared.</item>
+    /// </list>
+    /// Besides wall time it reports the process's read and write system call counts from <c>/proc/self/io</c> and the
+    /// number of io_uring submissions. Opens and closes are not counted by the kernel anywhere, so the saving on those
+    /// only shows in the wall time. When io_uring is unavailable only the default backend runs.
+    /// </summary>
+    public class IoBackendBenchmark
+    {
+        private readonly LauncherConfig _config;
+        private readonly ILogger _logger;
+
+        public IoBackendBenchmark(LauncherConfig config)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _logger = Log.ForContext<IoBackendBenchmark>();
+            _logger.Verbose("IoBackendBenchmark initialized.");
+        }
+
+        /// <summary>
+        /// Runs both workloads with each backend and logs a comparison.
+        /// </summary>
+        /// <param name="items">Work items of an installed version (client JAR, libraries, assets).</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public async Task<List<IoBackendBenchmarkResult>> RunAsync(IReadOnlyList<InstallWorkItem> items, CancellationToken cancellationToken = default)
+        {
+            if (items == null) throw new ArgumentNullException(nameof(items));
+            var results = new List<IoBackendBenchmarkResult>();
+
+            var backends = new List<IoBackend> { IoBackend.Default };
+            if (IoUringFileBatch.IsAvailable) backends.Add(IoBackend.IoUring);
+            else _logger.Warning("I/O benchmark: io_uring is not available to this process; only the default backend is measured.");
+
+            IoBackend selected = IoUringFileBatch.Backend;
+            try
+            {
+                var requests = items
+                    .Where(i => !string.IsNullOrEmpty(i.Sha1) && File.Exists(i.LocalPath))
+                    .GroupBy(i => Path.GetFullPath(i.LocalPath))
+                    .Select(g => new FileVerificationRequest(g.Key, (long?)g.First().Size, g.First().Sha1))
+                    .ToList();
+                if (requests.Count > 0)
+                {
+                    _logger.Information("I/O benchmark: verifying {Count} installed files ({Small} small enough for io_uring batches).",
+                        requests.Count, requests.Count(r => r.ExpectedSize <= IoUringFileBatch.MaxFileSize));
+                    IoUringFileBatch.Backend = IoBackend.Default;
+                    await CryptoUtils.VerifyFilesAsync(requests, cancellationToken: cancellationToken).ConfigureAwait(false);
+                    foreach (IoBackend backend in backends)
+                    {
+                        results.Add(await RunVerifyAsync(backend, requests, cancellationToken).ConfigureAwait(false));
+                    }
+                }
+                else
+                {
+                    _logger.Warning("I/O benchmark: none of the version's files are on disk; skipping verify. Install it first.");
+                }
+
+                List<InstallWorkItem> objects = items
+                    .Where(i => i.Kind == InstallWorkKind.Asset && !string.IsNullOrEmpty(i.Sha1) && i.Size.HasValue)
+                    .GroupBy(i => i.Sha1, StringComparer.OrdinalIgnoreCase)
+                    .Select(g => g.First())
+                    .ToList();
+                if (objects.Count > 0)
+                {
+                    _logger.Information("I/O benchmark: writing {Count} asset objects ({Mb:F1} MB).",
+                        objects.Count, objects.Sum(o => (long)o.Size.Value) / (1024.0 * 1024.0));
+                    foreach (IoBackend backend in backends)
+                    {
+                        cancellationToken.ThrowIfCancellationRequested();
+                        results.Add(RunInstall(backend, objects, cancellationToken));
+                    }
+                }
+            }
+            finally
+            {
+                IoUringFileBatch.Backend = selected;
+            }
+
+            _logger.Information("{Workload,-8} {Backend,-8} {Files,8} {Seconds,10} {FilesPerSec,10} {ReadCalls,10} {WriteCalls,10} {Submits,8} {Failed,7}",
+                "workload", "backend", "files", "elapsed s", "files/s", "syscr", "syscw", "submits", "failed");
+            foreach (var r in results)
+            {
+                _logger.Information("{Workload,-8} {Backend,-8} {Files,8} {Seconds,10:F2} {FilesPerSec,10:F0} {ReadCalls,10} {WriteCalls,10} {Submits,8} {Failed,7}",
+                    r.Workload, r.Backend == IoBackend.IoUring ? "io_uring" : "default", r.Files, r.Elapsed.TotalSeconds, r.FilesPerSecond,
+                    r.ReadCalls, r.WriteCalls, r.SubmitCalls, r.Failed);
+            }
+            return results;
+        }
+
+        private static async Task<IoBackendBenchmarkResult> RunVerifyAsync(IoBackend backend, List<FileVerificationRequest> requests, CancellationToken cancellationToken)
+        {
+            IoUringFileBatch.Backend = backend;
+            var result = new IoBackendBenchmarkResult { Workload = "verify", Backend = backend, Files = requests.Count };
+            var before = IoCounters.Read();
+            var stopwatch = Stopwatch.StartNew();
+            var verified = await CryptoUtils.VerifyFilesAsync(requests, cancellationToken: cancellationToken).ConfigureAwait(false);
+            stopwatch.Stop();
+            IoCounters.Read().Subtract(before, result);
+            result.Elapsed = stopwatch.Elapsed;
+            result.Bytes = verified.Sum(r => Math.Max(0, r.ActualSize));
+            result.Failed = verified.Count(r => !r.IsValid);
+            return result;
+        }
+
+        private IoBackendBenchmarkResult RunInstall(IoBackend backend, List<InstallWorkItem> objects, CancellationToken cancellationToken)
+        {
+            string root = Path.Combine(_config.BaseDataPath, "_bench", $"io-{backend.ToString().ToLowerInvariant()}");
+            if (Directory.Exists(root)) Directory.Delete(root, true);
+            foreach (var item in objects) Directory.CreateDirectory(Path.Combine(root, item.Sha1.Substring(0, 2)));
+
+            // One random buffer sized for the largest object; every file writes a prefix of it.
+            var content = new byte[objects.Max(o => (long)o.Size.Value)];
+            new Random(1234).NextBytes(content);
+
+            IoUringFileBatch.Backend = backend;
+            var result = new IoBackendBenchmarkResult
+            {
+                Workload = "install",
+                Backend = backend,
+                Files = objects.Count,
+                Bytes = objects.Sum(o => (long)o.Size.Value)
+            };
+            int failed = 0;
+            var before = IoCounters.Read();
+            var stopwatch = Stopwatch.StartNew();
+
+            // Both backends write with the same number of threads; the io_uring one hands each thread whole batches.
+            var chunks = objects.Chunk(IoUringFileBatch.Capacity).ToList();
+            var batches = new ThreadLocal<IoUringFileBatch>(IoUringFileBatch.TryCreate, trackAllValues: true);
+            try
+            {
+                Parallel.ForEach(chunks, new ParallelOptions { MaxDegreeOfParallelism = Environment.ProcessorCount, CancellationToken = cancellationToken }, chunk =>
+                {
+                    IoUringFileBatch batch = batches.Value;
+                    var batched = new List<(string Path, ReadOnlyMemory<byte> Content)>(chunk.Length);
+                    foreach (var item in chunk)
+                    {
+                        string finalPath = Path.Combine(root, item.Sha1.Substring(0, 2), item.Sha1);
+                        int size = (int)item.Size.Value;
+                        if (batch != null && size <= IoUringFileBatch.MaxFileSize)
+                        {
+                            batched.Add((finalPath, content.AsMemory(0, size)));
+                            continue;
+                        }
+                        string tempPath = AtomicFile.CreateTempPath(finalPath);
+                        using (var stream = new FileStream(tempPath, FileMode.CreateNew, FileAccess.Write, FileShare.None))
+                        {
+                            stream.Write(content, 0, size);
+                        }
+                        AtomicFile.Commit(tempPath, finalPath);
+                    }
+                    if (batched.Count == 0) return;
+
+                    Span<int> written = stackalloc int[IoUringFileBatch.Capacity];
+                    batch.WriteFiles(batched, written);
+                    for (int i = 0; i < batched.Count; i++)
+                    {
+                        if (written[i] != 0) Interlocked.Increment(ref failed);
+                    }
+                });
+            }
+            finally
+            {
+                foreach (var batch in batches.Values) batch?.Dispose();
+                batches.Dispose();
+            }
+            stopwatch.Stop();
+            IoCounters.Read().Subtract(before, result);
+            result.Elapsed = stopwatch.Elapsed;
+            result.Failed = failed;
+            _logger.Information("I/O benchmark: {Backend} wrote {Files} files in {Elapsed:F2}s.", backend, result.Files, result.Elapsed.TotalSeconds);
+
+            try
+            {
+                Directory.Delete(root, true);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Could not delete benchmark directory {Root}.", root);
+            }
+            return result;
+        }
+
+        /// <summary>
+        /// Snapshot of the process's I/O counters. All zero where <c>/proc/self/io</c> is not available.
+        /// </summary>
+        private readonly struct IoCounters
+        {
+            private IoCounters(long readCalls, long writeCalls, long submitCalls)
+            {
+                ReadCalls = readCalls;
+                WriteCalls = writeCalls;
+                SubmitCalls = submitCalls;
+            }
+
+            public long ReadCalls { get; }
+            public long WriteCalls { get; }
+            public long SubmitCalls { get; }
+
+            public static IoCounters Read()
+            {
+                long readCalls = 0, writeCalls = 0;
+                try
+                {
+                    foreach (string line in File.ReadAllLines("/proc/self/io"))
+                    {
+                        if (line.StartsWith("syscr:", StringComparison.Ordinal)) long.TryParse(line.Substring(6).Trim(), out readCalls);
+                        else if (line.StartsWith("syscw:", StringComparison.Ordinal)) long.TryParse(line.Substring(6).Trim(), out writeCalls);
+                    }
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    // Not Linux, or /proc is not mounted.
+                }
+                return new IoCounters(readCalls, writeCalls, IoUringFileBatch.SubmitCalls);
+            }
+
+            public void Subtract(IoCounters before, IoBackendBenchmarkResult into)
+            {
+                into.ReadCalls = ReadCalls - before.ReadCalls;
+                into.WriteCalls = WriteCalls - before.WriteCalls;
+                into.SubmitCalls = SubmitCalls - before.SubmitCalls;
+            }
+        }
+    }
+}
@@ -14,11 +14,13 @@ namespace ObsidianLauncher.Services
 {
     public class JavaDownloader
     {
+        private readonly LauncherConfig _config;
         private readonly HttpManager _httpManager;
         private readonly ILogger _logger;
 
-        public JavaDownloader(HttpManager httpManager)
+        public JavaDownloader(LauncherConfig config, HttpManager httpManager)
         {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
             _httpManager = httpManager ?? throw new ArgumentNullException(nameof(httpManager));
             _logger = Log.ForContext<JavaDownloader>();
             _logger.Verbose("JavaDownloader initialized.");
@@ -26,7 +28,7 @@ namespace ObsidianLauncher.Services
 
         private async Task<JsonDocument> FetchMojangJavaManifestAsync(CancellationToken cancellationToken = default)
         {
-            const string javaManifestUrl = "https://launchermeta.mojang.com/v1/products/java-runtime/2ec0cc96c44e5a76b9c8b7c39df7210883d12871/all.json";
+            string javaManifestUrl = _config.JavaRuntimeManifestUrl;
             _logger.Information("Fetching Mojang Java runtime manifest from: {Url}", javaManifestUrl);
 
             HttpResponseMessage responseMsg = await _httpManager.GetAsync(javaManifestUrl, cancellationToken: cancellationToken);
@@ -202,7 +204,7 @@ namespace ObsidianLauncher.Services
             _logger.Information("Adoptium API - OS: {AdoptiumOS}, Arch: {AdoptiumArch}", adoptiumOS, adoptiumArch);
 
             string imageType = "jre"; // Common for launchers; "jdk" is also an option.
-            string apiUrl = $"https://api.adoptium.net/v3/assets/latest/{requiredJava.MajorVersion}/hotspot" +
+            string apiUrl = $"{_config.AdoptiumApiUrl.TrimEnd('/')}/assets/latest/{requiredJava.MajorVersion}/hotspot" +
                             $"?architecture={adoptiumArch}" +
                             $"&heap_size=normal" + // "normal" or "large"
                             $"&image_type={imageType}" +
@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
 using System.IO.Compression; // For ZipFile
 using System.Linq;
@@ -17,15 +18,20 @@ namespace ObsidianLauncher.Services
         private readonly LauncherConfig _config;
         // HttpManager is now owned by JavaDownloader
         private readonly JavaDownloader _javaDownloader;
+        private readonly FileLockManager _locks;
         private readonly ILogger _logger;
         private List<JavaRuntimeInfo> _availableRuntimes;
 
-        public JavaManager(LauncherConfig config, HttpManager httpManager)
+        /// <param name="config">Launcher configuration.</param>
+        /// <param name="httpManager">HTTP manager used by the downloader.</param>
+        /// <param name="locks">Optional cross-process locks; lets concurrent launchers install a runtime only once.</param>
+        public JavaManager(LauncherConfig config, HttpManager httpManager, FileLockManager locks = null)
         {
             _config = config ?? throw new ArgumentNullException(nameof(config));
+            _locks = locks;
             _logger = Log.ForContext<JavaManager>();
             // JavaDownloader now takes HttpManager
-            _javaDownloader = new JavaDownloader(httpManager ?? throw new ArgumentNullException(nameof(httpManager)));
+            _javaDownloader = new JavaDownloader(_config, httpManager ?? throw new ArgumentNullException(nameof(httpManager)));
             _availableRuntimes = new List<JavaRuntimeInfo>();
 
             _logger.Verbose("JavaManager initializing...");
@@ -68,23 +74,43 @@ namespace ObsidianLauncher.Services
             _logger.Information("Ensuring Java for Minecraft version: {VersionId}", mcVersion.Id);
 
             var requiredJava = mcVersion.JavaVersion;
+            using Activity activity = LauncherTracing.Start("java.ensure");
+            activity?.SetTag("component", requiredJava.Component);
             _logger.Information("Required Java: Component '{Component}', Major Version '{MajorVersion}'",
                 requiredJava.Component, requiredJava.MajorVersion);
 
-            var existingRuntime = _availableRuntimes.FirstOrDefault(r =>
-                r.ComponentName.Equals(requiredJava.Component, StringComparison.OrdinalIgnoreCase) &&
-                r.MajorVersion == requiredJava.MajorVersion);
+            var existingRuntime = FindInstalledRuntime(requiredJava);
 
             if (existingRuntime != null)
             {
                 _logger.Information("Found existing suitable Java runtime: Component '{Component}', Version '{MajorVersion}', Source '{Source}', Home '{HomePath}'",
                     existingRuntime.ComponentName, existingRuntime.MajorVersion, existingRuntime.Source, existingRuntime.HomePath);
+                activity?.SetTag("cache", "hit");
                 return existingRuntime;
             }
 
+            // Another launcher sharing the data directory may be installing the same runtime. Hold the runtime's lock
+            // for the whole download/extract and re-scan once we have it, in case the other launcher finished it.
+            using FileLease runtimeLease = _locks == null ? null : await _locks.AcquireAsync(
+                $"runtime-{requiredJava.Component}_{requiredJava.MajorVersion}",
+                $"installing {requiredJava.Component} {requiredJava.MajorVersion}", cancellationToken);
+            if (runtimeLease != null)
+            {
+                ScanForExistingRuntimes();
+                existingRuntime = FindInstalledRuntime(requiredJava);
+                if (existingRuntime != null)
+                {
+                    _logger.Information("Java runtime {Component} v{MajorVersion} was installed by another launcher process: {HomePath}",
+                        requiredJava.Component, requiredJava.MajorVersion, existingRuntime.HomePath);
+                    activity?.SetTag("cache", "peer");
+                    return existingRuntime;
+                }
+            }
+
             _logger.Information("No existing suitable Java runtime found for {Component} v{MajorVersion}. Attempting download.",
                 requiredJava.Component, requiredJava.MajorVersion);
 
+            activity?.SetTag("cache", "miss");
             string downloadedArchivePath = null;
             string sourceApi = "unknown";
 
@@ -191,25 +217,51 @@ namespace ObsidianLauncher.Services
         {
             _logger.Information("Attempting to extract Java archive '{RuntimeName}': {ArchivePath} to {ExtractionDir}",
                 runtimeNameForPath, archivePath, extractionDir);
+            using Activity activity = LauncherTracing.Start("extract.java_runtime");
+            if (activity != null)
+            {
+                activity.SetTag("runtime", runtimeNameForPath);
+                try { activity.SetTag("bytes", new FileInfo(archivePath).Length); }
+                catch (IOException) { }
+            }
+            long started = Stopwatch.GetTimestamp();
 
+            // Extract into a staging directory next to the runtimes (same volume) and swap it into place once complete,
+            // so a runtime directory is never seen half-populated. The "_" prefix keeps ScanForExistingRuntimes away from it.
+            string stagingDir = Path.Combine(Path.GetDirectoryName(Path.GetFullPath(extractionDir)), "_staging",
+                $"{Path.GetFileName(extractionDir)}.{Environment.ProcessId}.{Guid.NewGuid():N}");
             try
             {
-                if (Directory.Exists(extractionDir))
-                {
-                    _logger.Information("Extraction directory {ExtractionDir} for '{RuntimeName}' already exists. Removing for fresh extraction.",
-                        extractionDir, runtimeNameForPath);
-                    Directory.Delete(extractionDir, true); // Recursive delete
-                }
-                Directory.CreateDirectory(extractionDir);
+                Directory.CreateDirectory(stagingDir);
 
                 // System.IO.Compression.ZipFile handles .zip archives.
                 // For .tar.gz, you'd need an external library like SharpZipLib or System.Formats.Tar (in .NET 7+)
                 // For simplicity, this example assumes .zip. If .tar.gz is common, this needs expansion.
                 if (archivePath.EndsWith(".zip", StringComparison.OrdinalIgnoreCase))
                 {
-                    ZipFile.ExtractToDirectory(archivePath, extractionDir, true); // true to overwrite files
+                    ZipFile.ExtractToDirectory(archivePath, stagingDir, true); // true to overwrite files
+                    if (Directory.Exists(extractionDir))
+                    {
+                        _logger.Information("Extraction directory {ExtractionDir} for '{RuntimeName}' already exists. Replacing it with the fresh extraction.",
+                            extractionDir, runtimeNameForPath);
+                    }
+                    if (_config.Durability != DurabilityMode.Fast)
+                    {
+                        // A runtime is one unit, so batched and strict both sync it as a whole before the swap.
+                        FileSync.SyncTree(stagingDir);
+                    }
+                    AtomicFile.ReplaceDirectory(stagingDir, extractionDir);
+                    if (_config.Durability != DurabilityMode.Fast)
+                    {
+                        FileSync.SyncDirectory(Path.GetDirectoryName(Path.GetFullPath(extractionDir)));
+                    }
                     _logger.Information("Successfully extracted ZIP archive '{RuntimeName}' to {ExtractionDir}.",
                         runtimeNameForPath, extractionDir);
+                    if (LauncherMetrics.ExtractBytes.Enabled)
+                    {
+                        using ZipArchive archive = ZipFile.OpenRead(archivePath); // Only the central directory is read.
+                        LauncherMetrics.RecordExtraction("java_runtime", archive.Entries.Sum(e => e.Length), started);
+                    }
                     return true;
                 }
                 // else if (archivePath.EndsWith(".tar.gz", StringComparison.OrdinalIgnoreCase))
@@ -235,13 +287,16 @@ namespace ObsidianLauncher.Services
             {
                 _logger.Error(ex, "Failed to extract Java archive '{RuntimeName}' ({ArchivePath}) to {ExtractionDir}.",
                     runtimeNameForPath, archivePath, extractionDir);
-                // Attempt to clean up partially extracted directory
-                if (Directory.Exists(extractionDir))
+                return false;
+            }
+            finally
+            {
+                // Clean up the staging directory if it was not moved into place (unsupported format or error)
+                if (Directory.Exists(stagingDir))
                 {
-                    try { Directory.Delete(extractionDir, true); _logger.Warning("Cleaned up extraction directory {ExtractionDir} for '{RuntimeName}' after error.", extractionDir, runtimeNameForPath); }
-                    catch (Exception delEx) { _logger.Error(delEx, "Failed to cleanup extraction directory {ExtractionDir} for '{RuntimeName}' after error.", extractionDir, runtimeNameForPath); }
+                    try { Directory.Delete(stagingDir, true); _logger.Warning("Cleaned up staging directory {StagingDir} for '{RuntimeName}'.", stagingDir, runtimeNameForPath); }
+                    catch (Exception delEx) { _logger.Error(delEx, "Failed to cleanup staging directory {StagingDir} for '{RuntimeName}'.", stagingDir, runtimeNameForPath); }
                 }
-                return false;
             }
         }
 
@@ -450,6 +505,18 @@ namespace ObsidianLauncher.Services
             _logger.Information("Java runtime scan complete. Found {Count} usable existing runtimes.", _availableRuntimes.Count);
         }
 
+        /// <summary>
+        /// Finds an already installed runtime matching the required component and major version. Does no I/O.
+        /// </summary>
+        /// <returns>The matching runtime, or null if one would have to be downloaded.</returns>
+        public JavaRuntimeInfo FindInstalledRuntime(JavaVersionInfo requiredJava)
+        {
+            if (requiredJava == null) return null;
+            return _availableRuntimes.FirstOrDefault(r =>
+                r.ComponentName.Equals(requiredJava.Component, StringComparison.OrdinalIgnoreCase) &&
+                r.MajorVersion == requiredJava.MajorVersion);
+        }
+
         /// <summary>
         /// Gets a list of currently known available Java runtimes.
         /// </summary>
@@ -0,0 +1,744 @@
+﻿// Services/LauncherDaemon.cs
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Net.Sockets;
+using System.Text;
+using System.Text.Encodings.Web;
+using System.Text.Json;
+using System.Text.Json.Nodes;
+using System.Text.Json.Serialization;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+using Serilog.Events;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// An install, prefetch or launch started through the daemon.
+    /// </summary>
+    public class DaemonJob
+    {
+        private readonly TaskCompletionSource<bool> _started = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+        private readonly TaskCompletionSource<bool> _finished = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+        internal DaemonJob(int id, string kind, string target, bool tracksProgress, CancellationToken daemonStopping)
+        {
+            Id = id;
+            Kind = kind;
+            Target = target;
+            Progress = tracksProgress ? new InstallProgress() : null;
+            Cancellation = CancellationTokenSource.CreateLinkedTokenSource(daemonStopping);
+        }
+
+        public int Id { get; }
+
+        /// <summary>
+        /// install, prefetch or launch.
+        /// </summary>
+        public string Kind { get; }
+
+        /// <summary>
+        /// The version, or the prefetch selectors.
+        /// </summary>
+        public string Target { get; }
+
+        public DaemonJobState State { get; internal set; } = DaemonJobState.Queued;
+        public DateTime CreatedUtc { get; } = DateTime.UtcNow;
+        public DateTime? FinishedUtc { get; private set; }
+
+        /// <summary>
+        /// Why the job failed, if it did.
+        /// </summary>
+        public string Message { get; internal set; }
+
+        /// <summary>
+        /// Exit code of the game, once a launch job's game has exited.
+        /// </summary>
+        public int? GameExitCode { get; internal set; }
+
+        /// <summary>
+        /// Install progress; null for prefetch jobs, which report only their outcome.
+        /// </summary>
+        [JsonIgnore]
+        public InstallProgress Progress { get; }
+
+        /// <summary>
+        /// Completes with true once a launch job's game process has started, or with false when the job ends without.
+        /// </summary>
+        [JsonIgnore]
+        public Task<bool> Started => _started.Task;
+
+        [JsonIgnore]
+        public Task Finished => _finished.Task;
+
+        [JsonIgnore]
+        internal CancellationTokenSource Cancellation { get; }
+
+        internal void MarkStarted() => _started.TrySetResult(true);
+
+        internal bool Fail(string message)
+        {
+            Message = message;
+            return false;
+        }
+
+        internal void Complete(DaemonJobState state)
+        {
+            State = state;
+            FinishedUtc = DateTime.UtcNow;
+            Progress?.Finish();
+            _started.TrySetResult(false);
+            _finished.TrySetResult(true);
+            Cancellation.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Long-running launcher process (<c>daemon</c>) that keeps its services warm (the parsed version manifest, the
+    /// scanned Java runtimes, the install journal's verified records, HTTP connection pools) and takes requests over a
+    /// Unix domain socket, so clients start installs and launches without paying the launcher's startup each time.
+    /// <para>
+    /// The protocol is one JSON object per line in each direction. A request is
+    /// <c>{"command":"install","args":["1.20.4"],"option":"value",...}</c>; each response line has an <c>event</c>:
+    /// <c>result</c> for plain commands, <c>accepted</c> (with the job id), <c>progress</c>, <c>started</c> and
+    /// <c>done</c> for jobs, and <c>error</c>. Requests on one connection are answered in order, and the daemon closes
+    /// the connection once the client has closed its side and the last answer is written, so
+    /// <c>echo '{"command":"status"}' | nc -NU launcher.sock</c> works as a client.
+    /// </para>
+    /// <para>
+    /// Commands: <c>status</c>, <c>list [--type=T] [--installed] [--refresh]</c>, <c>jobs</c>,
+    /// <c>install VERSION</c>, <c>launch VERSION [--instance=NAME] [--player=NAME] [--java-executable=PATH] [--wait]</c>,
+    /// <c>prefetch SELECTOR... [--no-java]</c>, <c>progress JOB</c>, <c>cancel JOB</c>,
+    /// <c>set-level [CONTEXT] LEVEL</c>, <c>metrics</c> (the Prometheus page as text) and <c>shutdown</c>.
+    /// Job commands stream progress every <c>--interval-ms=N</c> (default 500) until the job is done (a launch: until
+    /// the game has started, or with <c>--wait</c> until it exits); <c>--detach</c> answers with the job id only.
+    /// </para>
+    /// <para>
+    /// Installs, prefetches and the install part of launches run one at a time, since they share one download
+    /// scheduler and journal; a game, once started, no longer holds up the next job. Stopping the daemon cancels its
+    /// jobs, which also ends games it started. The socket is created with owner-only permissions, and anyone who can
+    /// connect to it can run installs and launches as the daemon's user.
+    /// </para>
+    /// </summary>
+    public class LauncherDaemon
+    {
+        /// <summary>
+        /// Socket file name in the data directory, used when no <c>--socket=PATH</c> is given.
+        /// </summary>
+        public const string DefaultSocketName = "launcher.sock";
+
+        /// <summary>
+        /// Finished jobs kept for <c>jobs</c> and <c>progress</c> queries; older ones are forgotten.
+        /// </summary>
+        public const int FinishedJobsKept = 50;
+
+        private static readonly TimeSpan DefaultProgressInterval = TimeSpan.FromMilliseconds(500);
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions
+        {
+            PropertyNamingPolicy = JsonNamingPolicy.CamelCase,
+            DefaultIgnoreCondition = JsonIgnoreCondition.WhenWritingNull,
+            // Answers go to a local client, not into HTML; keep quotes and backticks in messages readable.
+            Encoder = JavaScriptEncoder.UnsafeRelaxedJsonEscaping,
+            Converters = { new JsonStringEnumConverter(JsonNamingPolicy.CamelCase) }
+        };
+
+        private readonly LauncherConfig _config;
+        private readonly string _socketPath;
+        private readonly VersionCatalog _catalog;
+        private readonly InstallPlanner _planner;
+        private readonly AssetManager _assetManager;
+        private readonly JavaManager _javaManager;
+        private readonly PrefetchService _prefetchService;
+        private readonly InstallJournal _journal;
+        private readonly InstanceManager _instances;
+        private readonly VersionAccessStats _versionAccess;
+        private readonly VersionTiering _tiering;
+        private readonly ILogger _logger;
+        private readonly SemaphoreSlim _installLock = new SemaphoreSlim(1, 1);
+        private readonly ConcurrentDictionary<int, DaemonJob> _jobs = new ConcurrentDictionary<int, DaemonJob>();
+        private readonly DateTime _startedUtc = DateTime.UtcNow;
+        private CancellationTokenSource _stopping;
+        private int _nextJobId;
+
+        public LauncherDaemon(
+            LauncherConfig config,
+            string socketPath,
+            VersionCatalog catalog,
+            InstallPlanner planner,
+            AssetManager assetManager,
+            JavaManager javaManager,
+            PrefetchService prefetchService,
+            InstallJournal journal,
+            InstanceManager instances,
+            VersionAccessStats versionAccess,
+            VersionTiering tiering)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _socketPath = socketPath ?? throw new ArgumentNullException(nameof(socketPath));
+            _catalog = catalog ?? throw new ArgumentNullException(nameof(catalog));
+            _planner = planner ?? throw new ArgumentNullException(nameof(planner));
+            _assetManager = assetManager ?? throw new ArgumentNullException(nameof(assetManager));
+            _javaManager = javaManager ?? throw new ArgumentNullException(nameof(javaManager));
+            _prefetchService = prefetchService ?? throw new ArgumentNullException(nameof(prefetchService));
+            _journal = journal ?? throw new ArgumentNullException(nameof(journal));
+            _instances = instances ?? throw new ArgumentNullException(nameof(instances));
+            _versionAccess = versionAccess ?? throw new ArgumentNullException(nameof(versionAccess));
+            _tiering = tiering ?? throw new ArgumentNullException(nameof(tiering));
+            _logger = Log.ForContext<LauncherDaemon>();
+            _logger.Verbose("LauncherDaemon initialized for socket {SocketPath}.", _socketPath);
+        }
+
+        public static string GetDefaultSocketPath(LauncherConfig config) => Path.Combine(config.BaseDataPath, DefaultSocketName);
+
+        /// <summary>
+        /// Serves clients until <paramref name="cancellationToken"/> is cancelled or a client sends <c>shutdown</c>.
+        /// </summary>
+        /// <returns>False if the socket could not be opened (e.g. another daemon is serving it).</returns>
+        public async Task<bool> RunAsync(CancellationToken cancellationToken)
+        {
+            if (!await ReleaseStaleSocketAsync(cancellationToken).ConfigureAwait(false)) return false;
+
+            using var stopping = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+            _stopping = stopping;
+            using var listener = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+            try
+            {
+                BindPrivately(listener);
+                listener.Listen(16);
+            }
+            catch (Exception ex) when (ex is SocketException || ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Error(ex, "Could not listen on {SocketPath}.", _socketPath);
+                return false;
+            }
+            _logger.Information("Daemon listening on {SocketPath} (pid {ProcessId}); stop it with Ctrl+C or `ctl shutdown`.",
+                _socketPath, Environment.ProcessId);
+
+            var connections = new List<Task>();
+            try
+            {
+                while (!stopping.IsCancellationRequested)
+                {
+                    Socket client;
+                    try
+                    {
+                        client = await listener.AcceptAsync(stopping.Token).ConfigureAwait(false);
+                    }
+                    catch (OperationCanceledException)
+                    {
+                        break;
+                    }
+                    connections.RemoveAll(c => c.IsCompleted);
+                    connections.Add(Task.Run(() => ServeConnectionAsync(client, stopping.Token), CancellationToken.None));
+                }
+            }
+            finally
+            {
+                stopping.Cancel();
+                List<DaemonJob> unfinished = _jobs.Values.Where(j => !j.Finished.IsCompleted).ToList();
+                if (unfinished.Count > 0) _logger.Information("Stopping: cancelling {Count} unfinished job(s).", unfinished.Count);
+                await Task.WhenAll(unfinished.Select(j => j.Finished).Concat(connections)).ConfigureAwait(false);
+                TryDeleteSocket();
+                _logger.Information("Daemon stopped.");
+            }
+            return true;
+        }
+
+        // A socket file left behind by a daemon that crashed is removed; one that still answers belongs to a live daemon.
+        private async Task<bool> ReleaseStaleSocketAsync(CancellationToken cancellationToken)
+        {
+            if (!File.Exists(_socketPath)) return true;
+            using (var probe = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified))
+            {
+                try
+                {
+                    await probe.ConnectAsync(new UnixDomainSocketEndPoint(_socketPath), cancellationToken).ConfigureAwait(false);
+                    _logger.Error("Another daemon is already serving {SocketPath}.", _socketPath);
+                    return false;
+                }
+                catch (SocketException)
+                {
+                    // Nobody listening.
+                }
+            }
+            _logger.Information("Removing stale socket {SocketPath} left by a previous daemon.", _socketPath);
+            TryDeleteSocket();
+            return true;
+        }
+
+        // The socket file is created with the process umask. Binding it inside a 0700 staging directory and renaming it
+        // into place only once it is 0600 means no other user can ever connect to it.
+        private void BindPrivately(Socket listener)
+        {
+            if (OperatingSystem.IsWindows())
+            {
+                listener.Bind(new UnixDomainSocketEndPoint(_socketPath));
+                return;
+            }
+
+            string stagingDir = Path.Combine(Path.GetDirectoryName(Path.GetFullPath(_socketPath)), $".launcherd-{Environment.ProcessId}");
+            if (Directory.Exists(stagingDir)) Directory.Delete(stagingDir, recursive: true);
+            Directory.CreateDirectory(stagingDir, UnixFileMode.UserRead | UnixFileMode.UserWrite | UnixFileMode.UserExecute);
+            try
+            {
+                string stagingPath = Path.Combine(stagingDir, Path.GetFileName(_socketPath));
+                listener.Bind(new UnixDomainSocketEndPoint(stagingPath));
+                File.SetUnixFileMode(stagingPath, UnixFileMode.UserRead | UnixFileMode.UserWrite);
+                File.Move(stagingPath, _socketPath);
+            }
+            finally
+            {
+                Directory.Delete(stagingDir, recursive: true);
+            }
+        }
+
+        private void TryDeleteSocket()
+        {
+            try
+            {
+                File.Delete(_socketPath);
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not delete the socket {SocketPath}.", _socketPath);
+            }
+        }
+
+        private async Task ServeConnectionAsync(Socket client, CancellationToken cancellationToken)
+        {
+            try
+            {
+                using var stream = new NetworkStream(client, ownsSocket: true);
+                using var reader = new StreamReader(stream, new UTF8Encoding(false));
+                var connection = new Connection(stream);
+                string line;
+                while (!connection.Closed && (line = await reader.ReadLineAsync(cancellationToken).ConfigureAwait(false)) != null)
+                {
+                    if (string.IsNullOrWhiteSpace(line)) continue;
+                    JsonObject request;
+                    try
+                    {
+                        request = JsonNode.Parse(line) as JsonObject;
+                    }
+                    catch (JsonException)
+                    {
+                        request = null;
+                    }
+                    if (request == null)
+                    {
+                        await connection.SendAsync(Error("Each request must be a JSON object on one line."), cancellationToken).ConfigureAwait(false);
+                        continue;
+                    }
+                    await HandleRequestAsync(request, connection, cancellationToken).ConfigureAwait(false);
+                }
+            }
+            catch (OperationCanceledException)
+            {
+                // The daemon is stopping.
+            }
+            catch (Exception ex) when (ex is IOException || ex is SocketException || ex is ObjectDisposedException)
+            {
+                _logger.Verbose(ex, "Daemon client connection closed.");
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Unexpected error while serving a daemon client.");
+            }
+        }
+
+        private async Task HandleRequestAsync(JsonObject request, Connection connection, CancellationToken cancellationToken)
+        {
+            string command = (request["command"] as JsonValue)?.TryGetValue(out string name) == true ? name.ToLowerInvariant() : null;
+            _logger.Debug("Daemon request: {Request}", request.ToJsonString());
+            switch (command)
+            {
+                case "status":
+                    await connection.SendAsync(Status(), cancellationToken).ConfigureAwait(false);
+                    return;
+                case "list":
+                    await connection.SendAsync(await ListAsync(request, cancellationToken).ConfigureAwait(false), cancellationToken).ConfigureAwait(false);
+                    return;
+                case "jobs":
+                    await connection.SendAsync(new { @event = "result", command, jobs = _jobs.Values.OrderBy(j => j.Id).ToList() }, cancellationToken).ConfigureAwait(false);
+                    return;
+                case "install":
+                case "launch":
+                {
+                    string versionId = Argument(request, 0);
+                    if (versionId == null)
+                    {
+                        await connection.SendAsync(Error($"Usage: {command} VERSION"), cancellationToken).ConfigureAwait(false);
+                        return;
+                    }
+                    bool launch = command == "launch";
+                    DaemonJob job = StartJob(command, versionId, true, (j, ct) => InstallAsync(j, versionId, launch, request, ct));
+                    await FollowJobAsync(job, request, connection, cancellationToken).ConfigureAwait(false);
+                    return;
+                }
+                case "prefetch":
+                {
+                    List<string> selectors = Arguments(request);
+                    if (selectors.Count == 0)
+                    {
+                        await connection.SendAsync(Error("Usage: prefetch SELECTOR... [--no-java]"), cancellationToken).ConfigureAwait(false);
+                        return;
+                    }
+                    bool includeRuntimes = !Flag(request, "no-java");
+                    DaemonJob job = StartJob(command, string.Join(" ", selectors), false, (j, ct) => PrefetchAsync(selectors, includeRuntimes, ct));
+                    await FollowJobAsync(job, request, connection, cancellationToken).ConfigureAwait(false);
+                    return;
+                }
+                case "progress":
+                {
+                    DaemonJob job = FindJob(request);
+                    if (job == null)
+                    {
+                        await connection.SendAsync(Error("Usage: progress JOB (an id from `jobs`)"), cancellationToken).ConfigureAwait(false);
+                        return;
+                    }
+                    await StreamJobAsync(job, request, connection, cancellationToken).ConfigureAwait(false);
+                    return;
+                }
+                case "cancel":
+                {
+                    DaemonJob job = FindJob(request);
+                    if (job == null)
+                    {
+                        await connection.SendAsync(Error("Usage: cancel JOB (an id from `jobs`)"), cancellationToken).ConfigureAwait(false);
+                        return;
+                    }
+                    bool cancelled = false;
+                    if (!job.Finished.IsCompleted)
+                    {
+                        try
+                        {
+                            job.Cancellation.Cancel();
+                            cancelled = true;
+                            _logger.Information("Job {JobId} ({Kind} {Target}) cancelled by a client.", job.Id, job.Kind, job.Target);
+                        }
+                        catch (ObjectDisposedException)
+                        {
+                            // Finished in the meantime.
+                        }
+                    }
+                    await connection.SendAsync(new { @event = "result", command, job = job.Id, cancelled }, cancellationToken).ConfigureAwait(false);
+                    return;
+                }
+                case "set-level":
+                {
+                    List<string> arguments = Arguments(request);
+                    string context = arguments.Count > 1 ? arguments[0] : "*";
+                    if (arguments.Count == 0 || !Enum.TryParse(arguments[^1], true, out LogEventLevel level) || !Enum.IsDefined(level))
+                    {
+                        await connection.SendAsync(Error("Usage: set-level [CONTEXT] Verbose|Debug|Information|Warning|Error|Fatal"), cancellationToken).ConfigureAwait(false);
+                        return;
+                    }
+                    int changed = LoggerSetup.SetLevel(context, level);
+                    await connection.SendAsync(new { @event = "result", command, context, level, changed }, cancellationToken).ConfigureAwait(false);
+                    return;
+                }
+                case "metrics":
+                {
+                    var text = new StringWriter();
+                    MetricsCollector.EnsureShared().WritePrometheus(text);
+                    await connection.SendAsync(new { @event = "result", command, text = text.ToString() }, cancellationToken).ConfigureAwait(false);
+                    return;
+                }
+                case "shutdown":
+                    _logger.Information("Shutdown requested by a client.");
+                    await connection.SendAsync(new { @event = "result", command }, cancellationToken).ConfigureAwait(false);
+                    _stopping.Cancel();
+                    return;
+                default:
+                    await connection.SendAsync(Error(command == null ? "The request has no command." : $"Unknown command '{command}'."), cancellationToken).ConfigureAwait(false);
+                    return;
+            }
+        }
+
+        private object Status()
+        {
+            return new
+            {
+                @event = "result",
+                command = "status",
+                processId = Environment.ProcessId,
+                startedUtc = _startedUtc,
+                uptimeSeconds = Math.Round((DateTime.UtcNow - _startedUtc).TotalSeconds, 1),
+                dataDirectory = _config.BaseDataPath,
+                socket = _socketPath,
+                javaRuntimes = _javaManager.GetAvailableRuntimes().Count,
+                runningJobs = _jobs.Values.Count(j => !j.Finished.IsCompleted)
+            };
+        }
+
+        private async Task<object> ListAsync(JsonObject request, CancellationToken cancellationToken)
+        {
+            VersionManifest manifest = await _catalog.GetManifestAsync(Flag(request, "refresh"), cancellationToken).ConfigureAwait(false);
+            if (manifest == null) return Error("The version manifest is not available.");
+            string type = Option(request, "type");
+            bool installedOnly = Flag(request, "installed");
+            var versions = manifest.Versions
+                .Where(v => type == null || v.Type.Equals(type, StringComparison.OrdinalIgnoreCase))
+                .Select(v => new { id = v.Id, type = v.Type, releaseTime = v.ReleaseTime, installed = File.Exists(_catalog.GetVersionJsonPath(v.Id)) })
+                .Where(v => !installedOnly || v.installed)
+                .ToList();
+            return new { @event = "result", command = "list", latest = manifest.Latest, versions };
+        }
+
+        private DaemonJob StartJob(string kind, string target, bool tracksProgress, Func<DaemonJob, CancellationToken, Task<bool>> work)
+        {
+            var job = new DaemonJob(Interlocked.Increment(ref _nextJobId), kind, target, tracksProgress, _stopping.Token);
+            _jobs[job.Id] = job;
+            ForgetOldJobs();
+            _logger.Information("Job {JobId}: {Kind} {Target}", job.Id, kind, target);
+            CancellationToken token = job.Cancellation.Token;
+            _ = Task.Run(async () =>
+            {
+                DaemonJobState state;
+                try
+                {
+                    state = await work(job, token).ConfigureAwait(false) ? DaemonJobState.Succeeded : DaemonJobState.Failed;
+                }
+                catch (OperationCanceledException) when (token.IsCancellationRequested)
+                {
+                    state = DaemonJobState.Cancelled;
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Job {JobId} ({Kind} {Target}) failed unexpectedly.", job.Id, kind, target);
+                    job.Message = ex.Message;
+                    state = DaemonJobState.Failed;
+                }
+                // Persist what the journal buffered, as the one-shot launcher does on exit.
+                _journal.Flush();
+                job.Complete(state);
+                _logger.Information("Job {JobId} ({Kind} {Target}) {State}{Message}", job.Id, kind, target, state,
+                    job.Message != null ? ": " + job.Message : string.Empty);
+            }, CancellationToken.None);
+            return job;
+        }
+
+        private void ForgetOldJobs()
+        {
+            foreach (DaemonJob old in _jobs.Values.Where(j => j.Finished.IsCompleted).OrderByDescending(j => j.Id).Skip(FinishedJobsKept).ToList())
+            {
+                _jobs.TryRemove(old.Id, out _);
+            }
+        }
+
+        private DaemonJob FindJob(JsonObject request)
+        {
+            return int.TryParse(Argument(request, 0), out int id) && _jobs.TryGetValue(id, out DaemonJob job) ? job : null;
+        }
+
+        // Installs a version and, for a launch, starts the game once everything is in place, as the one-shot launcher does.
+        private async Task<bool> InstallAsync(DaemonJob job, string versionId, bool launch, JsonObject request, CancellationToken cancellationToken)
+        {
+            InstanceProfile instance = null;
+            string instanceName = Option(request, "instance");
+            if (instanceName != null)
+            {
+                instance = _instances.Get(instanceName);
+                if (instance == null) return job.Fail($"Instance '{instanceName}' does not exist.");
+            }
+
+            // Held until the install (or the game it launches) ends, so tiering leaves this version's files alone.
+            using FileLease versionInUse = await _tiering.AcquireInUseAsync(versionId, cancellationToken).ConfigureAwait(false);
+            string gameDirectory = instance != null ? _instances.GetGameDirectory(instance.Name) : Path.GetFullPath(_config.BaseDataPath);
+            MinecraftVersion version;
+            InstallPlan plan;
+            InstallResult result;
+            string assetsDirectory = null;
+            await _installLock.WaitAsync(cancellationToken).ConfigureAwait(false);
+            try
+            {
+                job.State = DaemonJobState.Running;
+                VersionManifest manifest = await _catalog.GetManifestAsync(cancellationToken: cancellationToken).ConfigureAwait(false);
+                if (manifest == null) return job.Fail("The version manifest is not available.");
+                VersionMetadata versionMeta = manifest.Versions.FirstOrDefault(v => v.Id == versionId);
+                if (versionMeta == null) return job.Fail($"Version '{versionId}' is not in the version manifest.");
+                version = await _catalog.GetVersionAsync(versionMeta, cancellationToken).ConfigureAwait(false);
+                if (version == null) return job.Fail($"Could not read the details of version '{versionId}'.");
+
+                if (_tiering.IsPacked(version.Id)) await _tiering.RehydrateAsync(version.Id, cancellationToken).ConfigureAwait(false);
+                plan = await _planner.CreatePlanAsync(version, cancellationToken).ConfigureAwait(false);
+                if (plan == null) return job.Fail($"Could not build an install plan for version '{versionId}'.");
+                result = await _planner.ExecuteAsync(plan, job.Progress, cancellationToken).ConfigureAwait(false);
+                cancellationToken.ThrowIfCancellationRequested();
+                if (!result.Success) return job.Fail($"Install of version '{versionId}' failed; see the daemon's log.");
+
+                // Legacy asset layouts are written into shared directories, so they are laid out under the install lock too.
+                if (launch)
+                {
+                    assetsDirectory = _assetManager.MaterializeLegacyAssets(version, gameDirectory);
+                    if (assetsDirectory == null) return job.Fail($"Could not lay out the legacy assets of version '{versionId}'.");
+                }
+            }
+            finally
+            {
+                _installLock.Release();
+            }
+            if (!launch) return true;
+
+            // ArgumentBuilder holds per-launch settings, so each launch gets its own.
+            var argumentBuilder = new ArgumentBuilder(_config);
+            string classpath = argumentBuilder.BuildClasspath(plan.ClientJarPath, result.LibraryClasspath);
+            argumentBuilder.SetOfflinePlayerName(Option(request, "player") ?? "Player123");
+            if (instance != null) argumentBuilder.SetGameDirectory(gameDirectory);
+            argumentBuilder.SetGameAssetsDirectory(assetsDirectory);
+            List<string> jvmArgs = argumentBuilder.BuildJvmArguments(version, classpath, Path.GetFullPath(plan.NativesDirectory), result.Runtime);
+            List<string> gameArgs = argumentBuilder.BuildGameArguments(version);
+
+            string javaExecutable = result.Runtime.JavaExecutablePath;
+            string javaOverride = Option(request, "java-executable");
+            if (javaOverride != null)
+            {
+                if (!File.Exists(javaOverride)) return job.Fail($"The java executable '{javaOverride}' does not exist.");
+                javaExecutable = Path.GetFullPath(javaOverride);
+            }
+
+            _versionAccess.RecordLaunch(version.Id);
+            if (instance != null) _instances.RecordLaunch(instance.Name);
+            int exitCode = await new GameLauncher(_config).LaunchAsync(javaExecutable, jvmArgs, version.MainClass, gameArgs, gameDirectory,
+                onStarted: job.MarkStarted, cancellationToken: cancellationToken).ConfigureAwait(false);
+            job.GameExitCode = exitCode;
+            cancellationToken.ThrowIfCancellationRequested();
+            return job.Started.IsCompleted || job.Fail("The game process could not be started.");
+        }
+
+        private async Task<bool> PrefetchAsync(List<string> selectors, bool includeRuntimes, CancellationToken cancellationToken)
+        {
+            await _installLock.WaitAsync(cancellationToken).ConfigureAwait(false);
+            try
+            {
+                return await _prefetchService.PrefetchAsync(selectors, includeRuntimes, cancellationToken).ConfigureAwait(false);
+            }
+            finally
+            {
+                _installLock.Release();
+            }
+        }
+
+        private async Task FollowJobAsync(DaemonJob job, JsonObject request, Connection connection, CancellationToken cancellationToken)
+        {
+            if (!await connection.SendAsync(new { @event = "accepted", job = job.Id, kind = job.Kind, target = job.Target }, cancellationToken).ConfigureAwait(false)) return;
+            if (Flag(request, "detach")) return;
+            await StreamJobAsync(job, request, connection, cancellationToken).ConfigureAwait(false);
+        }
+
+        // Progress until the install is done, then for a launch "started" (and "done" once the game exits, with --wait),
+        // otherwise "done". A client that goes away only stops the stream; the job carries on.
+        private async Task StreamJobAsync(DaemonJob job, JsonObject request, Connection connection, CancellationToken cancellationToken)
+        {
+            TimeSpan interval = DefaultProgressInterval;
+            if (int.TryParse(Option(request, "interval-ms"), out int intervalMs) && intervalMs > 0) interval = TimeSpan.FromMilliseconds(intervalMs);
+
+            if (job.Progress != null)
+            {
+                await foreach (InstallProgressSnapshot snapshot in job.Progress.WatchAsync(interval, cancellationToken).ConfigureAwait(false))
+                {
+                    if (!await connection.SendAsync(ProgressEvent(job, snapshot), cancellationToken).ConfigureAwait(false)) return;
+                }
+            }
+
+            if (job.Kind == "launch" && await job.Started.WaitAsync(cancellationToken).ConfigureAwait(false))
+            {
+                if (!await connection.SendAsync(new { @event = "started", job = job.Id, target = job.Target }, cancellationToken).ConfigureAwait(false)) return;
+                if (!Flag(request, "wait")) return;
+            }
+            await job.Finished.WaitAsync(cancellationToken).ConfigureAwait(false);
+            await connection.SendAsync(new { @event = "done", job = job.Id, state = job.State, message = job.Message, gameExitCode = job.GameExitCode },
+                cancellationToken).ConfigureAwait(false);
+        }
+
+        private static object ProgressEvent(DaemonJob job, in InstallProgressSnapshot snapshot)
+        {
+            return new
+            {
+                @event = "progress",
+                job = job.Id,
+                phase = snapshot.CurrentPhase,
+                fraction = Math.Round(snapshot.Fraction, 4),
+                bytesDone = snapshot.BytesDone,
+                bytesTotal = snapshot.BytesTotal,
+                itemsDone = snapshot.ItemsDone,
+                itemsFailed = snapshot.ItemsFailed,
+                itemsTotal = snapshot.ItemsTotal,
+                bytesPerSecond = Math.Round(snapshot.BytesPerSecond),
+                etaSeconds = snapshot.Eta.HasValue ? Math.Round(snapshot.Eta.Value.TotalSeconds, 1) : (double?)null,
+                finished = snapshot.IsFinished
+            };
+        }
+
+        private static object Error(string message) => new { @event = "error", message };
+
+        private static List<string> Arguments(JsonObject request)
+        {
+            return request["args"] is JsonArray array
+                ? array.Select(a => (a as JsonValue)?.TryGetValue(out string s) == true ? s : a?.ToJsonString()).Where(s => s != null).ToList()
+                : new List<string>();
+        }
+
+        private static string Argument(JsonObject request, int index)
+        {
+            List<string> arguments = Arguments(request);
+            return index < arguments.Count ? arguments[index] : null;
+        }
+
+        private static string Option(JsonObject request, string name)
+        {
+            return request[name] is JsonValue value && value.TryGetValue(out string text) ? text : null;
+        }
+
+        // A flag is true when given as true (or as any string but "false").
+        private static bool Flag(JsonObject request, string name)
+        {
+            if (request[name] is not JsonValue value) return false;
+            if (value.TryGetValue(out bool flag)) return flag;
+            return value.TryGetValue(out string text) && !text.Equals("false", StringComparison.OrdinalIgnoreCase);
+        }
+
+        /// <summary>
+        /// Writes response lines to one client; stops writing once the client has gone away.
+        /// </summary>
+        private sealed class Connection
+        {
+            private static readonly byte[] NewLine = { (byte)'\n' };
+
+            private readonly Stream _stream;
+
+            public Connection(Stream stream)
+            {
+                _stream = stream;
+            }
+
+            public bool Closed { get; private set; }
+
+            public async Task<bool> SendAsync(object message, CancellationToken cancellationToken)
+            {
+                if (Closed) return false;
+                byte[] json = JsonSerializer.SerializeToUtf8Bytes(message, JsonOptions);
+                try
+                {
+                    await _stream.WriteAsync(json, cancellationToken).ConfigureAwait(false);
+                    await _stream.WriteAsync(NewLine, cancellationToken).ConfigureAwait(false);
+                    await _stream.FlushAsync(cancellationToken).ConfigureAwait(false);
+                    return true;
+                }
+                catch (IOException)
+                {
+                    Closed = true;
+                    return false;
+                }
+            }
+        }
+    }
+}
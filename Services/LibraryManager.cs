@@ -1,6 +1,8 @@
 ﻿// Services/LibraryManager.cs
 using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
 using System.IO.Compression; // For ZipFile and ZipArchive
 using System.Linq;
@@ -12,6 +14,7 @@ using ObsidianLauncher.Models;
 using ObsidianLauncher.Utils;
 using ObsidianLauncher.Enums;
 using Serilog;
+using Serilog.Events;
 
 namespace ObsidianLauncher.Services
 {
@@ -19,12 +22,14 @@ namespace ObsidianLauncher.Services
     {
         private readonly LauncherConfig _config;
         private readonly HttpManager _httpManager;
+        private readonly DownloadScheduler _scheduler;
         private readonly ILogger _logger;
 
-        public LibraryManager(LauncherConfig config, HttpManager httpManager)
+        public LibraryManager(LauncherConfig config, HttpManager httpManager, DownloadScheduler scheduler = null)
         {
             _config = config ?? throw new ArgumentNullException(nameof(config));
             _httpManager = httpManager ?? throw new ArgumentNullException(nameof(httpManager));
+            _scheduler = scheduler ?? new DownloadScheduler(httpManager);
             _logger = Log.ForContext<LibraryManager>();
             _logger.Verbose("LibraryManager initialized.");
         }
@@ -51,137 +56,119 @@ namespace ObsidianLauncher.Services
 
             _logger.Information("Processing {Count} library entries for version {VersionId}...", mcVersion.Libraries.Count, mcVersion.Id);
             Directory.CreateDirectory(_config.LibrariesDir); // Ensure base libraries directory exists
+
+            // 1. Resolve what every applicable library needs, then download all of it in one concurrent batch.
+            //    Extraction and classpath ordering happen afterwards, in library order.
+            List<ResolvedLibrary> resolvedLibraries = ResolveLibraries(mcVersion);
+            var downloadResults = new ConcurrentDictionary<string, bool>();
+            await _scheduler.RunAsync(
+                resolvedLibraries.SelectMany(r => r.WorkItems),
+                (item, success) => downloadResults[item.Key] = success,
+                cancellationToken: cancellationToken).ConfigureAwait(false);
+
+            return CompleteLibraries(mcVersion, resolvedLibraries, downloadResults, nativesDir, progress, cancellationToken);
+        }
+
+        /// <summary>
+        /// Second half of library processing, once the files are on disk: builds the classpath in library order
+        /// and extracts natives. Shared by <see cref="EnsureLibrariesAsync"/> and install plan execution.
+        /// </summary>
+        /// <param name="mcVersion">The Minecraft version details.</param>
+        /// <param name="resolvedLibraries">The result of <see cref="ResolveLibraries"/> for the version.</param>
+        /// <param name="downloadResults">Per-file outcome keyed by <see cref="InstallWorkItem.Key"/>.</param>
+        /// <param name="nativesDir">The directory where native libraries should be extracted.</param>
+        /// <param name="progress">Optional progress reporter.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>The library classpath entries, or null if any applicable library failed.</returns>
+        internal List<string> CompleteLibraries(
+            MinecraftVersion mcVersion,
+            List<ResolvedLibrary> resolvedLibraries,
+            IReadOnlyDictionary<string, bool> downloadResults,
+            string nativesDir,
+            IProgress<LibraryProcessingProgress> progress,
+            CancellationToken cancellationToken)
+        {
+            using Activity activity = LauncherTracing.Start("libraries.complete");
+            activity?.SetTag("libraries", resolvedLibraries.Count);
             Directory.CreateDirectory(nativesDir);     // Ensure natives directory exists
 
             var classpathEntries = new List<string>();
-            int totalLibraries = mcVersion.Libraries.Count;
+            int totalLibraries = mcVersion.Libraries?.Count ?? 0;
             int processedLibraries = 0;
             int successfullyProcessedLibraries = 0;
 
-            // Could use Task.WhenAll for concurrency, but library processing often has interdependencies
-            // or might be fine sequentially unless there are many independent large downloads.
-            // For simplicity, processing sequentially first. Can be parallelized later if needed.
-            foreach (var library in mcVersion.Libraries)
+            int applicableCount = resolvedLibraries.Count;
+            var resolvedByLibrary = resolvedLibraries.ToDictionary(r => r.Library); // Reference equality on Library
+            foreach (var library in mcVersion.Libraries ?? new List<Library>())
             {
                 cancellationToken.ThrowIfCancellationRequested();
                 processedLibraries++;
-                ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, "Checking applicability...");
 
-                if (!IsLibraryApplicable(library))
+                if (!resolvedByLibrary.TryGetValue(library, out ResolvedLibrary resolved))
                 {
                     _logger.Verbose("Skipping library (not applicable by rules): {LibraryName}", library.Name);
-                    ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, "Skipped (Rules)");
+                    ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, LibraryProcessingStatus.Skipped);
                     continue;
                 }
 
                 _logger.Verbose("Processing library: {LibraryName}", library.Name);
 
-                // 1. Handle main artifact
+                // 2. Handle main artifact
                 bool mainArtifactOk = true;
-                if (library.Downloads?.Artifact != null)
+                if (resolved.Artifact != null)
                 {
-                    var artifact = library.Downloads.Artifact;
-                    string artifactLocalPath = Path.Combine(_config.LibrariesDir, artifact.Path.Replace('/', Path.DirectorySeparatorChar));
-
-                    ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, $"Ensuring artifact: {Path.GetFileName(artifactLocalPath)}");
-                    mainArtifactOk = await DownloadAndVerifyFileAsync(
-                        artifact.Url,
-                        artifactLocalPath,
-                        artifact.Sha1,
-                        $"Library artifact {library.Name}",
-                        cancellationToken,
-                        artifact.Size
-                    );
-
+                    mainArtifactOk = downloadResults.TryGetValue(resolved.Artifact.Key, out bool ok) && ok;
                     if (mainArtifactOk)
                     {
-                        classpathEntries.Add(Path.GetFullPath(artifactLocalPath)); // Add to classpath
-                        _logger.Verbose("Main artifact for {LibraryName} is ready at {Path}", library.Name, artifactLocalPath);
+                        classpathEntries.Add(Path.GetFullPath(resolved.Artifact.LocalPath)); // Add to classpath
+                        _logger.Verbose("Main artifact for {LibraryName} is ready at {Path}", library.Name, resolved.Artifact.LocalPath);
                     }
                     else
                     {
-                        _logger.Error("Failed to ensure main artifact for library {LibraryName}. Path: {Path}", library.Name, artifactLocalPath);
-                        // Decide if this is a critical failure or if we can continue
-                        // For now, let's assume it's critical for this library.
+                        _logger.Error("Failed to ensure main artifact for library {LibraryName}. Path: {Path}", library.Name, resolved.Artifact.LocalPath);
                     }
                 }
-                else if (library.Downloads?.Classifiers == null || !library.Downloads.Classifiers.Any())
-                {
-                     _logger.Verbose("Library {LibraryName} has no specified artifact or classifiers in downloads. Assuming it's a conditional/platform-specific parent or already provided.", library.Name);
-                    // This library might be a "parent" POM or only provide natives.
-                }
-
 
-                // 2. Handle natives
+                // 3. Handle natives
                 bool nativesOk = true;
-                if (mainArtifactOk && library.Natives != null && library.Natives.Any())
+                if (mainArtifactOk && resolved.Native != null)
                 {
-                    string osName = GetCurrentOsNameForNatives();
-                    if (library.Natives.TryGetValue(osName, out string nativeClassifierKey))
+                    bool nativeJarDownloaded = downloadResults.TryGetValue(resolved.Native.Key, out bool ok) && ok;
+                    if (nativeJarDownloaded)
                     {
-                        if (library.Downloads?.Classifiers != null &&
-                            library.Downloads.Classifiers.TryGetValue(nativeClassifierKey, out LibraryArtifact nativeArtifact))
+                        _logger.Information("Extracting natives for {LibraryName} from {NativeJarPath} to {NativesDir}",
+                            library.Name, resolved.Native.LocalPath, nativesDir);
+                        ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, LibraryProcessingStatus.ExtractingNatives);
+                        nativesOk = ExtractNativeJar(resolved.Native.LocalPath, nativesDir, library.Extract);
+                        if (!nativesOk)
                         {
-                            string nativeJarLocalPath = Path.Combine(_config.LibrariesDir, nativeArtifact.Path.Replace('/', Path.DirectorySeparatorChar));
-                            ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, $"Ensuring native: {nativeClassifierKey}");
-
-                            bool nativeJarDownloaded = await DownloadAndVerifyFileAsync(
-                                nativeArtifact.Url,
-                                nativeJarLocalPath,
-                                nativeArtifact.Sha1,
-                                $"Native library {library.Name} ({nativeClassifierKey})",
-                                cancellationToken,
-                                nativeArtifact.Size
-                            );
-
-                            if (nativeJarDownloaded)
-                            {
-                                _logger.Information("Extracting natives for {LibraryName} from {NativeJarPath} to {NativesDir}",
-                                    library.Name, nativeJarLocalPath, nativesDir);
-                                ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, $"Extracting native: {nativeClassifierKey}");
-                                nativesOk = ExtractNativeJar(nativeJarLocalPath, nativesDir, library.Extract);
-                                if (!nativesOk)
-                                {
-                                    _logger.Error("Failed to extract natives for library {LibraryName} from {NativeJarPath}", library.Name, nativeJarLocalPath);
-                                }
-                                else
-                                {
-                                     _logger.Verbose("Natives for {LibraryName} extracted successfully.", library.Name);
-                                }
-                            }
-                            else
-                            {
-                                _logger.Error("Failed to ensure native JAR for library {LibraryName} ({NativeClassifierKey})", library.Name, nativeClassifierKey);
-                                nativesOk = false;
-                            }
+                            _logger.Error("Failed to extract natives for library {LibraryName} from {NativeJarPath}", library.Name, resolved.Native.LocalPath);
                         }
                         else
                         {
-                            _logger.Warning("Native classifier '{NativeClassifierKey}' specified for OS '{OsName}' in library {LibraryName}, but no corresponding download found in classifiers.",
-                                nativeClassifierKey, osName, library.Name);
-                            // This might not be an error if the main artifact itself contains natives for some OSes,
-                            // but usually, if `natives` map is present, a classifier is expected.
+                             _logger.Verbose("Natives for {LibraryName} extracted successfully.", library.Name);
                         }
                     }
                     else
                     {
-                        _logger.Verbose("No specific native classifier for current OS '{OsName}' in library {LibraryName}.", osName, library.Name);
+                        _logger.Error("Failed to ensure native JAR for library {LibraryName} ({NativeClassifierKey})", library.Name, resolved.NativeClassifier);
+                        nativesOk = false;
                     }
                 }
 
                 if (mainArtifactOk && nativesOk) // Only count as successful if both main (if any) and natives (if any) are okay
                 {
                     successfullyProcessedLibraries++;
-                    ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, "Processed successfully");
+                    ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, LibraryProcessingStatus.Processed);
                 }
                 else
                 {
-                     ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, "Processing failed");
+                     ReportLibraryProgress(progress, library.Name, processedLibraries, totalLibraries, LibraryProcessingStatus.Failed);
                     // If one library fails, should we stop the whole process? For now, we continue but report overall failure.
                 }
             }
 
-            bool allSucceeded = successfullyProcessedLibraries == mcVersion.Libraries.Count(IsLibraryApplicable);
+            bool allSucceeded = successfullyProcessedLibraries == applicableCount;
             if (allSucceeded)
             {
                 _logger.Information("All {SuccessfullyProcessedCount} applicable libraries for version {VersionId} processed successfully.",
@@ -190,15 +177,98 @@ namespace ObsidianLauncher.Services
             else
             {
                 _logger.Error("{FailedCount} out of {ApplicableCount} applicable libraries failed to process for version {VersionId}.",
-                    mcVersion.Libraries.Count(IsLibraryApplicable) - successfullyProcessedLibraries,
-                    mcVersion.Libraries.Count(IsLibraryApplicable), mcVersion.Id);
+                    applicableCount - successfullyProcessedLibraries, applicableCount, mcVersion.Id);
                 return null; // Indicate a critical failure in library setup
             }
 
             return classpathEntries;
         }
 
-        private bool IsLibraryApplicable(Library library)
+        /// <summary>
+        /// Resolves the library artifacts and native JARs a version needs on this OS, without downloading anything.
+        /// </summary>
+        /// <param name="mcVersion">The Minecraft version details.</param>
+        /// <returns>Work items for every applicable artifact and native classifier JAR.</returns>
+        public List<InstallWorkItem> CollectLibraryWorkItems(MinecraftVersion mcVersion)
+        {
+            return ResolveLibraries(mcVersion).SelectMany(r => r.WorkItems).ToList();
+        }
+
+        /// <summary>
+        /// Resolves which libraries apply on this OS and the files each one needs. Performs no I/O.
+        /// </summary>
+        internal List<ResolvedLibrary> ResolveLibraries(MinecraftVersion mcVersion)
+        {
+            var resolvedLibraries = new List<ResolvedLibrary>();
+            if (mcVersion.Libraries == null) return resolvedLibraries;
+
+            string osName = GetCurrentOsNameForNatives();
+            foreach (var library in mcVersion.Libraries)
+            {
+                if (!IsLibraryApplicable(library))
+                {
+                    continue;
+                }
+
+                var resolved = new ResolvedLibrary { Library = library };
+
+                if (library.Downloads?.Artifact != null)
+                {
+                    var artifact = library.Downloads.Artifact;
+                    resolved.Artifact = new InstallWorkItem
+                    {
+                        Kind = InstallWorkKind.Library,
+                        Url = artifact.Url,
+                        LocalPath = Path.Combine(_config.LibrariesDir, artifact.Path.Replace('/', Path.DirectorySeparatorChar)),
+                        Sha1 = artifact.Sha1,
+                        Size = artifact.Size,
+                        Description = $"Library artifact {library.Name}"
+                    };
+                }
+                else if (library.Downloads?.Classifiers == null || !library.Downloads.Classifiers.Any())
+                {
+                     _logger.Verbose("Library {LibraryName} has no specified artifact or classifiers in downloads. Assuming it's a conditional/platform-specific parent or already provided.", library.Name);
+                    // This library might be a "parent" POM or only provide natives.
+                }
+
+                if (library.Natives != null && library.Natives.Any())
+                {
+                    if (library.Natives.TryGetValue(osName, out string nativeClassifierKey))
+                    {
+                        if (library.Downloads?.Classifiers != null &&
+                            library.Downloads.Classifiers.TryGetValue(nativeClassifierKey, out LibraryArtifact nativeArtifact))
+                        {
+                            resolved.NativeClassifier = nativeClassifierKey;
+                            resolved.Native = new InstallWorkItem
+                            {
+                                Kind = InstallWorkKind.NativeLibrary,
+                                Url = nativeArtifact.Url,
+                                LocalPath = Path.Combine(_config.LibrariesDir, nativeArtifact.Path.Replace('/', Path.DirectorySeparatorChar)),
+                                Sha1 = nativeArtifact.Sha1,
+                                Size = nativeArtifact.Size,
+                                Description = $"Native library {library.Name} ({nativeClassifierKey})"
+                            };
+                        }
+                        else
+                        {
+                            _logger.Warning("Native classifier '{NativeClassifierKey}' specified for OS '{OsName}' in library {LibraryName}, but no corresponding download found in classifiers.",
+                                nativeClassifierKey, osName, library.Name);
+                            // This might not be an error if the main artifact itself contains natives for some OSes,
+                            // but usually, if `natives` map is present, a classifier is expected.
+                        }
+                    }
+                    else
+                    {
+                        _logger.Verbose("No specific native classifier for current OS '{OsName}' in library {LibraryName}.", osName, library.Name);
+                    }
+                }
+
+                resolvedLibraries.Add(resolved);
+            }
+            return resolvedLibraries;
+        }
+
+        internal bool IsLibraryApplicable(Library library)
         {
             if (library.Rules == null || !library.Rules.Any())
             {
@@ -295,11 +365,16 @@ namespace ObsidianLauncher.Services
             }
         }
 
-        private bool ExtractNativeJar(string nativeJarPath, string nativesDir, LibraryExtractRule extractRule)
+        internal bool ExtractNativeJar(string nativeJarPath, string nativesDir, LibraryExtractRule extractRule)
         {
+            using Activity activity = LauncherTracing.Start("extract.natives");
+            activity?.SetTag("jar", Path.GetFileName(nativeJarPath));
+            long started = Stopwatch.GetTimestamp();
             try
             {
                 using ZipArchive archive = ZipFile.OpenRead(nativeJarPath);
+                int extracted = 0;
+                long extractedBytes = 0;
                 foreach (ZipArchiveEntry entry in archive.Entries)
                 {
                     if (extractRule?.Exclude != null)
@@ -317,7 +392,7 @@ namespace ObsidianLauncher.Services
                         }
                         if (excluded)
                         {
-                            _logger.Verbose("Excluding native entry due to rule: {EntryFullName}", entry.FullName);
+                            if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Excluding native entry due to rule: {EntryFullName}", entry.FullName);
                             continue;
                         }
                     }
@@ -337,99 +412,27 @@ namespace ObsidianLauncher.Services
                         Directory.CreateDirectory(entryDirectory);
                     }
 
-                    _logger.Verbose("Extracting native: {EntryFullName} to {DestinationPath}", entry.FullName, destinationPath);
-                    entry.ExtractToFile(destinationPath, true); // true to overwrite
+                    if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Extracting native: {EntryFullName} to {DestinationPath}", entry.FullName, destinationPath);
+                    AtomicFile.ExtractEntry(entry, destinationPath); // Replaces any existing file in one rename
+                    extracted++;
+                    extractedBytes += entry.Length;
                 }
+                activity?.SetTag("entries", extracted);
+                activity?.SetTag("bytes", extractedBytes);
+                LauncherMetrics.RecordExtraction("natives", extractedBytes, started);
                 _logger.Information("Successfully extracted natives from {NativeJarPath}", nativeJarPath);
                 return true;
             }
             catch (Exception ex)
             {
                 _logger.Error(ex, "Failed to extract native JAR: {NativeJarPath}", nativeJarPath);
+                activity?.SetStatus(ActivityStatusCode.Error, ex.Message);
                 return false;
             }
         }
 
 
-        // This helper is identical to the one in AssetManager, consider moving to a shared utility
-        // or making AssetManager's version public static if appropriate.
-        private async Task<bool> DownloadAndVerifyFileAsync(
-            string url, string localPath, string expectedSha1, string fileDescription,
-            CancellationToken cancellationToken, ulong? expectedSize = null)
-        {
-            _logger.Verbose("Ensuring file: {Description} -> {LocalPath} from {Url}", fileDescription, localPath, url);
-            FileInfo fileInfo = new FileInfo(localPath);
-
-            if (fileInfo.Exists)
-            {
-                if (expectedSize.HasValue && fileInfo.Length != (long)expectedSize.Value)
-                {
-                    _logger.Warning("File {Description} exists at {LocalPath} but size mismatch. Expected: {ExpectedSize}, Actual: {ActualSize}. Re-downloading.",
-                        fileDescription, localPath, expectedSize.Value, fileInfo.Length);
-                }
-                else if (!string.IsNullOrEmpty(expectedSha1))
-                {
-                    _logger.Verbose("Verifying SHA1 for existing file: {LocalPath}", localPath);
-                    string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(localPath, cancellationToken);
-                    if (cancellationToken.IsCancellationRequested) return false;
-                    if (actualSha1 != null && actualSha1.Equals(expectedSha1, StringComparison.OrdinalIgnoreCase))
-                    {
-                        _logger.Verbose("SHA1 match for existing file: {LocalPath}. No download needed.", localPath);
-                        return true;
-                    }
-                    _logger.Warning("SHA1 mismatch for existing file {Description} at {LocalPath}. Expected: {ExpectedSha1}, Actual: {ActualSha1}. Re-downloading.",
-                        fileDescription, localPath, expectedSha1, actualSha1 ?? "N/A");
-                }
-                else
-                {
-                    _logger.Verbose("File {Description} exists and no SHA1 provided for verification, or size matches. Assuming valid: {LocalPath}", fileDescription, localPath);
-                    return true;
-                }
-                 try { fileInfo.Delete(); } catch(Exception ex) { _logger.Error(ex, "Failed to delete mismatched file {LocalPath} before re-download.", localPath); return false; }
-            }
-
-            _logger.Verbose("Downloading {Description}: {Url} -> {LocalPath}", fileDescription, url, localPath);
-            string directory = Path.GetDirectoryName(localPath);
-            if (!string.IsNullOrEmpty(directory) && !Directory.Exists(directory)) Directory.CreateDirectory(directory);
-
-            var (response, downloadedFilePath) = await _httpManager.DownloadAsync(url, localPath, null, cancellationToken);
-            if (cancellationToken.IsCancellationRequested) { DeletePartialFile(downloadedFilePath, "Download Canceled", fileDescription); return false; }
-            if (!response.IsSuccessStatusCode)
-            {
-                _logger.Error("Failed to download {Description} from {Url}. Status: {StatusCode}. File: {LocalPath}",
-                    fileDescription, url, response.StatusCode, localPath);
-                DeletePartialFile(downloadedFilePath, $"HTTP Error {response.StatusCode}", fileDescription);
-                return false;
-            }
-            _logger.Verbose("Download complete for {Description}: {LocalPath}", fileDescription, localPath);
-
-            if (!string.IsNullOrEmpty(expectedSha1))
-            {
-                _logger.Verbose("Verifying SHA1 for downloaded file: {LocalPath}", localPath);
-                string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(localPath, cancellationToken);
-                if (cancellationToken.IsCancellationRequested) { DeletePartialFile(localPath, "Verification Canceled", fileDescription); return false; }
-                if (actualSha1 == null || !actualSha1.Equals(expectedSha1, StringComparison.OrdinalIgnoreCase))
-                {
-                    _logger.Error("SHA1 mismatch after downloading {Description} to {LocalPath}. Expected: {ExpectedSha1}, Actual: {ActualSha1}",
-                        fileDescription, localPath, expectedSha1, actualSha1 ?? "N/A");
-                    DeletePartialFile(localPath, "SHA1 Mismatch", fileDescription);
-                    return false;
-                }
-                _logger.Verbose("SHA1 verified for downloaded file: {LocalPath}", localPath);
-            }
-            return true;
-        }
-
-        private void DeletePartialFile(string filePath, string reason, string fileDescription)
-        {
-            if (File.Exists(filePath))
-            {
-                try { File.Delete(filePath); _logger.Warning("Deleted file {Description} ({FilePath}) due to: {Reason}", fileDescription, filePath, reason); }
-                catch (Exception ex) { _logger.Error(ex, "Failed to delete file {Description} ({FilePath}) after error ({Reason})", fileDescription, filePath, reason); }
-            }
-        }
-
-         private void ReportLibraryProgress(IProgress<LibraryProcessingProgress> progress, string libraryName, int processed, int total, string status)
+         private void ReportLibraryProgress(IProgress<LibraryProcessingProgress> progress, string libraryName, int processed, int total, LibraryProcessingStatus status)
         {
             progress?.Report(new LibraryProcessingProgress
             {
@@ -442,13 +445,33 @@ namespace ObsidianLauncher.Services
     }
 
     /// <summary>
-    /// Progress report structure for library processing.
+    /// Progress report structure for library processing. A value type, so reporting allocates nothing.
+    /// </summary>
+    public readonly struct LibraryProcessingProgress
+    {
+        public string CurrentLibraryName { get; init; }
+        public int ProcessedLibraries { get; init; }
+        public int TotalLibraries { get; init; }
+        public LibraryProcessingStatus Status { get; init; }
+    }
+
+    /// <summary>
+    /// The download work an applicable library resolves to on the current OS.
     /// </summary>
-    public class LibraryProcessingProgress
+    internal class ResolvedLibrary
     {
-        public string CurrentLibraryName { get; set; }
-        public int ProcessedLibraries { get; set; }
-        public int TotalLibraries { get; set; }
-        public string Status { get; set; } // e.g., "Downloading", "Verifying", "Extracting", "Skipped"
+        public Library Library { get; set; }
+        public InstallWorkItem Artifact { get; set; }
+        public InstallWorkItem Native { get; set; }
+        public string NativeClassifier { get; set; }
+
+        public IEnumerable<InstallWorkItem> WorkItems
+        {
+            get
+            {
+                if (Artifact != null) yield return Artifact;
+                if (Native != null) yield return Native;
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+﻿// Services/LoggingBenchmark.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+using Serilog.Events;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Result of the install check at one log level.
+    /// </summary>
+    public class LoggingBenchmarkResult
+    {
+        public LogEventLevel Level { get; set; }
+
+        /// <summary>
+        /// Median wall time of the runs.
+        /// </summary>
+        public TimeSpan Elapsed { get; set; }
+
+        /// <summary>
+        /// Log events written per run.
+        /// </summary>
+        public long Events { get; set; }
+    }
+
+    /// <summary>
+    /// Measures what logging costs an install: the install check of an installed version (every file through
+    /// <see cref="DownloadScheduler.RunAsync"/>, nothing left to download) runs alternately with every logging context
+    /// at <see cref="LogEventLevel.Verbose"/> and at <see cref="LogEventLevel.Information"/>, and the difference is
+    /// reported as a share of the Verbose run's time. Journal and page cache are warmed by a discarded run first.
+    /// <para>
+    /// Levels are changed through <see cref="LoggerSetup.SetLevel"/> and put back to the root level afterwards, so
+    /// per-context levels set earlier in the same process are not restored.
+    /// </para>
+    /// </summary>
+    public class LoggingBenchmark
+    {
+        private readonly DownloadScheduler _scheduler;
+        private readonly ILogger _logger;
+
+        public LoggingBenchmark(DownloadScheduler scheduler)
+        {
+            _scheduler = scheduler ?? throw new ArgumentNullException(nameof(scheduler));
+            _logger = Log.ForContext<LoggingBenchmark>();
+            _logger.Verbose("LoggingBenchmark initialized.");
+        }
+
+        /// <summary>
+        /// Runs the comparison and logs it.
+        /// </summary>
+        /// <param name="items">Work items of an installed version.</param>
+        /// <param name="repetitions">Runs per level; the median is reported.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public async Task<List<LoggingBenchmarkResult>> RunAsync(IReadOnlyList<InstallWorkItem> items, int repetitions = 5, CancellationToken cancellationToken = default)
+        {
+            if (items == null) throw new ArgumentNullException(nameof(items));
+            if (repetitions < 1) repetitions = 1;
+
+            DownloadRunSummary warmup = await _scheduler.RunAsync(items, cancellationToken: cancellationToken).ConfigureAwait(false);
+            if (warmup.Downloaded > 0 || warmup.Failed > 0)
+            {
+                _logger.Warning("Logging benchmark: the version was not fully installed ({Downloaded} downloaded, {Failed} failed); results include only the check.",
+                    warmup.Downloaded, warmup.Failed);
+            }
+
+            LogEventLevel originalLevel = LoggerSetup.GetLevel("*");
+            var levels = new[] { LogEventLevel.Verbose, LogEventLevel.Information };
+            var times = levels.ToDictionary(l => l, _ => new List<TimeSpan>());
+            var events = levels.ToDictionary(l => l, _ => 0L);
+            try
+            {
+                for (int run = 0; run < repetitions; run++)
+                {
+                    // Alternate the levels so drift (thermal, background I/O) affects both alike.
+                    foreach (LogEventLevel level in levels)
+                    {
+                        cancellationToken.ThrowIfCancellationRequested();
+                        LoggerSetup.SetLevel("*", level);
+                        long eventsBefore = LoggerSetup.EventsWritten;
+                        var stopwatch = Stopwatch.StartNew();
+                        await _scheduler.RunAsync(items, cancellationToken: cancellationToken).ConfigureAwait(false);
+                        stopwatch.Stop();
+                        times[level].Add(stopwatch.Elapsed);
+                        events[level] = LoggerSetup.EventsWritten - eventsBefore;
+                    }
+                }
+            }
+            finally
+            {
+                LoggerSetup.SetLevel("*", originalLevel);
+            }
+
+            var results = levels.Select(l => new LoggingBenchmarkResult
+            {
+                Level = l,
+                Elapsed = times[l].OrderBy(t => t).ElementAt(times[l].Count / 2),
+                Events = events[l]
+            }).ToList();
+
+            foreach (var r in results)
+            {
+                _logger.Information("Logging benchmark: {Level,-11} {Seconds,8:F3}s per check of {Files} files, {Events} log event(s).",
+                    r.Level, r.Elapsed.TotalSeconds, warmup.TotalItems, r.Events);
+            }
+            double verbose = results[0].Elapsed.TotalSeconds;
+            double quiet = results[1].Elapsed.TotalSeconds;
+            _logger.Information("Logging benchmark: Verbose logging takes {Share:F1}% of the install check ({Delta:F1} ms; {PerEvent:F2} µs per extra event).",
+                verbose > 0 ? (verbose - quiet) / verbose * 100 : 0,
+                (verbose - quiet) * 1000,
+                results[0].Events > results[1].Events ? (verbose - quiet) * 1e6 / (results[0].Events - results[1].Events) : 0);
+            return results;
+        }
+    }
+}
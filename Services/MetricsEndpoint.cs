@@ -0,0 +1,139 @@
+﻿// Services/MetricsEndpoint.cs
+using System;
+using System.IO;
+using System.Net;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Serves the <see cref="LauncherMetrics"/> in the Prometheus text format at <c>http://127.0.0.1:PORT/metrics</c>.
+    /// <para>
+    /// The listener is bound to the loopback address only, and requests that still arrive from another address are
+    /// refused, so the launcher never exposes anything to the network; a node exporter or Prometheus agent on the same
+    /// machine scrapes it and forwards the data.
+    /// </para>
+    /// </summary>
+    public class MetricsEndpoint
+    {
+        /// <summary>
+        /// Port used when none is given (the usual port for Prometheus exporters embedded in applications).
+        /// </summary>
+        public const int DefaultPort = 9464;
+
+        private readonly int _port;
+        private readonly MetricsCollector _metrics;
+        private readonly ILogger _logger;
+
+        public MetricsEndpoint(int port = DefaultPort)
+        {
+            if (port <= 0 || port > 65535) throw new ArgumentOutOfRangeException(nameof(port));
+            _port = port;
+            _metrics = MetricsCollector.EnsureShared();
+            _logger = Log.ForContext<MetricsEndpoint>();
+            _logger.Verbose("MetricsEndpoint initialized on port {Port}.", _port);
+        }
+
+        /// <summary>
+        /// URL of the metrics page.
+        /// </summary>
+        public string Url => $"http://127.0.0.1:{_port}/metrics";
+
+        /// <summary>
+        /// Starts serving on the thread pool. The returned task completes when <paramref name="cancellationToken"/>
+        /// is cancelled; it never faults, failures are only logged.
+        /// </summary>
+        public Task Start(CancellationToken cancellationToken)
+        {
+            return Task.Run(async () =>
+            {
+                try
+                {
+                    await RunAsync(cancellationToken).ConfigureAwait(false);
+                }
+                catch (OperationCanceledException)
+                {
+                    _logger.Verbose("Metrics endpoint stopped.");
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Metrics endpoint stopped after an unexpected error.");
+                }
+            }, CancellationToken.None);
+        }
+
+        /// <summary>
+        /// Serves requests until cancelled.
+        /// </summary>
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            using var listener = new HttpListener();
+            listener.Prefixes.Add($"http://127.0.0.1:{_port}/");
+            try
+            {
+                listener.Start();
+            }
+            catch (HttpListenerException ex)
+            {
+                _logger.Error(ex, "Could not listen on {Url}; metrics are not exposed.", Url);
+                return;
+            }
+            _logger.Information("Serving Prometheus metrics at {Url}.", Url);
+
+            using CancellationTokenRegistration registration = cancellationToken.Register(listener.Stop);
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                HttpListenerContext context;
+                try
+                {
+                    context = await listener.GetContextAsync().ConfigureAwait(false);
+                }
+                catch (Exception ex) when (ex is HttpListenerException || ex is ObjectDisposedException)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    throw;
+                }
+                Respond(context);
+            }
+            cancellationToken.ThrowIfCancellationRequested();
+        }
+
+        private void Respond(HttpListenerContext context)
+        {
+            HttpListenerResponse response = context.Response;
+            try
+            {
+                if (!IPAddress.IsLoopback(context.Request.RemoteEndPoint.Address))
+                {
+                    response.StatusCode = (int)HttpStatusCode.Forbidden;
+                    return;
+                }
+                if (context.Request.HttpMethod != "GET" || context.Request.Url.AbsolutePath != "/metrics")
+                {
+                    response.StatusCode = (int)HttpStatusCode.NotFound;
+                    return;
+                }
+
+                var text = new StringWriter();
+                _metrics.WritePrometheus(text);
+                byte[] body = Encoding.UTF8.GetBytes(text.ToString());
+                response.StatusCode = (int)HttpStatusCode.OK;
+                response.ContentType = "text/plain; version=0.0.4; charset=utf-8";
+                response.ContentLength64 = body.Length;
+                response.OutputStream.Write(body, 0, body.Length);
+            }
+            catch (Exception ex) when (ex is HttpListenerException || ex is IOException)
+            {
+                _logger.Verbose(ex, "Metrics scrape from {Remote} failed.", context.Request.RemoteEndPoint);
+            }
+            finally
+            {
+                response.Close();
+            }
+        }
+    }
+}
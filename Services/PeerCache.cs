@@ -0,0 +1,857 @@
+﻿// Services/PeerCache.cs
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Net;
+using System.Net.Http;
+using System.Net.Http.Headers;
+using System.Net.NetworkInformation;
+using System.Net.Sockets;
+using System.Security.Cryptography;
+using System.Text;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+using Serilog.Events;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Settings for <see cref="PeerCache"/>.
+    /// </summary>
+    public class PeerCacheOptions
+    {
+        /// <summary>
+        /// HTTP port objects are served on when none is given.
+        /// </summary>
+        public const int DefaultPort = 47761;
+
+        /// <summary>
+        /// UDP port of the discovery announcements when none is given.
+        /// </summary>
+        public const int DefaultDiscoveryPort = 47760;
+
+        public int Port { get; set; } = DefaultPort;
+
+        public int DiscoveryPort { get; set; } = DefaultDiscoveryPort;
+
+        /// <summary>
+        /// Organization-local multicast group the announcements are sent to. They are sent with a TTL of 1, so they
+        /// never leave the local segment.
+        /// </summary>
+        public IPAddress MulticastGroup { get; set; } = IPAddress.Parse("239.255.77.76");
+
+        /// <summary>
+        /// Whether peers are found through multicast announcements. Without it only <see cref="StaticPeers"/> are used.
+        /// </summary>
+        public bool Discovery { get; set; } = true;
+
+        /// <summary>
+        /// Peers given as <c>host:port</c>, with IPv6 addresses in brackets (<c>[fe80::1]:47761</c>), for networks that
+        /// drop multicast. Their inventories are polled every <see cref="AnnounceInterval"/>.
+        /// </summary>
+        public List<string> StaticPeers { get; } = new List<string>();
+
+        /// <summary>
+        /// Time between announcements. A discovered peer is dropped after three intervals without one.
+        /// </summary>
+        public TimeSpan AnnounceInterval { get; set; } = TimeSpan.FromSeconds(5);
+
+        /// <summary>
+        /// How long the first download waits for answers to the start-up query before deciding no peer has the file.
+        /// </summary>
+        public TimeSpan DiscoveryWait { get; set; } = TimeSpan.FromSeconds(1);
+
+        /// <summary>
+        /// Uploads served at the same time; further requests are refused and the peer asks someone else.
+        /// </summary>
+        public int MaxUploads { get; set; } = 8;
+    }
+
+    /// <summary>
+    /// Opt-in LAN cache (<c>--peer-cache</c>): launchers on the same network segment share the content-addressed files
+    /// they already hold, so a lab of machines downloads each asset, library and client JAR from the internet once.
+    /// <para>
+    /// Every launcher serves the files its <see cref="InstallJournal"/> has verified over HTTP, at
+    /// <c>/objects/&lt;sha1&gt;</c>, and lists their hashes at <c>/inventory</c>. Launchers find each other through
+    /// small UDP multicast announcements (id, port, inventory tag); a changed tag makes the others fetch the inventory
+    /// again. <see cref="DownloadScheduler"/> asks <see cref="TryFetchAsync"/> before going upstream; a file from a peer
+    /// is only accepted once its size and SHA1 match the metadata, and a peer that sends anything else is not asked
+    /// again. Requests from outside the directly connected subnets are refused.
+    /// </para>
+    /// <para>
+    /// Mojang's metadata only carries SHA1s, so objects are addressed by SHA1. Java runtimes are installed from archives
+    /// that are not kept, so they are not shared.
+    /// </para>
+    /// </summary>
+    public class PeerCache : IDisposable
+    {
+        private const string App = "obsidian-launcher";
+        private const int Protocol = 1;
+
+        // Peers asked for one file before giving up on the LAN, and failures before a peer is skipped until its next
+        // successful inventory refresh.
+        private const int MaxAttempts = 3;
+        private const int MaxFailures = 3;
+
+        private static readonly TimeSpan InventoryTimeout = TimeSpan.FromSeconds(3);
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions
+        {
+            PropertyNamingPolicy = JsonNamingPolicy.CamelCase
+        };
+
+        private readonly InstallJournal _journal;
+        private readonly PeerCacheOptions _options;
+        private readonly ILogger _logger;
+        private readonly string _id = Guid.NewGuid().ToString("N");
+        private readonly ConcurrentDictionary<string, Peer> _peers = new ConcurrentDictionary<string, Peer>(StringComparer.Ordinal);
+        private readonly TaskCompletionSource _discovered = new TaskCompletionSource(TaskCreationOptions.RunContinuationsAsynchronously);
+        private readonly HttpClient _httpClient;
+        private readonly SemaphoreSlim _uploads;
+        private volatile LocalInventory _local = LocalInventory.Empty;
+        private volatile bool _serving;
+        private volatile List<(byte[] Address, int PrefixLength)> _subnets = new List<(byte[] Address, int PrefixLength)>();
+        private long _filesReceived;
+        private long _bytesReceived;
+        private long _filesServed;
+        private long _bytesServed;
+
+        public PeerCache(InstallJournal journal, PeerCacheOptions options = null)
+        {
+            _journal = journal ?? throw new ArgumentNullException(nameof(journal));
+            _options = options ?? new PeerCacheOptions();
+            if (_options.Port <= 0 || _options.Port > 65535) throw new ArgumentOutOfRangeException(nameof(options), "Invalid peer cache port.");
+            _uploads = new SemaphoreSlim(Math.Max(1, _options.MaxUploads));
+            // Peers are on the LAN: no proxy, and an unreachable one is given up on quickly.
+            _httpClient = new HttpClient(new SocketsHttpHandler { UseProxy = false, ConnectTimeout = TimeSpan.FromSeconds(2) })
+            {
+                Timeout = TimeSpan.FromMinutes(2)
+            };
+            _httpClient.DefaultRequestHeaders.UserAgent.ParseAdd("ObsidianLauncher/1.0 (peer-cache)");
+            _logger = Log.ForContext<PeerCache>();
+            _logger.Verbose("PeerCache initialized on port {Port}, discovery {Discovery}, {StaticPeers} static peer(s).",
+                _options.Port, _options.Discovery ? $"{_options.MulticastGroup}:{_options.DiscoveryPort}" : "off", _options.StaticPeers.Count);
+        }
+
+        /// <summary>
+        /// Peers currently known, usable or not.
+        /// </summary>
+        public int PeerCount => _peers.Count;
+
+        /// <summary>
+        /// Starts serving and discovering on the thread pool. The returned task completes when
+        /// <paramref name="cancellationToken"/> is cancelled; it never faults, failures are only logged.
+        /// </summary>
+        public Task Start(CancellationToken cancellationToken)
+        {
+            return Task.Run(async () =>
+            {
+                try
+                {
+                    await RunAsync(cancellationToken).ConfigureAwait(false);
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Peer cache stopped after an unexpected error.");
+                }
+            }, CancellationToken.None);
+        }
+
+        /// <summary>
+        /// Serves objects and takes part in discovery until cancelled. If the HTTP port cannot be opened, peers are
+        /// still found and fetched from, but this launcher does not announce itself or serve anything.
+        /// </summary>
+        /// <param name="cancellationToken">Stops the peer cache.</param>
+        /// <param name="requireServing">Return right away if the HTTP port cannot be opened (for <c>peer-serve</c>).</param>
+        /// <returns>False if serving was required but the HTTP port could not be opened, or the cache failed; true once cancelled.</returns>
+        public async Task<bool> RunAsync(CancellationToken cancellationToken, bool requireServing = false)
+        {
+            RefreshLocalInventory();
+            _subnets = ReadLocalSubnets();
+
+            using var listener = new HttpListener();
+            listener.Prefixes.Add($"http://+:{_options.Port}/");
+            try
+            {
+                listener.Start();
+                _serving = true;
+            }
+            catch (HttpListenerException ex)
+            {
+                // On Windows a wildcard prefix needs administrator rights or a URL reservation for the user.
+                if (OperatingSystem.IsWindows())
+                {
+                    _logger.Error(ex, "Could not listen on port {Port}; this launcher will not share its files. Reserve the URL once from an administrator prompt: netsh http add urlacl url=http://+:{Port}/ user={User}",
+                        _options.Port, Environment.UserDomainName + "\\" + Environment.UserName);
+                }
+                else
+                {
+                    _logger.Error(ex, "Could not listen on port {Port}; this launcher will not share its files.", _options.Port);
+                }
+                if (requireServing)
+                {
+                    _discovered.TrySetResult();
+                    return false;
+                }
+            }
+
+            using UdpClient udp = _options.Discovery ? OpenDiscoverySocket() : null;
+            _logger.Information("Peer cache {Sharing}{Discovery}.",
+                _serving ? $"sharing {_local.Objects.Count} object(s) on port {_options.Port}" : "fetching only",
+                udp != null ? $", discovering peers on {_options.MulticastGroup}:{_options.DiscoveryPort}" : string.Empty);
+
+            using var stop = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+            using CancellationTokenRegistration registration = stop.Token.Register(() => { if (_serving) listener.Stop(); });
+            var loops = new List<Task> { AnnounceAsync(udp, stop.Token) };
+            if (_serving) loops.Add(ServeAsync(listener, stop.Token));
+            if (udp != null) loops.Add(ReceiveAsync(udp, stop.Token));
+
+            await Task.WhenAny(loops).ConfigureAwait(false);
+            stop.Cancel();
+            bool stoppedCleanly = true;
+            try
+            {
+                await Task.WhenAll(loops).ConfigureAwait(false);
+            }
+            catch (OperationCanceledException)
+            {
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Peer cache stopped after an unexpected error.");
+                stoppedCleanly = false;
+            }
+
+            if (udp != null && _serving) await SendAsync(udp, "bye", CancellationToken.None).ConfigureAwait(false);
+            _discovered.TrySetResult();
+            _logger.Information("Peer cache stopped: {Received} file(s) ({ReceivedMB:F1} MB) fetched from peers, {Served} file(s) ({ServedMB:F1} MB) served.",
+                Interlocked.Read(ref _filesReceived), Interlocked.Read(ref _bytesReceived) / (1024.0 * 1024.0),
+                Interlocked.Read(ref _filesServed), Interlocked.Read(ref _bytesServed) / (1024.0 * 1024.0));
+            return stoppedCleanly && cancellationToken.IsCancellationRequested;
+        }
+
+        /// <summary>
+        /// Fetches <paramref name="item"/> from a peer that holds it into <paramref name="targetPath"/> and verifies its
+        /// size and SHA1. The first call waits up to <see cref="PeerCacheOptions.DiscoveryWait"/> for peers to answer.
+        /// </summary>
+        /// <returns>
+        /// True if <paramref name="targetPath"/> now holds the verified file. False if no peer has it, every peer asked
+        /// failed, or the item has no SHA1; nothing is left at <paramref name="targetPath"/> then.
+        /// </returns>
+        public async Task<bool> TryFetchAsync(InstallWorkItem item, string targetPath, InstallProgress installProgress = null, CancellationToken cancellationToken = default)
+        {
+            if (item == null) throw new ArgumentNullException(nameof(item));
+            if (string.IsNullOrEmpty(item.Sha1)) return false;
+            await WaitForDiscoveryAsync(cancellationToken).ConfigureAwait(false);
+
+            string sha1 = item.Sha1.ToLowerInvariant();
+            List<Peer> candidates = _peers.Values
+                .Where(p => p.IsUsable && p.Objects.Contains(sha1))
+                .OrderBy(p => p.Failures)
+                .ThenBy(_ => Random.Shared.Next()) // Spreads a lab's requests over every peer that has the file.
+                .Take(MaxAttempts)
+                .ToList();
+            if (candidates.Count == 0)
+            {
+                RecordFetch("miss");
+                return false;
+            }
+
+            using Activity activity = LauncherTracing.Start("peer.fetch");
+            foreach (Peer peer in candidates)
+            {
+                if (cancellationToken.IsCancellationRequested) return false;
+                if (await FetchFromPeerAsync(peer, item, sha1, targetPath, installProgress, cancellationToken).ConfigureAwait(false))
+                {
+                    activity?.SetTag("peer", peer.Endpoint);
+                    activity?.SetTag("result", "hit");
+                    return true;
+                }
+            }
+            activity?.SetTag("result", "unavailable");
+            RecordFetch("unavailable");
+            return false;
+        }
+
+        public void Dispose()
+        {
+            _httpClient.Dispose();
+            _uploads.Dispose();
+        }
+
+        private async Task WaitForDiscoveryAsync(CancellationToken cancellationToken)
+        {
+            if (_discovered.Task.IsCompleted) return;
+            try
+            {
+                await _discovered.Task.WaitAsync(_options.DiscoveryWait + InventoryTimeout, cancellationToken).ConfigureAwait(false);
+            }
+            catch (TimeoutException)
+            {
+                // Not started, or peers are slow to answer; later calls use whatever has been found by then.
+                _discovered.TrySetResult();
+            }
+            catch (OperationCanceledException)
+            {
+            }
+        }
+
+        private async Task<bool> FetchFromPeerAsync(Peer peer, InstallWorkItem item, string sha1, string targetPath, InstallProgress installProgress, CancellationToken cancellationToken)
+        {
+            string url = $"http://{peer.Endpoint}/objects/{sha1}";
+            try
+            {
+                using HttpResponseMessage response = await _httpClient.GetAsync(url, HttpCompletionOption.ResponseHeadersRead, cancellationToken).ConfigureAwait(false);
+                if (!response.IsSuccessStatusCode)
+                {
+                    // 404: the peer no longer has it (its inventory was stale); 503: it is busy uploading to others.
+                    if (response.StatusCode == HttpStatusCode.NotFound) peer.Forget(sha1);
+                    else peer.RecordFailure();
+                    if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Peer {Peer} answered {StatusCode} for {Sha1}.", peer.Endpoint, (int)response.StatusCode, sha1);
+                    return false;
+                }
+
+                long? length = response.Content.Headers.ContentLength;
+                if (item.Size.HasValue && length.HasValue && length.Value != (long)item.Size.Value)
+                {
+                    Distrust(peer, item, $"announced {length.Value} bytes, expected {item.Size.Value}");
+                    return false;
+                }
+
+                Directory.CreateDirectory(Path.GetDirectoryName(targetPath));
+                long bytes;
+                long? maxBytes = item.Size.HasValue ? (long)item.Size.Value : null;
+                using (Stream content = await response.Content.ReadAsStreamAsync(cancellationToken).ConfigureAwait(false))
+                using (FileStream file = HttpManager.OpenDownloadFile(targetPath, FileMode.Create, length))
+                {
+                    // Without a Content-Length (chunked), the expected size is the only bound on what a peer can write.
+                    bytes = await HttpManager.CopyToFileAsync(content, file, length, 0, null, installProgress, null, cancellationToken, maxBytes).ConfigureAwait(false);
+                }
+                if (bytes > maxBytes)
+                {
+                    DeleteQuietly(targetPath);
+                    Distrust(peer, item, $"sent more than the expected {maxBytes} bytes");
+                    return false;
+                }
+
+                string actualSha1 = await CryptoUtils.CalculateFileSHA1Async(targetPath, cancellationToken).ConfigureAwait(false);
+                if (cancellationToken.IsCancellationRequested)
+                {
+                    DeleteQuietly(targetPath);
+                    return false;
+                }
+                if ((item.Size.HasValue && bytes != (long)item.Size.Value) || !sha1.Equals(actualSha1, StringComparison.OrdinalIgnoreCase))
+                {
+                    DeleteQuietly(targetPath);
+                    Distrust(peer, item, $"got {bytes} bytes with SHA1 {actualSha1 ?? "N/A"}");
+                    return false;
+                }
+
+                peer.RecordSuccess();
+                Interlocked.Increment(ref _filesReceived);
+                Interlocked.Add(ref _bytesReceived, bytes);
+                RecordFetch("hit");
+                if (LauncherMetrics.PeerBytes.Enabled) LauncherMetrics.PeerBytes.Add(bytes, LauncherMetrics.Tag("direction", "received"));
+                if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Fetched {Description} ({Bytes} bytes) from peer {Peer}.", item.Description ?? sha1, bytes, peer.Endpoint);
+                return true;
+            }
+            catch (Exception ex) when (ex is HttpRequestException || ex is IOException || ex is OperationCanceledException)
+            {
+                DeleteQuietly(targetPath);
+                if (cancellationToken.IsCancellationRequested) return false;
+                peer.RecordFailure();
+                _logger.Debug("Fetching {Sha1} from peer {Peer} failed: {Reason}", sha1, peer.Endpoint, ex.Message);
+                return false;
+            }
+        }
+
+        private void Distrust(Peer peer, InstallWorkItem item, string reason)
+        {
+            peer.Distrusted = true;
+            RecordFetch("mismatch");
+            _logger.Warning("Peer {Peer} sent a bad copy of {Description} ({Reason}); it is not asked again.", peer.Endpoint, item.Description ?? item.Sha1, reason);
+        }
+
+        private static void RecordFetch(string result)
+        {
+            if (!LauncherMetrics.PeerFetches.Enabled) return;
+            LauncherMetrics.PeerFetches.Add(1, LauncherMetrics.Tag("result", result));
+        }
+
+        private void DeleteQuietly(string path)
+        {
+            try
+            {
+                File.Delete(path);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to delete {Path} after a failed peer fetch.", path);
+            }
+        }
+
+        // --- Serving ---
+
+        private async Task ServeAsync(HttpListener listener, CancellationToken cancellationToken)
+        {
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                HttpListenerContext context;
+                try
+                {
+                    context = await listener.GetContextAsync().ConfigureAwait(false);
+                }
+                catch (Exception ex) when (ex is HttpListenerException || ex is ObjectDisposedException)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    throw;
+                }
+                // Uploads can take a while; each runs on its own so inventories and other requests are not held up.
+                _ = Task.Run(() => RespondAsync(context, cancellationToken), CancellationToken.None);
+            }
+            cancellationToken.ThrowIfCancellationRequested();
+        }
+
+        private async Task RespondAsync(HttpListenerContext context, CancellationToken cancellationToken)
+        {
+            HttpListenerResponse response = context.Response;
+            try
+            {
+                if (!IsOnLocalSegment(context.Request.RemoteEndPoint.Address))
+                {
+                    response.StatusCode = (int)HttpStatusCode.Forbidden;
+                    return;
+                }
+
+                string path = context.Request.Url.AbsolutePath;
+                if (context.Request.HttpMethod != "GET")
+                {
+                    response.StatusCode = (int)HttpStatusCode.MethodNotAllowed;
+                }
+                else if (path == "/inventory")
+                {
+                    WriteInventory(context.Request, response);
+                }
+                else if (path.StartsWith("/objects/", StringComparison.Ordinal))
+                {
+                    await WriteObjectAsync(path.Substring("/objects/".Length).ToLowerInvariant(), response, cancellationToken).ConfigureAwait(false);
+                }
+                else
+                {
+                    response.StatusCode = (int)HttpStatusCode.NotFound;
+                }
+            }
+            catch (Exception ex) when (ex is HttpListenerException || ex is IOException || ex is OperationCanceledException)
+            {
+                _logger.Verbose(ex, "Peer request from {Remote} failed.", context.Request.RemoteEndPoint);
+            }
+            catch (Exception ex)
+            {
+                _logger.Error(ex, "Unexpected error while answering peer {Remote}.", context.Request.RemoteEndPoint);
+            }
+            finally
+            {
+                try { response.Close(); } catch (Exception ex) when (ex is HttpListenerException || ex is ObjectDisposedException) { }
+            }
+        }
+
+        private void WriteInventory(HttpListenerRequest request, HttpListenerResponse response)
+        {
+            LocalInventory inventory = _local;
+            string etag = $"\"{inventory.Tag}\"";
+            response.AddHeader("ETag", etag);
+            if (request.Headers["If-None-Match"] == etag)
+            {
+                response.StatusCode = (int)HttpStatusCode.NotModified;
+                return;
+            }
+            response.StatusCode = (int)HttpStatusCode.OK;
+            response.ContentType = "text/plain; charset=utf-8";
+            response.ContentLength64 = inventory.Body.Length;
+            response.OutputStream.Write(inventory.Body, 0, inventory.Body.Length);
+        }
+
+        private async Task WriteObjectAsync(string sha1, HttpListenerResponse response, CancellationToken cancellationToken)
+        {
+            // Only files the journal still vouches for (unchanged since they were verified) are handed out.
+            if (!IsSha1(sha1) || !_local.Objects.TryGetValue(sha1, out string filePath) ||
+                !_journal.IsVerified(new InstallWorkItem { LocalPath = filePath, Sha1 = sha1 }, new FileInfo(filePath)))
+            {
+                response.StatusCode = (int)HttpStatusCode.NotFound;
+                return;
+            }
+            if (!_uploads.Wait(0))
+            {
+                response.StatusCode = (int)HttpStatusCode.ServiceUnavailable;
+                return;
+            }
+
+            try
+            {
+                using var file = new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.Read | FileShare.Delete, 81920,
+                    FileOptions.Asynchronous | FileOptions.SequentialScan);
+                response.StatusCode = (int)HttpStatusCode.OK;
+                response.ContentType = "application/octet-stream";
+                response.ContentLength64 = file.Length;
+                await file.CopyToAsync(response.OutputStream, 81920, cancellationToken).ConfigureAwait(false);
+
+                Interlocked.Increment(ref _filesServed);
+                Interlocked.Add(ref _bytesServed, file.Length);
+                if (LauncherMetrics.PeerBytes.Enabled) LauncherMetrics.PeerBytes.Add(file.Length, LauncherMetrics.Tag("direction", "served"));
+            }
+            finally
+            {
+                _uploads.Release();
+            }
+        }
+
+        /// <summary>
+        /// Rebuilds the served objects from the journal's verified records. The tag is a hash of the sorted hash list,
+        /// so it only changes when the set of objects does.
+        /// </summary>
+        private void RefreshLocalInventory()
+        {
+            var objects = new Dictionary<string, string>(StringComparer.Ordinal);
+            foreach ((string sha1, string path) in _journal.GetVerifiedObjects())
+            {
+                string key = sha1.ToLowerInvariant();
+                if (IsSha1(key)) objects.TryAdd(key, path);
+            }
+
+            var keys = objects.Keys.ToList();
+            keys.Sort(StringComparer.Ordinal);
+            byte[] body = Encoding.ASCII.GetBytes(keys.Count == 0 ? string.Empty : string.Join("\n", keys) + "\n");
+            string tag = Convert.ToHexString(SHA1.HashData(body), 0, 8).ToLowerInvariant();
+            _local = new LocalInventory(objects, tag, body);
+        }
+
+        private static bool IsSha1(string value)
+        {
+            if (value == null || value.Length != 40) return false;
+            foreach (char c in value)
+            {
+                if (!char.IsAsciiHexDigitLower(c)) return false;
+            }
+            return true;
+        }
+
+        // --- Discovery ---
+
+        private UdpClient OpenDiscoverySocket()
+        {
+            var udp = new UdpClient(AddressFamily.InterNetwork);
+            try
+            {
+                // Several launchers on one machine share the port; multicast datagrams reach all of them.
+                if (OperatingSystem.IsWindows()) udp.ExclusiveAddressUse = false;
+                udp.Client.SetSocketOption(SocketOptionLevel.Socket, SocketOptionName.ReuseAddress, true);
+                udp.Client.Bind(new IPEndPoint(IPAddress.Any, _options.DiscoveryPort));
+                udp.JoinMulticastGroup(_options.MulticastGroup);
+                udp.MulticastLoopback = true;
+                udp.Client.SetSocketOption(SocketOptionLevel.IP, SocketOptionName.MulticastTimeToLive, 1);
+                return udp;
+            }
+            catch (SocketException ex)
+            {
+                udp.Dispose();
+                _logger.Warning("Could not join {Group}:{Port} ({Reason}); only static peers are used.", _options.MulticastGroup, _options.DiscoveryPort, ex.SocketErrorCode);
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Asks the segment for announcements, gives peers <see cref="PeerCacheOptions.DiscoveryWait"/> to answer and
+        /// fetches their inventories, then announces this launcher every interval and keeps the peer list current.
+        /// </summary>
+        private async Task AnnounceAsync(UdpClient udp, CancellationToken cancellationToken)
+        {
+            foreach (string endpoint in _options.StaticPeers)
+            {
+                _peers.TryAdd("static:" + endpoint, new Peer(endpoint, isStatic: true));
+            }
+            if (udp != null)
+            {
+                await SendAsync(udp, "query", cancellationToken).ConfigureAwait(false);
+                if (_serving) await SendAsync(udp, "announce", cancellationToken).ConfigureAwait(false);
+                await Task.Delay(_options.DiscoveryWait, cancellationToken).ConfigureAwait(false);
+            }
+            foreach (Peer peer in _peers.Values.Where(p => p.IsStatic)) BeginRefresh(peer, cancellationToken);
+            await Task.WhenAll(_peers.Values.Select(p => p.Refresh ?? Task.CompletedTask)).ConfigureAwait(false);
+            _discovered.TrySetResult();
+            _logger.Information("Peer cache found {Peers} peer(s) holding {Objects} distinct object(s).",
+                _peers.Count, _peers.Values.SelectMany(p => p.Objects).Distinct().Count());
+
+            while (true)
+            {
+                await Task.Delay(_options.AnnounceInterval, cancellationToken).ConfigureAwait(false);
+                RefreshLocalInventory();
+                _subnets = ReadLocalSubnets();
+                if (udp != null && _serving) await SendAsync(udp, "announce", cancellationToken).ConfigureAwait(false);
+
+                DateTime expiry = DateTime.UtcNow - 3 * _options.AnnounceInterval;
+                foreach (KeyValuePair<string, Peer> entry in _peers)
+                {
+                    if (entry.Value.IsStatic) BeginRefresh(entry.Value, cancellationToken);
+                    else if (entry.Value.LastSeenUtc < expiry && _peers.TryRemove(entry.Key, out _))
+                    {
+                        _logger.Information("Peer {Peer} went quiet; dropped.", entry.Value.Endpoint);
+                    }
+                }
+            }
+        }
+
+        private async Task ReceiveAsync(UdpClient udp, CancellationToken cancellationToken)
+        {
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                UdpReceiveResult datagram = await udp.ReceiveAsync(cancellationToken).ConfigureAwait(false);
+                PeerMessage message;
+                try
+                {
+                    message = JsonSerializer.Deserialize<PeerMessage>(datagram.Buffer, JsonOptions);
+                }
+                catch (JsonException)
+                {
+                    continue;
+                }
+                if (message == null || message.App != App || message.Protocol != Protocol || message.Id == _id || string.IsNullOrEmpty(message.Id)) continue;
+                if (!IsOnLocalSegment(datagram.RemoteEndPoint.Address)) continue;
+
+                switch (message.Type)
+                {
+                    case "query" when _serving:
+                        await SendAsync(udp, "announce", cancellationToken).ConfigureAwait(false);
+                        break;
+                    case "announce" when message.Port > 0 && message.Port <= 65535:
+                        string endpoint = new IPEndPoint(datagram.RemoteEndPoint.Address, message.Port).ToString();
+                        Peer peer = _peers.GetOrAdd(message.Id, _ => new Peer(endpoint, isStatic: false));
+                        peer.Endpoint = endpoint;
+                        peer.LastSeenUtc = DateTime.UtcNow;
+                        if (peer.InventoryTag != message.Tag) BeginRefresh(peer, cancellationToken);
+                        break;
+                    case "bye":
+                        if (_peers.TryRemove(message.Id, out Peer gone)) _logger.Information("Peer {Peer} left.", gone.Endpoint);
+                        break;
+                }
+            }
+            cancellationToken.ThrowIfCancellationRequested();
+        }
+
+        private async Task SendAsync(UdpClient udp, string type, CancellationToken cancellationToken)
+        {
+            LocalInventory inventory = _local;
+            var message = new PeerMessage
+            {
+                App = App,
+                Protocol = Protocol,
+                Type = type,
+                Id = _id,
+                Port = _options.Port,
+                Objects = inventory.Objects.Count,
+                Tag = inventory.Tag
+            };
+            try
+            {
+                byte[] datagram = JsonSerializer.SerializeToUtf8Bytes(message, JsonOptions);
+                await udp.SendAsync(datagram, new IPEndPoint(_options.MulticastGroup, _options.DiscoveryPort), cancellationToken).ConfigureAwait(false);
+            }
+            catch (Exception ex) when (ex is SocketException || ex is ObjectDisposedException)
+            {
+                _logger.Debug("Sending a peer {Type} failed: {Reason}", type, ex.Message);
+            }
+        }
+
+        private void BeginRefresh(Peer peer, CancellationToken cancellationToken)
+        {
+            lock (peer)
+            {
+                if (peer.Refresh != null && !peer.Refresh.IsCompleted) return;
+                peer.Refresh = RefreshInventoryAsync(peer, cancellationToken);
+            }
+        }
+
+        /// <summary>
+        /// Fetches the peer's list of objects, or confirms the one held is current. Never throws.
+        /// </summary>
+        private async Task RefreshInventoryAsync(Peer peer, CancellationToken cancellationToken)
+        {
+            try
+            {
+                using var request = new HttpRequestMessage(HttpMethod.Get, $"http://{peer.Endpoint}/inventory");
+                if (peer.InventoryTag != null) request.Headers.IfNoneMatch.Add(new EntityTagHeaderValue($"\"{peer.InventoryTag}\""));
+                using var timeout = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+                timeout.CancelAfter(InventoryTimeout);
+
+                using HttpResponseMessage response = await _httpClient.SendAsync(request, timeout.Token).ConfigureAwait(false);
+                if (response.StatusCode == HttpStatusCode.NotModified)
+                {
+                    peer.RecordSuccess();
+                    return;
+                }
+                if (!response.IsSuccessStatusCode)
+                {
+                    peer.RecordFailure();
+                    _logger.Debug("Peer {Peer} refused its inventory ({StatusCode}).", peer.Endpoint, (int)response.StatusCode);
+                    return;
+                }
+
+                string text = await response.Content.ReadAsStringAsync(timeout.Token).ConfigureAwait(false);
+                var objects = new HashSet<string>(StringComparer.Ordinal);
+                foreach (string line in text.Split('\n'))
+                {
+                    if (IsSha1(line)) objects.Add(line);
+                }
+                bool known = peer.InventoryTag != null;
+                peer.Objects = objects;
+                peer.InventoryTag = response.Headers.ETag?.Tag.Trim('"');
+                peer.RecordSuccess();
+                if (known) _logger.Debug("Peer {Peer} now holds {Objects} object(s).", peer.Endpoint, objects.Count);
+                else _logger.Information("Found peer {Peer} holding {Objects} object(s).", peer.Endpoint, objects.Count);
+            }
+            catch (Exception ex) when (ex is HttpRequestException || ex is IOException || ex is OperationCanceledException)
+            {
+                if (cancellationToken.IsCancellationRequested) return;
+                peer.RecordFailure();
+                _logger.Debug("Inventory of peer {Peer} unavailable: {Reason}", peer.Endpoint, ex.Message);
+            }
+        }
+
+        // --- Local segment ---
+
+        /// <summary>
+        /// True for loopback addresses and addresses inside one of this machine's directly connected subnets.
+        /// </summary>
+        private bool IsOnLocalSegment(IPAddress address)
+        {
+            if (address.IsIPv4MappedToIPv6) address = address.MapToIPv4();
+            if (IPAddress.IsLoopback(address)) return true;
+            byte[] bytes = address.GetAddressBytes();
+            foreach ((byte[] network, int prefixLength) in _subnets)
+            {
+                if (network.Length == bytes.Length && SharesPrefix(bytes, network, prefixLength)) return true;
+            }
+            return false;
+        }
+
+        private static bool SharesPrefix(byte[] a, byte[] b, int prefixLength)
+        {
+            int fullBytes = prefixLength / 8;
+            for (int i = 0; i < fullBytes; i++)
+            {
+                if (a[i] != b[i]) return false;
+            }
+            int remainingBits = prefixLength % 8;
+            if (remainingBits == 0) return true;
+            int mask = 0xFF << (8 - remainingBits) & 0xFF;
+            return (a[fullBytes] & mask) == (b[fullBytes] & mask);
+        }
+
+        private List<(byte[] Address, int PrefixLength)> ReadLocalSubnets()
+        {
+            var subnets = new List<(byte[] Address, int PrefixLength)>();
+            try
+            {
+                foreach (NetworkInterface nic in NetworkInterface.GetAllNetworkInterfaces())
+                {
+                    foreach (UnicastIPAddressInformation unicast in nic.GetIPProperties().UnicastAddresses)
+                    {
+                        // A zero-length prefix would match every address.
+                        if (unicast.PrefixLength > 0) subnets.Add((unicast.Address.GetAddressBytes(), unicast.PrefixLength));
+                    }
+                }
+            }
+            catch (NetworkInformationException ex)
+            {
+                _logger.Warning(ex, "Could not read the network interfaces; only loopback peers are accepted.");
+            }
+            return subnets;
+        }
+
+        private sealed class LocalInventory
+        {
+            public static readonly LocalInventory Empty =
+                new LocalInventory(new Dictionary<string, string>(StringComparer.Ordinal), "0", Array.Empty<byte>());
+
+            public LocalInventory(Dictionary<string, string> objects, string tag, byte[] body)
+            {
+                Objects = objects;
+                Tag = tag;
+                Body = body;
+            }
+
+            /// <summary>
+            /// Path of each served object by its lowercase SHA1. Never modified once published.
+            /// </summary>
+            public Dictionary<string, string> Objects { get; }
+
+            public string Tag { get; }
+            public byte[] Body { get; }
+        }
+
+        private sealed class Peer
+        {
+            private int _failures;
+
+            public Peer(string endpoint, bool isStatic)
+            {
+                Endpoint = endpoint;
+                IsStatic = isStatic;
+                LastSeenUtc = DateTime.UtcNow;
+            }
+
+            /// <summary>
+            /// <c>host:port</c> of the peer's HTTP server.
+            /// </summary>
+            public volatile string Endpoint;
+
+            public bool IsStatic { get; }
+            public DateTime LastSeenUtc { get; set; }
+            public volatile string InventoryTag;
+            public volatile HashSet<string> Objects = new HashSet<string>(StringComparer.Ordinal);
+            public volatile bool Distrusted;
+            public Task Refresh;
+
+            public int Failures => Volatile.Read(ref _failures);
+            public bool IsUsable => !Distrusted && Failures < MaxFailures;
+
+            public void RecordFailure() => Interlocked.Increment(ref _failures);
+            public void RecordSuccess() => Volatile.Write(ref _failures, 0);
+
+            /// <summary>
+            /// Drops one object after the peer said it no longer has it. The set is replaced, not changed, since
+            /// fetches read it without a lock.
+            /// </summary>
+            public void Forget(string sha1)
+            {
+                HashSet<string> objects = Objects;
+                if (!objects.Contains(sha1)) return;
+                var remaining = new HashSet<string>(objects, StringComparer.Ordinal);
+                remaining.Remove(sha1);
+                Objects = remaining;
+            }
+        }
+
+        private sealed class PeerMessage
+        {
+            public string App { get; set; }
+            public int Protocol { get; set; }
+
+            /// <summary>
+            /// "announce", "query" (everyone announces now) or "bye" (the sender is stopping).
+            /// </summary>
+            public string Type { get; set; }
+
+            public string Id { get; set; }
+            public int Port { get; set; }
+            public int Objects { get; set; }
+            public string Tag { get; set; }
+        }
+    }
+}
@@ -0,0 +1,471 @@
+﻿// Services/PerformanceHistory.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Text.Json;
+using System.Text.Json.Serialization;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// One install or launch run as stored in the performance history.
+    /// </summary>
+    public class PerformanceRunRecord
+    {
+        public DateTime TimestampUtc { get; set; }
+        public string LauncherVersion { get; set; }
+        public string Command { get; set; }
+        public string VersionId { get; set; }
+
+        /// <summary>
+        /// ok, installed (<c>--install-only</c>), failed or cancelled.
+        /// </summary>
+        public string Outcome { get; set; }
+
+        /// <summary>
+        /// Seconds per launch phase (manifest, version, plan, install, arguments, spawn, game, post_session).
+        /// </summary>
+        public Dictionary<string, double> Phases { get; set; } = new Dictionary<string, double>();
+
+        public long BytesDownloaded { get; set; }
+        public int FilesDownloaded { get; set; }
+        public int FilesAlreadyValid { get; set; }
+
+        /// <summary>
+        /// Download rate of the install's scheduler run, in bytes per second; 0 if it downloaded too little to tell.
+        /// </summary>
+        public double DownloadBytesPerSecond { get; set; }
+
+        /// <summary>
+        /// Bytes received per host, so a mirror change shows up next to a throughput change.
+        /// </summary>
+        public Dictionary<string, long> BytesByHost { get; set; } = new Dictionary<string, long>();
+
+        public long HashBytes { get; set; }
+
+        /// <summary>
+        /// Hashing rate of one reader, in bytes per second; 0 if too little was hashed to tell.
+        /// </summary>
+        public double HashBytesPerSecond { get; set; }
+
+        /// <summary>
+        /// Share of local cache checks that avoided a download, 0..1; null if nothing was checked.
+        /// </summary>
+        public double? CacheHitRate { get; set; }
+
+        /// <summary>
+        /// Share of existing files the install journal let skip hashing, 0..1; null if nothing was checked.
+        /// </summary>
+        public double? JournalHitRate { get; set; }
+
+        public PerformanceHostInfo Host { get; set; }
+
+        /// <summary>
+        /// Seconds from start to the game's launch: every phase except the game session and what follows it.
+        /// </summary>
+        [JsonIgnore]
+        public double LaunchOverheadSeconds =>
+            Phases.Where(p => p.Key != "game" && p.Key != "post_session").Sum(p => p.Value);
+    }
+
+    /// <summary>
+    /// The machine a run was measured on.
+    /// </summary>
+    public class PerformanceHostInfo
+    {
+        public string Os { get; set; }
+        public string Architecture { get; set; }
+        public int ProcessorCount { get; set; }
+        public string Runtime { get; set; }
+        public bool RotationalDataDisk { get; set; }
+
+        public override bool Equals(object obj)
+        {
+            return obj is PerformanceHostInfo other && Os == other.Os && Architecture == other.Architecture &&
+                   ProcessorCount == other.ProcessorCount && Runtime == other.Runtime && RotationalDataDisk == other.RotationalDataDisk;
+        }
+
+        public override int GetHashCode() => HashCode.Combine(Os, Architecture, ProcessorCount, Runtime, RotationalDataDisk);
+
+        public override string ToString() => $"{Os} {Architecture}, {ProcessorCount} CPUs, {Runtime}{(RotationalDataDisk ? ", HDD" : string.Empty)}";
+    }
+
+    /// <summary>
+    /// A metric of the latest run that is worse than its baseline by more than the threshold.
+    /// </summary>
+    public class PerformanceRegression
+    {
+        public string Metric { get; set; }
+        public double Baseline { get; set; }
+        public double Latest { get; set; }
+
+        /// <summary>
+        /// Relative change towards worse, in percent.
+        /// </summary>
+        public double ChangePercent { get; set; }
+    }
+
+    /// <summary>
+    /// Result of <see cref="PerformanceHistory.CreateReport"/>.
+    /// </summary>
+    public class PerformanceReport
+    {
+        public PerformanceRunRecord Latest { get; set; }
+        public List<PerformanceRunRecord> Baseline { get; } = new List<PerformanceRunRecord>();
+        public List<PerformanceRunRecord> Trend { get; } = new List<PerformanceRunRecord>();
+        public List<PerformanceRegression> Regressions { get; } = new List<PerformanceRegression>();
+
+        /// <summary>
+        /// Changes of launcher version, download hosts or machine between the baseline and the latest run.
+        /// </summary>
+        public List<string> Notes { get; } = new List<string>();
+    }
+
+    /// <summary>
+    /// Captures the <see cref="LauncherMetrics"/> totals when a run starts, so the run's own share can be taken
+    /// when it completes even if the process records several runs.
+    /// </summary>
+    public class PerformanceRunRecorder
+    {
+        private readonly MetricsCollector _metrics;
+        private readonly string _command;
+        private readonly DateTime _startedUtc = DateTime.UtcNow;
+        private readonly Totals _start;
+
+        internal PerformanceRunRecorder(MetricsCollector metrics, string command)
+        {
+            _metrics = metrics;
+            _command = command;
+            _start = Totals.Read(metrics);
+        }
+
+        /// <summary>
+        /// Builds the record of the run from what was measured since it started.
+        /// </summary>
+        /// <param name="versionId">Version that was installed or launched.</param>
+        /// <param name="outcome">ok, failed or cancelled.</param>
+        /// <param name="downloads">The install's scheduler run, if it got that far.</param>
+        /// <param name="dataPath">Data directory, to record whether it is on a rotational disk.</param>
+        public PerformanceRunRecord Complete(string versionId, string outcome, DownloadRunSummary downloads, string dataPath)
+        {
+            Totals end = Totals.Read(_metrics);
+            var record = new PerformanceRunRecord
+            {
+                TimestampUtc = _startedUtc,
+                LauncherVersion = LauncherConfig.VERSION,
+                Command = _command,
+                VersionId = versionId,
+                Outcome = outcome,
+                Phases = Delta(end.Phases, _start.Phases).Where(p => p.Value > 0).ToDictionary(p => p.Key, p => Math.Round(p.Value, 4)),
+                BytesDownloaded = downloads?.BytesDownloaded ?? 0,
+                FilesDownloaded = downloads?.Downloaded ?? 0,
+                FilesAlreadyValid = downloads?.AlreadyValid ?? 0,
+                BytesByHost = Delta(end.HttpBytesByHost, _start.HttpBytesByHost).Where(h => h.Value > 0).ToDictionary(h => h.Key, h => (long)h.Value),
+                HashBytes = (long)(end.HashBytes - _start.HashBytes),
+                Host = new PerformanceHostInfo
+                {
+                    Os = RuntimeInformation.OSDescription,
+                    Architecture = RuntimeInformation.ProcessArchitecture.ToString(),
+                    ProcessorCount = Environment.ProcessorCount,
+                    Runtime = RuntimeInformation.FrameworkDescription,
+                    RotationalDataDisk = StorageInfo.IsRotational(dataPath)
+                }
+            };
+            if (downloads != null && downloads.BytesDownloaded >= PerformanceHistory.MinThroughputBytes && downloads.Elapsed > TimeSpan.Zero)
+            {
+                record.DownloadBytesPerSecond = Math.Round(downloads.BytesDownloaded / downloads.Elapsed.TotalSeconds);
+            }
+            double hashSeconds = end.HashSeconds - _start.HashSeconds;
+            if (record.HashBytes >= PerformanceHistory.MinThroughputBytes && hashSeconds > 0)
+            {
+                record.HashBytesPerSecond = Math.Round(record.HashBytes / hashSeconds);
+            }
+            record.CacheHitRate = Rate(end.CacheHits - _start.CacheHits, end.CacheLookups - _start.CacheLookups);
+            record.JournalHitRate = Rate(end.JournalHits - _start.JournalHits, end.JournalLookups - _start.JournalLookups);
+            return record;
+        }
+
+        private static double? Rate(double hits, double total)
+        {
+            return total > 0 ? Math.Round(hits / total, 4) : null;
+        }
+
+        private static Dictionary<string, double> Delta(Dictionary<string, double> end, Dictionary<string, double> start)
+        {
+            return end.ToDictionary(e => e.Key, e => e.Value - (start.TryGetValue(e.Key, out double s) ? s : 0));
+        }
+
+        private sealed class Totals
+        {
+            public Dictionary<string, double> Phases;
+            public Dictionary<string, double> HttpBytesByHost;
+            public double HashBytes, HashSeconds, CacheLookups, CacheHits, JournalLookups, JournalHits;
+
+            public static Totals Read(MetricsCollector metrics)
+            {
+                return new Totals
+                {
+                    Phases = metrics.GetTotalsByTag("launcher.phase.duration", "phase"),
+                    HttpBytesByHost = metrics.GetTotalsByTag("launcher.http.bytes", "host"),
+                    HashBytes = metrics.GetTotal("launcher.hash.bytes"),
+                    HashSeconds = metrics.GetTotal("launcher.hash.duration"),
+                    CacheLookups = metrics.GetTotal("launcher.cache.lookups"),
+                    CacheHits = metrics.GetTotal("launcher.cache.lookups", "result", "hit"),
+                    JournalLookups = metrics.GetTotal("launcher.journal.lookups"),
+                    JournalHits = metrics.GetTotal("launcher.journal.lookups", "result", "hit")
+                };
+            }
+        }
+    }
+
+    /// <summary>
+    /// Local history of install and launch runs: each run appends one compact JSON line to
+    /// <c>perf_history.jsonl</c> in the data directory, and <see cref="CreateReport"/> compares the latest run with
+    /// the median of the runs before it to flag regressions, e.g. after a launcher upgrade or a mirror change.
+    /// <para>
+    /// Appends are single writes in append mode, so several launchers sharing the data directory do not interleave
+    /// records. The file is trimmed to the newest <see cref="MaxRecords"/> runs once it grows well past that.
+    /// </para>
+    /// </summary>
+    public class PerformanceHistory
+    {
+        /// <summary>
+        /// Runs kept in the history.
+        /// </summary>
+        public const int MaxRecords = 1000;
+
+        // Rates over less than this are dominated by per-request latency and per-file overhead.
+        internal const long MinThroughputBytes = 1024 * 1024;
+
+        // Phases shorter than this in both runs are noise, whatever their relative change.
+        private const double MinPhaseSeconds = 0.1;
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true };
+
+        private readonly string _path;
+        private readonly ILogger _logger;
+        private readonly object _lock = new object();
+
+        public PerformanceHistory(LauncherConfig config)
+        {
+            if (config == null) throw new ArgumentNullException(nameof(config));
+            _path = Path.Combine(config.BaseDataPath, "perf_history.jsonl");
+            _logger = Log.ForContext<PerformanceHistory>();
+            _logger.Verbose("PerformanceHistory initialized at {Path}.", _path);
+        }
+
+        public string FilePath => _path;
+
+        /// <summary>
+        /// Starts measuring a run. This attaches the shared <see cref="MetricsCollector"/>, so the launcher's
+        /// instruments record from here on.
+        /// </summary>
+        public PerformanceRunRecorder BeginRun(string command)
+        {
+            return new PerformanceRunRecorder(MetricsCollector.EnsureShared(), command);
+        }
+
+        /// <summary>
+        /// Appends a run to the history. Failures are logged; the run itself is not affected.
+        /// </summary>
+        public void Append(PerformanceRunRecord record)
+        {
+            if (record == null) throw new ArgumentNullException(nameof(record));
+            byte[] line = Encoding.UTF8.GetBytes(JsonSerializer.Serialize(record, JsonOptions) + "\n");
+            lock (_lock)
+            {
+                try
+                {
+                    Directory.CreateDirectory(Path.GetDirectoryName(_path));
+                    using (var stream = new FileStream(_path, FileMode.Append, FileAccess.Write, FileShare.ReadWrite | FileShare.Delete))
+                    {
+                        stream.Write(line, 0, line.Length);
+                    }
+                    if (new FileInfo(_path).Length > MaxRecords * 2L * line.Length) Trim();
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    _logger.Warning(ex, "Failed to append the run to the performance history at {Path}", _path);
+                }
+            }
+            _logger.Verbose("Recorded {Command} run of {VersionId} in the performance history.", record.Command, record.VersionId);
+        }
+
+        /// <summary>
+        /// Reads every run, oldest first. Unreadable lines are skipped.
+        /// </summary>
+        public List<PerformanceRunRecord> Load()
+        {
+            var records = new List<PerformanceRunRecord>();
+            if (!File.Exists(_path)) return records;
+            try
+            {
+                foreach (string line in File.ReadLines(_path))
+                {
+                    if (string.IsNullOrWhiteSpace(line)) continue;
+                    try
+                    {
+                        PerformanceRunRecord record = JsonSerializer.Deserialize<PerformanceRunRecord>(line, JsonOptions);
+                        if (record != null) records.Add(record);
+                    }
+                    catch (JsonException)
+                    {
+                        // A torn line from a crash mid-append; the rest of the history is still good.
+                    }
+                }
+            }
+            catch (IOException ex)
+            {
+                _logger.Warning(ex, "Could not read the performance history at {Path}", _path);
+            }
+            return records;
+        }
+
+        /// <summary>
+        /// Compares the latest run with the median of the <paramref name="baselineRuns"/> runs before it.
+        /// </summary>
+        /// <param name="versionId">Only consider runs of this version; null uses the version of the latest run.</param>
+        /// <param name="baselineRuns">Runs before the latest that form the baseline.</param>
+        /// <param name="thresholdPercent">Relative change towards worse that counts as a regression.</param>
+        /// <param name="trendRuns">Runs to include in <see cref="PerformanceReport.Trend"/>.</param>
+        /// <returns>The report, or null if there is no run to report on.</returns>
+        public PerformanceReport CreateReport(string versionId = null, int baselineRuns = 10, double thresholdPercent = 20, int trendRuns = 15)
+        {
+            List<PerformanceRunRecord> runs = Load().Where(r => r.Outcome == "ok").ToList();
+            if (runs.Count == 0) return null;
+            versionId ??= runs[^1].VersionId;
+            runs = runs.Where(r => r.VersionId == versionId).ToList();
+            if (runs.Count == 0) return null;
+
+            var report = new PerformanceReport { Latest = runs[^1] };
+            report.Trend.AddRange(runs.Skip(Math.Max(0, runs.Count - trendRuns)));
+            report.Baseline.AddRange(runs.Take(runs.Count - 1).Skip(Math.Max(0, runs.Count - 1 - baselineRuns)));
+            if (report.Baseline.Count == 0) return report;
+
+            PerformanceRunRecord latest = report.Latest;
+            // Lower is better.
+            foreach (string phase in latest.Phases.Keys.Where(p => p != "game" && p != "post_session"))
+            {
+                CompareCost(report, $"phase {phase} (s)", Median(report.Baseline, r => r.Phases.TryGetValue(phase, out double s) ? s : (double?)null),
+                    latest.Phases[phase], thresholdPercent);
+            }
+            CompareCost(report, "launch overhead (s)", Median(report.Baseline, r => r.LaunchOverheadSeconds), latest.LaunchOverheadSeconds, thresholdPercent);
+            // Higher is better.
+            CompareRate(report, "download rate (MB/s)", Median(report.Baseline, r => r.DownloadBytesPerSecond > 0 ? r.DownloadBytesPerSecond / 1e6 : null),
+                latest.DownloadBytesPerSecond > 0 ? latest.DownloadBytesPerSecond / 1e6 : null, thresholdPercent);
+            CompareRate(report, "hash rate (MB/s)", Median(report.Baseline, r => r.HashBytesPerSecond > 0 ? r.HashBytesPerSecond / 1e6 : null),
+                latest.HashBytesPerSecond > 0 ? latest.HashBytesPerSecond / 1e6 : null, thresholdPercent);
+            CompareRate(report, "cache hit rate (%)", Median(report.Baseline, r => r.CacheHitRate * 100), latest.CacheHitRate * 100, thresholdPercent);
+            CompareRate(report, "journal hit rate (%)", Median(report.Baseline, r => r.JournalHitRate * 100), latest.JournalHitRate * 100, thresholdPercent);
+
+            var baselineVersions = report.Baseline.Select(r => r.LauncherVersion).Distinct().ToList();
+            if (baselineVersions.Any(v => v != latest.LauncherVersion))
+            {
+                report.Notes.Add($"launcher version changed: {string.Join(", ", baselineVersions)} -> {latest.LauncherVersion}");
+            }
+            var baselineHosts = report.Baseline.SelectMany(r => r.BytesByHost.Keys).ToHashSet(StringComparer.OrdinalIgnoreCase);
+            var newHosts = latest.BytesByHost.Keys.Where(h => !baselineHosts.Contains(h)).ToList();
+            if (newHosts.Count > 0 && baselineHosts.Count > 0)
+            {
+                report.Notes.Add($"downloads came from new host(s): {string.Join(", ", newHosts)}");
+            }
+            if (latest.Host != null && report.Baseline.Any(r => r.Host != null && !r.Host.Equals(latest.Host)))
+            {
+                report.Notes.Add($"machine changed: now {latest.Host}");
+            }
+            return report;
+        }
+
+        /// <summary>
+        /// Writes the trend table, the comparison with the baseline and any regressions to the log.
+        /// </summary>
+        public void LogReport(PerformanceReport report, double thresholdPercent)
+        {
+            if (report == null)
+            {
+                _logger.Information("No completed install or launch runs recorded in {Path} yet.", _path);
+                return;
+            }
+            _logger.Information("Performance history for {VersionId}: {Count} recent run(s)", report.Latest.VersionId, report.Trend.Count);
+            _logger.Information("  {When,-16} {Launcher,-8} {Overhead,9} {Install,9} {Download,9} {Hash,9} {Cache,6} {Journal,7}",
+                "run (UTC)", "launcher", "launch s", "install s", "dl MB/s", "hash MB/s", "cache", "journal");
+            foreach (PerformanceRunRecord run in report.Trend)
+            {
+                _logger.Information("  {When,-16:yyyy-MM-dd HH:mm} {Launcher,-8} {Overhead,9:F2} {Install,9:F2} {Download,9} {Hash,9} {Cache,6} {Journal,7}",
+                    run.TimestampUtc, run.LauncherVersion, run.LaunchOverheadSeconds,
+                    run.Phases.TryGetValue("install", out double install) ? install : 0,
+                    run.DownloadBytesPerSecond > 0 ? (run.DownloadBytesPerSecond / 1e6).ToString("F1") : "-",
+                    run.HashBytesPerSecond > 0 ? (run.HashBytesPerSecond / 1e6).ToString("F0") : "-",
+                    run.CacheHitRate.HasValue ? (run.CacheHitRate.Value * 100).ToString("F0") + "%" : "-",
+                    run.JournalHitRate.HasValue ? (run.JournalHitRate.Value * 100).ToString("F0") + "%" : "-");
+            }
+
+            if (report.Baseline.Count == 0)
+            {
+                _logger.Information("Only one run recorded for {VersionId}; nothing to compare against yet.", report.Latest.VersionId);
+                return;
+            }
+            foreach (string note in report.Notes)
+            {
+                _logger.Information("Note: {Note}.", note);
+            }
+            if (report.Regressions.Count == 0)
+            {
+                _logger.Information("Latest run is within {Threshold}% of the median of the {Count} run(s) before it.", thresholdPercent, report.Baseline.Count);
+                return;
+            }
+            foreach (PerformanceRegression regression in report.Regressions)
+            {
+                _logger.Warning("REGRESSION {Metric}: {Latest:F2} vs baseline median {Baseline:F2} ({Change:+0;-0}% worse)",
+                    regression.Metric, regression.Latest, regression.Baseline, regression.ChangePercent);
+            }
+        }
+
+        private static void CompareCost(PerformanceReport report, string metric, double? baseline, double? latest, double thresholdPercent)
+        {
+            if (baseline == null || latest == null || Math.Max(baseline.Value, latest.Value) < MinPhaseSeconds) return;
+            double change = baseline.Value > 0 ? (latest.Value - baseline.Value) / baseline.Value * 100 : 100;
+            if (change > thresholdPercent && latest.Value - baseline.Value >= MinPhaseSeconds)
+            {
+                report.Regressions.Add(new PerformanceRegression { Metric = metric, Baseline = baseline.Value, Latest = latest.Value, ChangePercent = change });
+            }
+        }
+
+        private static void CompareRate(PerformanceReport report, string metric, double? baseline, double? latest, double thresholdPercent)
+        {
+            if (baseline == null || latest == null || baseline.Value <= 0) return;
+            double change = (baseline.Value - latest.Value) / baseline.Value * 100;
+            if (change > thresholdPercent)
+            {
+                report.Regressions.Add(new PerformanceRegression { Metric = metric, Baseline = baseline.Value, Latest = latest.Value, ChangePercent = change });
+            }
+        }
+
+        private static double? Median(IEnumerable<PerformanceRunRecord> runs, Func<PerformanceRunRecord, double?> selector)
+        {
+            List<double> values = runs.Select(selector).Where(v => v.HasValue).Select(v => v.Value).OrderBy(v => v).ToList();
+            if (values.Count == 0) return null;
+            int middle = values.Count / 2;
+            return values.Count % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+        }
+
+        // Rewrites the file with the newest MaxRecords runs. Called under _lock.
+        private void Trim()
+        {
+            List<PerformanceRunRecord> records = Load();
+            if (records.Count <= MaxRecords) return;
+            var text = new StringBuilder();
+            foreach (PerformanceRunRecord record in records.Skip(records.Count - MaxRecords))
+            {
+                text.Append(JsonSerializer.Serialize(record, JsonOptions)).Append('\n');
+            }
+            AtomicFile.WriteAllText(_path, text.ToString());
+            _logger.Verbose("Trimmed the performance history to {Count} runs.", MaxRecords);
+        }
+    }
+}
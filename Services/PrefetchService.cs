@@ -0,0 +1,164 @@
+﻿// Services/PrefetchService.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Headless multi-version prefetch. Resolves every selected version's requirements into one deduplicated
+    /// work set (assets by hash, libraries by path, runtimes by component/major version) and runs it through
+    /// a single <see cref="DownloadScheduler"/>. Nothing is launched.
+    /// </summary>
+    public class PrefetchService
+    {
+        private readonly LauncherConfig _config;
+        private readonly VersionCatalog _catalog;
+        private readonly AssetManager _assetManager;
+        private readonly LibraryManager _libraryManager;
+        private readonly JavaManager _javaManager;
+        private readonly DownloadScheduler _scheduler;
+        private readonly ILogger _logger;
+
+        public PrefetchService(
+            LauncherConfig config,
+            VersionCatalog catalog,
+            AssetManager assetManager,
+            LibraryManager libraryManager,
+            JavaManager javaManager,
+            DownloadScheduler scheduler)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _catalog = catalog ?? throw new ArgumentNullException(nameof(catalog));
+            _assetManager = assetManager ?? throw new ArgumentNullException(nameof(assetManager));
+            _libraryManager = libraryManager ?? throw new ArgumentNullException(nameof(libraryManager));
+            _javaManager = javaManager ?? throw new ArgumentNullException(nameof(javaManager));
+            _scheduler = scheduler ?? throw new ArgumentNullException(nameof(scheduler));
+            _logger = Log.ForContext<PrefetchService>();
+            _logger.Verbose("PrefetchService initialized.");
+        }
+
+        /// <summary>
+        /// Prefetches everything required by the versions matching <paramref name="selectors"/>.
+        /// See <see cref="VersionCatalog.ResolveSelectors"/> for the selector syntax.
+        /// </summary>
+        /// <param name="selectors">Version ids, globs or special selectors.</param>
+        /// <param name="includeRuntimes">Whether to also ensure the Java runtimes the versions require.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>True if every selected version's files (and runtimes, if requested) are in place.</returns>
+        public async Task<bool> PrefetchAsync(
+            IReadOnlyCollection<string> selectors,
+            bool includeRuntimes = true,
+            CancellationToken cancellationToken = default)
+        {
+            var manifest = await _catalog.GetManifestAsync(cancellationToken: cancellationToken);
+            if (manifest == null) return false;
+
+            List<VersionMetadata> selected = _catalog.ResolveSelectors(manifest, selectors);
+            if (selected.Count == 0)
+            {
+                _logger.Error("No versions matched the prefetch selectors: {Selectors}", string.Join(", ", selectors));
+                return false;
+            }
+            _logger.Information("Prefetching {Count} version(s): {Versions}", selected.Count, string.Join(", ", selected.Select(v => v.Id)));
+
+            // 1. Resolve every version's requirements into one work set.
+            var workItems = new List<InstallWorkItem>();
+            var runtimes = new Dictionary<(string Component, uint MajorVersion), MinecraftVersion>();
+            bool resolutionOk = true;
+            foreach (var versionMeta in selected)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                MinecraftVersion version = await _catalog.GetVersionAsync(versionMeta, cancellationToken);
+                if (version == null)
+                {
+                    resolutionOk = false;
+                    continue;
+                }
+
+                List<InstallWorkItem> assetItems = await _assetManager.CollectAssetWorkItemsAsync(version, cancellationToken);
+                if (assetItems == null)
+                {
+                    _logger.Error("Could not resolve assets for {VersionId}; its assets will be skipped.", version.Id);
+                    resolutionOk = false;
+                }
+                else
+                {
+                    workItems.AddRange(assetItems);
+                }
+
+                workItems.AddRange(_libraryManager.CollectLibraryWorkItems(version));
+
+                if (version.Downloads.TryGetValue("client", out DownloadDetails client))
+                {
+                    workItems.Add(new InstallWorkItem
+                    {
+                        Kind = InstallWorkKind.ClientJar,
+                        Url = client.Url,
+                        LocalPath = Path.Combine(_config.VersionsDir, version.Id, $"{version.Id}.jar"),
+                        Sha1 = client.Sha1,
+                        Size = client.Size,
+                        Description = $"Client JAR for {version.Id}"
+                    });
+                }
+
+                if (version.JavaVersion != null)
+                {
+                    runtimes.TryAdd((version.JavaVersion.Component, version.JavaVersion.MajorVersion), version);
+                }
+            }
+
+            var uniqueItems = _scheduler.Deduplicate(workItems);
+            _logger.Information("Resolved {Total} file requirement(s) across {Versions} version(s); {Unique} unique after deduplication. {Runtimes} distinct Java runtime(s).",
+                workItems.Count, selected.Count, uniqueItems.Count, runtimes.Count);
+            foreach (var group in uniqueItems.GroupBy(i => i.Kind))
+            {
+                _logger.Information("  {Kind}: {Count} file(s), {Megabytes:F1} MB", group.Key, group.Count(),
+                    group.Sum(i => (double)(i.Size ?? 0)) / (1024 * 1024));
+            }
+
+            // 2. Run the whole set through one scheduler.
+            DownloadRunSummary summary = await _scheduler.RunAsync(uniqueItems, cancellationToken: cancellationToken);
+
+            // 3. Runtimes, once per component/major version.
+            int runtimeFailures = 0;
+            if (includeRuntimes)
+            {
+                foreach (var runtime in runtimes)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    var info = await _javaManager.EnsureJavaForMinecraftVersionAsync(runtime.Value, cancellationToken);
+                    if (info == null)
+                    {
+                        runtimeFailures++;
+                    }
+                }
+            }
+
+            LogSummary(summary, runtimes.Count, runtimeFailures, includeRuntimes);
+            return resolutionOk && summary.Failed == 0 && runtimeFailures == 0;
+        }
+
+        private void LogSummary(DownloadRunSummary summary, int runtimeCount, int runtimeFailures, bool includeRuntimes)
+        {
+            _logger.Information("==================== Prefetch summary ====================");
+            _logger.Information("Files:      {Total} unique, {Downloaded} downloaded, {AlreadyValid} already valid, {Failed} failed",
+                summary.TotalItems, summary.Downloaded, summary.AlreadyValid, summary.Failed);
+            _logger.Information("Bytes:      {Downloaded:F1} MB downloaded, {Verified:F1} MB verified in place",
+                summary.BytesDownloaded / (1024.0 * 1024.0), summary.BytesVerified / (1024.0 * 1024.0));
+            _logger.Information("Throughput: {MBps:F2} MB/s, {ItemsPerSecond:F0} files/s over {Elapsed:F1}s",
+                summary.DownloadMegabytesPerSecond, summary.ItemsPerSecond, summary.Elapsed.TotalSeconds);
+            if (includeRuntimes)
+            {
+                _logger.Information("Runtimes:   {Ok}/{Total} ensured", runtimeCount - runtimeFailures, runtimeCount);
+            }
+            _logger.Information("==========================================================");
+        }
+    }
+}
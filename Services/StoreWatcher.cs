@@ -0,0 +1,236 @@
+﻿// Services/StoreWatcher.cs
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Watches the installed stores (libraries, asset objects, versions and Java runtimes) for changes made while the
+    /// launcher runs, and drops the <see cref="InstallJournal"/> records of every touched file. The next install check
+    /// then hashes exactly those files again, including edits that keep a file's size and modification time, which the
+    /// journal's own stat check cannot see.
+    /// <para>
+    /// Notifications are collected and applied to the journal every <see cref="FlushInterval"/>. Files the launcher
+    /// itself commits (renamed into place from a <c>.part</c> or <c>.tmp</c> file) are verified before the rename and
+    /// are not marked. Renamed or deleted directories mark everything under them.
+    /// </para>
+    /// <para>
+    /// When the kernel's event queue overflows, individual changes are lost. The watcher then re-checks every journal
+    /// record under the watched stores by size and modification time, <see cref="RescanBatchSize"/> records per
+    /// interval, so a burst of activity never turns into one long stall. A new overflow during the rescan restarts it.
+    /// </para>
+    /// </summary>
+    public class StoreWatcher
+    {
+        /// <summary>
+        /// How often collected notifications are applied to the journal.
+        /// </summary>
+        public static readonly TimeSpan FlushInterval = TimeSpan.FromMilliseconds(500);
+
+        /// <summary>
+        /// Journal records re-checked per <see cref="FlushInterval"/> during an overflow rescan.
+        /// </summary>
+        public const int RescanBatchSize = 2000;
+
+        // Largest inotify event buffer FileSystemWatcher accepts; it makes overflows rarer during big installs.
+        private const int EventBufferSize = 64 * 1024;
+
+        private static readonly StringComparer PathComparer = OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+
+        private readonly InstallJournal _journal;
+        private readonly List<string> _roots;
+        private readonly ILogger _logger;
+        private readonly ConcurrentQueue<(string Path, bool Tree)> _events = new ConcurrentQueue<(string, bool)>();
+        private int _overflowed;
+        private long _dirtied;
+        private long _overflows;
+
+        public StoreWatcher(LauncherConfig config, InstallJournal journal)
+        {
+            if (config == null) throw new ArgumentNullException(nameof(config));
+            _journal = journal ?? throw new ArgumentNullException(nameof(journal));
+            _roots = new List<string> { config.LibrariesDir, config.AssetObjectsDir, config.VersionsDir, config.JavaRuntimesDir };
+            _logger = Log.ForContext<StoreWatcher>();
+            _logger.Verbose("StoreWatcher initialized for {Roots}.", string.Join(", ", _roots));
+        }
+
+        /// <summary>
+        /// Journal records dropped because their files changed.
+        /// </summary>
+        public long DirtiedCount => Interlocked.Read(ref _dirtied);
+
+        /// <summary>
+        /// Number of times notifications were lost and a rescan was started.
+        /// </summary>
+        public long OverflowCount => Interlocked.Read(ref _overflows);
+
+        /// <summary>
+        /// Starts watching on the thread pool. The returned task completes when <paramref name="cancellationToken"/>
+        /// is cancelled; it never faults, failures are only logged.
+        /// </summary>
+        public Task Start(CancellationToken cancellationToken)
+        {
+            return Task.Run(async () =>
+            {
+                try
+                {
+                    await RunAsync(cancellationToken).ConfigureAwait(false);
+                }
+                catch (OperationCanceledException)
+                {
+                    _logger.Verbose("Store watcher stopped.");
+                }
+                catch (Exception ex)
+                {
+                    _logger.Error(ex, "Store watcher stopped after an unexpected error.");
+                }
+            }, CancellationToken.None);
+        }
+
+        /// <summary>
+        /// Watches the stores until cancelled.
+        /// </summary>
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            var watchers = new List<FileSystemWatcher>();
+            try
+            {
+                foreach (string root in _roots)
+                {
+                    FileSystemWatcher watcher = CreateWatcher(root);
+                    if (watcher != null) watchers.Add(watcher);
+                }
+                if (watchers.Count == 0)
+                {
+                    _logger.Warning("Store watcher: none of the stores could be watched; changes will only be caught by the usual size and date checks.");
+                    return;
+                }
+                _logger.Information("Watching {Count} store(s) for changes; touched files will be re-verified on the next launch.", watchers.Count);
+
+                List<string> rescan = null;
+                int rescanPosition = 0;
+                while (true)
+                {
+                    await Task.Delay(FlushInterval, cancellationToken).ConfigureAwait(false);
+                    ApplyEvents();
+
+                    if (Interlocked.Exchange(ref _overflowed, 0) != 0)
+                    {
+                        // Everything queued after the overflow is still applied; only what the kernel dropped is unknown.
+                        rescan = _journal.GetVerifiedPaths().Where(IsUnderRoot).ToList();
+                        rescanPosition = 0;
+                        _logger.Warning("Store watcher: change notifications overflowed; re-checking {Count} verified file(s) by size and date.", rescan.Count);
+                    }
+                    if (rescan != null)
+                    {
+                        int end = Math.Min(rescan.Count, rescanPosition + RescanBatchSize);
+                        for (; rescanPosition < end; rescanPosition++)
+                        {
+                            if (_journal.MarkDirtyIfChanged(rescan[rescanPosition])) Interlocked.Increment(ref _dirtied);
+                        }
+                        if (rescanPosition == rescan.Count)
+                        {
+                            _logger.Information("Store watcher: rescan after overflow finished ({Count} file(s) checked).", rescan.Count);
+                            rescan = null;
+                        }
+                    }
+                }
+            }
+            finally
+            {
+                foreach (var watcher in watchers) watcher.Dispose();
+                ApplyEvents();
+                _journal.Flush();
+            }
+        }
+
+        private FileSystemWatcher CreateWatcher(string root)
+        {
+            if (!Directory.Exists(root)) return null;
+            try
+            {
+                var watcher = new FileSystemWatcher(root)
+                {
+                    IncludeSubdirectories = true,
+                    NotifyFilter = NotifyFilters.FileName | NotifyFilters.DirectoryName | NotifyFilters.LastWrite | NotifyFilters.Size,
+                    InternalBufferSize = EventBufferSize
+                };
+                watcher.Changed += (_, e) => Enqueue(e.FullPath, false);
+                watcher.Created += (_, e) => Enqueue(e.FullPath, false);
+                watcher.Deleted += (_, e) => Enqueue(e.FullPath, true);
+                watcher.Renamed += OnRenamed;
+                watcher.Error += OnError;
+                watcher.EnableRaisingEvents = true;
+                return watcher;
+            }
+            catch (Exception ex) when (ex is IOException || ex is ArgumentException || ex is PlatformNotSupportedException || ex is UnauthorizedAccessException)
+            {
+                // Typically the inotify watch limit (fs.inotify.max_user_watches).
+                _logger.Warning(ex, "Store watcher: could not watch {Root}.", root);
+                return null;
+            }
+        }
+
+        private void OnRenamed(object sender, RenamedEventArgs e)
+        {
+            // A commit by a launcher: the content was verified before it was renamed into place.
+            if (IsTempFile(e.OldFullPath) && !IsTempFile(e.FullPath)) return;
+            Enqueue(e.OldFullPath, true);
+            Enqueue(e.FullPath, true);
+        }
+
+        private void OnError(object sender, ErrorEventArgs e)
+        {
+            Interlocked.Increment(ref _overflows);
+            Interlocked.Exchange(ref _overflowed, 1);
+            if (e.GetException() is not InternalBufferOverflowException)
+            {
+                _logger.Warning(e.GetException(), "Store watcher reported an error; scheduling a rescan.");
+            }
+        }
+
+        private void Enqueue(string path, bool tree)
+        {
+            if (IsTempFile(path)) return;
+            _events.Enqueue((path, tree));
+        }
+
+        private void ApplyEvents()
+        {
+            if (_events.IsEmpty) return;
+            var files = new HashSet<string>(PathComparer);
+            var trees = new HashSet<string>(PathComparer);
+            while (_events.TryDequeue(out var e))
+            {
+                (e.Tree ? trees : files).Add(e.Path);
+            }
+            int dropped = _journal.MarkDirty(files, trees);
+            if (dropped > 0)
+            {
+                Interlocked.Add(ref _dirtied, dropped);
+                _logger.Information("Store watcher: {Count} verified file(s) changed on disk and will be re-verified.", dropped);
+            }
+        }
+
+        private bool IsUnderRoot(string path)
+        {
+            foreach (string root in _roots)
+            {
+                if (path.StartsWith(root + Path.DirectorySeparatorChar, OperatingSystem.IsWindows() ? StringComparison.OrdinalIgnoreCase : StringComparison.Ordinal)) return true;
+            }
+            return false;
+        }
+
+        private static bool IsTempFile(string path)
+        {
+            return path.EndsWith(AtomicFile.TempSuffix, StringComparison.Ordinal) || path.EndsWith(InstallJournal.PartialSuffix, StringComparison.Ordinal);
+        }
+    }
+}
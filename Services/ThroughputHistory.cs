@@ -0,0 +1,103 @@
+﻿// Services/ThroughputHistory.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text.Json;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Keeps the download throughput of the last few scheduler runs on disk so that install plans can estimate
+    /// how long their downloads will take on this machine and connection.
+    /// </summary>
+    public class ThroughputHistory
+    {
+        private const int MaxSamples = 20;
+
+        // Runs that moved less than this are dominated by per-request latency and would skew the estimate.
+        private const long MinSampleBytes = 1024 * 1024;
+
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true, WriteIndented = true };
+
+        private readonly string _path;
+        private readonly ILogger _logger;
+        private readonly object _lock = new object();
+
+        public ThroughputHistory(LauncherConfig config)
+        {
+            if (config == null) throw new ArgumentNullException(nameof(config));
+            _path = Path.Combine(config.BaseDataPath, "download_throughput.json");
+            _logger = Log.ForContext<ThroughputHistory>();
+        }
+
+        /// <summary>
+        /// Records the downloads of a finished scheduler run. Runs that downloaded too little are ignored.
+        /// </summary>
+        public void Record(DownloadRunSummary summary)
+        {
+            if (summary == null || summary.BytesDownloaded < MinSampleBytes || summary.Elapsed <= TimeSpan.Zero) return;
+
+            lock (_lock)
+            {
+                var samples = Load();
+                samples.Add(new ThroughputSample
+                {
+                    TimestampUtc = DateTime.UtcNow,
+                    Bytes = summary.BytesDownloaded,
+                    Files = summary.Downloaded,
+                    Seconds = summary.Elapsed.TotalSeconds
+                });
+                if (samples.Count > MaxSamples) samples.RemoveRange(0, samples.Count - MaxSamples);
+
+                try
+                {
+                    AtomicFile.WriteAllText(_path, JsonSerializer.Serialize(samples, JsonOptions));
+                }
+                catch (Exception ex)
+                {
+                    _logger.Warning(ex, "Failed to write throughput history to {Path}", _path);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Average download rate over the recorded runs, in bytes per second, or null if nothing has been recorded yet.
+        /// </summary>
+        public double? GetRecentBytesPerSecond()
+        {
+            List<ThroughputSample> samples;
+            lock (_lock) { samples = Load(); }
+
+            double seconds = samples.Sum(s => s.Seconds);
+            if (samples.Count == 0 || seconds <= 0) return null;
+            return samples.Sum(s => (double)s.Bytes) / seconds;
+        }
+
+        private List<ThroughputSample> Load()
+        {
+            try
+            {
+                if (File.Exists(_path))
+                {
+                    return JsonSerializer.Deserialize<List<ThroughputSample>>(File.ReadAllText(_path), JsonOptions) ?? new List<ThroughputSample>();
+                }
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Ignoring unreadable throughput history at {Path}", _path);
+            }
+            return new List<ThroughputSample>();
+        }
+
+        private class ThroughputSample
+        {
+            public DateTime TimestampUtc { get; set; }
+            public long Bytes { get; set; }
+            public int Files { get; set; }
+            public double Seconds { get; set; }
+        }
+    }
+}
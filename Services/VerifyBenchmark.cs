@@ -0,0 +1,138 @@
+﻿// Services/VerifyBenchmark.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Result of verifying one file set with one method.
+    /// </summary>
+    public class VerifyBenchmarkResult
+    {
+        public string Method { get; set; }
+        public int Files { get; set; }
+        public long Bytes { get; set; }
+        public int Invalid { get; set; }
+        public TimeSpan Elapsed { get; set; }
+
+        public double FilesPerSecond => Elapsed.TotalSeconds > 0 ? Files / Elapsed.TotalSeconds : 0;
+        public double MegabytesPerSecond => Elapsed.TotalSeconds > 0 ? Bytes / (1024.0 * 1024.0) / Elapsed.TotalSeconds : 0;
+    }
+
+    /// <summary>
+    /// Compares full verification of an installed version's files through the per-file
+    /// <see cref="CryptoUtils.CalculateFileSHA1Async"/> (at the scheduler's concurrency) against the bulk
+    /// <see cref="CryptoUtils.VerifyFilesAsync"/>, with the platform SHA-1 and with <see cref="MultiBufferSha1"/> for
+    /// small files. Only files already on disk are used; nothing is downloaded.
+    /// Both methods run against a warm page cache (a discarded warm-up pass reads everything first), so the numbers
+    /// measure per-file overhead and hashing rather than the disk.
+    /// </summary>
+    public class VerifyBenchmark
+    {
+        private readonly ILogger _logger;
+
+        public VerifyBenchmark()
+        {
+            _logger = Log.ForContext<VerifyBenchmark>();
+            _logger.Verbose("VerifyBenchmark initialized.");
+        }
+
+        /// <summary>
+        /// Verifies the files of <paramref name="items"/> with each method and logs a comparison.
+        /// </summary>
+        /// <param name="items">Work items of an installed version (client JAR, libraries, assets).</param>
+        /// <param name="parallelism">Concurrent readers for both methods; 0 uses each method's default.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public async Task<List<VerifyBenchmarkResult>> RunAsync(IReadOnlyList<InstallWorkItem> items, int parallelism = 0, CancellationToken cancellationToken = default)
+        {
+            if (items == null) throw new ArgumentNullException(nameof(items));
+            var requests = items
+                .Where(i => !string.IsNullOrEmpty(i.Sha1) && File.Exists(i.LocalPath))
+                .GroupBy(i => Path.GetFullPath(i.LocalPath))
+                .Select(g => new FileVerificationRequest(g.Key, (long?)g.First().Size, g.First().Sha1))
+                .ToList();
+            var results = new List<VerifyBenchmarkResult>();
+            if (requests.Count == 0)
+            {
+                _logger.Warning("Verify benchmark: none of the version's files are on disk; install it first.");
+                return results;
+            }
+
+            int bulkParallelism = parallelism > 0 ? parallelism : CryptoUtils.GetRecommendedVerifyParallelism(requests[0].Path);
+            int perFileParallelism = parallelism > 0 ? parallelism : Environment.ProcessorCount;
+            _logger.Information("Verify benchmark: {Count} files, {Mb:F1} MB; per-file concurrency {PerFile}, bulk readers {Bulk}{Rotational}.",
+                requests.Count, requests.Sum(r => r.ExpectedSize ?? 0) / (1024.0 * 1024.0), perFileParallelism, bulkParallelism,
+                StorageInfo.IsRotational(requests[0].Path) ? " (rotational disk)" : string.Empty);
+
+            await CryptoUtils.VerifyFilesAsync(requests, bulkParallelism, cancellationToken: cancellationToken).ConfigureAwait(false);
+
+            results.Add(await RunPerFileAsync(requests, perFileParallelism, cancellationToken).ConfigureAwait(false));
+            bool? useMultiBuffer = CryptoUtils.UseMultiBufferSha1;
+            try
+            {
+                CryptoUtils.UseMultiBufferSha1 = false;
+                results.Add(await RunBulkAsync("bulk", requests, bulkParallelism, cancellationToken).ConfigureAwait(false));
+                if (MultiBufferSha1.IsEnabled)
+                {
+                    CryptoUtils.UseMultiBufferSha1 = true;
+                    results.Add(await RunBulkAsync("bulk-simd", requests, bulkParallelism, cancellationToken).ConfigureAwait(false));
+                    _logger.Information("Multi-buffer SHA-1 is {Choice} by default on this machine.", MultiBufferSha1.IsPreferred ? "used" : "not used");
+                }
+                else
+                {
+                    _logger.Information("Multi-buffer SHA-1 is not available on this CPU (AVX2 {Avx2}); skipping the bulk-simd run.", MultiBufferSha1.IsHardwareAccelerated);
+                }
+            }
+            finally
+            {
+                CryptoUtils.UseMultiBufferSha1 = useMultiBuffer;
+            }
+
+            _logger.Information("{Method,-10} {Files,8} {Mb,9} {Seconds,10} {FilesPerSec,10} {MBps,8} {Invalid,8}",
+                "method", "files", "MB", "elapsed s", "files/s", "MB/s", "invalid");
+            foreach (var r in results)
+            {
+                _logger.Information("{Method,-10} {Files,8} {Mb,9:F1} {Seconds,10:F2} {FilesPerSec,10:F0} {MBps,8:F1} {Invalid,8}",
+                    r.Method, r.Files, r.Bytes / (1024.0 * 1024.0), r.Elapsed.TotalSeconds, r.FilesPerSecond, r.MegabytesPerSecond, r.Invalid);
+            }
+            return results;
+        }
+
+        private static async Task<VerifyBenchmarkResult> RunPerFileAsync(List<FileVerificationRequest> requests, int parallelism, CancellationToken cancellationToken)
+        {
+            int invalid = 0;
+            long bytes = requests.Sum(r => new FileInfo(r.Path).Length);
+            var stopwatch = Stopwatch.StartNew();
+            await Parallel.ForEachAsync(requests, new ParallelOptions { MaxDegreeOfParallelism = parallelism, CancellationToken = cancellationToken }, async (request, ct) =>
+            {
+                string actual = await CryptoUtils.CalculateFileSHA1Async(request.Path, ct).ConfigureAwait(false);
+                if (!string.Equals(actual, request.ExpectedSha1, StringComparison.OrdinalIgnoreCase)) Interlocked.Increment(ref invalid);
+            }).ConfigureAwait(false);
+            stopwatch.Stop();
+            return new VerifyBenchmarkResult { Method = "per-file", Files = requests.Count, Bytes = bytes, Invalid = invalid, Elapsed = stopwatch.Elapsed };
+        }
+
+        private static async Task<VerifyBenchmarkResult> RunBulkAsync(string method, List<FileVerificationRequest> requests, int parallelism, CancellationToken cancellationToken)
+        {
+            var stopwatch = Stopwatch.StartNew();
+            var results = await CryptoUtils.VerifyFilesAsync(requests, parallelism, cancellationToken: cancellationToken).ConfigureAwait(false);
+            stopwatch.Stop();
+            return new VerifyBenchmarkResult
+            {
+                Method = method,
+                Files = results.Length,
+                Bytes = results.Sum(r => Math.Max(0, r.ActualSize)),
+                Invalid = results.Count(r => !r.IsValid),
+                Elapsed = stopwatch.Elapsed
+            };
+        }
+    }
+}
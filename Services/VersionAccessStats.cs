@@ -0,0 +1,94 @@
+﻿// Services/VersionAccessStats.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text.Json;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Launch statistics of one version.
+    /// </summary>
+    public class VersionAccessRecord
+    {
+        public DateTime LastLaunchUtc { get; set; }
+        public int LaunchCount { get; set; }
+    }
+
+    /// <summary>
+    /// Records when each version was last launched, in <c>&lt;data&gt;/version_access.json</c>.
+    /// Storage tiering uses it to decide which versions are cold.
+    /// </summary>
+    public class VersionAccessStats
+    {
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true, WriteIndented = true };
+
+        private readonly string _path;
+        private readonly ILogger _logger;
+        private readonly object _lock = new object();
+
+        public VersionAccessStats(LauncherConfig config)
+        {
+            if (config == null) throw new ArgumentNullException(nameof(config));
+            _path = Path.Combine(config.BaseDataPath, "version_access.json");
+            _logger = Log.ForContext<VersionAccessStats>();
+        }
+
+        /// <summary>
+        /// Records a launch of <paramref name="versionId"/> now.
+        /// </summary>
+        public void RecordLaunch(string versionId)
+        {
+            lock (_lock)
+            {
+                var records = Load();
+                if (!records.TryGetValue(versionId, out var record))
+                {
+                    record = new VersionAccessRecord();
+                    records[versionId] = record;
+                }
+                record.LastLaunchUtc = DateTime.UtcNow;
+                record.LaunchCount++;
+
+                try
+                {
+                    AtomicFile.WriteAllText(_path, JsonSerializer.Serialize(records, JsonOptions));
+                }
+                catch (Exception ex)
+                {
+                    _logger.Warning(ex, "Failed to write version access statistics to {Path}", _path);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Returns the statistics of every version launched so far.
+        /// </summary>
+        public Dictionary<string, VersionAccessRecord> GetAll()
+        {
+            lock (_lock)
+            {
+                return Load();
+            }
+        }
+
+        private Dictionary<string, VersionAccessRecord> Load()
+        {
+            try
+            {
+                if (File.Exists(_path))
+                {
+                    var records = JsonSerializer.Deserialize<Dictionary<string, VersionAccessRecord>>(File.ReadAllText(_path), JsonOptions);
+                    if (records != null) return new Dictionary<string, VersionAccessRecord>(records, StringComparer.Ordinal);
+                }
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Ignoring unreadable version access statistics at {Path}", _path);
+            }
+            return new Dictionary<string, VersionAccessRecord>(StringComparer.Ordinal);
+        }
+    }
+}
@@ -0,0 +1,288 @@
+﻿// Services/VersionCatalog.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Text.Json;
+using System.Text.RegularExpressions;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Models;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Fetches and caches Mojang's version manifest and per-version JSON files.
+    /// The manifest is fetched at most once per instance; version JSONs are cached under
+    /// <c>versions/&lt;id&gt;/&lt;id&gt;.json</c> and reused while their SHA1 matches the manifest entry.
+    /// </summary>
+    public class VersionCatalog
+    {
+        private static readonly JsonSerializerOptions JsonOptions = new JsonSerializerOptions { PropertyNameCaseInsensitive = true };
+
+        private readonly LauncherConfig _config;
+        private readonly HttpManager _httpManager;
+        private readonly ILogger _logger;
+        private readonly SemaphoreSlim _manifestLock = new SemaphoreSlim(1, 1);
+        private VersionManifest _manifest;
+
+        public VersionCatalog(LauncherConfig config, HttpManager httpManager)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _httpManager = httpManager ?? throw new ArgumentNullException(nameof(httpManager));
+            _logger = Log.ForContext<VersionCatalog>();
+            _logger.Verbose("VersionCatalog initialized.");
+        }
+
+        /// <summary>
+        /// Path of the on-disk copy of the last successfully fetched manifest.
+        /// </summary>
+        public string ManifestCachePath => Path.Combine(_config.BaseDataPath, "version_manifest_v2.json");
+
+        /// <summary>
+        /// Gets the version manifest. The first call fetches it from Mojang (falling back to the on-disk copy
+        /// if the network is unavailable); later calls reuse the parsed result unless <paramref name="forceRefresh"/> is set.
+        /// </summary>
+        /// <returns>The parsed manifest, or null if it could not be obtained.</returns>
+        public async Task<VersionManifest> GetManifestAsync(bool forceRefresh = false, CancellationToken cancellationToken = default)
+        {
+            using Activity activity = LauncherTracing.Start("catalog.manifest");
+            await _manifestLock.WaitAsync(cancellationToken).ConfigureAwait(false);
+            try
+            {
+                if (_manifest != null && !forceRefresh)
+                {
+                    activity?.SetTag("cache", "memory");
+                    LauncherMetrics.CacheLookups.Add(1, LauncherMetrics.Tag("kind", "VersionManifest"), LauncherMetrics.Tag("result", "hit"));
+                    return _manifest;
+                }
+
+                _logger.Information("Fetching Minecraft version manifest from Mojang...");
+                LauncherMetrics.CacheLookups.Add(1, LauncherMetrics.Tag("kind", "VersionManifest"), LauncherMetrics.Tag("result", "miss"));
+                HttpResponseMessage response = await _httpManager.GetAsync(_config.VersionManifestUrl, cancellationToken: cancellationToken);
+                cancellationToken.ThrowIfCancellationRequested();
+
+                string manifestJson = null;
+                if (response.IsSuccessStatusCode)
+                {
+                    manifestJson = await response.Content.ReadAsStringAsync(cancellationToken);
+                    activity?.SetTag("cache", "network");
+                    _logger.Information("Successfully fetched version manifest (status {StatusCode}). Size: {Length} bytes",
+                        response.StatusCode, manifestJson.Length);
+                    TryWriteCache(ManifestCachePath, manifestJson);
+                }
+                else
+                {
+                    _logger.Warning("Failed to fetch version manifest. Status: {StatusCode}, Reason: {ReasonPhrase}. Trying cached copy at {CachePath}.",
+                        response.StatusCode, response.ReasonPhrase, ManifestCachePath);
+                    manifestJson = TryReadCache(ManifestCachePath);
+                    activity?.SetTag("cache", "disk");
+                }
+
+                if (manifestJson == null)
+                {
+                    _logger.Error("No version manifest available (network fetch failed and no cached copy).");
+                    return null;
+                }
+
+                var manifest = JsonSerializer.Deserialize<VersionManifest>(manifestJson, JsonOptions);
+                if (manifest?.Versions == null)
+                {
+                    _logger.Error("Failed to parse version manifest or no versions found.");
+                    return null;
+                }
+                _logger.Verbose("Version manifest JSON parsed successfully. Found {Count} versions.", manifest.Versions.Count);
+                _manifest = manifest;
+                return _manifest;
+            }
+            finally
+            {
+                _manifestLock.Release();
+            }
+        }
+
+        /// <summary>
+        /// Gets the parsed version JSON for a manifest entry, using the cached copy under the versions directory
+        /// when its SHA1 matches.
+        /// </summary>
+        /// <returns>The parsed version, or null on failure.</returns>
+        public async Task<MinecraftVersion> GetVersionAsync(VersionMetadata versionMeta, CancellationToken cancellationToken = default)
+        {
+            if (versionMeta == null || string.IsNullOrEmpty(versionMeta.Url))
+            {
+                _logger.Error("Version metadata is missing or has no URL.");
+                return null;
+            }
+
+            using Activity activity = LauncherTracing.Start("catalog.version");
+            activity?.SetTag("version.id", versionMeta.Id);
+            string versionJsonPath = GetVersionJsonPath(versionMeta.Id);
+            string versionJson = null;
+
+            if (File.Exists(versionJsonPath) && !string.IsNullOrEmpty(versionMeta.Sha1))
+            {
+                string cachedSha1 = await CryptoUtils.CalculateFileSHA1Async(versionJsonPath, cancellationToken);
+                if (cachedSha1 != null && cachedSha1.Equals(versionMeta.Sha1, StringComparison.OrdinalIgnoreCase))
+                {
+                    _logger.Verbose("Using cached version JSON for '{VersionId}' at {Path}", versionMeta.Id, versionJsonPath);
+                    versionJson = await File.ReadAllTextAsync(versionJsonPath, cancellationToken);
+                    activity?.SetTag("cache", "disk");
+                }
+            }
+
+            LauncherMetrics.CacheLookups.Add(1, LauncherMetrics.Tag("kind", "VersionJson"), LauncherMetrics.Tag("result", versionJson != null ? "hit" : "miss"));
+            if (versionJson == null)
+            {
+                _logger.Information("Fetching details for version '{VersionId}'...", versionMeta.Id);
+                activity?.SetTag("cache", "network");
+                HttpResponseMessage response = await _httpManager.GetAsync(versionMeta.Url, cancellationToken: cancellationToken);
+                cancellationToken.ThrowIfCancellationRequested();
+
+                if (!response.IsSuccessStatusCode)
+                {
+                    string errorContent = await response.Content.ReadAsStringAsync(cancellationToken);
+                    _logger.Error("Failed to fetch version details for '{VersionId}'. Status: {StatusCode}, URL: {Url}, Error: {ErrorContent}",
+                        versionMeta.Id, response.StatusCode, versionMeta.Url, errorContent);
+                    return null;
+                }
+                versionJson = await response.Content.ReadAsStringAsync(cancellationToken);
+                _logger.Information("Successfully fetched version details for '{VersionId}'. Size: {Length} bytes",
+                    versionMeta.Id, versionJson.Length);
+                TryWriteCache(versionJsonPath, versionJson);
+            }
+
+            MinecraftVersion version = JsonSerializer.Deserialize<MinecraftVersion>(versionJson, JsonOptions);
+            if (version == null)
+            {
+                _logger.Error("Failed to parse details for version '{VersionId}'.", versionMeta.Id);
+                return null;
+            }
+            return version;
+        }
+
+        /// <summary>
+        /// Convenience overload resolving a version id through the manifest.
+        /// </summary>
+        public async Task<MinecraftVersion> GetVersionAsync(string versionId, CancellationToken cancellationToken = default)
+        {
+            var manifest = await GetManifestAsync(cancellationToken: cancellationToken);
+            var meta = manifest?.Versions.FirstOrDefault(v => v.Id == versionId);
+            if (meta == null)
+            {
+                _logger.Error("Target version '{VersionId}' not found in manifest.", versionId);
+                return null;
+            }
+            return await GetVersionAsync(meta, cancellationToken);
+        }
+
+        /// <summary>
+        /// Resolves a list of version selectors against the manifest. Supported selectors:
+        /// <list type="bullet">
+        /// <item><c>latest</c>, <c>latest-release</c>, <c>latest-snapshot</c></item>
+        /// <item><c>type:&lt;type&gt;</c> (e.g., <c>type:release</c>) for every version of that type</item>
+        /// <item>glob patterns using <c>*</c> and <c>?</c> (e.g., <c>1.20.*</c>)</item>
+        /// <item>exact version ids</item>
+        /// </list>
+        /// </summary>
+        /// <returns>The matching manifest entries in manifest order, without duplicates.</returns>
+        public List<VersionMetadata> ResolveSelectors(VersionManifest manifest, IEnumerable<string> selectors)
+        {
+            var selected = new HashSet<string>(StringComparer.Ordinal);
+            foreach (string rawSelector in selectors)
+            {
+                string selector = rawSelector?.Trim();
+                if (string.IsNullOrEmpty(selector)) continue;
+
+                List<VersionMetadata> matches;
+                if (selector.Equals("latest", StringComparison.OrdinalIgnoreCase) ||
+                    selector.Equals("latest-release", StringComparison.OrdinalIgnoreCase))
+                {
+                    matches = manifest.Versions.Where(v => v.Id == manifest.Latest?.Release).ToList();
+                }
+                else if (selector.Equals("latest-snapshot", StringComparison.OrdinalIgnoreCase))
+                {
+                    matches = manifest.Versions.Where(v => v.Id == manifest.Latest?.Snapshot).ToList();
+                }
+                else if (selector.StartsWith("type:", StringComparison.OrdinalIgnoreCase))
+                {
+                    string type = selector.Substring("type:".Length);
+                    matches = manifest.Versions.Where(v => string.Equals(v.Type, type, StringComparison.OrdinalIgnoreCase)).ToList();
+                }
+                else if (selector.Contains('*') || selector.Contains('?'))
+                {
+                    var regex = new Regex("^" + Regex.Escape(selector).Replace("\\*", ".*").Replace("\\?", ".") + "$", RegexOptions.IgnoreCase);
+                    matches = manifest.Versions.Where(v => regex.IsMatch(v.Id)).ToList();
+                }
+                else
+                {
+                    matches = manifest.Versions.Where(v => v.Id == selector).ToList();
+                }
+
+                if (matches.Count == 0)
+                {
+                    _logger.Warning("Version selector '{Selector}' did not match any version in the manifest.", selector);
+                }
+                else
+                {
+                    _logger.Information("Version selector '{Selector}' matched {Count} version(s).", selector, matches.Count);
+                }
+                foreach (var match in matches) selected.Add(match.Id);
+            }
+
+            return manifest.Versions.Where(v => selected.Contains(v.Id)).ToList();
+        }
+
+        /// <summary>
+        /// Gets the on-disk path of a version's JSON file.
+        /// </summary>
+        public string GetVersionJsonPath(string versionId) => Path.Combine(_config.VersionsDir, versionId, $"{versionId}.json");
+
+        /// <summary>
+        /// Parses the version JSON cached under the versions directory, without touching the network.
+        /// </summary>
+        /// <returns>The parsed version, or null if it is not cached or cannot be parsed.</returns>
+        public MinecraftVersion TryLoadCachedVersion(string versionId)
+        {
+            string versionJsonPath = GetVersionJsonPath(versionId);
+            if (!File.Exists(versionJsonPath)) return null;
+            try
+            {
+                return JsonSerializer.Deserialize<MinecraftVersion>(File.ReadAllText(versionJsonPath), JsonOptions);
+            }
+            catch (Exception ex) when (ex is IOException || ex is JsonException || ex is UnauthorizedAccessException)
+            {
+                _logger.Warning(ex, "Could not read cached version JSON {Path}", versionJsonPath);
+                return null;
+            }
+        }
+
+        private void TryWriteCache(string path, string content)
+        {
+            try
+            {
+                AtomicFile.WriteAllText(path, content);
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to write cache file {Path}", path);
+            }
+        }
+
+        private string TryReadCache(string path)
+        {
+            try
+            {
+                return File.Exists(path) ? File.ReadAllText(path) : null;
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Failed to read cache file {Path}", path);
+                return null;
+            }
+        }
+    }
+}
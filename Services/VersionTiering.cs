@@ -0,0 +1,447 @@
+﻿// Services/VersionTiering.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.IO.Compression;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ObsidianLauncher.Utils;
+using Serilog;
+
+namespace ObsidianLauncher.Services
+{
+    /// <summary>
+    /// Outcome of <see cref="VersionTiering.ApplyBudgetAsync"/>.
+    /// </summary>
+    public class TieringReport
+    {
+        public bool Executed { get; set; }
+        public long BudgetBytes { get; set; }
+
+        /// <summary>
+        /// Versions kept expanded, most recently launched first.
+        /// </summary>
+        public List<string> Hot { get; } = new List<string>();
+
+        /// <summary>
+        /// Versions outside the budget (packed, or to be packed in a dry run).
+        /// </summary>
+        public List<string> Cold { get; } = new List<string>();
+
+        /// <summary>
+        /// Cold versions left expanded because a launcher is using them, along with every file they reference.
+        /// </summary>
+        public List<string> InUse { get; } = new List<string>();
+
+        /// <summary>
+        /// Bytes of expanded content attributed to the hot versions (shared files counted once).
+        /// </summary>
+        public long HotBytes { get; set; }
+
+        public int PacksWritten { get; set; }
+        public long PackBytes { get; set; }
+
+        /// <summary>
+        /// Bytes of expanded files removed (or that would be removed) because they now live in packs.
+        /// </summary>
+        public long FreedBytes { get; set; }
+    }
+
+    /// <summary>
+    /// Keeps recently launched versions expanded within a disk budget and moves the rest into compressed packs.
+    /// <para>
+    /// Versions are ranked by last launch (<see cref="VersionAccessStats"/>; never-launched versions by the age of their
+    /// directory). Walking from the most recent one, each version is charged for the files it references that no
+    /// more recent version already paid for. The first version that does not fit makes it and every older version cold.
+    /// A cold version's pack, <c>&lt;data&gt;/packs/&lt;version&gt;.zip</c>, holds every file it references that no hot version uses.
+    /// This includes the client JAR and natives but not the version JSON, so the version stays installed and resolvable.
+    /// The zip's central directory is the pack index. Once a pack is written and synced, its files are deleted from the store.
+    /// </para>
+    /// <para>
+    /// <see cref="RehydrateAsync"/> restores a packed version from local disk before launch. The install then re-verifies
+    /// every file as usual. Files shared by several cold versions are stored in each of their packs, so every pack can be
+    /// restored on its own. With the io_uring backend, small files are written in batches. Java runtimes are not tiered.
+    /// Tiering and rehydration run under the store lock, like garbage collection. Launches hold their version's in-use
+    /// lock (<see cref="AcquireInUseAsync"/>) until the game exits, and tiering leaves versions whose lock it cannot take alone.
+    /// </para>
+    /// </summary>
+    public class VersionTiering
+    {
+        private const string PackExtension = ".zip";
+
+        private static readonly StringComparer PathComparer = OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+
+        private readonly LauncherConfig _config;
+        private readonly ContentStore _store;
+        private readonly VersionAccessStats _accessStats;
+        private readonly FileLockManager _locks;
+        private readonly ILogger _logger;
+
+        public VersionTiering(LauncherConfig config, ContentStore store, VersionAccessStats accessStats, FileLockManager locks)
+        {
+            _config = config ?? throw new ArgumentNullException(nameof(config));
+            _store = store ?? throw new ArgumentNullException(nameof(store));
+            _accessStats = accessStats ?? throw new ArgumentNullException(nameof(accessStats));
+            _locks = locks ?? throw new ArgumentNullException(nameof(locks));
+            _logger = Log.ForContext<VersionTiering>();
+            _logger.Verbose("VersionTiering initialized with packs at {PacksDir}.", _config.PacksDir);
+        }
+
+        /// <summary>
+        /// Path of the pack a version is stored in while cold.
+        /// </summary>
+        public static string GetPackPath(LauncherConfig config, string versionId) => Path.Combine(config.PacksDir, versionId + PackExtension);
+
+        /// <summary>
+        /// Key of the lock launches hold (shared) while a version is being installed or played.
+        /// </summary>
+        public static string GetInUseLockKey(string versionId) => $"version-{versionId}";
+
+        /// <summary>
+        /// Marks a version as in use until the returned lease is disposed, so tiering does not pack it or remove its
+        /// files. Take it before planning and keep it until the game exits; it waits while tiering is packing the version.
+        /// </summary>
+        public Task<FileLease> AcquireInUseAsync(string versionId, CancellationToken cancellationToken = default)
+        {
+            return _locks.AcquireSharedAsync(GetInUseLockKey(versionId), cancellationToken);
+        }
+
+        /// <summary>
+        /// Returns true if the version is currently packed.
+        /// </summary>
+        public bool IsPacked(string versionId) => File.Exists(GetPackPath(_config, versionId));
+
+        /// <summary>
+        /// Restores every file of a packed version that is missing from the store, then deletes the pack.
+        /// </summary>
+        /// <returns>True if the version is expanded (or was not packed).</returns>
+        public async Task<bool> RehydrateAsync(string versionId, CancellationToken cancellationToken = default)
+        {
+            string packPath = GetPackPath(_config, versionId);
+            if (!File.Exists(packPath)) return true;
+
+            using FileLease lease = await _locks.AcquireAsync(ContentStore.GcLockKey, $"rehydrating {versionId}", cancellationToken).ConfigureAwait(false);
+            if (!File.Exists(packPath)) return true; // Another launcher restored it while we waited.
+
+            var stopwatch = Stopwatch.StartNew();
+            int restored = 0;
+            long restoredBytes = 0;
+            try
+            {
+                using (ZipArchive pack = ZipFile.OpenRead(packPath))
+                using (IoUringFileBatch batch = IoUringFileBatch.TryCreate())
+                {
+                    // With the io_uring backend, small entries are decompressed into memory and written a batch at a time.
+                    var pending = new List<(ZipArchiveEntry Entry, string Path, ReadOnlyMemory<byte> Content)>(IoUringFileBatch.Capacity);
+                    foreach (ZipArchiveEntry entry in pack.Entries)
+                    {
+                        cancellationToken.ThrowIfCancellationRequested();
+                        if (string.IsNullOrEmpty(entry.Name)) continue; // Directory entry.
+                        string targetPath = _store.FromStorePath(entry.FullName);
+                        if (File.Exists(targetPath)) continue;
+
+                        Directory.CreateDirectory(Path.GetDirectoryName(targetPath));
+                        if (batch != null && entry.Length <= IoUringFileBatch.MaxFileSize)
+                        {
+                            pending.Add((entry, targetPath, ReadEntry(entry)));
+                            if (pending.Count == IoUringFileBatch.Capacity) WriteBatch(batch, pending);
+                        }
+                        else
+                        {
+                            AtomicFile.ExtractEntry(entry, targetPath);
+                        }
+                        restored++;
+                        restoredBytes += entry.Length;
+                    }
+                    if (pending.Count > 0) WriteBatch(batch, pending);
+                }
+                File.Delete(packPath);
+            }
+            catch (Exception ex) when (ex is IOException || ex is InvalidDataException || ex is UnauthorizedAccessException)
+            {
+                // Whatever could not be restored is missing from the store and will simply be downloaded again.
+                _logger.Error(ex, "Failed to rehydrate {VersionId} from {PackPath}; missing files will be re-downloaded.", versionId, packPath);
+                return false;
+            }
+
+            _logger.Information("Rehydrated {VersionId}: restored {Count} file(s) ({Mb:F1} MB) from its pack in {Elapsed:F1}s.",
+                versionId, restored, restoredBytes / (1024.0 * 1024.0), stopwatch.Elapsed.TotalSeconds);
+            return true;
+        }
+
+        private static byte[] ReadEntry(ZipArchiveEntry entry)
+        {
+            var content = new byte[entry.Length];
+            using Stream stream = entry.Open();
+            stream.ReadExactly(content);
+            return content;
+        }
+
+        /// <summary>
+        /// Writes the pending entries through <paramref name="batch"/>; any that fail are extracted the regular way.
+        /// </summary>
+        private void WriteBatch(IoUringFileBatch batch, List<(ZipArchiveEntry Entry, string Path, ReadOnlyMemory<byte> Content)> pending)
+        {
+            Span<int> results = stackalloc int[IoUringFileBatch.Capacity];
+            batch.WriteFiles(pending.Select(p => (p.Path, p.Content)).ToList(), results);
+            for (int i = 0; i < pending.Count; i++)
+            {
+                if (results[i] == 0) continue;
+                _logger.Verbose("Batched write of {Path} failed (errno {Errno}); extracting it directly.", pending[i].Path, -results[i]);
+                AtomicFile.ExtractEntry(pending[i].Entry, pending[i].Path);
+            }
+            pending.Clear();
+        }
+
+        /// <summary>
+        /// Splits installed versions into hot and cold by last launch and, with <paramref name="execute"/>, packs the
+        /// cold ones and removes their expanded files.
+        /// </summary>
+        /// <param name="budgetBytes">Disk space the expanded versions may use. The most recent version is always kept.</param>
+        /// <param name="execute">False for a dry run.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        public async Task<TieringReport> ApplyBudgetAsync(long budgetBytes, bool execute, CancellationToken cancellationToken = default)
+        {
+            var report = new TieringReport { Executed = execute, BudgetBytes = budgetBytes };
+            using FileLease lease = await _locks.AcquireAsync(ContentStore.GcLockKey, execute ? "tiering versions" : "tiering versions (dry run)", cancellationToken).ConfigureAwait(false);
+
+            // 1. Rank installed versions by last use.
+            Dictionary<string, VersionAccessRecord> access = _accessStats.GetAll();
+            var versions = new List<(string Id, DateTime LastUsedUtc, HashSet<string> Files)>();
+            var unresolved = new List<string>();
+            foreach (string versionDir in Directory.Exists(_config.VersionsDir) ? Directory.EnumerateDirectories(_config.VersionsDir) : Enumerable.Empty<string>())
+            {
+                string versionId = Path.GetFileName(versionDir);
+                VersionRefs refs = _store.ResolveRefs(versionId);
+                if (refs == null)
+                {
+                    unresolved.Add(versionId);
+                    continue;
+                }
+
+                var files = new HashSet<string>(refs.Files.Select(_store.FromStorePath), PathComparer);
+                string versionJson = Path.Combine(versionDir, $"{versionId}.json");
+                foreach (string file in Directory.EnumerateFiles(versionDir, "*", SearchOption.AllDirectories))
+                {
+                    if (!PathComparer.Equals(Path.GetFullPath(file), Path.GetFullPath(versionJson))) files.Add(Path.GetFullPath(file));
+                }
+
+                DateTime lastUsed = access.TryGetValue(versionId, out var record) ? record.LastLaunchUtc : Directory.GetLastWriteTimeUtc(versionDir);
+                versions.Add((versionId, lastUsed, files));
+            }
+            if (unresolved.Count > 0)
+            {
+                // Its files are unknown, so packing anything could take files away from it.
+                _logger.Warning("Tiering skipped: {Versions} cannot be resolved offline. Launch them once to record their references.", string.Join(", ", unresolved));
+                return report;
+            }
+            versions.Sort((a, b) => b.LastUsedUtc.CompareTo(a.LastUsedUtc));
+
+            // 2. Charge each version for the files not already paid for by a more recent one.
+            var packSizes = new Dictionary<string, Dictionary<string, long>>(StringComparer.Ordinal);
+            var hotFiles = new HashSet<string>(PathComparer);
+            bool overBudget = false;
+            foreach (var version in versions)
+            {
+                Dictionary<string, long> packed = ReadPackSizes(version.Id);
+                packSizes[version.Id] = packed;
+                long incremental = 0;
+                foreach (string file in version.Files)
+                {
+                    if (hotFiles.Contains(file)) continue;
+                    var info = new FileInfo(file);
+                    incremental += info.Exists ? info.Length : packed.TryGetValue(_store.ToStorePath(file), out long size) ? size : 0;
+                }
+
+                if (!overBudget && (report.HotBytes + incremental <= budgetBytes || report.Hot.Count == 0))
+                {
+                    report.Hot.Add(version.Id);
+                    report.HotBytes += incremental;
+                    hotFiles.UnionWith(version.Files);
+                }
+                else
+                {
+                    overBudget = true;
+                    report.Cold.Add(version.Id);
+                }
+            }
+
+            // 3. Cold versions a launcher is using stay expanded, and so does every file they reference.
+            var coldLeases = new List<FileLease>();
+            try
+            {
+                foreach (var version in versions.Where(v => report.Cold.Contains(v.Id)))
+                {
+                    FileLease inUse = _locks.TryAcquire(GetInUseLockKey(version.Id), "tiering");
+                    if (inUse != null)
+                    {
+                        coldLeases.Add(inUse);
+                        continue;
+                    }
+                    report.InUse.Add(version.Id);
+                    hotFiles.UnionWith(version.Files);
+                }
+
+                // 4. Pack the remaining cold versions, then drop their expanded files.
+                var coldFiles = new Dictionary<string, List<string>>(StringComparer.Ordinal);
+                foreach (var version in versions.Where(v => report.Cold.Contains(v.Id) && !report.InUse.Contains(v.Id)))
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    List<string> wanted = version.Files.Where(f => !hotFiles.Contains(f)).ToList();
+                    coldFiles[version.Id] = wanted;
+
+                    var present = packSizes[version.Id];
+                    bool packUpToDate = File.Exists(GetPackPath(_config, version.Id)) &&
+                                        wanted.All(f => present.ContainsKey(_store.ToStorePath(f)) || !File.Exists(f));
+                    if (packUpToDate || !execute) continue;
+
+                    long packBytes = WritePack(version.Id, wanted, packSizes.Keys);
+                    if (packBytes < 0) coldFiles.Remove(version.Id); // Keep the files if the pack could not be written.
+                    else
+                    {
+                        report.PacksWritten++;
+                        report.PackBytes += packBytes;
+                    }
+                }
+
+                foreach (var pair in coldFiles)
+                {
+                    foreach (string file in pair.Value)
+                    {
+                        var info = new FileInfo(file);
+                        if (!info.Exists) continue;
+                        report.FreedBytes += info.Length;
+                        if (!execute) continue;
+                        try
+                        {
+                            info.Delete();
+                        }
+                        catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                        {
+                            _logger.Warning(ex, "Failed to remove packed file {Path}", file);
+                            report.FreedBytes -= info.Length;
+                        }
+                    }
+                    if (execute) AtomicFile.PruneEmptyDirectories(Path.Combine(_config.VersionsDir, pair.Key));
+                }
+            }
+            finally
+            {
+                foreach (FileLease coldLease in coldLeases) coldLease.Dispose();
+            }
+
+            _logger.Information("Tiering with a {BudgetMb:F0} MB budget: {Hot} hot version(s) using {HotMb:F1} MB ({HotList}); {Cold} cold ({ColdList}).",
+                budgetBytes / (1024.0 * 1024.0), report.Hot.Count, report.HotBytes / (1024.0 * 1024.0), string.Join(", ", report.Hot),
+                report.Cold.Count, report.Cold.Count > 0 ? string.Join(", ", report.Cold) : "none");
+            if (report.InUse.Count > 0)
+            {
+                _logger.Information("Left {Versions} expanded: in use by a running launcher.", string.Join(", ", report.InUse));
+            }
+            _logger.Information("{Verb} {FreedMb:F1} MB of expanded files; {Packs} pack(s) written ({PackMb:F1} MB).",
+                execute ? "Freed" : "Would free", report.FreedBytes / (1024.0 * 1024.0), report.PacksWritten, report.PackBytes / (1024.0 * 1024.0));
+            return report;
+        }
+
+        /// <summary>
+        /// Writes a version's pack from the store, falling back to other packs for files that are no longer expanded.
+        /// </summary>
+        /// <returns>The pack size in bytes, or -1 on failure.</returns>
+        private long WritePack(string versionId, List<string> files, IEnumerable<string> otherPackIds)
+        {
+            string packPath = GetPackPath(_config, versionId);
+            string tempPath = AtomicFile.CreateTempPath(packPath);
+            var sourcePacks = new Dictionary<string, ZipArchive>(StringComparer.Ordinal);
+            try
+            {
+                int written = 0, missing = 0;
+                using (var stream = new FileStream(tempPath, FileMode.CreateNew, FileAccess.Write, FileShare.None))
+                using (var pack = new ZipArchive(stream, ZipArchiveMode.Create))
+                {
+                    foreach (string file in files)
+                    {
+                        string entryName = _store.ToStorePath(file);
+                        if (File.Exists(file))
+                        {
+                            pack.CreateEntryFromFile(file, entryName, CompressionLevel.Optimal);
+                            written++;
+                            continue;
+                        }
+
+                        ZipArchiveEntry source = FindInPacks(entryName, otherPackIds, sourcePacks);
+                        if (source == null)
+                        {
+                            missing++; // Neither expanded nor packed anywhere; rehydration leaves it to the download path.
+                            continue;
+                        }
+                        ZipArchiveEntry copy = pack.CreateEntry(entryName, CompressionLevel.Optimal);
+                        using (Stream from = source.Open())
+                        using (Stream to = copy.Open())
+                        {
+                            from.CopyTo(to);
+                        }
+                        written++;
+                    }
+                }
+
+                foreach (var archive in sourcePacks.Values) archive?.Dispose();
+                sourcePacks.Clear();
+
+                FileSync.FlushFile(tempPath); // The expanded copies are deleted next; the pack must survive a power cut.
+                AtomicFile.Commit(tempPath, packPath);
+                FileSync.SyncDirectory(_config.PacksDir);
+                long size = new FileInfo(packPath).Length;
+                _logger.Information("Packed {VersionId}: {Count} file(s) into {PackPath} ({Mb:F1} MB){Missing}.",
+                    versionId, written, packPath, size / (1024.0 * 1024.0), missing > 0 ? $", {missing} missing file(s) left to re-download" : string.Empty);
+                return size;
+            }
+            catch (Exception ex) when (ex is IOException || ex is InvalidDataException || ex is UnauthorizedAccessException)
+            {
+                _logger.Error(ex, "Failed to pack {VersionId}; leaving it expanded.", versionId);
+                AtomicFile.TryDeleteTemp(tempPath);
+                return -1;
+            }
+            finally
+            {
+                foreach (var archive in sourcePacks.Values) archive?.Dispose();
+            }
+        }
+
+        private ZipArchiveEntry FindInPacks(string entryName, IEnumerable<string> packIds, Dictionary<string, ZipArchive> opened)
+        {
+            foreach (string packId in packIds)
+            {
+                if (!opened.TryGetValue(packId, out ZipArchive archive))
+                {
+                    string path = GetPackPath(_config, packId);
+                    archive = File.Exists(path) ? ZipFile.OpenRead(path) : null;
+                    opened[packId] = archive;
+                }
+                ZipArchiveEntry entry = archive?.GetEntry(entryName);
+                if (entry != null) return entry;
+            }
+            return null;
+        }
+
+        /// <summary>
+        /// Reads the uncompressed entry sizes from a version's pack index, keyed by store path.
+        /// </summary>
+        private Dictionary<string, long> ReadPackSizes(string versionId)
+        {
+            var sizes = new Dictionary<string, long>(PathComparer);
+            string packPath = GetPackPath(_config, versionId);
+            if (!File.Exists(packPath)) return sizes;
+            try
+            {
+                using ZipArchive pack = ZipFile.OpenRead(packPath);
+                foreach (var entry in pack.Entries) sizes[entry.FullName] = entry.Length;
+            }
+            catch (Exception ex) when (ex is IOException || ex is InvalidDataException)
+            {
+                _logger.Warning(ex, "Pack {PackPath} is unreadable; it will be rewritten.", packPath);
+            }
+            return sizes;
+        }
+    }
+}
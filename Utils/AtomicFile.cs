@@ -0,0 +1,155 @@
+﻿// Utils/AtomicFile.cs
+using System;
+using System.IO;
+using System.IO.Compression;
+using System.Linq;
+using System.Text;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Temp-file-plus-rename helpers. Content is always written to a uniquely named sibling file first and then moved
+    /// over the final path in one rename, so readers (including other launcher processes) see either the old file or
+    /// the complete new one, never a half-written file.
+    /// </summary>
+    public static class AtomicFile
+    {
+        /// <summary>
+        /// Suffix of every temporary file created by this class. Anything ending in it is garbage from an interrupted write.
+        /// </summary>
+        public const string TempSuffix = ".tmp";
+
+        private static readonly ILogger _logger = Log.ForContext(typeof(AtomicFile));
+
+        /// <summary>
+        /// Returns a unique temporary path in the same directory as <paramref name="finalPath"/> (same volume,
+        /// so the final rename is atomic). The name includes the process id, so concurrent writers never collide.
+        /// </summary>
+        public static string CreateTempPath(string finalPath)
+        {
+            string directory = Path.GetDirectoryName(Path.GetFullPath(finalPath));
+            string name = $".{Path.GetFileName(finalPath)}.{Environment.ProcessId}.{Guid.NewGuid():N}{TempSuffix}";
+            return Path.Combine(directory, name);
+        }
+
+        /// <summary>
+        /// Moves a fully written temporary file over its final path, replacing any existing file.
+        /// </summary>
+        public static void Commit(string tempPath, string finalPath)
+        {
+            File.Move(tempPath, finalPath, overwrite: true);
+        }
+
+        /// <summary>
+        /// Deletes a temporary file, ignoring errors.
+        /// </summary>
+        public static void TryDeleteTemp(string tempPath)
+        {
+            try
+            {
+                if (tempPath != null && File.Exists(tempPath)) File.Delete(tempPath);
+            }
+            catch (Exception ex)
+            {
+                _logger.Verbose(ex, "Failed to delete temporary file {TempPath}", tempPath);
+            }
+        }
+
+        /// <summary>
+        /// Atomically replaces <paramref name="path"/> with <paramref name="content"/> (UTF-8, no BOM).
+        /// </summary>
+        public static void WriteAllText(string path, string content)
+        {
+            WriteAllBytes(path, new UTF8Encoding(false).GetBytes(content));
+        }
+
+        /// <summary>
+        /// Atomically replaces <paramref name="path"/> with <paramref name="bytes"/>.
+        /// </summary>
+        public static void WriteAllBytes(string path, byte[] bytes)
+        {
+            Directory.CreateDirectory(Path.GetDirectoryName(Path.GetFullPath(path)));
+            string tempPath = CreateTempPath(path);
+            try
+            {
+                File.WriteAllBytes(tempPath, bytes);
+                Commit(tempPath, path);
+            }
+            catch
+            {
+                TryDeleteTemp(tempPath);
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Extracts a ZIP entry to <paramref name="destinationPath"/> through a temporary file.
+        /// </summary>
+        public static void ExtractEntry(ZipArchiveEntry entry, string destinationPath)
+        {
+            string tempPath = CreateTempPath(destinationPath);
+            try
+            {
+                entry.ExtractToFile(tempPath, false);
+                Commit(tempPath, destinationPath);
+            }
+            catch
+            {
+                TryDeleteTemp(tempPath);
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Replaces the directory <paramref name="finalDir"/> with the fully populated <paramref name="stagingDir"/>.
+        /// The old directory (if any) is first renamed next to the staging directory and deleted afterwards, so
+        /// <paramref name="finalDir"/> is never observed partially populated. Both directories must be on the same volume.
+        /// </summary>
+        public static void ReplaceDirectory(string stagingDir, string finalDir)
+        {
+            string retiredDir = null;
+            if (Directory.Exists(finalDir))
+            {
+                retiredDir = Path.Combine(Path.GetDirectoryName(Path.GetFullPath(stagingDir)), $"retired.{Environment.ProcessId}.{Guid.NewGuid():N}");
+                Directory.Move(finalDir, retiredDir);
+            }
+
+            Directory.Move(stagingDir, finalDir);
+
+            if (retiredDir != null)
+            {
+                try
+                {
+                    Directory.Delete(retiredDir, true);
+                }
+                catch (Exception ex)
+                {
+                    _logger.Warning(ex, "Failed to delete retired directory {RetiredDir}; it can be removed manually.", retiredDir);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Removes every empty directory below <paramref name="rootDir"/> (deepest first, so emptied parents go too).
+        /// The root itself is kept. Directories that cannot be removed are skipped.
+        /// </summary>
+        public static void PruneEmptyDirectories(string rootDir)
+        {
+            if (!Directory.Exists(rootDir)) return;
+            string[] directories = Directory.GetDirectories(rootDir, "*", SearchOption.AllDirectories);
+            Array.Sort(directories, (a, b) => b.Length.CompareTo(a.Length));
+            foreach (string directory in directories)
+            {
+                try
+                {
+                    if (!Directory.EnumerateFileSystemEntries(directory).Any()) Directory.Delete(directory);
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    _logger.Verbose(ex, "Could not remove empty directory {Path}", directory);
+                }
+            }
+        }
+    }
+}
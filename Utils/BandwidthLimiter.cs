@@ -0,0 +1,56 @@
+﻿// Utils/BandwidthLimiter.cs
+using System;
+using System.Diagnostics;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// A token-bucket style rate limiter for byte streams. Every caller reserves a time slot for the bytes
+    /// it is about to transfer; if the reservation lies in the future the caller waits until then.
+    /// One instance can be shared by any number of concurrent downloads to cap their combined rate.
+    /// </summary>
+    public sealed class BandwidthLimiter
+    {
+        private readonly object _lock = new object();
+        private readonly double _ticksPerByte;
+        private readonly long _burstTicks;
+        private long _nextFreeTick;
+
+        /// <param name="bytesPerSecond">Maximum sustained rate in bytes per second.</param>
+        /// <param name="burst">How far ahead of the sustained rate callers may run before being delayed.</param>
+        public BandwidthLimiter(long bytesPerSecond, TimeSpan? burst = null)
+        {
+            if (bytesPerSecond <= 0) throw new ArgumentOutOfRangeException(nameof(bytesPerSecond), "Rate must be positive.");
+            BytesPerSecond = bytesPerSecond;
+            _ticksPerByte = (double)Stopwatch.Frequency / bytesPerSecond;
+            _burstTicks = (long)((burst ?? TimeSpan.FromMilliseconds(250)).TotalSeconds * Stopwatch.Frequency);
+            _nextFreeTick = Stopwatch.GetTimestamp();
+        }
+
+        public long BytesPerSecond { get; }
+
+        /// <summary>
+        /// Waits until <paramref name="bytes"/> may be transferred without exceeding the configured rate.
+        /// </summary>
+        public ValueTask WaitAsync(int bytes, CancellationToken cancellationToken = default)
+        {
+            if (bytes <= 0) return ValueTask.CompletedTask;
+
+            long now = Stopwatch.GetTimestamp();
+            long reservationEnd;
+            lock (_lock)
+            {
+                // Idle time does not accumulate beyond the burst allowance.
+                if (_nextFreeTick < now - _burstTicks) _nextFreeTick = now - _burstTicks;
+                _nextFreeTick += (long)(bytes * _ticksPerByte);
+                reservationEnd = _nextFreeTick;
+            }
+
+            long waitTicks = reservationEnd - now - _burstTicks;
+            if (waitTicks <= 0) return ValueTask.CompletedTask;
+            return new ValueTask(Task.Delay(TimeSpan.FromSeconds((double)waitTicks / Stopwatch.Frequency), cancellationToken));
+        }
+    }
+}
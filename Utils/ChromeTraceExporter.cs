@@ -0,0 +1,174 @@
+﻿// Utils/ChromeTraceExporter.cs
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text.Json;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Records every <see cref="LauncherTracing"/> span of this process and writes them on <see cref="Dispose"/> as a
+    /// Chrome <c>trace_event</c> JSON file, which <c>chrome://tracing</c>, Perfetto (ui.perfetto.dev) and speedscope
+    /// show as a flame timeline.
+    /// <para>
+    /// Spans become complete (<c>"ph": "X"</c>) events with their tags as <c>args</c>. The viewers nest events by
+    /// thread, and async spans hop threads, so spans are laid out on synthetic lanes instead: a span goes on the first
+    /// lane where it nests inside the spans still open there, which keeps parents above their children and puts
+    /// concurrent downloads side by side.
+    /// </para>
+    /// </summary>
+    public sealed class ChromeTraceExporter : IDisposable
+    {
+        private readonly string _path;
+        private readonly ActivityListener _listener;
+        private readonly ConcurrentQueue<SpanRecord> _spans = new ConcurrentQueue<SpanRecord>();
+        private readonly ILogger _logger;
+        private bool _disposed;
+
+        /// <param name="path">Trace file to write when disposed.</param>
+        public ChromeTraceExporter(string path)
+        {
+            _path = path ?? throw new ArgumentNullException(nameof(path));
+            _logger = Log.ForContext<ChromeTraceExporter>();
+            _listener = new ActivityListener
+            {
+                ShouldListenTo = source => source.Name == LauncherTracing.SourceName,
+                Sample = (ref ActivityCreationOptions<ActivityContext> _) => ActivitySamplingResult.AllDataAndRecorded,
+                ActivityStopped = OnStopped
+            };
+            ActivitySource.AddActivityListener(_listener);
+            _logger.Verbose("ChromeTraceExporter recording to {Path}.", _path);
+        }
+
+        /// <summary>
+        /// Spans recorded so far.
+        /// </summary>
+        public int Count => _spans.Count;
+
+        private void OnStopped(Activity activity)
+        {
+            List<KeyValuePair<string, object>> tags = null;
+            foreach (var tag in activity.TagObjects)
+            {
+                (tags ??= new List<KeyValuePair<string, object>>()).Add(tag);
+            }
+            _spans.Enqueue(new SpanRecord(activity.OperationName, activity.StartTimeUtc, activity.Duration, activity.Status == ActivityStatusCode.Error, tags));
+        }
+
+        /// <summary>
+        /// Stops recording and writes the trace file.
+        /// </summary>
+        public void Dispose()
+        {
+            if (_disposed) return;
+            _disposed = true;
+            _listener.Dispose();
+            try
+            {
+                Directory.CreateDirectory(Path.GetDirectoryName(Path.GetFullPath(_path)));
+                Write();
+                _logger.Information("Wrote {Count} span(s) to {Path}; open it in ui.perfetto.dev or chrome://tracing.", _spans.Count, _path);
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Error(ex, "Could not write trace file {Path}.", _path);
+            }
+        }
+
+        private void Write()
+        {
+            List<SpanRecord> spans = _spans.OrderBy(s => s.Start).ThenByDescending(s => s.Duration).ToList();
+            DateTime origin = spans.Count > 0 ? spans[0].Start : DateTime.UtcNow;
+            int pid = Environment.ProcessId;
+
+            using var stream = new FileStream(AtomicFile.CreateTempPath(_path), FileMode.CreateNew, FileAccess.Write, FileShare.None);
+            string tempPath = stream.Name;
+            using (var writer = new Utf8JsonWriter(stream))
+            {
+                writer.WriteStartObject();
+                writer.WriteString("displayTimeUnit", "ms");
+                writer.WriteStartArray("traceEvents");
+
+                writer.WriteStartObject();
+                writer.WriteString("name", "process_name");
+                writer.WriteString("ph", "M");
+                writer.WriteNumber("pid", pid);
+                writer.WriteStartObject("args");
+                writer.WriteString("name", $"Obsidian Launcher {LauncherConfig.VERSION}");
+                writer.WriteEndObject();
+                writer.WriteEndObject();
+
+                // Each lane is a stack of the end times of the spans open on it.
+                var lanes = new List<Stack<DateTime>>();
+                foreach (var span in spans)
+                {
+                    DateTime end = span.Start + span.Duration;
+                    int lane = 0;
+                    for (; lane < lanes.Count; lane++)
+                    {
+                        Stack<DateTime> open = lanes[lane];
+                        while (open.Count > 0 && open.Peek() <= span.Start) open.Pop();
+                        if (open.Count == 0 || open.Peek() >= end) break;
+                    }
+                    if (lane == lanes.Count) lanes.Add(new Stack<DateTime>());
+                    lanes[lane].Push(end);
+
+                    writer.WriteStartObject();
+                    writer.WriteString("name", span.Name);
+                    writer.WriteString("cat", span.Name.Split('.')[0]);
+                    writer.WriteString("ph", "X");
+                    writer.WriteNumber("ts", (span.Start - origin).Ticks / 10.0);
+                    writer.WriteNumber("dur", span.Duration.Ticks / 10.0);
+                    writer.WriteNumber("pid", pid);
+                    writer.WriteNumber("tid", lane + 1);
+                    if (span.Tags != null || span.Failed)
+                    {
+                        writer.WriteStartObject("args");
+                        if (span.Failed) writer.WriteBoolean("error", true);
+                        foreach (var tag in span.Tags ?? Enumerable.Empty<KeyValuePair<string, object>>())
+                        {
+                            switch (tag.Value)
+                            {
+                                case null: writer.WriteNull(tag.Key); break;
+                                case bool b: writer.WriteBoolean(tag.Key, b); break;
+                                case int i: writer.WriteNumber(tag.Key, i); break;
+                                case long l: writer.WriteNumber(tag.Key, l); break;
+                                case double d: writer.WriteNumber(tag.Key, d); break;
+                                default: writer.WriteString(tag.Key, tag.Value.ToString()); break;
+                            }
+                        }
+                        writer.WriteEndObject();
+                    }
+                    writer.WriteEndObject();
+                }
+
+                writer.WriteEndArray();
+                writer.WriteEndObject();
+            }
+            stream.Dispose();
+            AtomicFile.Commit(tempPath, _path);
+        }
+
+        private readonly struct SpanRecord
+        {
+            public SpanRecord(string name, DateTime start, TimeSpan duration, bool failed, List<KeyValuePair<string, object>> tags)
+            {
+                Name = name;
+                Start = start;
+                Duration = duration;
+                Failed = failed;
+                Tags = tags;
+            }
+
+            public string Name { get; }
+            public DateTime Start { get; }
+            public TimeSpan Duration { get; }
+            public bool Failed { get; }
+            public List<KeyValuePair<string, object>> Tags { get; }
+        }
+    }
+}
@@ -1,16 +1,47 @@
 ﻿// Utils/CryptoUtils.cs
 using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
 using System.Security.Cryptography;
-using System.Text;
 using System.Threading;
 using System.Threading.Tasks;
+using Microsoft.Win32.SafeHandles;
+using ObsidianLauncher.Enums;
+using ObsidianLauncher.Models;
 using Serilog;
+using Serilog.Events;
 
 namespace ObsidianLauncher.Utils
 {
     public static class CryptoUtils
     {
+        /// <summary>
+        /// Read size for bulk verification. Files up to this size are read in a single call sized to the file;
+        /// larger files are read in chunks of this size, double-buffered.
+        /// </summary>
+        public const int VerifyChunkSize = 1024 * 1024;
+
+        /// <summary>
+        /// Files up to this size are hashed in groups through <see cref="MultiBufferSha1"/> by <see cref="VerifyFilesAsync"/>.
+        /// </summary>
+        public const int MultiBufferSmallFileLimit = 64 * 1024;
+
+        private const int Sha1Length = 20;
+
+        // Batch readers each own a ring and a registered buffer; a few are enough to keep the kernel busy.
+        private const int MaxIoUringReaders = 4;
+
+        /// <summary>
+        /// Whether <see cref="VerifyFilesAsync"/> hashes small files with <see cref="MultiBufferSha1"/>: null (the default)
+        /// when <see cref="MultiBufferSha1.IsPreferred"/>, true whenever it is enabled, false never.
+        /// Benchmarks set it to compare both paths.
+        /// </summary>
+        public static bool? UseMultiBufferSha1 { get; set; }
+
         private static readonly ILogger _logger = Log.ForContext(typeof(CryptoUtils));
 
         /// <summary>
@@ -21,7 +52,7 @@ namespace ObsidianLauncher.Utils
         /// <returns>A hex-encoded string of the SHA1 hash. Returns null on error (e.g., file not found, crypto error).</returns>
         public static async Task<string> CalculateFileSHA1Async(string filePath, CancellationToken cancellationToken = default)
         {
-            _logger.Verbose("Calculating SHA1 for file: {FilePath}", filePath);
+            if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Calculating SHA1 for file: {FilePath}", filePath);
             if (!File.Exists(filePath))
             {
                 _logger.Error("File not found for SHA1 calculation: {FilePath}", filePath);
@@ -30,19 +61,17 @@ namespace ObsidianLauncher.Utils
 
             try
             {
+                using Activity activity = LauncherTracing.Start("hash.sha1");
                 using var sha1 = SHA1.Create();
                 using var stream = new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.Read, 4096, true); // true for async
+                activity?.SetTag("bytes", stream.Length);
+                long started = Stopwatch.GetTimestamp();
                 
                 byte[] hash = await sha1.ComputeHashAsync(stream, cancellationToken).ConfigureAwait(false);
+                RecordHash("file", stream.Length, started);
                 
-                // Convert byte array to hex string
-                var sb = new StringBuilder(hash.Length * 2);
-                foreach (byte b in hash)
-                {
-                    sb.Append(b.ToString("x2"));
-                }
-                string hexHash = sb.ToString();
-                _logger.Verbose("SHA1 for {FilePath}: {Hash}", filePath, hexHash);
+                string hexHash = Convert.ToHexString(hash).ToLowerInvariant();
+                if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("SHA1 for {FilePath}: {Hash}", filePath, hexHash);
                 return hexHash;
             }
             catch (OperationCanceledException)
@@ -65,7 +94,7 @@ namespace ObsidianLauncher.Utils
         /// <returns>A hex-encoded string of the SHA256 hash. Returns null on error (e.g., file not found, crypto error).</returns>
         public static async Task<string> CalculateFileSHA256Async(string filePath, CancellationToken cancellationToken = default)
         {
-            _logger.Verbose("Calculating SHA256 for file: {FilePath}", filePath);
+            if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("Calculating SHA256 for file: {FilePath}", filePath);
             if (!File.Exists(filePath))
             {
                 _logger.Error("File not found for SHA256 calculation: {FilePath}", filePath);
@@ -79,14 +108,8 @@ namespace ObsidianLauncher.Utils
                 
                 byte[] hash = await sha256.ComputeHashAsync(stream, cancellationToken).ConfigureAwait(false);
                 
-                // Convert byte array to hex string
-                var sb = new StringBuilder(hash.Length * 2);
-                foreach (byte b in hash)
-                {
-                    sb.Append(b.ToString("x2"));
-                }
-                string hexHash = sb.ToString();
-                _logger.Verbose("SHA256 for {FilePath}: {Hash}", filePath, hexHash);
+                string hexHash = Convert.ToHexString(hash).ToLowerInvariant();
+                if (_logger.IsEnabled(LogEventLevel.Verbose)) _logger.Verbose("SHA256 for {FilePath}: {Hash}", filePath, hexHash);
                 return hexHash;
             }
             catch (OperationCanceledException)
@@ -100,5 +123,439 @@ namespace ObsidianLauncher.Utils
                 return null;
             }
         }
+        /// <summary>
+        /// Returns the number of concurrent readers <see cref="VerifyFilesAsync"/> uses for files under
+        /// <paramref name="path"/>: a couple on a rotational disk, where parallel reads only add seeks, and enough to
+        /// keep an SSD's queue busy otherwise.
+        /// </summary>
+        public static int GetRecommendedVerifyParallelism(string path)
+        {
+            if (StorageInfo.IsRotational(path)) return 2;
+            return Math.Clamp(Environment.ProcessorCount, 4, 16);
+        }
+
+        /// <summary>
+        /// Checks many files against their expected size and SHA1 in one call. Intended for full verification of an
+        /// install, which is thousands of files of a few KB each, where per-file overheads dominate:
+        /// <list type="bullet">
+        /// <item>A bounded pool of readers pulls files from the set; each reuses one hash instance and two pooled buffers.</item>
+        /// <item>Files are opened as raw handles and read at explicit offsets, with reads sized to the file.</item>
+        /// <item>Large files are double-buffered: the next chunk is read while the current one is hashed.</item>
+        /// <item>Hashes are compared as bytes; hex strings are only built for mismatches.</item>
+        /// <item>Files up to <see cref="MultiBufferSmallFileLimit"/> are hashed several at a time with <see cref="MultiBufferSha1"/>
+        /// where that is faster on this CPU.</item>
+        /// <item>Sizes are compared before reading, so a truncated file is never hashed.</item>
+        /// <item>With the io_uring backend (<see cref="IoUringFileBatch.Backend"/>), small files are opened, read and closed
+        /// in batches of <see cref="IoUringFileBatch.Capacity"/>, a few system calls per batch.</item>
+        /// </list>
+        /// File failures never throw; they are reported per file (cancellation still throws). On a rotational disk the set is processed in path order.
+        /// </summary>
+        /// <param name="requests">Files to check.</param>
+        /// <param name="maxParallelism">Concurrent readers; 0 uses <see cref="GetRecommendedVerifyParallelism"/>.</param>
+        /// <param name="onResult">Optional callback invoked (on a pool thread) as each file completes.</param>
+        /// <param name="cancellationToken">Cancellation token.</param>
+        /// <returns>One result per request, in request order.</returns>
+        public static async Task<FileVerificationResult[]> VerifyFilesAsync(
+            IReadOnlyList<FileVerificationRequest> requests,
+            int maxParallelism = 0,
+            Action<FileVerificationResult> onResult = null,
+            CancellationToken cancellationToken = default)
+        {
+            if (requests == null) throw new ArgumentNullException(nameof(requests));
+            var results = new FileVerificationResult[requests.Count];
+            if (requests.Count == 0) return results;
+            using Activity activity = LauncherTracing.Start("hash.verify_batch");
+            activity?.SetTag("files", requests.Count);
+            long started = Stopwatch.GetTimestamp();
+
+            bool rotational = false;
+            if (maxParallelism <= 0)
+            {
+                rotational = StorageInfo.IsRotational(requests[0].Path);
+                maxParallelism = rotational ? 2 : GetRecommendedVerifyParallelism(requests[0].Path);
+            }
+
+            // Path order keeps an HDD's head moving forward; SSDs don't care, so the caller's order is kept.
+            int[] order = Enumerable.Range(0, requests.Count).ToArray();
+            if (rotational) Array.Sort(order, (a, b) => string.CompareOrdinal(requests[a].Path, requests[b].Path));
+
+            bool useMultiBuffer = UseMultiBufferSha1 ?? MultiBufferSha1.IsPreferred;
+            useMultiBuffer &= MultiBufferSha1.IsEnabled;
+
+            // With the io_uring backend, files small enough for a batch slot go to a few batch readers instead of the pool.
+            int[] batched = Array.Empty<int>();
+            if (IoUringFileBatch.Backend == IoBackend.IoUring && IoUringFileBatch.IsAvailable)
+            {
+                batched = order.Where(i => IsBatchCandidate(requests[i])).ToArray();
+                order = order.Where(i => !IsBatchCandidate(requests[i])).ToArray();
+            }
+            int batchReaders = Math.Min(Math.Min(maxParallelism, MaxIoUringReaders), (batched.Length + IoUringFileBatch.Capacity - 1) / IoUringFileBatch.Capacity);
+            activity?.SetTag("parallelism", maxParallelism);
+            activity?.SetTag("multibuffer", useMultiBuffer);
+            activity?.SetTag("io_uring", batchReaders > 0);
+
+            int next = -1;
+            int nextBatch = 0;
+            var workers = new Task[Math.Min(maxParallelism, order.Length) + batchReaders];
+            for (int w = 0; w < batchReaders; w++)
+            {
+                workers[w] = Task.Run(async () =>
+                {
+                    using IoUringFileBatch batch = IoUringFileBatch.TryCreate();
+                    using var sha1 = IncrementalHash.CreateHash(HashAlgorithmName.SHA1);
+                    byte[] current = ArrayPool<byte>.Shared.Rent(VerifyChunkSize);
+                    byte[] ahead = ArrayPool<byte>.Shared.Rent(VerifyChunkSize);
+                    var deferred = new List<int>();
+                    try
+                    {
+                        int start;
+                        while ((start = Interlocked.Add(ref nextBatch, IoUringFileBatch.Capacity) - IoUringFileBatch.Capacity) < batched.Length)
+                        {
+                            cancellationToken.ThrowIfCancellationRequested();
+                            var chunk = new ArraySegment<int>(batched, start, Math.Min(IoUringFileBatch.Capacity, batched.Length - start));
+                            if (batch != null) VerifyBatch(batch, requests, chunk, results, onResult, useMultiBuffer, deferred);
+                            else deferred.AddRange(chunk);
+
+                            foreach (int index in deferred)
+                            {
+                                var result = await VerifyOneAsync(requests[index], index, sha1, current, ahead, null, cancellationToken).ConfigureAwait(false);
+                                results[index] = result;
+                                onResult?.Invoke(result);
+                            }
+                            deferred.Clear();
+                        }
+                    }
+                    finally
+                    {
+                        ArrayPool<byte>.Shared.Return(current);
+                        ArrayPool<byte>.Shared.Return(ahead);
+                    }
+                }, cancellationToken);
+            }
+            for (int w = batchReaders; w < workers.Length; w++)
+            {
+                workers[w] = Task.Run(async () =>
+                {
+                    using var sha1 = IncrementalHash.CreateHash(HashAlgorithmName.SHA1);
+                    byte[] current = ArrayPool<byte>.Shared.Rent(VerifyChunkSize);
+                    byte[] ahead = ArrayPool<byte>.Shared.Rent(VerifyChunkSize);
+                    var batch = useMultiBuffer ? new SmallFileBatch(results, onResult) : null;
+                    try
+                    {
+                        int i;
+                        while ((i = Interlocked.Increment(ref next)) < order.Length)
+                        {
+                            cancellationToken.ThrowIfCancellationRequested();
+                            var request = requests[order[i]];
+                            var result = await VerifyOneAsync(request, order[i], sha1, current, ahead, batch, cancellationToken).ConfigureAwait(false);
+                            if (result == null) continue; // Deferred to the small-file batch.
+                            results[order[i]] = result;
+                            onResult?.Invoke(result);
+                        }
+                        batch?.Flush();
+                    }
+                    finally
+                    {
+                        batch?.Dispose();
+                        ArrayPool<byte>.Shared.Return(current);
+                        ArrayPool<byte>.Shared.Return(ahead);
+                    }
+                }, cancellationToken);
+            }
+            await Task.WhenAll(workers).ConfigureAwait(false);
+            if (activity != null || LauncherMetrics.HashBytes.Enabled)
+            {
+                long bytes = 0;
+                foreach (var result in results) bytes += Math.Max(result?.ActualSize ?? 0, 0);
+                activity?.SetTag("bytes", bytes);
+                RecordHash("batch", bytes, started);
+            }
+            return results;
+        }
+
+        private static void RecordHash(string operation, long bytes, long startTimestamp)
+        {
+            if (!LauncherMetrics.HashBytes.Enabled) return;
+            var tag = LauncherMetrics.Tag("operation", operation);
+            LauncherMetrics.HashBytes.Add(bytes, tag);
+            LauncherMetrics.HashDuration.Record(LauncherMetrics.SecondsSince(startTimestamp), tag);
+        }
+
+        /// <returns>The result, or null if the file was handed to <paramref name="batch"/>, which reports it when flushed.</returns>
+        private static async Task<FileVerificationResult> VerifyOneAsync(
+            FileVerificationRequest request, int index, IncrementalHash sha1, byte[] current, byte[] ahead, SmallFileBatch batch, CancellationToken cancellationToken)
+        {
+            var result = new FileVerificationResult { Request = request };
+            byte[] expectedHash = null;
+            if (!string.IsNullOrEmpty(request.ExpectedSha1))
+            {
+                if (request.ExpectedSha1.Length != Sha1Length * 2)
+                {
+                    result.Status = FileVerificationStatus.Error;
+                    result.Error = $"Malformed expected SHA1 '{request.ExpectedSha1}'.";
+                    return result;
+                }
+                try
+                {
+                    expectedHash = Convert.FromHexString(request.ExpectedSha1);
+                }
+                catch (FormatException)
+                {
+                    result.Status = FileVerificationStatus.Error;
+                    result.Error = $"Malformed expected SHA1 '{request.ExpectedSha1}'.";
+                    return result;
+                }
+            }
+
+            SafeFileHandle handle;
+            try
+            {
+                handle = File.OpenHandle(request.Path, FileMode.Open, FileAccess.Read, FileShare.Read | FileShare.Delete, FileOptions.SequentialScan);
+            }
+            catch (Exception ex) when (ex is FileNotFoundException || ex is DirectoryNotFoundException)
+            {
+                result.Status = FileVerificationStatus.Missing;
+                return result;
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                result.Status = FileVerificationStatus.Error;
+                result.Error = ex.Message;
+                return result;
+            }
+
+            using (handle)
+            {
+                try
+                {
+                    long length = RandomAccess.GetLength(handle);
+                    result.ActualSize = length;
+                    if (request.ExpectedSize.HasValue && length != request.ExpectedSize.Value)
+                    {
+                        result.Status = FileVerificationStatus.SizeMismatch;
+                        return result;
+                    }
+                    if (expectedHash == null)
+                    {
+                        result.Status = FileVerificationStatus.Valid;
+                        return result;
+                    }
+
+                    if (batch != null && length <= MultiBufferSmallFileLimit)
+                    {
+                        byte[] content = ArrayPool<byte>.Shared.Rent((int)Math.Max(length, 1));
+                        int read = ReadFully(handle, content, (int)length, 0);
+                        batch.Add(index, result, expectedHash, content, read);
+                        return null;
+                    }
+
+                    // First chunk (the whole file for most assets) is read synchronously; for larger files each following
+                    // chunk is requested before the current one is hashed, so the read overlaps the hashing.
+                    long offset = 0;
+                    int count = ReadFully(handle, current, (int)Math.Min(length, VerifyChunkSize), offset);
+                    while (count > 0)
+                    {
+                        offset += count;
+                        ValueTask<int> pending = offset < length
+                            ? RandomAccess.ReadAsync(handle, ahead.AsMemory(0, (int)Math.Min(length - offset, VerifyChunkSize)), offset, cancellationToken)
+                            : new ValueTask<int>(0);
+                        sha1.AppendData(current, 0, count);
+                        count = await pending.ConfigureAwait(false);
+                        (current, ahead) = (ahead, current);
+                    }
+
+                    byte[] actualHash = sha1.GetHashAndReset();
+                    if (actualHash.AsSpan().SequenceEqual(expectedHash))
+                    {
+                        result.Status = FileVerificationStatus.Valid;
+                        result.ActualSha1 = request.ExpectedSha1.ToLowerInvariant();
+                    }
+                    else
+                    {
+                        result.Status = FileVerificationStatus.HashMismatch;
+                        result.ActualSha1 = Convert.ToHexString(actualHash).ToLowerInvariant();
+                    }
+                    return result;
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    // Drop any partial state so the next file on this worker starts clean.
+                    sha1.GetHashAndReset();
+                    result.Status = FileVerificationStatus.Error;
+                    result.Error = ex.Message;
+                    return result;
+                }
+            }
+        }
+
+        private static bool IsBatchCandidate(FileVerificationRequest request)
+        {
+            return request.ExpectedSize.HasValue && request.ExpectedSize.Value <= IoUringFileBatch.MaxFileSize &&
+                   request.ExpectedSha1?.Length == Sha1Length * 2;
+        }
+
+        /// <summary>
+        /// Verifies one chunk of small files read through <paramref name="batch"/>. Files whose read length differs from
+        /// the expected size, and malformed hashes, are added to <paramref name="deferred"/> for the regular path, which
+        /// reports them in detail.
+        /// </summary>
+        private static void VerifyBatch(
+            IoUringFileBatch batch, IReadOnlyList<FileVerificationRequest> requests, ArraySegment<int> indices,
+            FileVerificationResult[] results, Action<FileVerificationResult> onResult, bool useMultiBuffer, List<int> deferred)
+        {
+            int count = indices.Count;
+            var paths = new string[count];
+            Span<int> maxLengths = stackalloc int[IoUringFileBatch.Capacity];
+            Span<int> read = stackalloc int[IoUringFileBatch.Capacity];
+            for (int i = 0; i < count; i++)
+            {
+                paths[i] = requests[indices[i]].Path;
+                maxLengths[i] = (int)requests[indices[i]].ExpectedSize.Value + 1; // One byte more reveals a file that grew.
+            }
+            batch.ReadFiles(paths, maxLengths, read);
+
+            var slots = new List<(int Slot, byte[] ExpectedHash)>(count);
+            for (int i = 0; i < count; i++)
+            {
+                int index = indices[i];
+                var request = requests[index];
+                if (read[i] < 0)
+                {
+                    var result = new FileVerificationResult { Request = request };
+                    if (IoUringFileBatch.IsNotFound(read[i]))
+                    {
+                        result.Status = FileVerificationStatus.Missing;
+                    }
+                    else
+                    {
+                        result.Status = FileVerificationStatus.Error;
+                        result.Error = Marshal.GetPInvokeErrorMessage(-read[i]);
+                    }
+                    results[index] = result;
+                    onResult?.Invoke(result);
+                    continue;
+                }
+                if (read[i] != request.ExpectedSize.Value)
+                {
+                    deferred.Add(index);
+                    continue;
+                }
+                try
+                {
+                    slots.Add((i, Convert.FromHexString(request.ExpectedSha1)));
+                }
+                catch (FormatException)
+                {
+                    deferred.Add(index);
+                }
+            }
+
+            byte[] hashes = new byte[slots.Count * Sha1Length];
+            if (useMultiBuffer)
+            {
+                var messages = new ReadOnlyMemory<byte>[slots.Count];
+                for (int k = 0; k < slots.Count; k++) messages[k] = batch.GetContent(slots[k].Slot, read[slots[k].Slot]);
+                MultiBufferSha1.HashMany(messages, hashes);
+            }
+            else
+            {
+                for (int k = 0; k < slots.Count; k++) SHA1.HashData(batch.GetContent(slots[k].Slot, read[slots[k].Slot]).Span, hashes.AsSpan(k * Sha1Length, Sha1Length));
+            }
+
+            for (int k = 0; k < slots.Count; k++)
+            {
+                var (slot, expectedHash) = slots[k];
+                int index = indices[slot];
+                var result = new FileVerificationResult { Request = requests[index], ActualSize = read[slot] };
+                ReadOnlySpan<byte> actualHash = hashes.AsSpan(k * Sha1Length, Sha1Length);
+                if (actualHash.SequenceEqual(expectedHash))
+                {
+                    result.Status = FileVerificationStatus.Valid;
+                    result.ActualSha1 = result.Request.ExpectedSha1.ToLowerInvariant();
+                }
+                else
+                {
+                    result.Status = FileVerificationStatus.HashMismatch;
+                    result.ActualSha1 = Convert.ToHexString(actualHash).ToLowerInvariant();
+                }
+                results[index] = result;
+                onResult?.Invoke(result);
+            }
+        }
+
+        /// <summary>
+        /// Small files read by one verification worker, hashed together through <see cref="MultiBufferSha1"/> once
+        /// enough have accumulated for several full vector groups.
+        /// </summary>
+        private sealed class SmallFileBatch : IDisposable
+        {
+            private const int Capacity = 4 * MultiBufferSha1.Lanes;
+
+            private readonly FileVerificationResult[] _results;
+            private readonly Action<FileVerificationResult> _onResult;
+            private readonly List<(int Index, FileVerificationResult Result, byte[] ExpectedHash, byte[] Content, int Length)> _pending =
+                new List<(int, FileVerificationResult, byte[], byte[], int)>(Capacity);
+            private readonly byte[] _hashes = new byte[Capacity * MultiBufferSha1.HashSize];
+            private readonly ReadOnlyMemory<byte>[] _messages = new ReadOnlyMemory<byte>[Capacity];
+
+            public SmallFileBatch(FileVerificationResult[] results, Action<FileVerificationResult> onResult)
+            {
+                _results = results;
+                _onResult = onResult;
+            }
+
+            public void Add(int index, FileVerificationResult result, byte[] expectedHash, byte[] content, int length)
+            {
+                _pending.Add((index, result, expectedHash, content, length));
+                if (_pending.Count == Capacity) Flush();
+            }
+
+            public void Flush()
+            {
+                if (_pending.Count == 0) return;
+                for (int i = 0; i < _pending.Count; i++) _messages[i] = _pending[i].Content.AsMemory(0, _pending[i].Length);
+                MultiBufferSha1.HashMany(new ArraySegment<ReadOnlyMemory<byte>>(_messages, 0, _pending.Count), _hashes);
+
+                for (int i = 0; i < _pending.Count; i++)
+                {
+                    var (index, result, expectedHash, content, _) = _pending[i];
+                    ReadOnlySpan<byte> actualHash = _hashes.AsSpan(i * MultiBufferSha1.HashSize, MultiBufferSha1.HashSize);
+                    if (actualHash.SequenceEqual(expectedHash))
+                    {
+                        result.Status = FileVerificationStatus.Valid;
+                        result.ActualSha1 = result.Request.ExpectedSha1.ToLowerInvariant();
+                    }
+                    else
+                    {
+                        result.Status = FileVerificationStatus.HashMismatch;
+                        result.ActualSha1 = Convert.ToHexString(actualHash).ToLowerInvariant();
+                    }
+                    ArrayPool<byte>.Shared.Return(content);
+                    _messages[i] = default;
+                    _results[index] = result;
+                    _onResult?.Invoke(result);
+                }
+                _pending.Clear();
+            }
+
+            public void Dispose()
+            {
+                // Only reached with pending files when the run was cancelled or failed.
+                foreach (var entry in _pending) ArrayPool<byte>.Shared.Return(entry.Content);
+                _pending.Clear();
+            }
+        }
+
+        private static int ReadFully(SafeFileHandle handle, byte[] buffer, int count, long offset)
+        {
+            int total = 0;
+            while (total < count)
+            {
+                int read = RandomAccess.Read(handle, buffer.AsSpan(total, count - total), offset + total);
+                if (read == 0) break; // Truncated since the length was taken.
+                total += read;
+            }
+            return total;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+﻿// Utils/DurableCommitter.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Threading;
+using ObsidianLauncher.Enums;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Moves completed temporary files into place according to a <see cref="DurabilityMode"/>.
+    /// <para>
+    /// In <see cref="DurabilityMode.Batched"/> mode, committed files are queued and fsynced in groups, and each
+    /// distinct parent directory is synced once per group. Callers learn when a file has become durable through the
+    /// <c>onDurable</c> callback. That callback is the point at which a file may be recorded as verified.
+    /// </para>
+    /// Thread-safe; one instance is shared by all downloads of a scheduler.
+    /// </summary>
+    public sealed class DurableCommitter
+    {
+        /// <summary>
+        /// Number of files per fsync group in batched mode.
+        /// </summary>
+        public const int DefaultBatchSize = 256;
+
+        private readonly object _lock = new object();
+        private readonly int _batchSize;
+        private readonly ILogger _logger;
+        private List<PendingFile> _pending = new List<PendingFile>();
+        private long _fileSyncs;
+        private long _directorySyncs;
+        private long _syncTicks;
+
+        public DurableCommitter(DurabilityMode mode, int batchSize = DefaultBatchSize)
+        {
+            Mode = mode;
+            _batchSize = Math.Max(1, batchSize);
+            _logger = Log.ForContext<DurableCommitter>();
+        }
+
+        public DurabilityMode Mode { get; }
+
+        /// <summary>
+        /// Number of file fsyncs issued so far.
+        /// </summary>
+        public long FileSyncs => Interlocked.Read(ref _fileSyncs);
+
+        /// <summary>
+        /// Number of directory fsyncs issued so far.
+        /// </summary>
+        public long DirectorySyncs => Interlocked.Read(ref _directorySyncs);
+
+        /// <summary>
+        /// Total time spent inside fsync calls, summed over all threads.
+        /// </summary>
+        public TimeSpan SyncTime => TimeSpan.FromTicks(Interlocked.Read(ref _syncTicks));
+
+        /// <summary>
+        /// Renames <paramref name="tempPath"/> over <paramref name="finalPath"/> with the configured durability.
+        /// </summary>
+        /// <param name="tempPath">The fully written temporary file.</param>
+        /// <param name="finalPath">The final path.</param>
+        /// <param name="onDurable">
+        /// Invoked once the file is as durable as the mode promises. This happens immediately in fast and strict mode, and
+        /// when the file's group is flushed in batched mode. It is not invoked if the file disappears before the flush.
+        /// </param>
+        public void Commit(string tempPath, string finalPath, Action onDurable = null)
+        {
+            switch (Mode)
+            {
+                case DurabilityMode.Strict:
+                    TimedSync(() => FileSync.FlushFile(tempPath), ref _fileSyncs);
+                    AtomicFile.Commit(tempPath, finalPath);
+                    TimedSync(() => FileSync.SyncDirectory(GetDirectory(finalPath)), ref _directorySyncs);
+                    onDurable?.Invoke();
+                    break;
+
+                case DurabilityMode.Batched:
+                    AtomicFile.Commit(tempPath, finalPath);
+                    List<PendingFile> full = null;
+                    lock (_lock)
+                    {
+                        _pending.Add(new PendingFile(finalPath, onDurable));
+                        if (_pending.Count >= _batchSize)
+                        {
+                            full = _pending;
+                            _pending = new List<PendingFile>();
+                        }
+                    }
+                    if (full != null) SyncGroup(full);
+                    break;
+
+                default:
+                    AtomicFile.Commit(tempPath, finalPath);
+                    onDurable?.Invoke();
+                    break;
+            }
+        }
+
+        /// <summary>
+        /// Syncs every file still queued in batched mode. Call at the end of a run; a no-op in the other modes.
+        /// </summary>
+        public void Flush()
+        {
+            List<PendingFile> group;
+            lock (_lock)
+            {
+                if (_pending.Count == 0) return;
+                group = _pending;
+                _pending = new List<PendingFile>();
+            }
+            SyncGroup(group);
+        }
+
+        private void SyncGroup(List<PendingFile> group)
+        {
+            var directories = new HashSet<string>(OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal);
+            var synced = new List<PendingFile>(group.Count);
+            foreach (var file in group)
+            {
+                try
+                {
+                    TimedSync(() => FileSync.FlushFile(file.Path), ref _fileSyncs);
+                    directories.Add(GetDirectory(file.Path));
+                    synced.Add(file);
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    // Deleted or replaced since it was committed; whoever did that owns its state now.
+                    _logger.Verbose(ex, "Skipping fsync of {Path}", file.Path);
+                }
+            }
+
+            foreach (string directory in directories)
+            {
+                try
+                {
+                    TimedSync(() => FileSync.SyncDirectory(directory), ref _directorySyncs);
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    _logger.Warning(ex, "Failed to fsync directory {Directory}; its files will be re-verified next run.", directory);
+                    synced.RemoveAll(f => string.Equals(GetDirectory(f.Path), directory, StringComparison.Ordinal));
+                }
+            }
+
+            foreach (var file in synced)
+            {
+                file.OnDurable?.Invoke();
+            }
+            _logger.Verbose("Synced {Files} file(s) in {Directories} director(ies).", synced.Count, directories.Count);
+        }
+
+        private void TimedSync(Action sync, ref long counter)
+        {
+            long start = Stopwatch.GetTimestamp();
+            try
+            {
+                sync();
+                Interlocked.Increment(ref counter);
+            }
+            finally
+            {
+                long elapsed = Stopwatch.GetTimestamp() - start;
+                Interlocked.Add(ref _syncTicks, (long)(elapsed * ((double)TimeSpan.TicksPerSecond / Stopwatch.Frequency)));
+            }
+        }
+
+        private static string GetDirectory(string path) => Path.GetDirectoryName(Path.GetFullPath(path));
+
+        private readonly struct PendingFile
+        {
+            public PendingFile(string path, Action onDurable)
+            {
+                Path = path;
+                OnDurable = onDurable;
+            }
+
+            public string Path { get; }
+            public Action OnDurable { get; }
+        }
+    }
+}
@@ -0,0 +1,154 @@
+﻿// Utils/FileCloner.cs
+using System;
+using System.IO;
+using System.Runtime.InteropServices;
+using Microsoft.Win32.SafeHandles;
+using ObsidianLauncher.Enums;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Materializes a file at a new path as cheaply as the file system allows: a copy-on-write reflink where
+    /// supported, otherwise a hard link (when the caller allows it), otherwise a symbolic link (when the caller allows
+    /// it), otherwise a byte copy.
+    /// <para>
+    /// A hard link shares the file itself, so a write through one path shows up in the other. It is only suitable for
+    /// content nobody writes to. By default the source is marked read-only when it is hard linked, so an in-place write
+    /// fails instead of silently changing every linked copy.
+    /// </para>
+    /// </summary>
+    public static class FileCloner
+    {
+        // _IOW(0x94, 9, int) from linux/fs.h.
+        private const uint FICLONE = 0x40049409;
+
+        private static readonly ILogger _logger = Log.ForContext(typeof(FileCloner));
+
+        // Set once reflinks fail with "not supported" for a reason that won't change during this run (e.g. ext4).
+        private static volatile bool _reflinkUnsupported;
+
+        /// <summary>
+        /// Materializes <paramref name="sourcePath"/> at <paramref name="destinationPath"/>, which must not exist.
+        /// </summary>
+        /// <param name="sourcePath">Existing file.</param>
+        /// <param name="destinationPath">New path on the same volume (cross-volume requests fall back to copying).</param>
+        /// <param name="allowHardlink">Whether a hard link is acceptable (read-only content only).</param>
+        /// <param name="allowSymlink">Whether a symbolic link is acceptable when neither a reflink nor a hard link works
+        /// (e.g. across volumes). The link is absolute, so the source must stay where it is.</param>
+        /// <param name="protectSource">Whether to mark the source read-only when it is hard linked. Callers whose store
+        /// is content-addressed and re-verified (and must stay deletable on Windows) turn this off.</param>
+        /// <returns>The method that was used.</returns>
+        public static FileCloneMethod Clone(string sourcePath, string destinationPath, bool allowHardlink, bool allowSymlink = false, bool protectSource = true)
+        {
+            if (!_reflinkUnsupported && TryReflink(sourcePath, destinationPath))
+            {
+                return FileCloneMethod.Reflink;
+            }
+            if (allowHardlink && TryHardlink(sourcePath, destinationPath, protectSource))
+            {
+                return FileCloneMethod.Hardlink;
+            }
+            if (allowSymlink && TrySymlink(sourcePath, destinationPath))
+            {
+                return FileCloneMethod.Symlink;
+            }
+            File.Copy(sourcePath, destinationPath, false);
+            return FileCloneMethod.Copy;
+        }
+
+        private static bool TryReflink(string sourcePath, string destinationPath)
+        {
+            try
+            {
+                if (OperatingSystem.IsMacOS())
+                {
+                    if (clonefile(sourcePath, destinationPath, 0) == 0) return true;
+                    NoteReflinkFailure(Marshal.GetLastWin32Error());
+                    return false;
+                }
+                if (!OperatingSystem.IsLinux()) return false; // ReFS block cloning is not worth the complexity here.
+
+                using SafeFileHandle source = File.OpenHandle(sourcePath, FileMode.Open, FileAccess.Read, FileShare.Read);
+                bool cloned;
+                using (SafeFileHandle destination = File.OpenHandle(destinationPath, FileMode.CreateNew, FileAccess.Write, FileShare.None))
+                {
+                    cloned = ioctl((int)destination.DangerousGetHandle(), (nuint)FICLONE, (int)source.DangerousGetHandle()) == 0;
+                    if (!cloned) NoteReflinkFailure(Marshal.GetLastWin32Error());
+                }
+                if (!cloned) File.Delete(destinationPath);
+                return cloned;
+            }
+            catch (Exception ex) when (ex is EntryPointNotFoundException || ex is DllNotFoundException)
+            {
+                _reflinkUnsupported = true;
+                return false;
+            }
+        }
+
+        private static void NoteReflinkFailure(int errno)
+        {
+            // EOPNOTSUPP (95 on Linux, 45 on macOS), ENOTTY (25), ENOTSUP (45 on macOS) and EINVAL (22) mean
+            // "this file system can't"; EXDEV (18) only means these two paths are on different volumes.
+            if (errno == 95 || errno == 45 || errno == 25 || errno == 22)
+            {
+                if (!_reflinkUnsupported) _logger.Verbose("Reflinks are not supported here (errno {Errno}); falling back to hard links or copies.", errno);
+                _reflinkUnsupported = true;
+            }
+        }
+
+        private static bool TryHardlink(string sourcePath, string destinationPath, bool protectSource)
+        {
+            try
+            {
+                bool linked = OperatingSystem.IsWindows()
+                    ? CreateHardLinkW(destinationPath, sourcePath, IntPtr.Zero)
+                    : link(sourcePath, destinationPath) == 0;
+                if (!linked) return false;
+            }
+            catch (Exception ex) when (ex is EntryPointNotFoundException || ex is DllNotFoundException)
+            {
+                return false;
+            }
+            if (!protectSource) return true;
+
+            try
+            {
+                File.SetAttributes(sourcePath, File.GetAttributes(sourcePath) | FileAttributes.ReadOnly);
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Verbose(ex, "Could not mark hard-linked {Path} read-only", sourcePath);
+            }
+            return true;
+        }
+
+        private static bool TrySymlink(string sourcePath, string destinationPath)
+        {
+            try
+            {
+                File.CreateSymbolicLink(destinationPath, Path.GetFullPath(sourcePath));
+                return true;
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                // Windows without developer mode or the symlink privilege.
+                _logger.Verbose(ex, "Could not create a symbolic link at {Path}", destinationPath);
+                return false;
+            }
+        }
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int ioctl(int fd, nuint request, int arg);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int link([MarshalAs(UnmanagedType.LPUTF8Str)] string oldPath, [MarshalAs(UnmanagedType.LPUTF8Str)] string newPath);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int clonefile([MarshalAs(UnmanagedType.LPUTF8Str)] string src, [MarshalAs(UnmanagedType.LPUTF8Str)] string dst, int flags);
+
+        [DllImport("kernel32.dll", CharSet = CharSet.Unicode, SetLastError = true)]
+        [return: MarshalAs(UnmanagedType.Bool)]
+        private static extern bool CreateHardLinkW(string fileName, string existingFileName, IntPtr securityAttributes);
+    }
+}
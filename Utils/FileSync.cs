@@ -0,0 +1,91 @@
+﻿// Utils/FileSync.cs
+using System;
+using System.IO;
+using System.Runtime.InteropServices;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// fsync helpers. .NET can flush a file it opened for writing, but it has no API for syncing a directory,
+    /// which is what makes a rename durable on Unix. That part goes straight to libc.
+    /// </summary>
+    public static class FileSync
+    {
+        /// <summary>
+        /// Flushes the file's data and metadata to the storage device.
+        /// </summary>
+        public static void FlushFile(string path)
+        {
+            // FileMode.Open with write access neither truncates nor creates; Flush(true) is fsync/FlushFileBuffers.
+            using var stream = new FileStream(path, FileMode.Open, FileAccess.Write, FileShare.ReadWrite | FileShare.Delete);
+            stream.Flush(true);
+        }
+
+        /// <summary>
+        /// Makes the directory's entries (files created, renamed or deleted in it) durable.
+        /// On Windows this is a no-op: NTFS journals directory changes and directories cannot be flushed.
+        /// </summary>
+        public static void SyncDirectory(string directoryPath)
+        {
+            if (OperatingSystem.IsWindows()) return;
+
+            int fd = open(directoryPath, O_RDONLY);
+            if (fd < 0)
+            {
+                throw new IOException($"Could not open directory '{directoryPath}' for fsync (errno {Marshal.GetLastWin32Error()}).");
+            }
+            try
+            {
+                if (fsync(fd) != 0)
+                {
+                    throw new IOException($"fsync of directory '{directoryPath}' failed (errno {Marshal.GetLastWin32Error()}).");
+                }
+            }
+            finally
+            {
+                close(fd);
+            }
+        }
+
+        /// <summary>
+        /// Flushes every file under <paramref name="rootPath"/> and then every directory, deepest first.
+        /// </summary>
+        public static void SyncTree(string rootPath)
+        {
+            foreach (string file in Directory.EnumerateFiles(rootPath, "*", SearchOption.AllDirectories))
+            {
+                FlushFile(file);
+            }
+            string[] directories = Directory.GetDirectories(rootPath, "*", SearchOption.AllDirectories);
+            Array.Sort(directories, (a, b) => b.Length.CompareTo(a.Length));
+            foreach (string directory in directories)
+            {
+                SyncDirectory(directory);
+            }
+            SyncDirectory(rootPath);
+        }
+
+        /// <summary>
+        /// Asks the OS to write back all dirty data system-wide (<c>sync(2)</c>). Used by measurements to start
+        /// from a clean page cache; does nothing on Windows.
+        /// </summary>
+        public static void SyncAll()
+        {
+            if (!OperatingSystem.IsWindows()) sync();
+        }
+
+        private const int O_RDONLY = 0;
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int open([MarshalAs(UnmanagedType.LPUTF8Str)] string path, int flags);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int fsync(int fd);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int close(int fd);
+
+        [DllImport("libc")]
+        private static extern void sync();
+    }
+}
@@ -0,0 +1,96 @@
+﻿// Utils/IoPriority.cs
+using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Lowers the disk priority of the calling thread, for background work that must not compete with the game:
+    /// the idle I/O scheduling class on Linux (<c>ioprio_set</c> with <c>IOPRIO_CLASS_IDLE</c>), background processing
+    /// mode on Windows and the throttled I/O policy on macOS. The thread's CPU priority is lowered as well.
+    /// <para>
+    /// The setting belongs to the thread, so it only helps work that stays on a dedicated thread; thread pool threads
+    /// and async continuations do not keep it.
+    /// </para>
+    /// </summary>
+    public static class IoPriority
+    {
+        private const int IoprioWhoProcess = 1;   // With who = 0: the calling thread.
+        private const int IoprioClassIdle = 3;
+        private const int IoprioClassShift = 13;
+
+        private const int ThreadModeBackgroundBegin = 0x00010000;
+
+        private const int IopolTypeDisk = 0;
+        private const int IopolScopeThread = 1;
+        private const int IopolThrottle = 3;
+
+        /// <summary>
+        /// Moves the calling thread into the idle I/O class.
+        /// </summary>
+        /// <returns>True if the OS accepted the I/O priority change; the CPU priority is lowered either way.</returns>
+        public static bool SetCurrentThreadIdle()
+        {
+            Thread.CurrentThread.Priority = ThreadPriority.Lowest;
+            try
+            {
+                if (OperatingSystem.IsLinux())
+                {
+                    long number = IoprioSetSyscall();
+                    return number >= 0 && syscall(number, IoprioWhoProcess, 0, IoprioClassIdle << IoprioClassShift) == 0;
+                }
+                if (OperatingSystem.IsWindows())
+                {
+                    return SetThreadPriority(GetCurrentThread(), ThreadModeBackgroundBegin);
+                }
+                if (OperatingSystem.IsMacOS())
+                {
+                    return setiopolicy_np(IopolTypeDisk, IopolScopeThread, IopolThrottle) == 0;
+                }
+            }
+            catch (Exception ex) when (ex is DllNotFoundException || ex is EntryPointNotFoundException)
+            {
+                // Unusual libc; the thread just keeps its normal I/O priority.
+            }
+            return false;
+        }
+
+        /// <summary>
+        /// Whether the calling thread is in the idle I/O class. Linux only; false elsewhere.
+        /// </summary>
+        public static bool IsCurrentThreadIdle()
+        {
+            if (!OperatingSystem.IsLinux()) return false;
+            long number = IoprioSetSyscall();
+            if (number < 0) return false;
+            long value = syscall(number + 1, IoprioWhoProcess, 0, 0); // ioprio_get follows ioprio_set on every architecture.
+            return value >= 0 && value >> IoprioClassShift == IoprioClassIdle;
+        }
+
+        private static long IoprioSetSyscall()
+        {
+            switch (RuntimeInformation.ProcessArchitecture)
+            {
+                case Architecture.X64: return 251;
+                case Architecture.X86: return 289;
+                case Architecture.Arm64: return 30;
+                case Architecture.Arm: return 314;
+                default: return -1;
+            }
+        }
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern long syscall(long number, long arg1, long arg2, long arg3);
+
+        [DllImport("kernel32.dll", SetLastError = true)]
+        private static extern IntPtr GetCurrentThread();
+
+        [DllImport("kernel32.dll", SetLastError = true)]
+        [return: MarshalAs(UnmanagedType.Bool)]
+        private static extern bool SetThreadPriority(IntPtr thread, int priority);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int setiopolicy_np(int ioType, int scope, int policy);
+    }
+}
@@ -0,0 +1,420 @@
+﻿// Utils/IoUring.cs
+using System;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Minimal Linux io_uring instance on the raw system calls (no liburing). The submission and completion rings are
+    /// mapped into the process; callers queue entries with the <c>Prepare*</c> methods and hand them to the kernel with
+    /// <see cref="SubmitAndWait"/>, which costs one <c>io_uring_enter</c> for the whole batch.
+    /// Not thread-safe: use one instance per thread.
+    /// </summary>
+    internal sealed unsafe class IoUring : IDisposable
+    {
+        /// <summary>
+        /// <c>AT_FDCWD</c>: relative paths given to <see cref="PrepareOpenAt"/> and <see cref="PrepareRenameAt"/> resolve against the working directory.
+        /// </summary>
+        public const int AtFdCwd = -100;
+
+        public const int ORdOnly = 0x0;
+        public const int OWrOnly = 0x1;
+        public const int OCreat = 0x40;
+        public const int OExcl = 0x80;
+        public const int OCloExec = 0x80000;
+
+        private const long SysIoUringSetup = 425;
+        private const long SysIoUringEnter = 426;
+        private const long SysIoUringRegister = 427;
+
+        private const byte OpReadFixed = 4;
+        private const byte OpWriteFixed = 5;
+        private const byte OpOpenAt = 18;
+        private const byte OpClose = 19;
+        private const byte OpRead = 22;
+        private const byte OpWrite = 23;
+        private const byte OpRenameAt = 35;
+
+        private const uint SetupSubmitAll = 1 << 7;
+        private const uint FeatSingleMmap = 1 << 0;
+        private const uint EnterGetEvents = 1 << 0;
+        private const uint RegisterBuffersOp = 0;
+
+        private const long OffSqRing = 0;
+        private const long OffCqRing = 0x8000000;
+        private const long OffSqes = 0x10000000;
+
+        private const int ProtRead = 0x1;
+        private const int ProtWrite = 0x2;
+        private const int MapShared = 0x1;
+        private const int MapPopulate = 0x8000;
+
+        private const int EINTR = 4;
+        private const int EAGAIN = 11;
+        private const int EBUSY = 16;
+        private const int EINVAL = 22;
+        private const int ENOSYS = 38;
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct SqRingOffsets
+        {
+            public uint Head, Tail, RingMask, RingEntries, Flags, Dropped, Array, Resv1;
+            public ulong UserAddr;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct CqRingOffsets
+        {
+            public uint Head, Tail, RingMask, RingEntries, Overflow, Cqes, Flags, Resv1;
+            public ulong UserAddr;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct Params
+        {
+            public uint SqEntries, CqEntries, Flags, SqThreadCpu, SqThreadIdle, Features, WqFd;
+            public fixed uint Resv[3];
+            public SqRingOffsets SqOff;
+            public CqRingOffsets CqOff;
+        }
+
+        [StructLayout(LayoutKind.Explicit, Size = 64)]
+        private struct Sqe
+        {
+            [FieldOffset(0)] public byte Opcode;
+            [FieldOffset(1)] public byte Flags;
+            [FieldOffset(2)] public ushort IoPrio;
+            [FieldOffset(4)] public int Fd;
+            [FieldOffset(8)] public ulong Off;
+            [FieldOffset(16)] public ulong Addr;
+            [FieldOffset(24)] public uint Len;
+            [FieldOffset(28)] public uint OpFlags;
+            [FieldOffset(32)] public ulong UserData;
+            [FieldOffset(40)] public ushort BufIndex;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct Cqe
+        {
+            public ulong UserData;
+            public int Res;
+            public uint Flags;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct IoVec
+        {
+            public IntPtr Base;
+            public nuint Length;
+        }
+
+        /// <summary>
+        /// One completed entry: the caller's tag and the operation's result (a byte count or fd, or a negative errno).
+        /// </summary>
+        public readonly struct Completion
+        {
+            public Completion(ulong userData, int result)
+            {
+                UserData = userData;
+                Result = result;
+            }
+
+            public ulong UserData { get; }
+            public int Result { get; }
+        }
+
+        private static long _enterCalls;
+
+        private readonly int _fd;
+        private IntPtr _sqRing;
+        private IntPtr _cqRing;
+        private IntPtr _sqesMap;
+        private nuint _sqRingSize;
+        private nuint _cqRingSize;
+        private nuint _sqesSize;
+
+        private uint* _sqHead;
+        private uint* _sqTail;
+        private uint* _sqArray;
+        private uint _sqMask;
+        private uint _sqEntries;
+        private Sqe* _sqes;
+        private uint* _cqHead;
+        private uint* _cqTail;
+        private uint _cqMask;
+        private Cqe* _cqes;
+
+        private int _queued;
+        private bool _buffersRegistered;
+        private bool _disposed;
+
+        private IoUring(int fd)
+        {
+            _fd = fd;
+        }
+
+        /// <summary>
+        /// Total <c>io_uring_enter</c> calls made by every ring in this process.
+        /// </summary>
+        public static long EnterCalls => Interlocked.Read(ref _enterCalls);
+
+        /// <summary>
+        /// Number of entries that can be queued between two <see cref="SubmitAndWait"/> calls.
+        /// </summary>
+        public int Entries => (int)_sqEntries;
+
+        /// <summary>
+        /// Creates a ring with room for <paramref name="entries"/> queued operations.
+        /// </summary>
+        /// <param name="entries">Submission queue size (rounded up to a power of two by the kernel).</param>
+        /// <param name="errno">Why the ring could not be created: ENOSYS off Linux or on old kernels, EPERM when io_uring is
+        /// disabled by <c>kernel.io_uring_disabled</c> or a seccomp filter (typical in containers).</param>
+        /// <returns>The ring, or null if io_uring is not usable.</returns>
+        public static IoUring TryCreate(uint entries, out int errno)
+        {
+            errno = ENOSYS;
+            if (!OperatingSystem.IsLinux()) return null;
+            try
+            {
+                // SUBMIT_ALL (5.18) keeps submitting past an entry that fails early; older kernels reject the flag.
+                Params p = default;
+                p.Flags = SetupSubmitAll;
+                long fd = syscall(SysIoUringSetup, entries, (long)&p, 0, 0, 0, 0);
+                if (fd < 0 && Marshal.GetLastPInvokeError() == EINVAL)
+                {
+                    p = default;
+                    fd = syscall(SysIoUringSetup, entries, (long)&p, 0, 0, 0, 0);
+                }
+                if (fd < 0)
+                {
+                    errno = Marshal.GetLastPInvokeError();
+                    return null;
+                }
+
+                var ring = new IoUring((int)fd);
+                if (!ring.MapRings(ref p))
+                {
+                    errno = Marshal.GetLastPInvokeError();
+                    ring.Dispose();
+                    return null;
+                }
+                errno = 0;
+                return ring;
+            }
+            catch (Exception ex) when (ex is DllNotFoundException || ex is EntryPointNotFoundException)
+            {
+                return null;
+            }
+        }
+
+        private bool MapRings(ref Params p)
+        {
+            _sqRingSize = p.SqOff.Array + p.SqEntries * sizeof(uint);
+            _cqRingSize = p.CqOff.Cqes + p.CqEntries * (uint)sizeof(Cqe);
+            bool singleMmap = (p.Features & FeatSingleMmap) != 0;
+            if (singleMmap) _sqRingSize = _cqRingSize = Math.Max(_sqRingSize, _cqRingSize);
+
+            _sqRing = mmap(IntPtr.Zero, _sqRingSize, ProtRead | ProtWrite, MapShared | MapPopulate, _fd, OffSqRing);
+            if (_sqRing == new IntPtr(-1)) return false;
+            if (singleMmap)
+            {
+                _cqRing = _sqRing;
+            }
+            else
+            {
+                _cqRing = mmap(IntPtr.Zero, _cqRingSize, ProtRead | ProtWrite, MapShared | MapPopulate, _fd, OffCqRing);
+                if (_cqRing == new IntPtr(-1)) return false;
+            }
+            _sqesSize = p.SqEntries * (uint)sizeof(Sqe);
+            _sqesMap = mmap(IntPtr.Zero, _sqesSize, ProtRead | ProtWrite, MapShared | MapPopulate, _fd, OffSqes);
+            if (_sqesMap == new IntPtr(-1)) return false;
+
+            byte* sq = (byte*)_sqRing;
+            _sqHead = (uint*)(sq + p.SqOff.Head);
+            _sqTail = (uint*)(sq + p.SqOff.Tail);
+            _sqArray = (uint*)(sq + p.SqOff.Array);
+            _sqMask = *(uint*)(sq + p.SqOff.RingMask);
+            _sqEntries = p.SqEntries;
+            _sqes = (Sqe*)_sqesMap;
+
+            byte* cq = (byte*)_cqRing;
+            _cqHead = (uint*)(cq + p.CqOff.Head);
+            _cqTail = (uint*)(cq + p.CqOff.Tail);
+            _cqMask = *(uint*)(cq + p.CqOff.RingMask);
+            _cqes = (Cqe*)(cq + p.CqOff.Cqes);
+            return true;
+        }
+
+        /// <summary>
+        /// Registers one buffer with the kernel, which pins it once instead of on every read and write. Fixed reads and
+        /// writes (<c>bufferIndex</c> 0) must then stay inside it. Fails when the buffer exceeds <c>RLIMIT_MEMLOCK</c>
+        /// on older kernels; plain reads and writes are used then.
+        /// </summary>
+        public bool RegisterBuffer(byte* buffer, int length)
+        {
+            var iov = new IoVec { Base = (IntPtr)buffer, Length = (nuint)length };
+            _buffersRegistered = syscall(SysIoUringRegister, _fd, RegisterBuffersOp, (long)&iov, 1, 0, 0) == 0;
+            return _buffersRegistered;
+        }
+
+        /// <summary>
+        /// Queues <c>openat(AT_FDCWD, path, flags, mode)</c>. <paramref name="path"/> must be NUL-terminated and stay
+        /// valid until the completion is reaped.
+        /// </summary>
+        public void PrepareOpenAt(byte* path, int flags, uint mode, ulong userData)
+        {
+            Sqe* sqe = NextSqe();
+            sqe->Opcode = OpOpenAt;
+            sqe->Fd = AtFdCwd;
+            sqe->Addr = (ulong)path;
+            sqe->Len = mode;
+            sqe->OpFlags = (uint)flags;
+            sqe->UserData = userData;
+        }
+
+        /// <summary>
+        /// Queues a read of up to <paramref name="length"/> bytes at <paramref name="offset"/> into <paramref name="buffer"/>,
+        /// from the registered buffer when there is one.
+        /// </summary>
+        public void PrepareRead(int fd, byte* buffer, uint length, ulong offset, ulong userData)
+        {
+            Sqe* sqe = NextSqe();
+            sqe->Opcode = _buffersRegistered ? OpReadFixed : OpRead;
+            sqe->Fd = fd;
+            sqe->Addr = (ulong)buffer;
+            sqe->Len = length;
+            sqe->Off = offset;
+            sqe->UserData = userData;
+        }
+
+        /// <summary>
+        /// Queues a write of <paramref name="length"/> bytes at <paramref name="offset"/> from <paramref name="buffer"/>,
+        /// from the registered buffer when there is one.
+        /// </summary>
+        public void PrepareWrite(int fd, byte* buffer, uint length, ulong offset, ulong userData)
+        {
+            Sqe* sqe = NextSqe();
+            sqe->Opcode = _buffersRegistered ? OpWriteFixed : OpWrite;
+            sqe->Fd = fd;
+            sqe->Addr = (ulong)buffer;
+            sqe->Len = length;
+            sqe->Off = offset;
+            sqe->UserData = userData;
+        }
+
+        /// <summary>
+        /// Queues <c>close(fd)</c>.
+        /// </summary>
+        public void PrepareClose(int fd, ulong userData)
+        {
+            Sqe* sqe = NextSqe();
+            sqe->Opcode = OpClose;
+            sqe->Fd = fd;
+            sqe->UserData = userData;
+        }
+
+        /// <summary>
+        /// Queues <c>renameat(AT_FDCWD, oldPath, AT_FDCWD, newPath)</c>, replacing any file at <paramref name="newPath"/>.
+        /// Kernels before 5.11 complete it with -EINVAL.
+        /// </summary>
+        public void PrepareRenameAt(byte* oldPath, byte* newPath, ulong userData)
+        {
+            Sqe* sqe = NextSqe();
+            sqe->Opcode = OpRenameAt;
+            sqe->Fd = AtFdCwd;
+            sqe->Addr = (ulong)oldPath;
+            sqe->Len = unchecked((uint)AtFdCwd);
+            sqe->Off = (ulong)newPath;
+            sqe->UserData = userData;
+        }
+
+        /// <summary>
+        /// Submits every queued entry and waits until all of them have completed.
+        /// </summary>
+        /// <param name="completions">Receives one completion per queued entry, in completion order.</param>
+        /// <returns>Number of completions written.</returns>
+        public int SubmitAndWait(Span<Completion> completions)
+        {
+            int expected = _queued;
+            if (completions.Length < expected) throw new ArgumentException("Too few completion slots for the queued entries.", nameof(completions));
+
+            int submitted = 0;
+            int reaped = 0;
+            while (reaped < expected)
+            {
+                // The kernel only waits when everything passed in was submitted, so this never blocks on entries it has not seen.
+                long ret = syscall(SysIoUringEnter, _fd, expected - submitted, expected - reaped, EnterGetEvents, 0, 0);
+                Interlocked.Increment(ref _enterCalls);
+                if (ret < 0)
+                {
+                    int errno = Marshal.GetLastPInvokeError();
+                    if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                    {
+                        throw new IOException($"io_uring_enter failed: {Marshal.GetPInvokeErrorMessage(errno)} (errno {errno}).");
+                    }
+                }
+                else
+                {
+                    submitted += (int)ret;
+                }
+                reaped += Reap(completions.Slice(reaped));
+            }
+            _queued = 0;
+            return reaped;
+        }
+
+        private int Reap(Span<Completion> into)
+        {
+            uint head = *_cqHead;
+            uint tail = Volatile.Read(ref *_cqTail);
+            int count = 0;
+            while (head != tail && count < into.Length)
+            {
+                Cqe* cqe = _cqes + (head & _cqMask);
+                into[count++] = new Completion(cqe->UserData, cqe->Res);
+                head++;
+            }
+            Volatile.Write(ref *_cqHead, head);
+            return count;
+        }
+
+        private Sqe* NextSqe()
+        {
+            if (_queued >= _sqEntries) throw new InvalidOperationException("The submission queue is full; submit before queuing more entries.");
+            uint tail = *_sqTail;
+            uint index = tail & _sqMask;
+            Sqe* sqe = _sqes + index;
+            *sqe = default;
+            _sqArray[index] = index;
+            // The kernel only reads the queue inside io_uring_enter, but the tail is still published with release semantics.
+            Volatile.Write(ref *_sqTail, tail + 1);
+            _queued++;
+            return sqe;
+        }
+
+        public void Dispose()
+        {
+            if (_disposed) return;
+            _disposed = true;
+            if (_sqesMap != IntPtr.Zero && _sqesMap != new IntPtr(-1)) munmap(_sqesMap, _sqesSize);
+            if (_cqRing != IntPtr.Zero && _cqRing != _sqRing && _cqRing != new IntPtr(-1)) munmap(_cqRing, _cqRingSize);
+            if (_sqRing != IntPtr.Zero && _sqRing != new IntPtr(-1)) munmap(_sqRing, _sqRingSize);
+            _sqesMap = _cqRing = _sqRing = IntPtr.Zero;
+            close(_fd);
+        }
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern long syscall(long number, long arg1, long arg2, long arg3, long arg4, long arg5, long arg6);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern IntPtr mmap(IntPtr address, nuint length, int protection, int flags, int fd, long offset);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int munmap(IntPtr address, nuint length);
+
+        [DllImport("libc", SetLastError = true)]
+        private static extern int close(int fd);
+    }
+}
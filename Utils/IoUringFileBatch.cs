@@ -0,0 +1,307 @@
+﻿// Utils/IoUringFileBatch.cs
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+using ObsidianLauncher.Enums;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Reads and writes groups of small files through one <see cref="IoUring"/>. Each step (open, read or write, close,
+    /// rename) for up to <see cref="Capacity"/> files is a single submission, so a group costs a handful of system calls
+    /// instead of three or four per file. File contents move through one pinned buffer registered with the ring once,
+    /// split into a <see cref="SlotSize"/> slot per file.
+    /// <para>
+    /// Used by bulk verification and by small-file writes when <see cref="Backend"/> is <see cref="IoBackend.IoUring"/>.
+    /// io_uring is often unavailable (non-Linux, kernels before 5.6, <c>kernel.io_uring_disabled</c>, container seccomp
+    /// profiles); <see cref="TryCreate"/> then returns null and callers keep their regular file API path.
+    /// Not thread-safe: use one batch per thread.
+    /// </para>
+    /// </summary>
+    public sealed unsafe class IoUringFileBatch : IDisposable
+    {
+        /// <summary>
+        /// Files handled per call.
+        /// </summary>
+        public const int Capacity = 32;
+
+        /// <summary>
+        /// Largest file that fits a slot; callers use their regular path for anything bigger.
+        /// </summary>
+        public const int MaxFileSize = CryptoUtils.MultiBufferSmallFileLimit;
+
+        /// <summary>
+        /// Buffer space per file. One page more than <see cref="MaxFileSize"/>, so a read can tell a file that grew past
+        /// its expected size from one that matches it.
+        /// </summary>
+        public const int SlotSize = MaxFileSize + 4096;
+
+        private const uint DefaultFileMode = 0x1A4; // 0644, before the umask.
+
+        private const int ENOENT = 2;
+        private const int ENOTDIR = 20;
+        private const int EINVAL = 22;
+
+        private static readonly ILogger _logger = Log.ForContext<IoUringFileBatch>();
+        private static int _availability; // 0 = not probed yet, 1 = available, -1 = not available.
+
+        private readonly IoUring _ring;
+        private readonly byte[] _buffer;
+        private readonly byte* _bufferPointer;
+        private readonly IoUring.Completion[] _completions = new IoUring.Completion[Capacity];
+        private readonly int[] _fds = new int[Capacity];
+        private byte* _paths;
+        private int _pathsCapacity;
+
+        /// <summary>
+        /// Backend selected for this process (<c>--io=default|uring</c>).
+        /// </summary>
+        public static IoBackend Backend { get; set; } = IoBackend.Default;
+
+        /// <summary>
+        /// Whether io_uring can be used by this process. Probed once by creating a ring.
+        /// </summary>
+        public static bool IsAvailable
+        {
+            get
+            {
+                if (_availability == 0)
+                {
+                    using IoUring probe = IoUring.TryCreate(Capacity, out int errno);
+                    if (probe == null)
+                    {
+                        _logger.Information("io_uring is not available ({Error}); using the default file I/O path.",
+                            OperatingSystem.IsLinux() ? $"{Marshal.GetPInvokeErrorMessage(errno)}, errno {errno}" : "not Linux");
+                    }
+                    Interlocked.CompareExchange(ref _availability, probe != null ? 1 : -1, 0);
+                }
+                return _availability > 0;
+            }
+        }
+
+        private IoUringFileBatch(IoUring ring)
+        {
+            _ring = ring;
+            // Allocated on the pinned object heap, so the address handed to the kernel never moves.
+            _buffer = GC.AllocateUninitializedArray<byte>(Capacity * SlotSize, pinned: true);
+            _bufferPointer = (byte*)Unsafe.AsPointer(ref MemoryMarshal.GetArrayDataReference(_buffer));
+            if (!_ring.RegisterBuffer(_bufferPointer, _buffer.Length))
+            {
+                _logger.Verbose("Could not register the io_uring buffer (memlock limit?); using unregistered reads and writes.");
+            }
+        }
+
+        /// <summary>
+        /// Creates a batch if <see cref="Backend"/> selects io_uring and it is available.
+        /// </summary>
+        /// <returns>The batch, or null if the caller should use its regular path.</returns>
+        public static IoUringFileBatch TryCreate()
+        {
+            if (Backend != IoBackend.IoUring || !IsAvailable) return null;
+            IoUring ring = IoUring.TryCreate(Capacity, out int errno);
+            if (ring == null)
+            {
+                _logger.Verbose("Could not create an io_uring (errno {Errno}); using the default file I/O path.", errno);
+                return null;
+            }
+            return new IoUringFileBatch(ring);
+        }
+
+        /// <summary>
+        /// Total <c>io_uring_enter</c> calls made in this process, for benchmarks.
+        /// </summary>
+        public static long SubmitCalls => IoUring.EnterCalls;
+
+        /// <summary>
+        /// Returns true if an errno from <see cref="ReadFiles"/> means the file does not exist.
+        /// </summary>
+        public static bool IsNotFound(int result) => result == -ENOENT || result == -ENOTDIR;
+
+        /// <summary>
+        /// Content of slot <paramref name="slot"/> after <see cref="ReadFiles"/>. Valid until the next call on this batch.
+        /// </summary>
+        public ReadOnlyMemory<byte> GetContent(int slot, int length) => new ReadOnlyMemory<byte>(_buffer, slot * SlotSize, length);
+
+        /// <summary>
+        /// Opens, reads from the start and closes up to <see cref="Capacity"/> files in three submissions.
+        /// File <c>i</c> lands in slot <c>i</c> (see <see cref="GetContent"/>).
+        /// </summary>
+        /// <param name="paths">Files to read.</param>
+        /// <param name="maxLengths">Bytes to read per file, at most <see cref="SlotSize"/>.</param>
+        /// <param name="results">Per file: the number of bytes read, or a negative errno.</param>
+        public void ReadFiles(IReadOnlyList<string> paths, ReadOnlySpan<int> maxLengths, Span<int> results)
+        {
+            int count = CheckCount(paths.Count);
+            EncodePaths(paths, null, out int[] offsets, out _);
+
+            for (int i = 0; i < count; i++) _ring.PrepareOpenAt(_paths + offsets[i], IoUring.ORdOnly | IoUring.OCloExec, 0, (ulong)i);
+            Complete(_fds);
+
+            int reads = 0;
+            for (int i = 0; i < count; i++)
+            {
+                results[i] = _fds[i];
+                if (_fds[i] < 0) continue;
+                _ring.PrepareRead(_fds[i], _bufferPointer + i * SlotSize, (uint)Math.Min(maxLengths[i], SlotSize), 0, (ulong)i);
+                reads++;
+            }
+            if (reads > 0) Complete(results);
+
+            CloseAll(count);
+        }
+
+        /// <summary>
+        /// Writes up to <see cref="Capacity"/> files the way <see cref="AtomicFile.WriteAllBytes"/> does (temporary sibling,
+        /// then a rename over the final path), in four submissions: open, write, close and rename. Nothing is fsynced.
+        /// Parent directories must exist.
+        /// </summary>
+        /// <param name="files">Final paths and contents, each at most <see cref="SlotSize"/> bytes.</param>
+        /// <param name="results">Per file: 0 on success, or a negative errno from the step that failed (the temporary file is removed then).</param>
+        public void WriteFiles(IReadOnlyList<(string Path, ReadOnlyMemory<byte> Content)> files, Span<int> results)
+        {
+            int count = CheckCount(files.Count);
+            var finalPaths = new string[count];
+            var tempPaths = new string[count];
+            for (int i = 0; i < count; i++)
+            {
+                if (files[i].Content.Length > SlotSize) throw new ArgumentException($"{files[i].Path} is larger than a slot ({SlotSize} bytes).", nameof(files));
+                finalPaths[i] = files[i].Path;
+                tempPaths[i] = AtomicFile.CreateTempPath(files[i].Path);
+                files[i].Content.Span.CopyTo(new Span<byte>(_buffer, i * SlotSize, SlotSize));
+            }
+            EncodePaths(tempPaths, finalPaths, out int[] tempOffsets, out int[] finalOffsets);
+
+            for (int i = 0; i < count; i++)
+            {
+                _ring.PrepareOpenAt(_paths + tempOffsets[i], IoUring.OWrOnly | IoUring.OCreat | IoUring.OExcl | IoUring.OCloExec, DefaultFileMode, (ulong)i);
+            }
+            Complete(_fds);
+
+            var written = new int[count];
+            int writes = 0;
+            for (int i = 0; i < count; i++)
+            {
+                results[i] = _fds[i] < 0 ? _fds[i] : 0;
+                if (_fds[i] < 0) continue;
+                _ring.PrepareWrite(_fds[i], _bufferPointer + i * SlotSize, (uint)files[i].Content.Length, 0, (ulong)i);
+                writes++;
+            }
+            if (writes > 0) Complete(written);
+            for (int i = 0; i < count; i++)
+            {
+                if (_fds[i] < 0) continue;
+                if (written[i] < 0) results[i] = written[i];
+                else if (written[i] != files[i].Content.Length) results[i] = -EINVAL; // Short write; should not happen for regular files.
+            }
+
+            CloseAll(count);
+
+            var renamed = new int[count];
+            int renames = 0;
+            for (int i = 0; i < count; i++)
+            {
+                if (results[i] != 0) continue;
+                _ring.PrepareRenameAt(_paths + tempOffsets[i], _paths + finalOffsets[i], (ulong)i);
+                renames++;
+            }
+            if (renames > 0) Complete(renamed);
+
+            for (int i = 0; i < count; i++)
+            {
+                if (_fds[i] < 0) continue; // The temporary file was never created.
+                if (results[i] == 0 && renamed[i] == -EINVAL)
+                {
+                    // IORING_OP_RENAMEAT needs 5.11; rename the regular way on older kernels.
+                    try
+                    {
+                        AtomicFile.Commit(tempPaths[i], finalPaths[i]);
+                        continue;
+                    }
+                    catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                    {
+                        results[i] = -EINVAL;
+                    }
+                }
+                else if (results[i] == 0)
+                {
+                    results[i] = renamed[i];
+                }
+                if (results[i] != 0) AtomicFile.TryDeleteTemp(tempPaths[i]);
+            }
+        }
+
+        private int CheckCount(int count)
+        {
+            if (count > Capacity) throw new ArgumentException($"At most {Capacity} files per call.");
+            return count;
+        }
+
+        /// <summary>
+        /// Closes every file opened by the last call; close failures on read-only or already written files are ignored.
+        /// </summary>
+        private void CloseAll(int count)
+        {
+            int closes = 0;
+            for (int i = 0; i < count; i++)
+            {
+                if (_fds[i] < 0) continue;
+                _ring.PrepareClose(_fds[i], (ulong)i);
+                closes++;
+            }
+            if (closes > 0) _ring.SubmitAndWait(_completions);
+        }
+
+        /// <summary>
+        /// Submits the queued entries and stores each completion's result at its tag's index.
+        /// </summary>
+        private void Complete(Span<int> resultsByTag)
+        {
+            int completed = _ring.SubmitAndWait(_completions);
+            for (int c = 0; c < completed; c++) resultsByTag[(int)_completions[c].UserData] = _completions[c].Result;
+        }
+
+        /// <summary>
+        /// Copies the paths as NUL-terminated UTF-8 into native memory that stays put until the next call.
+        /// </summary>
+        private void EncodePaths(IReadOnlyList<string> first, IReadOnlyList<string> second, out int[] firstOffsets, out int[] secondOffsets)
+        {
+            int size = 0;
+            foreach (string path in first) size += Encoding.UTF8.GetByteCount(path) + 1;
+            if (second != null) foreach (string path in second) size += Encoding.UTF8.GetByteCount(path) + 1;
+            if (size > _pathsCapacity)
+            {
+                _paths = (byte*)NativeMemory.Realloc(_paths, (nuint)size);
+                _pathsCapacity = size;
+            }
+
+            int offset = 0;
+            firstOffsets = Encode(first, ref offset);
+            secondOffsets = second != null ? Encode(second, ref offset) : null;
+
+            int[] Encode(IReadOnlyList<string> paths, ref int position)
+            {
+                var offsets = new int[paths.Count];
+                for (int i = 0; i < paths.Count; i++)
+                {
+                    offsets[i] = position;
+                    position += Encoding.UTF8.GetBytes(paths[i], new Span<byte>(_paths + position, _pathsCapacity - position));
+                    _paths[position++] = 0;
+                }
+                return offsets;
+            }
+        }
+
+        public void Dispose()
+        {
+            _ring.Dispose();
+            if (_paths != null) NativeMemory.Free(_paths);
+            _paths = null;
+            _pathsCapacity = 0;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+﻿// Utils/LauncherEventSource.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics.Tracing;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// EventCounters over the <see cref="LauncherMetrics"/> instruments, so a running launcher can be watched with
+    /// <c>dotnet-counters monitor -p PID --counters ObsidianLauncher-Counters</c>.
+    /// <para>
+    /// The counters, and the <see cref="MetricsCollector"/> behind them, are created when a session first enables the
+    /// source; until then it costs nothing.
+    /// </para>
+    /// </summary>
+    [EventSource(Name = SourceName)]
+    public sealed class LauncherEventSource : EventSource
+    {
+        public const string SourceName = "ObsidianLauncher-Counters";
+
+        /// <summary>
+        /// The process-wide instance. Touch it at startup so tools can see the source before it is enabled.
+        /// </summary>
+        public static readonly LauncherEventSource Log = new LauncherEventSource();
+
+        private readonly object _countersLock = new object();
+        private List<DiagnosticCounter> _counters;
+
+        private LauncherEventSource()
+        {
+        }
+
+        protected override void OnEventCommand(EventCommandEventArgs command)
+        {
+            if (command.Command != EventCommand.Enable) return;
+            lock (_countersLock)
+            {
+                if (_counters != null) return;
+                MetricsCollector metrics = MetricsCollector.EnsureShared();
+                var second = TimeSpan.FromSeconds(1);
+                _counters = new List<DiagnosticCounter>
+                {
+                    new IncrementingPollingCounter("download-rate", this, () => metrics.GetTotal("launcher.http.bytes"))
+                        { DisplayName = "Download Rate", DisplayUnits = "B", DisplayRateTimeScale = second },
+                    new IncrementingPollingCounter("http-request-rate", this, () => metrics.GetTotal("launcher.http.requests"))
+                        { DisplayName = "HTTP Requests", DisplayRateTimeScale = second },
+                    new PollingCounter("http-ttfb", this, IntervalMean(metrics, "launcher.http.ttfb"))
+                        { DisplayName = "Mean Time To First Byte", DisplayUnits = "ms" },
+                    new PollingCounter("http-duration", this, IntervalMean(metrics, "launcher.http.duration"))
+                        { DisplayName = "Mean Request Duration", DisplayUnits = "ms" },
+                    new IncrementingPollingCounter("http-retries", this, () => metrics.GetTotal("launcher.http.retries"))
+                        { DisplayName = "HTTP Retries", DisplayRateTimeScale = second },
+                    new PollingCounter("cache-hit-ratio", this, () => HitRatio(metrics, "launcher.cache.lookups"))
+                        { DisplayName = "Cache Hit Ratio", DisplayUnits = "%" },
+                    new PollingCounter("journal-hit-ratio", this, () => HitRatio(metrics, "launcher.journal.lookups"))
+                        { DisplayName = "Install Journal Hit Ratio", DisplayUnits = "%" },
+                    new IncrementingPollingCounter("hash-throughput", this, () => metrics.GetTotal("launcher.hash.bytes"))
+                        { DisplayName = "Hash Throughput", DisplayUnits = "B", DisplayRateTimeScale = second },
+                    new IncrementingPollingCounter("extract-throughput", this, () => metrics.GetTotal("launcher.extract.bytes"))
+                        { DisplayName = "Extraction Throughput", DisplayUnits = "B", DisplayRateTimeScale = second },
+                    new PollingCounter("game-sessions", this, () => metrics.GetTotal("launcher.game.sessions"))
+                        { DisplayName = "Game Sessions" }
+                };
+            }
+        }
+
+        private static double HitRatio(MetricsCollector metrics, string instrumentName)
+        {
+            double total = metrics.GetTotal(instrumentName);
+            return total > 0 ? metrics.GetTotal(instrumentName, "result", "hit") / total * 100 : 0;
+        }
+
+        // Mean of a seconds histogram over the values recorded since the previous poll, in milliseconds.
+        private static Func<double> IntervalMean(MetricsCollector metrics, string instrumentName)
+        {
+            double lastSum = 0;
+            long lastCount = 0;
+            return () =>
+            {
+                double sum = metrics.GetTotal(instrumentName);
+                long count = metrics.GetCount(instrumentName);
+                double mean = count > lastCount ? (sum - lastSum) / (count - lastCount) * 1000 : 0;
+                lastSum = sum;
+                lastCount = count;
+                return mean;
+            };
+        }
+    }
+}
@@ -0,0 +1,103 @@
+﻿// Utils/LauncherMetrics.cs
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Diagnostics.Metrics;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// The launcher's <see cref="System.Diagnostics.Metrics.Meter"/> and its instruments. Services record into these
+    /// directly; <see cref="MetricsCollector"/> aggregates them for the Prometheus endpoint (<c>--metrics</c>) and the
+    /// <see cref="LauncherEventSource"/> counters, and <c>dotnet-counters</c> or an OpenTelemetry SDK can read the meter
+    /// by its name as well.
+    /// <para>
+    /// Until something listens, recording into an instrument returns after one field check. Durations use
+    /// <see cref="Stopwatch.GetTimestamp"/>, which does not allocate.
+    /// </para>
+    /// </summary>
+    public static class LauncherMetrics
+    {
+        /// <summary>
+        /// Name of the meter, for listeners.
+        /// </summary>
+        public const string MeterName = "ObsidianLauncher";
+
+        public static readonly Meter Meter = new Meter(MeterName, LauncherConfig.VERSION);
+
+        public static readonly Counter<long> HttpBytes = Meter.CreateCounter<long>(
+            "launcher.http.bytes", "By", "Response body bytes received, by host.");
+
+        public static readonly Counter<long> HttpRequests = Meter.CreateCounter<long>(
+            "launcher.http.requests", "{request}", "HTTP requests, by host and status code (0 if no response arrived).");
+
+        public static readonly Histogram<double> HttpDuration = Meter.CreateHistogram<double>(
+            "launcher.http.duration", "s", "Time from sending a request to the end of its body, by host.");
+
+        public static readonly Histogram<double> HttpTimeToFirstByte = Meter.CreateHistogram<double>(
+            "launcher.http.ttfb", "s", "Time from sending a request to its response headers, by host.");
+
+        public static readonly Counter<long> HttpRetries = Meter.CreateCounter<long>(
+            "launcher.http.retries", "{retry}", "Requests sent again, by host and reason.");
+
+        public static readonly Counter<long> CacheLookups = Meter.CreateCounter<long>(
+            "launcher.cache.lookups", "{lookup}", "Local cache checks before a download, by kind and result (hit or miss).");
+
+        public static readonly Counter<long> JournalLookups = Meter.CreateCounter<long>(
+            "launcher.journal.lookups", "{lookup}", "Install journal checks that let a file skip hashing, by result (hit or miss).");
+
+        public static readonly Counter<long> PeerFetches = Meter.CreateCounter<long>(
+            "launcher.peer.fetches", "{fetch}", "LAN peer cache lookups before an upstream download, by result (hit, miss, unavailable or mismatch).");
+
+        public static readonly Counter<long> PeerBytes = Meter.CreateCounter<long>(
+            "launcher.peer.bytes", "By", "Bytes moved through the LAN peer cache, by direction (received or served).");
+
+        public static readonly Counter<long> HashBytes = Meter.CreateCounter<long>(
+            "launcher.hash.bytes", "By", "Bytes hashed for verification, by operation (file or batch).");
+
+        public static readonly Histogram<double> HashDuration = Meter.CreateHistogram<double>(
+            "launcher.hash.duration", "s", "Wall time of hash operations, by operation (file or batch).");
+
+        public static readonly Counter<long> ExtractBytes = Meter.CreateCounter<long>(
+            "launcher.extract.bytes", "By", "Bytes extracted from archives, by kind (natives or java_runtime).");
+
+        public static readonly Histogram<double> ExtractDuration = Meter.CreateHistogram<double>(
+            "launcher.extract.duration", "s", "Wall time of archive extractions, by kind.");
+
+        public static readonly Histogram<double> PhaseDuration = Meter.CreateHistogram<double>(
+            "launcher.phase.duration", "s", "Duration of launch phases, by phase.");
+
+        public static readonly Counter<long> GameSessions = Meter.CreateCounter<long>(
+            "launcher.game.sessions", "{session}", "Game sessions, by result (exited, crashed, cancelled or failed).");
+
+        public static readonly Histogram<double> GameSessionDuration = Meter.CreateHistogram<double>(
+            "launcher.game.session.duration", "s", "Length of game sessions.");
+
+        /// <summary>
+        /// Seconds elapsed since <paramref name="startTimestamp"/> (a <see cref="Stopwatch.GetTimestamp"/> value).
+        /// </summary>
+        public static double SecondsSince(long startTimestamp)
+        {
+            return Stopwatch.GetElapsedTime(startTimestamp).TotalSeconds;
+        }
+
+        /// <summary>
+        /// Records one archive extraction of <paramref name="bytes"/> uncompressed bytes.
+        /// </summary>
+        public static void RecordExtraction(string kind, long bytes, long startTimestamp)
+        {
+            if (!ExtractBytes.Enabled) return;
+            var tag = Tag("kind", kind);
+            ExtractBytes.Add(bytes, tag);
+            ExtractDuration.Record(SecondsSince(startTimestamp), tag);
+        }
+
+        /// <summary>
+        /// Shorthand for a measurement tag.
+        /// </summary>
+        public static KeyValuePair<string, object> Tag(string key, object value)
+        {
+            return new KeyValuePair<string, object>(key, value);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+﻿// Utils/LauncherTracing.cs
+using System;
+using System.Diagnostics;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// The launcher's <see cref="ActivitySource"/>. Phases of <c>Program.Main</c> (<see cref="PhaseTimer"/>), manager calls, downloads, hashing and
+    /// extraction start spans here; <see cref="ChromeTraceExporter"/> (<c>--trace</c>) records them, and any other
+    /// <see cref="ActivityListener"/> or OpenTelemetry SDK listening to <see cref="SourceName"/> can as well.
+    /// <para>
+    /// With nothing listening, <see cref="ActivitySource.StartActivity(string, ActivityKind)"/> returns null after one
+    /// field check, so call sites use <c>activity?.SetTag(...)</c> and pay nothing else. Tag values that take work to
+    /// compute are guarded with <see cref="IsEnabled"/>.
+    /// </para>
+    /// </summary>
+    public static class LauncherTracing
+    {
+        /// <summary>
+        /// Name of the source, for listeners.
+        /// </summary>
+        public const string SourceName = "ObsidianLauncher";
+
+        /// <summary>
+        /// The source all launcher spans are started from.
+        /// </summary>
+        public static readonly ActivitySource Source = new ActivitySource(SourceName, LauncherConfig.VERSION);
+
+        /// <summary>
+        /// Whether anything is recording spans.
+        /// </summary>
+        public static bool IsEnabled => Source.HasListeners();
+
+        /// <summary>
+        /// Starts a span, or returns null if nothing is listening.
+        /// </summary>
+        public static Activity Start(string name) => Source.StartActivity(name);
+
+        /// <summary>
+        /// Host part of a URL for the <c>url.host</c> tag; null if it is not an absolute URL.
+        /// </summary>
+        public static string GetHost(string url)
+        {
+            return Uri.TryCreate(url, UriKind.Absolute, out Uri uri) ? uri.Host : null;
+        }
+    }
+}
@@ -1,15 +1,58 @@
 ﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Linq;
+using System.Reflection;
+using System.Runtime.CompilerServices;
+using System.Threading;
 using Serilog;
+using Serilog.Core;
 using Serilog.Events;
 using System.IO;
 
 namespace ObsidianLauncher.Utils // Correct namespace based on folder structure
 {
     
+    /// <summary>
+    /// Configures Serilog for the launcher. Sinks are written from background threads: each sink sits behind a
+    /// bounded queue (<see cref="AsyncQueueSize"/> events), and the file sink buffers its writes and flushes them to
+    /// disk once per <see cref="FileFlushInterval"/>, so logging never waits for the disk inside an install.
+    /// When the file queue is full, new events are dropped rather than stalling the caller; the console queue
+    /// applies back-pressure instead, so nothing shown to the user is lost.
+    /// <para>
+    /// Every launcher type gets its own <see cref="LoggingLevelSwitch"/> keyed by its <c>SourceContext</c> (its full
+    /// type name), so levels can be changed per class or per namespace at runtime with <see cref="SetLevel"/>.
+    /// Loggers resolve their switch once in <c>ForContext</c>, so an event below its switch's level is rejected before
+    /// its message or properties are captured. Hot loops additionally guard with <c>IsEnabled</c> where building the
+    /// arguments costs something.
+    /// </para>
+    /// </summary>
     public static class LoggerSetup
     {
         private const String LogTemplate = "{Timestamp:hh:mm:ss.fff tt} [{Level:u3}] [{SourceContext}] {Message:lj}{NewLine}{Exception}";
 
+        /// <summary>
+        /// Events each sink can have queued before the file sink starts dropping and the console sink starts blocking.
+        /// </summary>
+        public const int AsyncQueueSize = 10000;
+
+        /// <summary>
+        /// How often buffered file output is flushed to disk.
+        /// </summary>
+        public static readonly TimeSpan FileFlushInterval = TimeSpan.FromSeconds(1);
+
+        // Level of loggers without a launcher SourceContext (the static Log methods, third-party contexts).
+        private static readonly LoggingLevelSwitch RootSwitch = new LoggingLevelSwitch(LogEventLevel.Verbose);
+        private static readonly ConcurrentDictionary<string, LoggingLevelSwitch> ContextSwitches =
+            new ConcurrentDictionary<string, LoggingLevelSwitch>(StringComparer.Ordinal);
+        private static long _eventsWritten;
+
+        /// <summary>
+        /// Events that passed their level switch since startup, across all sinks. Benchmarks use it to relate logging
+        /// cost to event volume.
+        /// </summary>
+        public static long EventsWritten => Interlocked.Read(ref _eventsWritten);
+
         
         /// <summary>
         /// Initializes the global Serilog logger with console and file sinks.
@@ -27,17 +70,29 @@ namespace ObsidianLauncher.Utils // Correct namespace based on folder structure
 
             try
             {
+                // Nothing below what the most verbose sink wants needs to be captured at all.
+                LogEventLevel pipelineLevel = consoleLevel < fileLevel ? consoleLevel : fileLevel;
+                RootSwitch.MinimumLevel = pipelineLevel;
+
                 var loggerConfiguration = new LoggerConfiguration()
-                    .MinimumLevel.Verbose() // Set the global minimum level; sinks can override with a higher minimum.
+                    .MinimumLevel.ControlledBy(RootSwitch)
                     .Enrich.FromLogContext() // Essential for adding SourceContext or other enrichers
-                    .WriteTo.Console(
-                        restrictedToMinimumLevel: consoleLevel,
-                        outputTemplate: LogTemplate
-                    );
+                    .WriteTo.Sink(new CountingSink())
+                    .WriteTo.Async(sink => sink.Console(
+                            restrictedToMinimumLevel: consoleLevel,
+                            outputTemplate: LogTemplate
+                        ), bufferSize: AsyncQueueSize, blockWhenFull: true);
+
+                foreach (string context in GetLauncherContexts())
+                {
+                    LoggingLevelSwitch levelSwitch = ContextSwitches.GetOrAdd(context, _ => new LoggingLevelSwitch(pipelineLevel));
+                    levelSwitch.MinimumLevel = pipelineLevel;
+                    loggerConfiguration.MinimumLevel.Override(context, levelSwitch);
+                }
 
                 if (!string.IsNullOrEmpty(config.LogsDir)) // Only add file sink if LogsDir is configured
                 {
-                    loggerConfiguration.WriteTo.File(
+                    loggerConfiguration.WriteTo.Async(sink => sink.File(
                         logFilePath,
                         restrictedToMinimumLevel: fileLevel,
                         rollingInterval: RollingInterval.Day,     // New log file daily
@@ -45,8 +100,10 @@ namespace ObsidianLauncher.Utils // Correct namespace based on folder structure
                         fileSizeLimitBytes: 10 * 1024 * 1024,      // 10 MB limit per file
                         retainedFileCountLimit: 7,                 // Keep the last 7 log files
                         outputTemplate: LogTemplate,
+                        buffered: true,                            // Flushed by the interval below and on shutdown
+                        flushToDiskInterval: FileFlushInterval,
                         shared: false                              // false = exclusive lock, true = shared (can be slower)
-                    );
+                    ), bufferSize: AsyncQueueSize, blockWhenFull: false);
                 }
                 else
                 {
@@ -76,31 +133,92 @@ namespace ObsidianLauncher.Utils // Correct namespace based on folder structure
         }
 
         /// <summary>
-        /// Sets the logging level for a specific logger context.
-        /// Note: Serilog's dynamic level control is more complex than spdlog's simple SetLevel.
-        /// This is a simplified approach. For true dynamic control, you'd use Serilog.Settings.Configuration
-        /// or a LoggingLevelSwitch. This example won't dynamically change levels of already created loggers
-        /// without reconfiguring the global Log.Logger or using LoggingLevelSwitch.
-        ///
-        /// For this project, it's often sufficient to set the desired level when creating the logger:
-        /// Log.ForContext&lt;MyClass&gt;().IsEnabled(LogEventLevel.Verbose)
-        /// Or filter at the sink level.
+        /// Sets the minimum level of a logging context at runtime. Takes effect immediately, also for loggers that
+        /// were already created. The sinks' own minimum levels still apply on top (the console shows Information and
+        /// above unless it was initialized otherwise).
         /// </summary>
-        /// <param name="loggerName">This parameter is not directly used in simple Serilog setup without level switches.</param>
+        /// <param name="loggerName">
+        /// A full type name (<c>ObsidianLauncher.Services.AssetManager</c>), a namespace that applies to every type in it
+        /// (<c>ObsidianLauncher.Services</c>), a bare type name (<c>AssetManager</c>), or <c>*</c> for everything,
+        /// including loggers without a context.
+        /// </param>
         /// <param name="level">The desired minimum level.</param>
+        /// <returns>The number of contexts changed; 0 if the name matched none.</returns>
+        public static int SetLevel(string loggerName, LogEventLevel level)
+        {
+            if (string.IsNullOrEmpty(loggerName)) throw new ArgumentException("A context name or * is required.", nameof(loggerName));
+
+            int changed = 0;
+            bool all = loggerName == "*";
+            if (all)
+            {
+                RootSwitch.MinimumLevel = level;
+                changed++;
+            }
+            foreach (var entry in ContextSwitches)
+            {
+                if (all || MatchesContext(entry.Key, loggerName))
+                {
+                    entry.Value.MinimumLevel = level;
+                    changed++;
+                }
+            }
+
+            if (changed == 0)
+            {
+                Log.Warning("No logging context matches '{LoggerName}'; expected a launcher type or namespace, or *.", loggerName);
+            }
+            else
+            {
+                Log.Information("Log level of '{LoggerName}' set to {Level} ({Count} context(s)).", loggerName, level, changed);
+            }
+            return changed;
+        }
+
+        /// <summary>
+        /// Current minimum level of a context (full type name), or of the root for <c>*</c> and unknown names.
+        /// </summary>
+        public static LogEventLevel GetLevel(string loggerName)
+        {
+            return loggerName != null && ContextSwitches.TryGetValue(loggerName, out var levelSwitch)
+                ? levelSwitch.MinimumLevel
+                : RootSwitch.MinimumLevel;
+        }
+
+        private static bool MatchesContext(string context, string name)
+        {
+            if (context.Equals(name, StringComparison.Ordinal)) return true;
+            if (context.Length > name.Length && context.StartsWith(name, StringComparison.Ordinal) && context[name.Length] == '.') return true;
+            return name.IndexOf('.') < 0 && context.EndsWith("." + name, StringComparison.Ordinal);
+        }
 
-        public static void SetLevel(string loggerName, LogEventLevel level)
+        /// <summary>
+        /// SourceContext names of the launcher's own types (what <c>Log.ForContext&lt;T&gt;()</c> produces for them).
+        /// </summary>
+        private static IEnumerable<string> GetLauncherContexts()
+        {
+            Type[] types;
+            try
+            {
+                types = typeof(LoggerSetup).Assembly.GetTypes();
+            }
+            catch (ReflectionTypeLoadException ex)
+            {
+                types = ex.Types.Where(t => t != null).ToArray();
+            }
+            return types
+                .Where(t => t.Namespace != null && t.Namespace.StartsWith("ObsidianLauncher", StringComparison.Ordinal) &&
+                            !t.IsNested && !t.IsDefined(typeof(CompilerGeneratedAttribute), false))
+                .Select(t => t.FullName)
+                .Distinct(StringComparer.Ordinal);
+        }
+
+        /// <summary>
+        /// Counts events that made it past their level switch.
+        /// </summary>
+        private sealed class CountingSink : ILogEventSink
         {
-            // Serilog doesn't have a direct equivalent to spdlog's per-logger SetLevel
-            // after the main logger is configured, unless using LoggingLevelSwitch.
-            // Typically, you filter at the sink level or when creating a contextual logger.
-            // This function is more of a placeholder or would require a more advanced Serilog setup.
-            Log.Warning("Serilog's SetLevel for a specific context ('{LoggerName}') after initialization is not directly supported in this basic setup. Minimum levels are generally controlled globally or at the sink level. Consider using LoggingLevelSwitch for dynamic control.", loggerName);
-
-            // If you wanted to change the *global* minimum level:
-            // This is generally not what you want for a specific logger.
-            // LoggerConfiguration newConfig = ... recreate with new MinimumLevel(level) ...
-            // Log.Logger = newConfig.CreateLogger();
+            public void Emit(LogEvent logEvent) => Interlocked.Increment(ref _eventsWritten);
         }
     }
 }
\ No newline at end of file
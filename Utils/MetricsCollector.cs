@@ -0,0 +1,270 @@
+﻿// Utils/MetricsCollector.cs
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Diagnostics.Metrics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Aggregates the <see cref="LauncherMetrics"/> instruments in process: counters are summed and histograms
+    /// bucketed per tag combination, for the Prometheus endpoint and the <see cref="LauncherEventSource"/> counters.
+    /// <para>
+    /// Nothing listens to the meter until <see cref="EnsureShared"/> is first called (by <c>--metrics</c> or when a
+    /// <c>dotnet-counters</c> session enables the event source), so the instruments stay free until then.
+    /// </para>
+    /// </summary>
+    public sealed class MetricsCollector : IDisposable
+    {
+        // Seconds: wide enough for both a TTFB and a game session.
+        private static readonly double[] BucketBounds =
+        {
+            0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 300, 900, 3600, 14400
+        };
+
+        private static readonly object SharedLock = new object();
+        private static MetricsCollector _shared;
+
+        private readonly MeterListener _listener;
+        private readonly ConcurrentDictionary<string, InstrumentState> _instruments = new ConcurrentDictionary<string, InstrumentState>(StringComparer.Ordinal);
+
+        private MetricsCollector()
+        {
+            _listener = new MeterListener
+            {
+                InstrumentPublished = (instrument, listener) =>
+                {
+                    if (instrument.Meter.Name != LauncherMetrics.MeterName) return;
+                    InstrumentState state = _instruments.GetOrAdd(instrument.Name, _ => new InstrumentState(instrument));
+                    listener.EnableMeasurementEvents(instrument, state);
+                }
+            };
+            _listener.SetMeasurementEventCallback<long>((instrument, value, tags, state) => ((InstrumentState)state).Record(value, tags));
+            _listener.SetMeasurementEventCallback<double>((instrument, value, tags, state) => ((InstrumentState)state).Record(value, tags));
+            _listener.Start();
+        }
+
+        /// <summary>
+        /// The process-wide collector, created and attached to the meter on first use.
+        /// </summary>
+        public static MetricsCollector EnsureShared()
+        {
+            lock (SharedLock)
+            {
+                return _shared ??= new MetricsCollector();
+            }
+        }
+
+        /// <summary>
+        /// Sum of a counter (or of a histogram's values) over all series, or only those where
+        /// <paramref name="tagKey"/> equals <paramref name="tagValue"/>.
+        /// </summary>
+        public double GetTotal(string instrumentName, string tagKey = null, string tagValue = null)
+        {
+            if (!_instruments.TryGetValue(instrumentName, out InstrumentState state)) return 0;
+            double total = 0;
+            foreach (Series series in state.Series.Values)
+            {
+                if (tagKey != null && !series.HasTag(tagKey, tagValue)) continue;
+                lock (series) total += series.Sum;
+            }
+            return total;
+        }
+
+        /// <summary>
+        /// Sums of a counter (or of a histogram's values) grouped by the value of <paramref name="tagKey"/>.
+        /// </summary>
+        public Dictionary<string, double> GetTotalsByTag(string instrumentName, string tagKey)
+        {
+            var totals = new Dictionary<string, double>(StringComparer.Ordinal);
+            if (!_instruments.TryGetValue(instrumentName, out InstrumentState state)) return totals;
+            foreach (Series series in state.Series.Values)
+            {
+                string value = series.GetTag(tagKey) ?? string.Empty;
+                double sum;
+                lock (series) sum = series.Sum;
+                totals[value] = totals.TryGetValue(value, out double existing) ? existing + sum : sum;
+            }
+            return totals;
+        }
+
+        /// <summary>
+        /// Number of values recorded into a histogram over all series.
+        /// </summary>
+        public long GetCount(string instrumentName)
+        {
+            if (!_instruments.TryGetValue(instrumentName, out InstrumentState state)) return 0;
+            long count = 0;
+            foreach (Series series in state.Series.Values)
+            {
+                lock (series) count += series.Count;
+            }
+            return count;
+        }
+
+        /// <summary>
+        /// Writes every instrument in the Prometheus text exposition format (version 0.0.4).
+        /// </summary>
+        public void WritePrometheus(TextWriter writer)
+        {
+            foreach (InstrumentState state in _instruments.Values.OrderBy(s => s.Name, StringComparer.Ordinal))
+            {
+                writer.Write("# HELP ");
+                writer.Write(state.Name);
+                writer.Write(' ');
+                writer.Write(state.Description);
+                writer.Write('\n');
+                writer.Write("# TYPE ");
+                writer.Write(state.Name);
+                writer.Write(state.IsHistogram ? " histogram\n" : " counter\n");
+
+                foreach (Series series in state.Series.Values.OrderBy(s => s.Labels, StringComparer.Ordinal))
+                {
+                    lock (series)
+                    {
+                        if (!state.IsHistogram)
+                        {
+                            WriteSample(writer, state.Name, series.Labels, null, series.Sum);
+                            continue;
+                        }
+                        long cumulative = 0;
+                        for (int i = 0; i < BucketBounds.Length; i++)
+                        {
+                            cumulative += series.Buckets[i];
+                            WriteSample(writer, state.Name + "_bucket", series.Labels, BucketBounds[i].ToString(CultureInfo.InvariantCulture), cumulative);
+                        }
+                        WriteSample(writer, state.Name + "_bucket", series.Labels, "+Inf", series.Count);
+                        WriteSample(writer, state.Name + "_sum", series.Labels, null, series.Sum);
+                        WriteSample(writer, state.Name + "_count", series.Labels, null, series.Count);
+                    }
+                }
+            }
+        }
+
+        private static void WriteSample(TextWriter writer, string name, string labels, string le, double value)
+        {
+            writer.Write(name);
+            if (labels.Length > 0 || le != null)
+            {
+                writer.Write('{');
+                writer.Write(labels);
+                if (le != null)
+                {
+                    if (labels.Length > 0) writer.Write(',');
+                    writer.Write("le=\"");
+                    writer.Write(le);
+                    writer.Write('"');
+                }
+                writer.Write('}');
+            }
+            writer.Write(' ');
+            writer.Write(value.ToString(CultureInfo.InvariantCulture));
+            writer.Write('\n');
+        }
+
+        public void Dispose()
+        {
+            _listener.Dispose();
+        }
+
+        private sealed class InstrumentState
+        {
+            public InstrumentState(Instrument instrument)
+            {
+                IsHistogram = instrument.GetType().IsGenericType && instrument.GetType().GetGenericTypeDefinition() == typeof(Histogram<>);
+                Name = ToPrometheusName(instrument.Name, instrument.Unit, !IsHistogram);
+                Description = (instrument.Description ?? string.Empty).Replace("\\", "\\\\").Replace("\n", "\\n");
+            }
+
+            public string Name { get; }
+            public string Description { get; }
+            public bool IsHistogram { get; }
+            public ConcurrentDictionary<string, Series> Series { get; } = new ConcurrentDictionary<string, Series>(StringComparer.Ordinal);
+
+            public void Record(double value, ReadOnlySpan<KeyValuePair<string, object>> tags)
+            {
+                string key = BuildKey(tags);
+                if (!Series.TryGetValue(key, out Series series))
+                {
+                    series = Series.GetOrAdd(key, new Series(tags, IsHistogram ? BucketBounds.Length : 0));
+                }
+                lock (series)
+                {
+                    series.Sum += value;
+                    series.Count++;
+                    if (series.Buckets == null) return;
+                    int bucket = 0;
+                    while (bucket < BucketBounds.Length && value > BucketBounds[bucket]) bucket++;
+                    if (bucket < BucketBounds.Length) series.Buckets[bucket]++;
+                }
+            }
+
+            private static string BuildKey(ReadOnlySpan<KeyValuePair<string, object>> tags)
+            {
+                if (tags.Length == 0) return string.Empty;
+                if (tags.Length == 1) return tags[0].Key + "=" + tags[0].Value;
+                var builder = new StringBuilder();
+                foreach (var tag in tags)
+                {
+                    builder.Append(tag.Key).Append('=').Append(tag.Value).Append('\u0001');
+                }
+                return builder.ToString();
+            }
+
+            // launcher.http.duration (s) -> launcher_http_duration_seconds; counters end in _total.
+            private static string ToPrometheusName(string name, string unit, bool counter)
+            {
+                string result = name.Replace('.', '_');
+                if (unit == "s" && !result.EndsWith("_seconds", StringComparison.Ordinal)) result += "_seconds";
+                if (unit == "By" && !result.EndsWith("_bytes", StringComparison.Ordinal)) result += "_bytes";
+                return counter ? result + "_total" : result;
+            }
+        }
+
+        private sealed class Series
+        {
+            private readonly KeyValuePair<string, string>[] _tags;
+
+            public Series(ReadOnlySpan<KeyValuePair<string, object>> tags, int buckets)
+            {
+                _tags = new KeyValuePair<string, string>[tags.Length];
+                for (int i = 0; i < tags.Length; i++)
+                {
+                    _tags[i] = new KeyValuePair<string, string>(tags[i].Key, Convert.ToString(tags[i].Value, CultureInfo.InvariantCulture) ?? string.Empty);
+                }
+                Labels = string.Join(",", _tags.OrderBy(t => t.Key, StringComparer.Ordinal)
+                    .Select(t => $"{t.Key.Replace('.', '_')}=\"{EscapeLabel(t.Value)}\""));
+                Buckets = buckets > 0 ? new long[buckets] : null;
+            }
+
+            public string Labels { get; }
+            public long[] Buckets { get; }
+            public double Sum { get; set; }
+            public long Count { get; set; }
+
+            public bool HasTag(string key, string value)
+            {
+                return GetTag(key) == value;
+            }
+
+            public string GetTag(string key)
+            {
+                foreach (var tag in _tags)
+                {
+                    if (tag.Key == key) return tag.Value;
+                }
+                return null;
+            }
+
+            private static string EscapeLabel(string value)
+            {
+                return value.Replace("\\", "\\\\").Replace("\"", "\\\"").Replace("\n", "\\n");
+            }
+        }
+    }
+}
@@ -0,0 +1,363 @@
+﻿// Utils/MultiBufferSha1.cs
+using System;
+using System.Buffers.Binary;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using System.Runtime.CompilerServices;
+using System.Runtime.Intrinsics;
+using System.Runtime.Intrinsics.X86;
+using System.Security.Cryptography;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Multi-buffer SHA-1: hashes up to eight independent messages at once, one per 32-bit lane of a
+    /// <see cref="Vector256{T}"/> (AVX2). Asset objects are mostly a few KB, so hashing them one call at a time is
+    /// dominated by per-call setup rather than by the compression function; running eight of them through the
+    /// compression rounds together amortizes that and keeps the vector units busy.
+    /// <para>
+    /// Messages are sorted by length and grouped eight at a time, so lanes in a group need about the same number of
+    /// blocks; a lane that runs out of blocks is masked and keeps its state. Without AVX2, or if the vector kernel ever
+    /// disagrees with the platform implementation in the one-time self-test, every message goes through
+    /// <see cref="SHA1.HashData(ReadOnlySpan{byte}, Span{byte})"/> instead.
+    /// </para>
+    /// <para>
+    /// CPUs with the SHA extensions (SHA-NI) hash a single stream in hardware about as fast as this kernel hashes
+    /// eight, so after the self-test the kernel is also timed against the platform implementation on typical asset
+    /// sizes; <see cref="IsPreferred"/> tells callers whether it actually pays off on this machine.
+    /// </para>
+    /// SHA-1 is used here only for integrity checks against Mojang's published hashes, not for security.
+    /// </summary>
+    public static class MultiBufferSha1
+    {
+        /// <summary>
+        /// Messages hashed per vector pass.
+        /// </summary>
+        public const int Lanes = 8;
+
+        /// <summary>
+        /// Size of a SHA-1 hash in bytes.
+        /// </summary>
+        public const int HashSize = 20;
+
+        private const int BlockSize = 64;
+
+        private static readonly Vector256<uint> K0 = Vector256.Create(0x5A827999u);
+        private static readonly Vector256<uint> K1 = Vector256.Create(0x6ED9EBA1u);
+        private static readonly Vector256<uint> K2 = Vector256.Create(0x8F1BBCDCu);
+        private static readonly Vector256<uint> K3 = Vector256.Create(0xCA62C1D6u);
+
+        // Reverses the bytes of every 32-bit word (pshufb works within each 128-bit half).
+        private static readonly Vector256<byte> ByteSwapMask = Vector256.Create(
+            (byte)3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+        private static readonly ILogger _logger = Log.ForContext(typeof(MultiBufferSha1));
+        private static readonly Lazy<bool> _selfTestPassed = new Lazy<bool>(RunSelfTest);
+        private static readonly Lazy<bool> _fasterThanPlatform = new Lazy<bool>(RunCalibration);
+
+        /// <summary>
+        /// Whether the CPU supports the vector kernel.
+        /// </summary>
+        public static bool IsHardwareAccelerated => Avx2.IsSupported && Vector256.IsHardwareAccelerated;
+
+        /// <summary>
+        /// Whether <see cref="HashMany"/> uses the vector kernel: the CPU supports it and it passed the cross-check
+        /// against the platform implementation (run once, on first use).
+        /// </summary>
+        public static bool IsEnabled => IsHardwareAccelerated && _selfTestPassed.Value;
+
+        /// <summary>
+        /// Whether the vector kernel is enabled and measured faster than the platform implementation for small
+        /// messages on this machine (measured once, on first use).
+        /// </summary>
+        public static bool IsPreferred => IsEnabled && _fasterThanPlatform.Value;
+
+        /// <summary>
+        /// Computes the SHA-1 of every message.
+        /// </summary>
+        /// <param name="messages">Messages to hash; any number.</param>
+        /// <param name="destination">Receives <c>messages.Count * HashSize</c> bytes, the hash of message i at offset <c>i * HashSize</c>.</param>
+        public static void HashMany(IReadOnlyList<ReadOnlyMemory<byte>> messages, Span<byte> destination)
+        {
+            if (messages == null) throw new ArgumentNullException(nameof(messages));
+            if (destination.Length < messages.Count * HashSize) throw new ArgumentException("Destination is too small for the hashes.", nameof(destination));
+
+            if (!IsEnabled)
+            {
+                for (int i = 0; i < messages.Count; i++)
+                {
+                    SHA1.HashData(messages[i].Span, destination.Slice(i * HashSize, HashSize));
+                }
+                return;
+            }
+            HashManyVectorized(messages, destination);
+        }
+
+        private static void HashManyVectorized(IReadOnlyList<ReadOnlyMemory<byte>> messages, Span<byte> destination)
+        {
+            int[] order = Enumerable.Range(0, messages.Count).ToArray();
+            Array.Sort(order, (a, b) => messages[a].Length.CompareTo(messages[b].Length));
+
+            for (int start = 0; start < order.Length; start += Lanes)
+            {
+                int count = Math.Min(Lanes, order.Length - start);
+                if (count == 1)
+                {
+                    // A lone message would leave seven lanes idle; the scalar path is cheaper.
+                    SHA1.HashData(messages[order[start]].Span, destination.Slice(order[start] * HashSize, HashSize));
+                    continue;
+                }
+                HashGroup(messages, order.AsSpan(start, count), destination);
+            }
+        }
+
+        // Optimized straight away: the first calls (self-test, calibration) must not run unoptimized tier-0 vector code.
+        [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+        private static void HashGroup(IReadOnlyList<ReadOnlyMemory<byte>> messages, ReadOnlySpan<int> group, Span<byte> destination)
+        {
+            // Each lane's message is its whole blocks followed by one or two tail blocks holding the remainder,
+            // the 0x80 terminator and the bit length.
+            Span<int> fullBlocks = stackalloc int[Lanes];
+            Span<int> totalBlocks = stackalloc int[Lanes];
+            Span<byte> tails = stackalloc byte[Lanes * 2 * BlockSize];
+            tails.Clear();
+            int maxBlocks = 0;
+            for (int lane = 0; lane < group.Length; lane++)
+            {
+                ReadOnlySpan<byte> message = messages[group[lane]].Span;
+                int remainder = message.Length % BlockSize;
+                fullBlocks[lane] = message.Length / BlockSize;
+                Span<byte> tail = tails.Slice(lane * 2 * BlockSize, 2 * BlockSize);
+                message.Slice(message.Length - remainder).CopyTo(tail);
+                tail[remainder] = 0x80;
+                int tailBlocks = remainder + 9 <= BlockSize ? 1 : 2;
+                BinaryPrimitives.WriteUInt64BigEndian(tail.Slice(tailBlocks * BlockSize - 8), (ulong)message.Length * 8);
+                totalBlocks[lane] = fullBlocks[lane] + tailBlocks;
+                maxBlocks = Math.Max(maxBlocks, totalBlocks[lane]);
+            }
+
+            Vector256<uint> h0 = Vector256.Create(0x67452301u);
+            Vector256<uint> h1 = Vector256.Create(0xEFCDAB89u);
+            Vector256<uint> h2 = Vector256.Create(0x98BADCFEu);
+            Vector256<uint> h3 = Vector256.Create(0x10325476u);
+            Vector256<uint> h4 = Vector256.Create(0xC3D2E1F0u);
+
+            Span<uint> activeLanes = stackalloc uint[Lanes];
+            Span<Vector256<uint>> low = stackalloc Vector256<uint>[Lanes];
+            Span<Vector256<uint>> high = stackalloc Vector256<uint>[Lanes];
+            Span<Vector256<uint>> w = stackalloc Vector256<uint>[16];
+
+            for (int block = 0; block < maxBlocks; block++)
+            {
+                // Load each lane's block as big-endian words (lane = row), then transpose so that vector t holds word t
+                // of every lane.
+                for (int lane = 0; lane < Lanes; lane++)
+                {
+                    bool active = lane < group.Length && block < totalBlocks[lane];
+                    activeLanes[lane] = active ? uint.MaxValue : 0;
+                    if (!active)
+                    {
+                        low[lane] = Vector256<uint>.Zero;
+                        high[lane] = Vector256<uint>.Zero;
+                        continue;
+                    }
+                    ReadOnlySpan<byte> source = block < fullBlocks[lane]
+                        ? messages[group[lane]].Span.Slice(block * BlockSize, BlockSize)
+                        : tails.Slice(lane * 2 * BlockSize + (block - fullBlocks[lane]) * BlockSize, BlockSize);
+                    low[lane] = Avx2.Shuffle(Vector256.Create(source.Slice(0, 32)), ByteSwapMask).AsUInt32();
+                    high[lane] = Avx2.Shuffle(Vector256.Create(source.Slice(32, 32)), ByteSwapMask).AsUInt32();
+                }
+                Transpose(low, w.Slice(0, 8));
+                Transpose(high, w.Slice(8, 8));
+
+                Vector256<uint> a = h0, b = h1, c = h2, d = h3, e = h4;
+                for (int i = 0; i < 80; i++)
+                {
+                    Vector256<uint> wi = Schedule(w, i);
+
+                    Vector256<uint> f, k;
+                    if (i < 20)
+                    {
+                        f = Vector256.ConditionalSelect(b, c, d); // Ch: (b & c) | (~b & d)
+                        k = K0;
+                    }
+                    else if (i < 40)
+                    {
+                        f = b ^ c ^ d;
+                        k = K1;
+                    }
+                    else if (i < 60)
+                    {
+                        f = (b & c) | (d & (b | c)); // Majority
+                        k = K2;
+                    }
+                    else
+                    {
+                        f = b ^ c ^ d;
+                        k = K3;
+                    }
+
+                    Vector256<uint> temp = RotateLeft(a, 5) + f + e + k + wi;
+                    e = d;
+                    d = c;
+                    c = RotateLeft(b, 30);
+                    b = a;
+                    a = temp;
+                }
+
+                // Lanes whose message has no block at this index keep their state.
+                Vector256<uint> mask = Vector256.Create<uint>(activeLanes);
+                h0 = Vector256.ConditionalSelect(mask, h0 + a, h0);
+                h1 = Vector256.ConditionalSelect(mask, h1 + b, h1);
+                h2 = Vector256.ConditionalSelect(mask, h2 + c, h2);
+                h3 = Vector256.ConditionalSelect(mask, h3 + d, h3);
+                h4 = Vector256.ConditionalSelect(mask, h4 + e, h4);
+            }
+
+            for (int lane = 0; lane < group.Length; lane++)
+            {
+                Span<byte> hash = destination.Slice(group[lane] * HashSize, HashSize);
+                BinaryPrimitives.WriteUInt32BigEndian(hash, h0.GetElement(lane));
+                BinaryPrimitives.WriteUInt32BigEndian(hash.Slice(4), h1.GetElement(lane));
+                BinaryPrimitives.WriteUInt32BigEndian(hash.Slice(8), h2.GetElement(lane));
+                BinaryPrimitives.WriteUInt32BigEndian(hash.Slice(12), h3.GetElement(lane));
+                BinaryPrimitives.WriteUInt32BigEndian(hash.Slice(16), h4.GetElement(lane));
+            }
+        }
+
+        /// <summary>
+        /// Returns the message word for round <paramref name="i"/>, expanding the schedule in place (16-word ring).
+        /// </summary>
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        private static Vector256<uint> Schedule(Span<Vector256<uint>> w, int i)
+        {
+            if (i < 16) return w[i];
+            Vector256<uint> word = RotateLeft(w[(i - 3) & 15] ^ w[(i - 8) & 15] ^ w[(i - 14) & 15] ^ w[i & 15], 1);
+            w[i & 15] = word;
+            return word;
+        }
+
+        /// <summary>
+        /// Transposes an 8x8 matrix of 32-bit words held as eight row vectors.
+        /// </summary>
+        private static void Transpose(ReadOnlySpan<Vector256<uint>> rows, Span<Vector256<uint>> columns)
+        {
+            Vector256<uint> t0 = Avx2.UnpackLow(rows[0], rows[1]);
+            Vector256<uint> t1 = Avx2.UnpackHigh(rows[0], rows[1]);
+            Vector256<uint> t2 = Avx2.UnpackLow(rows[2], rows[3]);
+            Vector256<uint> t3 = Avx2.UnpackHigh(rows[2], rows[3]);
+            Vector256<uint> t4 = Avx2.UnpackLow(rows[4], rows[5]);
+            Vector256<uint> t5 = Avx2.UnpackHigh(rows[4], rows[5]);
+            Vector256<uint> t6 = Avx2.UnpackLow(rows[6], rows[7]);
+            Vector256<uint> t7 = Avx2.UnpackHigh(rows[6], rows[7]);
+
+            Vector256<uint> u0 = Avx2.UnpackLow(t0.AsUInt64(), t2.AsUInt64()).AsUInt32();
+            Vector256<uint> u1 = Avx2.UnpackHigh(t0.AsUInt64(), t2.AsUInt64()).AsUInt32();
+            Vector256<uint> u2 = Avx2.UnpackLow(t1.AsUInt64(), t3.AsUInt64()).AsUInt32();
+            Vector256<uint> u3 = Avx2.UnpackHigh(t1.AsUInt64(), t3.AsUInt64()).AsUInt32();
+            Vector256<uint> u4 = Avx2.UnpackLow(t4.AsUInt64(), t6.AsUInt64()).AsUInt32();
+            Vector256<uint> u5 = Avx2.UnpackHigh(t4.AsUInt64(), t6.AsUInt64()).AsUInt32();
+            Vector256<uint> u6 = Avx2.UnpackLow(t5.AsUInt64(), t7.AsUInt64()).AsUInt32();
+            Vector256<uint> u7 = Avx2.UnpackHigh(t5.AsUInt64(), t7.AsUInt64()).AsUInt32();
+
+            columns[0] = Avx2.Permute2x128(u0, u4, 0x20);
+            columns[1] = Avx2.Permute2x128(u1, u5, 0x20);
+            columns[2] = Avx2.Permute2x128(u2, u6, 0x20);
+            columns[3] = Avx2.Permute2x128(u3, u7, 0x20);
+            columns[4] = Avx2.Permute2x128(u0, u4, 0x31);
+            columns[5] = Avx2.Permute2x128(u1, u5, 0x31);
+            columns[6] = Avx2.Permute2x128(u2, u6, 0x31);
+            columns[7] = Avx2.Permute2x128(u3, u7, 0x31);
+        }
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        private static Vector256<uint> RotateLeft(Vector256<uint> value, int count)
+        {
+            return (value << count) | (value >> (32 - count));
+        }
+
+        /// <summary>
+        /// Cross-checks the vector kernel against the platform SHA-1 on messages around every padding boundary, of
+        /// mixed lengths in one group, and of typical asset sizes.
+        /// </summary>
+        private static bool RunSelfTest()
+        {
+            try
+            {
+                var random = new Random(20240601);
+                var messages = new List<ReadOnlyMemory<byte>>();
+                for (int length = 0; length <= 3 * BlockSize + 1; length++) messages.Add(RandomBytes(random, length));
+                foreach (int length in new[] { 1000, 4096, 4097, 16 * 1024, 65 * 1024 }) messages.Add(RandomBytes(random, length));
+
+                var actual = new byte[messages.Count * HashSize];
+                HashManyVectorized(messages, actual);
+                var expected = new byte[HashSize];
+                for (int i = 0; i < messages.Count; i++)
+                {
+                    SHA1.HashData(messages[i].Span, expected);
+                    if (!expected.AsSpan().SequenceEqual(actual.AsSpan(i * HashSize, HashSize)))
+                    {
+                        _logger.Warning("Multi-buffer SHA-1 disagrees with the platform implementation for a {Length}-byte message; using the platform implementation.",
+                            messages[i].Length);
+                        return false;
+                    }
+                }
+                _logger.Verbose("Multi-buffer SHA-1 self-test passed ({Count} messages, {Lanes} lanes).", messages.Count, Lanes);
+                return true;
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Multi-buffer SHA-1 self-test failed; using the platform implementation.");
+                return false;
+            }
+        }
+
+        /// <summary>
+        /// Times the vector kernel against one-shot platform hashing on a batch of asset-sized messages (best of
+        /// several rounds each, so a stray context switch doesn't decide it).
+        /// </summary>
+        private static bool RunCalibration()
+        {
+            try
+            {
+                var random = new Random(7);
+                var messages = new List<ReadOnlyMemory<byte>>();
+                for (int i = 0; i < 256; i++) messages.Add(RandomBytes(random, random.Next(512, 8 * 1024)));
+                var hashes = new byte[messages.Count * HashSize];
+
+                double vectorTicks = double.MaxValue, platformTicks = double.MaxValue;
+                for (int round = 0; round < 5; round++)
+                {
+                    long start = Stopwatch.GetTimestamp();
+                    HashManyVectorized(messages, hashes);
+                    vectorTicks = Math.Min(vectorTicks, Stopwatch.GetTimestamp() - start);
+
+                    start = Stopwatch.GetTimestamp();
+                    for (int i = 0; i < messages.Count; i++) SHA1.HashData(messages[i].Span, hashes.AsSpan(i * HashSize, HashSize));
+                    platformTicks = Math.Min(platformTicks, Stopwatch.GetTimestamp() - start);
+                }
+
+                bool faster = vectorTicks < platformTicks;
+                _logger.Verbose("Multi-buffer SHA-1 calibration: vector {VectorMs:F2} ms, platform {PlatformMs:F2} ms; {Choice}.",
+                    vectorTicks * 1000.0 / Stopwatch.Frequency, platformTicks * 1000.0 / Stopwatch.Frequency,
+                    faster ? "using multi-buffer for small files" : "using the platform implementation");
+                return faster;
+            }
+            catch (Exception ex)
+            {
+                _logger.Warning(ex, "Multi-buffer SHA-1 calibration failed; using the platform implementation.");
+                return false;
+            }
+        }
+
+        private static byte[] RandomBytes(Random random, int length)
+        {
+            var bytes = new byte[length];
+            random.NextBytes(bytes);
+            return bytes;
+        }
+    }
+}
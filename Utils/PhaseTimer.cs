@@ -0,0 +1,47 @@
+﻿// Utils/PhaseTimer.cs
+using System;
+using System.Diagnostics;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Tracks the current phase of a sequential flow such as <c>Program.Main</c>. Each <see cref="Next"/> ends the
+    /// previous phase: its <c>phase.*</c> span is stopped and its duration recorded in
+    /// <see cref="LauncherMetrics.PhaseDuration"/>. A flow with many early returns keeps one instance and calls
+    /// <see cref="Stop"/> in a <c>finally</c>.
+    /// </summary>
+    public sealed class PhaseTimer
+    {
+        private Activity _activity;
+        private string _phase;
+        private long _started;
+
+        /// <summary>
+        /// The phase in progress, or null.
+        /// </summary>
+        public string Current => _phase;
+
+        /// <summary>
+        /// Ends the current phase (if any) and starts <paramref name="phase"/>.
+        /// </summary>
+        public void Next(string phase)
+        {
+            Stop();
+            _phase = phase ?? throw new ArgumentNullException(nameof(phase));
+            _started = Stopwatch.GetTimestamp();
+            _activity = LauncherTracing.Start("phase." + phase);
+        }
+
+        /// <summary>
+        /// Ends the current phase, if any.
+        /// </summary>
+        public void Stop()
+        {
+            if (_phase == null) return;
+            _activity?.Stop();
+            LauncherMetrics.PhaseDuration.Record(LauncherMetrics.SecondsSince(_started), LauncherMetrics.Tag("phase", _phase));
+            _activity = null;
+            _phase = null;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+﻿// Utils/StorageInfo.cs
+using System;
+using System.IO;
+using System.Text;
+using Serilog;
+
+namespace ObsidianLauncher.Utils
+{
+    /// <summary>
+    /// Best-effort facts about the device a path lives on, used to tune I/O parallelism.
+    /// </summary>
+    public static class StorageInfo
+    {
+        private static readonly ILogger _logger = Log.ForContext(typeof(StorageInfo));
+
+        /// <summary>
+        /// Whether <paramref name="path"/> is on a rotational disk (HDD), where parallel random reads make the heads
+        /// seek back and forth and are slower than reading in order. Only Linux reports this
+        /// (<c>/sys/dev/block/&lt;dev&gt;/queue/rotational</c>); elsewhere, and for virtual devices, false is returned.
+        /// </summary>
+        public static bool IsRotational(string path)
+        {
+            if (!OperatingSystem.IsLinux()) return false;
+            try
+            {
+                string device = FindMountDevice(Path.GetFullPath(path));
+                if (device == null) return false;
+
+                // Partitions have no queue directory of their own; their parent disk does.
+                foreach (string candidate in new[] { $"/sys/dev/block/{device}/queue/rotational", $"/sys/dev/block/{device}/../queue/rotational" })
+                {
+                    if (File.Exists(candidate)) return File.ReadAllText(candidate).Trim() == "1";
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                _logger.Verbose(ex, "Could not determine the storage type of {Path}", path);
+            }
+            return false;
+        }
+
+        /// <summary>
+        /// Returns the <c>major:minor</c> device of the mount containing <paramref name="fullPath"/>, from
+        /// <c>/proc/self/mountinfo</c> (longest matching mount point wins).
+        /// </summary>
+        private static string FindMountDevice(string fullPath)
+        {
+            const string MountInfoPath = "/proc/self/mountinfo";
+            if (!File.Exists(MountInfoPath)) return null;
+
+            string bestDevice = null;
+            int bestLength = -1;
+            foreach (string line in File.ReadLines(MountInfoPath))
+            {
+                // "<id> <parent> <major:minor> <root> <mount point> <options> ..."
+                string[] fields = line.Split(' ');
+                if (fields.Length < 5) continue;
+                string mountPoint = UnescapeMountField(fields[4]);
+                bool contains = mountPoint == "/" ||
+                                fullPath == mountPoint ||
+                                fullPath.StartsWith(mountPoint + "/", StringComparison.Ordinal);
+                if (contains && mountPoint.Length > bestLength)
+                {
+                    bestLength = mountPoint.Length;
+                    bestDevice = fields[2];
+                }
+            }
+            return bestDevice;
+        }
+
+        // mountinfo escapes space, tab, newline and backslash as \ooo octal.
+        private static string UnescapeMountField(string field)
+        {
+            if (field.IndexOf('\\') < 0) return field;
+            var sb = new StringBuilder(field.Length);
+            for (int i = 0; i < field.Length; i++)
+            {
+                if (field[i] == '\\' && i + 3 < field.Length)
+                {
+                    try
+                    {
+                        sb.Append((char)Convert.ToInt32(field.Substring(i + 1, 3), 8));
+                        i += 3;
+                        continue;
+                    }
+                    catch (FormatException)
+                    {
+                    }
+                }
+                sb.Append(field[i]);
+            }
+            return sb.ToString();
+        }
+    }
+}